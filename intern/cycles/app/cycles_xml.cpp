@@ -321,6 +321,8 @@ static void xml_read_integrator(const XMLReadState& state, pugi::xml_node node)
 	xml_read_int(&integrator->seed, node, "seed");
 	xml_read_float(&integrator->sample_clamp_direct, node, "sample_clamp_direct");
 	xml_read_float(&integrator->sample_clamp_indirect, node, "sample_clamp_indirect");
+
+	xml_read_bool(&integrator->use_light_tree, node, "use_light_tree");
 }
 
 /* Camera */
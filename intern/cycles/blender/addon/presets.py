@@ -77,6 +77,10 @@ class AddPresetSampling(AddPresetBase, Operator):
         "cycles.sample_clamp_indirect",
         "cycles.sample_all_lights_direct",
         "cycles.sample_all_lights_indirect",
+        "cycles.use_light_tree",
+        "cycles.use_adaptive_sampling",
+        "cycles.adaptive_threshold",
+        "cycles.adaptive_min_samples",
     ]
 
     preset_subdir = "cycles/sampling"
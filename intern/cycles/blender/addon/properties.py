@@ -266,6 +266,35 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=True,
                 )
 
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick mesh lights by their distance, orientation and strength from the shading point, "
+                            "rather than by area only (faster convergence for scenes with many small mesh lights)",
+                default=False,
+                )
+
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling pixels once their noise is below the threshold, "
+                            "and tiles once all their pixels are (final renders on the CPU only)",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level at which pixels stop being sampled, "
+                            "lower values give less noise at the cost of render time",
+                min=0.0001, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Number of samples every pixel gets before its noise is measured "
+                            "(0 for the square root of the number of samples)",
+                min=0, max=4096,
+                default=0,
+                )
+
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
                 description="Use reflective caustics, resulting in a brighter image (more noise but added realism)",
@@ -464,6 +493,25 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use BVH spatial splits: longer builder time, faster render",
                 default=False,
                 )
+        cls.use_ray_stream = BoolProperty(
+                name="Use Ray Streams",
+                description="Trace camera rays of neighboring pixels together, faster for coherent rays "
+                            "(CPU and path tracing only)",
+                default=False,
+                )
+        cls.use_wavefront = BoolProperty(
+                name="Use Wavefront",
+                description="Trace many paths together one bounce at a time, shading them sorted by shader, "
+                            "can be faster for scenes with many complex shaders (CPU and path tracing only)",
+                default=False,
+                )
+        cls.use_instance_arrays = BoolProperty(
+                name="Use Instance Arrays",
+                description="Sync duplicated meshes as compact arrays of transforms instead of an object per duplicate, "
+                            "faster to sync and using less memory for many duplicates; duplicates don't have "
+                            "motion blur, particle info, dupli texture coordinates or emission sampling",
+                default=False,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -479,6 +527,46 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                             "but time can be saved by manually stopping the render when the noise is low enough)",
                 default=False,
                 )
+        cls.use_denoising = BoolProperty(
+                name="Denoising",
+                description="Filter noise out of the combined pass into a separate Denoised pass "
+                            "once all tiles are rendered, guided by the normal, color and depth of surfaces (final renders on the CPU only)",
+                default=False,
+                )
+        cls.denoising_radius = IntProperty(
+                name="Denoising Radius",
+                description="Radius in pixels of the area searched for similar pixels, "
+                            "larger values remove more noise but are slower",
+                min=1, max=25,
+                default=8,
+                )
+        cls.denoising_strength = FloatProperty(
+                name="Denoising Strength",
+                description="How different pixels can be relative to their noise to be averaged, "
+                            "higher values remove more noise and more detail",
+                min=0.0, max=2.0,
+                default=0.5,
+                )
+        cls.denoising_feature_strength = FloatProperty(
+                name="Denoising Feature Strength",
+                description="How different the normal, color and depth of surfaces can be to be averaged, "
+                            "higher values remove more noise and more detail",
+                min=0.0, max=2.0,
+                default=1.0,
+                )
+        cls.use_texture_cache = BoolProperty(
+                name="Texture Cache",
+                description="Read image textures on demand at the resolution needed, "
+                            "in tiles that are freed when the memory limit is reached; "
+                            "use .tx files made with maketx next to the images for best results (CPU and SVM only)",
+                default=False,
+                )
+        cls.texture_cache_size = IntProperty(
+                name="Texture Cache Size",
+                description="Memory limit of the texture cache in megabytes",
+                min=16, max=65536,
+                default=1024,
+                )
 
         cls.bake_type = EnumProperty(
             name="Bake Type",
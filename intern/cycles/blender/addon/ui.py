@@ -147,6 +147,7 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
 
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
+        sub.prop(cscene, "use_light_tree")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) == False:
             col = split.column()
@@ -173,6 +174,14 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
             sub.prop(cscene, "subsurface_samples", text="Subsurface")
             sub.prop(cscene, "volume_samples", text="Volume")
 
+        row = layout.row()
+        row.active = use_cpu(context)
+        row.prop(cscene, "use_adaptive_sampling")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         if use_cpu(context) or cscene.feature_set == 'EXPERIMENTAL':
             layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
@@ -309,6 +318,15 @@ class CyclesRender_PT_film(CyclesButtonsPanel, Panel):
         if cscene.filter_type != 'BOX':
             sub.prop(cscene, "filter_width", text="Width")
 
+        row = layout.row()
+        row.active = use_cpu(context)
+        row.prop(cscene, "use_denoising")
+        sub = row.row(align=True)
+        sub.active = cscene.use_denoising
+        sub.prop(cscene, "denoising_radius", text="Radius")
+        sub.prop(cscene, "denoising_strength", text="Strength")
+        sub.prop(cscene, "denoising_feature_strength", text="Features")
+
 
 class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
     bl_label = "Performance"
@@ -358,8 +376,18 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         col.separator()
 
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size", text="Size (MB)")
+
+        col.separator()
+
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
+        col.prop(cscene, "use_ray_stream")
+        col.prop(cscene, "use_wavefront")
+        col.prop(cscene, "use_instance_arrays")
 
 
 class CyclesRender_PT_layer_options(CyclesButtonsPanel, Panel):
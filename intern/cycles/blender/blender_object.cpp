@@ -31,6 +31,7 @@
 #include "util_foreach.h"
 #include "util_hash.h"
 #include "util_logging.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -514,6 +515,38 @@ static bool object_render_hide_duplis(BL::Object b_ob)
 	return (parent && object_render_hide_original(b_ob.type(), parent.dupli_type()));
 }
 
+/* Instance Arrays
+ *
+ * Duplicates of the same mesh object are gathered into a single object with
+ * an array of transforms, to avoid creating an object per duplicate. */
+
+struct BlenderInstanceArray {
+	BlenderInstanceArray() : object(NULL), random_id(0), parent_random_id(0) {}
+
+	Object *object;
+	uint random_id;
+	uint parent_random_id;
+	vector<Transform> tfm;
+	vector<uint> instance_random_id;
+};
+
+static void sync_instance_array(Scene *scene, BlenderInstanceArray& array)
+{
+	Object *object = array.object;
+
+	/* texture coordinates of the first duplicate don't apply to all */
+	object->dupli_generated = make_float3(0.0f, 0.0f, 0.0f);
+	object->dupli_uv = make_float2(0.0f, 0.0f);
+
+	if(object->instance_tfm != array.tfm ||
+	   object->instance_random_id != array.instance_random_id)
+	{
+		object->instance_tfm.swap(array.tfm);
+		object->instance_random_id.swap(array.instance_random_id);
+		object->tag_update(scene);
+	}
+}
+
 /* Object Loop */
 
 void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
@@ -555,6 +588,21 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 	 */
 	int dupli_settings = preview ? 1 : 2;
 
+	/* duplicates need their own object for motion */
+	bool use_instance_arrays = false;
+	if(!motion && scene->need_motion() == Scene::MOTION_NONE) {
+		PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+		use_instance_arrays = get_boolean(cscene, "use_instance_arrays");
+	}
+
+	/* arrays are keyed apart from the duplicates they replace */
+	int instance_persistent_id[OBJECT_PERSISTENT_ID_SIZE];
+	for(int i = 0; i < OBJECT_PERSISTENT_ID_SIZE; i++)
+		instance_persistent_id[i] = -1;
+
+	size_t num_instances = 0, num_instance_arrays = 0;
+	double time_start = time_dt();
+
 	bool cancel = false;
 	bool use_portal = false;
 
@@ -588,6 +636,7 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 					b_ob.dupli_list_create(b_scene, dupli_settings);
 
 					BL::Object::dupli_list_iterator b_dup;
+					map<void*, BlenderInstanceArray> instance_arrays;
 
 					for(b_ob.dupli_list.begin(b_dup); b_dup != b_ob.dupli_list.end(); ++b_dup) {
 						Transform tfm = get_transform(b_dup->matrix());
@@ -601,6 +650,41 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 							 * between frames and updates */
 							BL::Array<int, OBJECT_PERSISTENT_ID_SIZE> persistent_id = b_dup->persistent_id();
 
+							if(use_instance_arrays && !object_is_light(b_dup_ob) && object_is_mesh(b_dup_ob)) {
+								if(use_camera_cull && object_boundbox_clip(scene, b_dup_ob, tfm, camera_cull_margin))
+									continue;
+
+								BlenderInstanceArray& array = instance_arrays[b_dup_ob.ptr.data];
+
+								if(!array.object) {
+									/* one object for all duplicates, with the mesh in world space */
+									Transform itfm = transform_identity();
+									array.object = sync_object(b_ob,
+									                           instance_persistent_id,
+									                           *b_dup,
+									                           itfm,
+									                           ob_layer,
+									                           motion_time,
+									                           hide_tris,
+									                           false,
+									                           0.0f,
+									                           &use_portal);
+									array.random_id = hash_string(b_dup_ob.name().c_str());
+									array.parent_random_id = hash_int(hash_string(b_ob.name().c_str()));
+								}
+
+								/* same random number as the object of a duplicate would have */
+								uint random_id = array.random_id;
+								for(int i = 0; i < OBJECT_PERSISTENT_ID_SIZE; i++)
+									random_id = hash_int_2d(random_id, persistent_id.data[i]);
+								if(b_ob.ptr.data != b_dup_ob.ptr.data)
+									random_id ^= array.parent_random_id;
+
+								array.tfm.push_back(tfm);
+								array.instance_random_id.push_back(random_id);
+								continue;
+							}
+
 							/* sync object and mesh or light data */
 							Object *object = sync_object(b_ob,
 							                             persistent_id.data,
@@ -622,6 +706,15 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 						}
 					}
 
+					map<void*, BlenderInstanceArray>::iterator it;
+					for(it = instance_arrays.begin(); it != instance_arrays.end(); it++) {
+						if(it->second.object) {
+							num_instances += it->second.tfm.size();
+							num_instance_arrays++;
+							sync_instance_array(scene, it->second);
+						}
+					}
+
 					b_ob.dupli_list_clear();
 				}
 
@@ -650,6 +743,14 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 
 	progress.set_sync_status("");
 
+	if(num_instance_arrays) {
+		VLOG(1) << "Synced " << num_instances << " instances in "
+		        << num_instance_arrays << " instance arrays, "
+		        << time_dt() - time_start << " seconds for all objects, "
+		        << string_printf("%.2fM", num_instances*(sizeof(Transform) + sizeof(uint))/(1024.0*1024.0))
+		        << " of instance data.";
+	}
+
 	if(!cancel && !motion) {
 		sync_background_light(use_portal);
 
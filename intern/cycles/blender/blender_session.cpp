@@ -281,6 +281,8 @@ static PassType get_pass_type(BL::RenderPass b_pass)
 				return PASS_BVH_TRAVERSED_INSTANCES;
 			if(b_pass.debug_type() == BL::RenderPass::debug_type_RAY_BOUNCES)
 				return PASS_RAY_BOUNCES;
+			if(b_pass.debug_type() == BL::RenderPass::debug_type_SAMPLE_COUNT)
+				return PASS_SAMPLE_COUNT;
 			break;
 		}
 #endif
@@ -289,6 +291,15 @@ static PassType get_pass_type(BL::RenderPass b_pass)
 	return PASS_NONE;
 }
 
+/* Named pass the denoised combined pass is written to, it has no pass type. */
+#define DENOISED_PASS_NAME "Denoised"
+
+static bool is_denoised_pass(BL::RenderPass& b_pass, const string& view)
+{
+	string name = (view.empty())? DENOISED_PASS_NAME: string(DENOISED_PASS_NAME ".") + view;
+	return b_pass.name() == name;
+}
+
 static ShaderEvalType get_shader_type(const string& pass_type)
 {
 	const char *shader_type = pass_type.c_str();
@@ -431,6 +442,10 @@ void BlenderSession::render()
 	for(r.layers.begin(b_layer_iter); b_layer_iter != r.layers.end(); ++b_layer_iter) {
 		b_rlay_name = b_layer_iter->name();
 
+		/* denoised result, next to the combined pass */
+		if(session_params.use_denoising)
+			b_engine.add_pass(DENOISED_PASS_NAME, 4, "RGBA", b_rlay_name.c_str());
+
 		/* temporary render result to find needed passes and views */
 		BL::RenderResult b_rr = begin_render_result(b_engine, 0, 0, 1, 1, b_rlay_name.c_str(), NULL);
 		BL::RenderResult::layers_iterator b_single_rlay;
@@ -464,6 +479,14 @@ void BlenderSession::render()
 			}
 		}
 
+		/* half of the samples for the convergence test of adaptive sampling */
+		if(scene->integrator->adaptive_threshold > 0.0f && session_params.device.type == DEVICE_CPU)
+			Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+
+		/* features and variance the denoiser is guided by */
+		if(session_params.use_denoising)
+			Pass::add(PASS_DENOISING_DATA, passes);
+
 		buffer_params.passes = passes;
 		scene->film->pass_alpha_threshold = b_layer_iter->pass_alpha_threshold();
 		scene->film->tag_passes_update(scene, passes);
@@ -654,7 +677,14 @@ void BlenderSession::do_write_update_render_result(BL::RenderResult b_rr, BL::Re
 			int components = b_pass.channels();
 
 			/* copy pixels */
-			if(!buffers->get_pass_rect(pass_type, exposure, rtile.sample, components, &pixels[0]))
+			bool found;
+
+			if(is_denoised_pass(b_pass, b_rview_name))
+				found = buffers->get_denoised_rect(exposure, &pixels[0]);
+			else
+				found = buffers->get_pass_rect(pass_type, exposure, rtile.sample, components, &pixels[0]);
+
+			if(!found)
 				memset(&pixels[0], 0, pixels.size()*sizeof(float));
 
 			b_pass.rect(&pixels[0]);
@@ -152,6 +152,8 @@ void BlenderSync::sync_data(BL::RenderSettings b_render,
                             void **python_thread_state,
                             const char *layer)
 {
+	RenderLayerInfo prev_render_layer = render_layer;
+
 	sync_render_layers(b_v3d, layer);
 	sync_integrator();
 	sync_film();
@@ -159,11 +161,35 @@ void BlenderSync::sync_data(BL::RenderSettings b_render,
 	sync_images();
 	sync_curve_settings();
 
+	/* in the viewport objects only need to be synced again when the depsgraph
+	 * tagged any of them, or settings that affect all of them changed, so
+	 * material and world edits don't walk all objects and duplis. This is
+	 * checked after the settings sync, which may tag meshes as well. */
+	bool objects_recalc = !b_v3d ||
+	                      scene->objects.empty() ||
+	                      scene->need_motion() != Scene::MOTION_NONE ||
+	                      object_map.has_recalc() ||
+	                      mesh_map.has_recalc() ||
+	                      light_map.has_recalc() ||
+	                      particle_system_map.has_recalc() ||
+	                      BlendDataObjects_is_updated_get(&b_data.ptr) ||
+	                      b_scene.is_updated() ||
+	                      world_recalc ||
+	                      render_layer.modified(prev_render_layer);
+
+	/* meshes need to be synced again for attributes requested by shaders */
+	foreach(Shader *shader, scene->shaders)
+		if(shader->need_update_attributes)
+			objects_recalc = true;
+
 	mesh_synced.clear(); /* use for objects and motion sync */
 
-	if(scene->need_motion() == Scene::MOTION_PASS ||
-	   scene->need_motion() == Scene::MOTION_NONE ||
-	   scene->camera->motion_position == Camera::MOTION_POSITION_CENTER)
+	if(!objects_recalc) {
+		VLOG(1) << "Skipping objects sync, no objects were changed.";
+	}
+	else if(scene->need_motion() == Scene::MOTION_PASS ||
+	        scene->need_motion() == Scene::MOTION_NONE ||
+	        scene->camera->motion_position == Camera::MOTION_POSITION_CENTER)
 	{
 		sync_objects(b_v3d);
 	}
@@ -235,6 +261,14 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	if(get_boolean(cscene, "use_adaptive_sampling"))
+		integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	else
+		integrator->adaptive_threshold = 0.0f;
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
 	int transmission_samples = get_int(cscene, "transmission_samples");
@@ -450,6 +484,14 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background, bo
 		params.use_qbvh = false;
 	}
 
+	params.use_ray_stream = is_cpu && get_boolean(cscene, "use_ray_stream");
+	params.use_wavefront = is_cpu && get_boolean(cscene, "use_wavefront");
+
+	if(is_cpu && params.shadingsystem == SHADINGSYSTEM_SVM && get_boolean(cscene, "use_texture_cache"))
+		params.texture_cache_size = (size_t)get_int(cscene, "texture_cache_size")*1024*1024;
+	else
+		params.texture_cache_size = 0;
+
 	return params;
 }
 
@@ -575,6 +617,14 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine,
 
 	params.progressive_refine = get_boolean(cscene, "use_progressive_refine");
 
+	/* denoising, the features it is guided by are written by CPU kernels only */
+	params.use_denoising = background &&
+	                       params.device.type == DEVICE_CPU &&
+	                       get_boolean(cscene, "use_denoising");
+	params.denoising.radius = get_int(cscene, "denoising_radius");
+	params.denoising.strength = get_float(cscene, "denoising_strength");
+	params.denoising.feature_strength = get_float(cscene, "denoising_feature_strength");
+
 	if(background) {
 		if(params.progressive_refine)
 			params.progressive = true;
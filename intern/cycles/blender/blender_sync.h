@@ -159,6 +159,20 @@ private:
 		  samples(0), bound_samples(false)
 		{}
 
+		/* settings that affect which objects are synced and how */
+		bool modified(const RenderLayerInfo& info) const
+		{
+			return !(scene_layer == info.scene_layer &&
+			         layer == info.layer &&
+			         holdout_layer == info.holdout_layer &&
+			         exclude_layer == info.exclude_layer &&
+			         material_override.ptr.data == info.material_override.ptr.data &&
+			         use_surfaces == info.use_surfaces &&
+			         use_hair == info.use_hair &&
+			         use_viewport_visibility == info.use_viewport_visibility &&
+			         use_localview == info.use_localview);
+		}
+
 		string name;
 		uint scene_layer;
 		uint layer;
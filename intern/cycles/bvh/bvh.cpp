@@ -119,15 +119,45 @@ void BVH::build(Progress& progress)
 
 void BVH::refit(Progress& progress)
 {
-	progress.set_substatus("Packing BVH primitives");
-	pack_primitives();
+	if(params.top_level) {
+		/* only the objects moved, primitives of meshes with transform applied
+		 * and the merged BVHs of instanced meshes stay the same */
+		instance_arrays.clear();
+
+		foreach(Object *ob, objects)
+			if(ob->has_instances())
+				instance_arrays.push_back(ob);
+	}
+	else {
+		progress.set_substatus("Packing BVH primitives");
+		pack_primitives();
 
-	if(progress.get_cancel()) return;
+		if(progress.get_cancel()) return;
+	}
 
 	progress.set_substatus("Refitting BVH nodes");
 	refit_nodes();
 }
 
+void BVH::refit_object(int object, BoundBox& bbox, uint& visibility)
+{
+	const Object *ob;
+
+	if(object < (int)objects.size()) {
+		ob = objects[object];
+		bbox.grow(ob->bounds);
+	}
+	else {
+		/* instance of an instance array */
+		ob = object_find_instance_array(instance_arrays, object);
+
+		BoundBox mbounds = ob->mesh->bounds;
+		bbox.grow(mbounds.transformed(&ob->instance_tfm[object - ob->instance_offset]));
+	}
+
+	visibility |= ob->visibility;
+}
+
 /* Triangles */
 
 void BVH::pack_triangle(int idx, float4 woop[3])
@@ -229,10 +259,15 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
 	map<Mesh*, int> mesh_map;
 
+	/* instances of instance arrays are numbered after the objects */
+	size_t object_node_size = objects.size();
+
 	foreach(Object *ob, objects) {
 		Mesh *mesh = ob->mesh;
 		BVH *bvh = mesh->bvh;
 
+		object_node_size += ob->instance_tfm.size();
+
 		if(!mesh->transform_applied) {
 			if(mesh_map.find(mesh) == mesh_map.end()) {
 				prim_index_size += bvh->pack.prim_index.size();
@@ -254,7 +289,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	pack.tri_woop.resize(tri_woop_size);
 	pack.nodes.resize(nodes_size);
 	pack.leaf_nodes.resize(leaf_nodes_size);
-	pack.object_node.resize(objects.size());
+	pack.object_node.resize(object_node_size);
 
 	int *pack_prim_index = (pack.prim_index.size())? &pack.prim_index[0]: NULL;
 	int *pack_prim_type = (pack.prim_type.size())? &pack.prim_type[0]: NULL;
@@ -379,6 +414,16 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 		nodes_leaf_offset += bvh->pack.leaf_nodes.size();
 		prim_offset += bvh->pack.prim_index.size();
 	}
+
+	/* instances traverse the BVH of the mesh of their array */
+	object_offset = 0;
+
+	foreach(Object *ob, objects) {
+		for(size_t j = 0; j < ob->instance_tfm.size(); j++)
+			pack.object_node[ob->instance_offset + j] = pack.object_node[object_offset];
+
+		object_offset++;
+	}
 }
 
 /* Regular BVH */
@@ -482,8 +527,6 @@ void RegularBVH::pack_nodes(const BVHNode *root)
 
 void RegularBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -495,18 +538,21 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 		int4 *data = &pack.leaf_nodes[idx*BVH_NODE_LEAF_SIZE];
 		int c0 = data[0].x;
 		int c1 = data[0].y;
+		/* object leaves of the top level BVH store their primitive inverted */
+		int prim_begin = (c0 < 0)? ~c0: c0;
+		int prim_end = (c0 < 0)? ~c0 + 1: c1;
 		/* refit leaf node */
-		for(int prim = c0; prim < c1; prim++) {
+		for(int prim = prim_begin; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
-			Object *ob = objects[tob];
 
 			if(pidx == -1) {
 				/* object instance */
-				bbox.grow(ob->bounds);
+				refit_object(tob, bbox, visibility);
 			}
 			else {
 				/* primitives */
+				const Object *ob = objects[tob];
 				const Mesh *mesh = ob->mesh;
 
 				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE) {
@@ -555,9 +601,9 @@ void RegularBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility
 						}
 					}
 				}
-			}
 
-			visibility |= ob->visibility;
+				visibility |= ob->visibility;
+			}
 		}
 
 		/* TODO(sergey): De-duplicate with pack_leaf(). */
@@ -747,8 +793,6 @@ void QBVH::pack_nodes(const BVHNode *root)
 
 void QBVH::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -759,18 +803,21 @@ void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 	if(leaf) {
 		int4 *data = &pack.leaf_nodes[idx*BVH_QNODE_LEAF_SIZE];
 		int4 c = data[0];
+		/* Object leaves of the top level BVH store their primitive inverted. */
+		int prim_begin = (c.x < 0)? ~c.x: c.x;
+		int prim_end = (c.x < 0)? ~c.x + 1: c.y;
 		/* Refit leaf node. */
-		for(int prim = c.x; prim < c.y; prim++) {
+		for(int prim = prim_begin; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
-			Object *ob = objects[tob];
 
 			if(pidx == -1) {
 				/* Object instance. */
-				bbox.grow(ob->bounds);
+				refit_object(tob, bbox, visibility);
 			}
 			else {
 				/* Primitives. */
+				const Object *ob = objects[tob];
 				const Mesh *mesh = ob->mesh;
 
 				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE) {
@@ -819,9 +866,9 @@ void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 						}
 					}
 				}
-			}
 
-			visibility |= ob->visibility;
+				visibility |= ob->visibility;
+			}
 		}
 
 		/* TODO(sergey): This is actually a copy of pack_leaf(),
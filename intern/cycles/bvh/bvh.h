@@ -102,6 +102,10 @@ protected:
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
 
+	/* bounds of objects and instances in the top level BVH */
+	void refit_object(int object, BoundBox& bbox, uint& visibility);
+	vector<Object*> instance_arrays;
+
 	/* for subclasses to implement */
 	virtual void pack_nodes(const BVHNode *root) = 0;
 	virtual void refit_nodes() = 0;
@@ -62,6 +62,39 @@ public:
 	BVHObjectBinning range;
 };
 
+/* BVH Spatial Split Build Task
+ *
+ * Spatial splits duplicate references, which changes the size of the array
+ * while building, so each task builds its subtree from own copy of the
+ * references of its range. */
+
+class BVHSpatialSplitBuildTask : public Task {
+public:
+	BVHSpatialSplitBuildTask(BVHBuild *build,
+	                         InnerNode *node,
+	                         int child,
+	                         const BVHRange& range_,
+	                         const vector<BVHReference>& references_,
+	                         int level)
+	: range(range_),
+	  references(references_.begin() + range_.start(), references_.begin() + range_.end())
+	{
+		range.set_start(0);
+		run = function_bind(&BVHBuild::thread_build_spatial_split_node,
+		                    build,
+		                    node,
+		                    child,
+		                    &range,
+		                    &references,
+		                    &storage,
+		                    level);
+	}
+
+	BVHRange range;
+	vector<BVHReference> references;
+	BVHSpatialStorage storage;
+};
+
 /* Constructor / Destructor */
 
 BVHBuild::BVHBuild(const vector<Object*>& objects_,
@@ -79,6 +112,7 @@ BVHBuild::BVHBuild(const vector<Object*>& objects_,
    progress_start_time(0.0)
 {
 	spatial_min_overlap = 0.0f;
+	spatial_prim_capacity = 0;
 }
 
 BVHBuild::~BVHBuild()
@@ -163,6 +197,29 @@ void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob
 	center.grow(ob->bounds.center2());
 }
 
+void BVHBuild::add_reference_instances(BoundBox& root, BoundBox& center, Object *ob)
+{
+	BoundBox mbounds = ob->mesh->bounds;
+
+	for(size_t j = 0; j < ob->instance_tfm.size(); j++) {
+		BoundBox bounds = mbounds.transformed(&ob->instance_tfm[j]);
+
+		references.push_back(BVHReference(bounds, -1, ob->instance_offset + j, 0));
+		root.grow(bounds);
+		center.grow(bounds.center2());
+	}
+
+	instance_arrays.push_back(ob);
+}
+
+uint BVHBuild::object_visibility(int object) const
+{
+	if(object < (int)objects.size())
+		return objects[object]->visibility;
+
+	return object_find_instance_array(instance_arrays, object)->visibility;
+}
+
 static size_t count_curve_segments(Mesh *mesh)
 {
 	size_t num = 0, num_curves = mesh->curves.size();
@@ -180,7 +237,10 @@ void BVHBuild::add_references(BVHRange& root)
 
 	foreach(Object *ob, objects) {
 		if(params.top_level) {
-			if(ob->mesh->transform_applied) {
+			if(ob->has_instances()) {
+				num_alloc_references += ob->instance_tfm.size();
+			}
+			else if(ob->mesh->transform_applied) {
 				num_alloc_references += ob->mesh->triangles.size();
 				num_alloc_references += count_curve_segments(ob->mesh);
 			}
@@ -201,7 +261,9 @@ void BVHBuild::add_references(BVHRange& root)
 
 	foreach(Object *ob, objects) {
 		if(params.top_level) {
-			if(ob->mesh->transform_applied)
+			if(ob->has_instances())
+				add_reference_instances(bounds, center, ob);
+			else if(ob->mesh->transform_applied)
 				add_reference_mesh(bounds, center, ob->mesh, i);
 			else
 				add_reference_object(bounds, center, ob, i);
@@ -244,8 +306,6 @@ BVHNode* BVHBuild::run()
 	}
 
 	spatial_min_overlap = root.bounds().safe_area() * params.spatial_split_alpha;
-	spatial_right_bounds.clear();
-	spatial_right_bounds.resize(max(root.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
 
 	/* init progress updates */
 	double build_start_time;
@@ -254,16 +314,27 @@ BVHNode* BVHBuild::run()
 	progress_total = references.size();
 	progress_original_total = progress_total;
 
-	prim_type.resize(references.size());
-	prim_index.resize(references.size());
-	prim_object.resize(references.size());
+	if(params.use_spatial_split) {
+		/* leaves append their primitives, see create_leaf_node() */
+		prim_type.clear();
+		prim_index.clear();
+		prim_object.clear();
+		spatial_prim_capacity = 0;
+		reserve_spatial_prims(references.size());
+	}
+	else {
+		prim_type.resize(references.size());
+		prim_index.resize(references.size());
+		prim_object.resize(references.size());
+	}
 
 	/* build recursively */
 	BVHNode *rootnode;
 
 	if(params.use_spatial_split) {
-		/* singlethreaded spatial split build */
-		rootnode = build_node(root, 0);
+		/* multithreaded spatial split build */
+		rootnode = build_node(root, &references, &spatial_storage, 0);
+		task_pool.wait_work();
 	}
 	else {
 		/* multithreaded binning build */
@@ -279,13 +350,16 @@ BVHNode* BVHBuild::run()
 			rootnode = NULL;
 			VLOG(1) << "BVH build cancelled.";
 		}
-		else if(!params.use_spatial_split) {
+		else {
 			/*rotate(rootnode, 4, 5);*/
 			rootnode->update_visibility();
 		}
 		if(rootnode != NULL) {
 			VLOG(1) << "BVH build statistics:\n"
 			        << "  Build time: " << time_dt() - build_start_time << "\n"
+			        << "  SAH cost: " << rootnode->computeSubtreeSAHCost(params) << "\n"
+			        << "  Number of references: " << prim_type.size()
+			        << " (" << prim_type.size() - progress_original_total << " duplicated)\n"
 			        << "  Total number of nodes: "
 			        << rootnode->getSubtreeSize(BVH_STAT_NODE_COUNT) << "\n"
 			        << "  Number of inner nodes: "
@@ -336,7 +410,35 @@ void BVHBuild::thread_build_node(InnerNode *inner, int child, BVHObjectBinning *
 	}
 }
 
-bool BVHBuild::range_within_max_leaf_size(const BVHRange& range)
+void BVHBuild::thread_build_spatial_split_node(InnerNode *inner,
+                                               int child,
+                                               BVHRange *range,
+                                               vector<BVHReference> *references,
+                                               BVHSpatialStorage *storage,
+                                               int level)
+{
+	if(progress.get_cancel())
+		return;
+
+	/* build nodes */
+	BVHNode *node = build_node(*range, references, storage, level);
+
+	/* set child in inner node */
+	inner->children[child] = node;
+
+	/* update progress */
+	if(range->size() < THREAD_TASK_SIZE) {
+		thread_scoped_lock lock(build_mutex);
+
+		/* the task references start with its range, the rest are duplicates */
+		progress_total += references->size() - range->size();
+		progress_count += references->size();
+		progress_update();
+	}
+}
+
+bool BVHBuild::range_within_max_leaf_size(const BVHRange& range,
+                                          const vector<BVHReference>& references) const
 {
 	size_t size = range.size();
 	size_t max_leaf_size = max(params.max_triangle_leaf_size, params.max_curve_leaf_size);
@@ -349,7 +451,7 @@ bool BVHBuild::range_within_max_leaf_size(const BVHRange& range)
 	size_t num_motion_curves = 0;
 
 	for(int i = 0; i < size; i++) {
-		BVHReference& ref = references[range.start() + i];
+		const BVHReference& ref = references[range.start() + i];
 
 		if(ref.prim_type() & PRIMITIVE_CURVE)
 			num_curves++;
@@ -375,8 +477,8 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	 * visibility tests, since object instances do not check visibility flag */
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
 		/* make leaf node when threshold reached or SAH tells us */
-		if(params.small_enough_for_leaf(size, level) || (range_within_max_leaf_size(range) && leafSAH < splitSAH))
-			return create_leaf_node(range);
+		if(params.small_enough_for_leaf(size, level) || (range_within_max_leaf_size(range, references) && leafSAH < splitSAH))
+			return create_leaf_node(range, references);
 	}
 
 	/* perform split */
@@ -404,48 +506,62 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	return inner;
 }
 
-/* single threaded spatial split builder */
-BVHNode* BVHBuild::build_node(const BVHRange& range, int level)
+/* multithreaded spatial split builder */
+BVHNode* BVHBuild::build_node(const BVHRange& range,
+                              vector<BVHReference> *references,
+                              BVHSpatialStorage *storage,
+                              int level)
 {
-	/* progress update */
-	progress_update();
 	if(progress.get_cancel())
 		return NULL;
 
 	/* small enough or too deep => create leaf. */
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
-		if(params.small_enough_for_leaf(range.size(), level)) {
-			progress_count += range.size();
-			return create_leaf_node(range);
-		}
+		if(params.small_enough_for_leaf(range.size(), level))
+			return create_leaf_node(range, *references);
 	}
 
 	/* splitting test */
-	BVHMixedSplit split(this, range, level);
+	BVHMixedSplit split(this, storage, range, references, level);
 
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
-		if(split.no_split) {
-			progress_count += range.size();
-			return create_leaf_node(range);
-		}
+		if(split.no_split)
+			return create_leaf_node(range, *references);
 	}
 	
 	/* do split */
 	BVHRange left, right;
 	split.split(this, left, right, range);
 
-	progress_total += left.size() + right.size() - range.size();
-	size_t total = progress_total;
+	/* create inner node. */
+	InnerNode *inner;
+
+	if(range.size() < THREAD_TASK_SIZE) {
+		/* local build */
+		size_t num_references = references->size();
+
+		BVHNode *leftnode = build_node(left, references, storage, level + 1);
+
+		/* right node (modify start for duplicates inserted by the left node) */
+		right.set_start(right.start() + (int)(references->size() - num_references));
+		BVHNode *rightnode = build_node(right, references, storage, level + 1);
+
+		inner = new InnerNode(range.bounds(), leftnode, rightnode);
+	}
+	else {
+		/* threaded build */
+		{
+			thread_scoped_lock lock(build_mutex);
+			progress_total += left.size() + right.size() - range.size();
+		}
 
-	/* left node */
-	BVHNode *leftnode = build_node(left, level + 1);
+		inner = new InnerNode(range.bounds());
 
-	/* right node (modify start for splits) */
-	right.set_start(right.start() + progress_total - total);
-	BVHNode *rightnode = build_node(right, level + 1);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 0, left, *references, level + 1), true);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 1, right, *references, level + 1), true);
+	}
 
-	/* inner node */
-	return new InnerNode(range.bounds(), leftnode, rightnode);
+	return inner;
 }
 
 /* Create Nodes */
@@ -458,11 +574,8 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 	}
 	else if(num == 1) {
 		assert(start < prim_type.size());
-		prim_type[start] = ref->prim_type();
-		prim_index[start] = ref->prim_index();
-		prim_object[start] = ref->prim_object();
 
-		uint visibility = objects[ref->prim_object()]->visibility;
+		uint visibility = object_visibility(ref->prim_object());
 		return new LeafNode(ref->bounds(), visibility, start, start+1);
 	}
 	else {
@@ -478,23 +591,21 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 	}
 }
 
-BVHNode *BVHBuild::create_primitive_leaf_node(const int *p_type,
-                                              const int *p_index,
-                                              const int *p_object,
-                                              const BoundBox& bounds,
-                                              uint visibility,
-                                              int start,
-                                              int num)
+void BVHBuild::reserve_spatial_prims(size_t num)
 {
-	for(int i = 0; i < num; ++i) {
-		prim_type[start + i] = p_type[i];
-		prim_index[start + i] = p_index[i];
-		prim_object[start + i] = p_object[i];
+	if(num > spatial_prim_capacity) {
+		/* grow in steps, to not copy the arrays for every leaf */
+		size_t capacity = spatial_prim_capacity + spatial_prim_capacity/2;
+		spatial_prim_capacity = (num > capacity)? num: capacity;
+
+		prim_type.reserve(spatial_prim_capacity);
+		prim_index.reserve(spatial_prim_capacity);
+		prim_object.reserve(spatial_prim_capacity);
 	}
-	return new LeafNode(bounds, visibility, start, start + num);
 }
 
-BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
+BVHNode* BVHBuild::create_leaf_node(const BVHRange& range,
+                                    vector<BVHReference>& references)
 {
 	/* TODO(sergey): Consider writing own allocator which would
 	 * not do heap allocation if number of elements is relatively small.
@@ -520,7 +631,7 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 			p_object[type_index].push_back(ref.prim_object());
 
 			bounds[type_index].grow(ref.bounds());
-			visibility[type_index] |= objects[ref.prim_object()]->visibility;
+			visibility[type_index] |= object_visibility(ref.prim_object());
 		}
 		else {
 			if(ob_num < i) {
@@ -530,33 +641,49 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 		}
 	}
 
-	/* Extend an array when needed. */
-	if(prim_type.size() < range.end()) {
-		assert(params.use_spatial_split);
-		prim_type.reserve(references.size());
-		prim_index.reserve(references.size());
-		prim_object.reserve(references.size());
-		prim_type.resize(range.end());
-		prim_index.resize(range.end());
-		prim_object.resize(range.end());
+	/* Store primitives of the leaf, grouped by type with objects last. */
+	int start = range.start();
+
+	if(params.use_spatial_split) {
+		/* Spatial splits duplicate references, so the final number of
+		 * primitives is only known at the end of the build. Leaves append
+		 * their primitives as the build tasks create them. */
+		build_mutex.lock();
+
+		start = (int)prim_type.size();
+		reserve_spatial_prims(start + range.size());
+		prim_type.resize(start + range.size());
+		prim_index.resize(start + range.size());
+		prim_object.resize(start + range.size());
+	}
+
+	int prim_start = start;
+	for(int i = 0; i < PRIMITIVE_NUM_TOTAL; ++i) {
+		assert(p_type[i].size() == p_index[i].size());
+		assert(p_type[i].size() == p_object[i].size());
+		for(size_t j = 0; j < p_type[i].size(); ++j, ++prim_start) {
+			prim_type[prim_start] = p_type[i][j];
+			prim_index[prim_start] = p_index[i][j];
+			prim_object[prim_start] = p_object[i][j];
+		}
+	}
+	for(int i = 0; i < ob_num; ++i, ++prim_start) {
+		const BVHReference& ref = references[range.start() + i];
+		prim_type[prim_start] = ref.prim_type();
+		prim_index[prim_start] = ref.prim_index();
+		prim_object[prim_start] = ref.prim_object();
 	}
 
+	if(params.use_spatial_split)
+		build_mutex.unlock();
+
 	/* Create leaf nodes for every existing primitive. */
 	BVHNode *leaves[PRIMITIVE_NUM_TOTAL + 1] = {NULL};
 	int num_leaves = 0;
-	int start = range.start();
 	for(int i = 0; i < PRIMITIVE_NUM_TOTAL; ++i) {
 		int num = (int)p_type[i].size();
 		if(num != 0) {
-			assert(p_type[i].size() == p_index[i].size());
-			assert(p_type[i].size() == p_object[i].size());
-			leaves[num_leaves] = create_primitive_leaf_node(&p_type[i][0],
-			                                                &p_index[i][0],
-			                                                &p_object[i][0],
-			                                                bounds[i],
-			                                                visibility[i],
-			                                                start,
-			                                                num);
+			leaves[num_leaves] = new LeafNode(bounds[i], visibility[i], start, start + num);
 			++num_leaves;
 			start += num;
 		}
@@ -31,6 +31,7 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuildTask;
 class BVHParams;
+class BVHSpatialSplitBuildTask;
 class InnerNode;
 class Mesh;
 class Object;
@@ -57,32 +58,40 @@ protected:
 	friend class BVHObjectSplit;
 	friend class BVHSpatialSplit;
 	friend class BVHBuildTask;
+	friend class BVHSpatialSplitBuildTask;
 
 	/* adding references */
 	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
 	void add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i);
+	void add_reference_instances(BoundBox& root, BoundBox& center, Object *ob);
 	void add_references(BVHRange& root);
 
+	/* visibility of object or instance of an instance array */
+	uint object_visibility(int object) const;
+
 	/* building */
-	BVHNode *build_node(const BVHRange& range, int level);
+	BVHNode *build_node(const BVHRange& range,
+	                    vector<BVHReference> *references,
+	                    BVHSpatialStorage *storage,
+	                    int level);
 	BVHNode *build_node(const BVHObjectBinning& range, int level);
-	BVHNode *create_leaf_node(const BVHRange& range);
+	BVHNode *create_leaf_node(const BVHRange& range,
+	                          vector<BVHReference>& references);
 	BVHNode *create_object_leaf_nodes(const BVHReference *ref, int start, int num);
+	void reserve_spatial_prims(size_t num);
 
-	/* Leaf node type splitting. */
-	BVHNode *create_primitive_leaf_node(const int *p_type,
-	                                    const int *p_index,
-	                                    const int *p_object,
-	                                    const BoundBox& bounds,
-	                                    uint visibility,
-	                                    int start,
-	                                    int nun);
-
-	bool range_within_max_leaf_size(const BVHRange& range);
+	bool range_within_max_leaf_size(const BVHRange& range,
+	                                const vector<BVHReference>& references) const;
 
 	/* threads */
 	enum { THREAD_TASK_SIZE = 4096 };
 	void thread_build_node(InnerNode *node, int child, BVHObjectBinning *range, int level);
+	void thread_build_spatial_split_node(InnerNode *node,
+	                                     int child,
+	                                     BVHRange *range,
+	                                     vector<BVHReference> *references,
+	                                     BVHSpatialStorage *storage,
+	                                     int level);
 	thread_mutex build_mutex;
 
 	/* progress */
@@ -94,6 +103,7 @@ protected:
 
 	/* objects and primitive references */
 	vector<Object*> objects;
+	vector<Object*> instance_arrays;
 	vector<BVHReference> references;
 	int num_original_references;
 
@@ -114,8 +124,8 @@ protected:
 
 	/* spatial splitting */
 	float spatial_min_overlap;
-	vector<BoundBox> spatial_right_bounds;
-	BVHSpatialBin spatial_bins[3][BVHParams::NUM_SPATIAL_BINS];
+	BVHSpatialStorage spatial_storage;
+	size_t spatial_prim_capacity;
 
 	/* threads */
 	TaskPool task_pool;
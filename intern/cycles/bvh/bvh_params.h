@@ -19,6 +19,7 @@
 #define __BVH_PARAMS_H__
 
 #include "util_boundbox.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -175,6 +176,23 @@ struct BVHSpatialBin
 	}
 };
 
+/* BVH Spatial Storage
+ *
+ * Temporary storage of the spatial split builder, kept per build task so
+ * subtrees can be split in parallel. */
+
+struct BVHSpatialStorage
+{
+	/* accumulated bounds when sweeping from right to left */
+	vector<BoundBox> right_bounds;
+
+	/* bins used for histogram of spatial split candidates */
+	BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+
+	/* duplicated references of a spatial split, inserted in one go */
+	vector<BVHReference> new_references;
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __BVH_PARAMS_H__ */
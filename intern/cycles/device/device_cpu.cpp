@@ -44,6 +44,7 @@
 
 #include "buffers.h"
 
+#include "util_aligned_malloc.h"
 #include "util_debug.h"
 #include "util_foreach.h"
 #include "util_function.h"
@@ -68,6 +69,8 @@ public:
 	CPUDevice(DeviceInfo& info, Stats &stats, bool background)
 	: Device(info, stats, background)
 	{
+		kernel_globals.texture_cache = NULL;
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
@@ -222,6 +225,89 @@ public:
 		else
 #endif
 			path_trace_kernel = kernel_cpu_path_trace;
+
+		void(*path_trace_stream_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int, int, int);
+
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+		if(system_cpu_support_avx2())
+			path_trace_stream_kernel = kernel_cpu_avx2_path_trace_stream;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
+		if(system_cpu_support_avx())
+			path_trace_stream_kernel = kernel_cpu_avx_path_trace_stream;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
+		if(system_cpu_support_sse41())
+			path_trace_stream_kernel = kernel_cpu_sse41_path_trace_stream;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
+		if(system_cpu_support_sse3())
+			path_trace_stream_kernel = kernel_cpu_sse3_path_trace_stream;
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
+		if(system_cpu_support_sse2())
+			path_trace_stream_kernel = kernel_cpu_sse2_path_trace_stream;
+		else
+#endif
+			path_trace_stream_kernel = kernel_cpu_path_trace_stream;
+
+		void(*path_trace_wavefront_kernel)(KernelGlobals*, void*, float*, unsigned int*, int, int, int, int, int, int, int);
+		size_t(*path_trace_wavefront_state_size)();
+
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+		if(system_cpu_support_avx2()) {
+			path_trace_wavefront_kernel = kernel_cpu_avx2_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_avx2_path_trace_wavefront_state_size;
+		}
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
+		if(system_cpu_support_avx()) {
+			path_trace_wavefront_kernel = kernel_cpu_avx_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_avx_path_trace_wavefront_state_size;
+		}
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
+		if(system_cpu_support_sse41()) {
+			path_trace_wavefront_kernel = kernel_cpu_sse41_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_sse41_path_trace_wavefront_state_size;
+		}
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
+		if(system_cpu_support_sse3()) {
+			path_trace_wavefront_kernel = kernel_cpu_sse3_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_sse3_path_trace_wavefront_state_size;
+		}
+		else
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
+		if(system_cpu_support_sse2()) {
+			path_trace_wavefront_kernel = kernel_cpu_sse2_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_sse2_path_trace_wavefront_state_size;
+		}
+		else
+#endif
+		{
+			path_trace_wavefront_kernel = kernel_cpu_path_trace_wavefront;
+			path_trace_wavefront_state_size = kernel_cpu_path_trace_wavefront_state_size;
+		}
+
+		/* camera rays of blocks of pixels are traced together, or all paths
+		 * of a tile one bounce at a time, only for the regular path tracer */
+		bool use_wavefront = task.use_wavefront && !task.integrator_branched;
+		bool use_ray_stream = task.use_ray_stream && !task.integrator_branched;
+
+		/* paths in flight, kept for all tiles and samples of the thread */
+		void *wavefront_state = NULL;
+
+		if(use_wavefront)
+			wavefront_state = util_aligned_malloc(path_trace_wavefront_state_size(), 16);
 		
 		while(task.acquire_tile(this, tile)) {
 			float *render_buffer = (float*)tile.buffer;
@@ -235,16 +321,49 @@ public:
 						break;
 				}
 
-				for(int y = tile.y; y < tile.y + tile.h; y++) {
-					for(int x = tile.x; x < tile.x + tile.w; x++) {
-						path_trace_kernel(&kg, render_buffer, rng_state,
-						                  sample, x, y, tile.offset, tile.stride);
+				if(use_wavefront) {
+					path_trace_wavefront_kernel(&kg, wavefront_state, render_buffer, rng_state,
+					                            sample, tile.x, tile.y, tile.w, tile.h,
+					                            tile.offset, tile.stride);
+				}
+				else if(use_ray_stream) {
+					for(int y = tile.y; y < tile.y + tile.h; y += RAY_STREAM_HEIGHT) {
+						int h = min(RAY_STREAM_HEIGHT, tile.y + tile.h - y);
+
+						for(int x = tile.x; x < tile.x + tile.w; x += RAY_STREAM_WIDTH) {
+							int w = min(RAY_STREAM_WIDTH, tile.x + tile.w - x);
+
+							path_trace_stream_kernel(&kg, render_buffer, rng_state,
+							                         sample, x, y, w, h, tile.offset, tile.stride);
+						}
+					}
+				}
+				else {
+					for(int y = tile.y; y < tile.y + tile.h; y++) {
+						for(int x = tile.x; x < tile.x + tile.w; x++) {
+							path_trace_kernel(&kg, render_buffer, rng_state,
+							                  sample, x, y, tile.offset, tile.stride);
+						}
 					}
 				}
 
 				tile.sample = sample + 1;
 
 				task.update_progress(&tile);
+
+				if(task.need_adaptive_check(tile.sample) &&
+				   thread_adaptive_sampling(&kg, tile))
+				{
+					/* all pixels converged, retire the tile */
+					adaptive_scale_tile(&kg, tile, (float)end_sample/(float)tile.sample);
+
+					while(tile.sample < end_sample) {
+						tile.sample++;
+						task.update_progress(&tile);
+					}
+
+					break;
+				}
 			}
 
 			task.release_tile(tile);
@@ -255,11 +374,50 @@ public:
 			}
 		}
 
+		if(wavefront_state)
+			util_aligned_free(wavefront_state);
+
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
 	}
 
+	/* Test the convergence of the pixels in the tile, and keep the neighbors of
+	 * unconverged pixels from converging. Returns true when all pixels in the
+	 * tile converged. These only touch the buffer once per pixel every few
+	 * samples, so there is no need for the optimized kernels here. */
+	bool thread_adaptive_sampling(KernelGlobals *kg, RenderTile& tile)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		bool converged = true;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				converged &= kernel_cpu_adaptive_convergence_check(kg, render_buffer, tile.sample,
+				                                                  x, y, tile.offset, tile.stride);
+			}
+		}
+
+		if(converged)
+			return true;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++)
+			kernel_cpu_adaptive_dilate(kg, render_buffer, tile.x, y, 1, tile.w, tile.offset, tile.stride);
+		for(int x = tile.x; x < tile.x + tile.w; x++)
+			kernel_cpu_adaptive_dilate(kg, render_buffer, x, tile.y, tile.stride, tile.h, tile.offset, tile.stride);
+
+		return false;
+	}
+
+	void adaptive_scale_tile(KernelGlobals *kg, RenderTile& tile, float scale)
+	{
+		float *render_buffer = (float*)tile.buffer;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++)
+			for(int x = tile.x; x < tile.x + tile.w; x++)
+				kernel_cpu_adaptive_scale(kg, render_buffer, scale, x, y, tile.offset, tile.stride);
+	}
+
 	void thread_film_convert(DeviceTask& task)
 	{
 		float sample_scale = 1.0f/(task.sample + 1);
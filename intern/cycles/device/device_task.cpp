@@ -30,7 +30,9 @@ DeviceTask::DeviceTask(Type type_)
 : type(type_), x(0), y(0), w(0), h(0), rgba_byte(0), rgba_half(0), buffer(0),
   sample(0), num_samples(1),
   shader_input(0), shader_output(0), shader_output_luma(0),
-  shader_eval_type(0), shader_x(0), shader_w(0)
+  shader_eval_type(0), shader_x(0), shader_w(0),
+  integrator_adaptive(false), adaptive_min_samples(0),
+  use_ray_stream(false), use_wavefront(false)
 {
 	last_update_time = time_dt();
 }
@@ -119,5 +121,17 @@ void DeviceTask::update_progress(RenderTile *rtile)
 	}
 }
 
+/* Adaptive sampling tests the convergence of pixels after this many samples,
+ * a multiple of two since the auxiliary pass holds every other sample. */
+
+#define ADAPTIVE_SAMPLING_STEP 4
+
+bool DeviceTask::need_adaptive_check(int num_samples) const
+{
+	return integrator_adaptive &&
+	       num_samples >= adaptive_min_samples &&
+	       (num_samples % ADAPTIVE_SAMPLING_STEP) == 0;
+}
+
 CCL_NAMESPACE_END
 
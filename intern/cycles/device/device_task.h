@@ -57,6 +57,8 @@ public:
 
 	void update_progress(RenderTile *rtile);
 
+	bool need_adaptive_check(int num_samples) const;
+
 	function<bool(Device *device, RenderTile&)> acquire_tile;
 	function<void(void)> update_progress_sample;
 	function<void(RenderTile&)> update_tile_sample;
@@ -65,6 +67,10 @@ public:
 
 	bool need_finish_queue;
 	bool integrator_branched;
+	bool integrator_adaptive;
+	int adaptive_min_samples;
+	bool use_ray_stream;
+	bool use_wavefront;
 	int2 requested_tile_size;
 protected:
 	double last_update_time;
@@ -53,6 +53,11 @@ CCL_NAMESPACE_BEGIN
 #include "geom_qbvh.h"
 #endif
 
+/* Common ray stream functions. */
+#ifdef __RAY_STREAM__
+#include "geom_bvh_stream.h"
+#endif
+
 /* Regular BVH traversal */
 
 #define BVH_FUNCTION_NAME bvh_intersect
@@ -211,6 +216,26 @@ CCL_NAMESPACE_BEGIN
 #include "geom_bvh_volume_all.h"
 #endif
 
+/* Ray stream traversal */
+
+#if defined(__RAY_STREAM__)
+#define BVH_FUNCTION_NAME bvh_intersect_stream
+#define BVH_FUNCTION_FEATURES 0
+#include "geom_bvh_stream_traversal.h"
+#endif
+
+#if defined(__RAY_STREAM__) && defined(__INSTANCING__)
+#define BVH_FUNCTION_NAME bvh_intersect_stream_instancing
+#define BVH_FUNCTION_FEATURES BVH_INSTANCING
+#include "geom_bvh_stream_traversal.h"
+#endif
+
+#if defined(__RAY_STREAM__) && defined(__OBJECT_MOTION__)
+#define BVH_FUNCTION_NAME bvh_intersect_stream_motion
+#define BVH_FUNCTION_FEATURES BVH_INSTANCING|BVH_MOTION
+#include "geom_bvh_stream_traversal.h"
+#endif
+
 #undef BVH_FEATURE
 #undef BVH_NAME_JOIN
 #undef BVH_NAME_EVAL
@@ -254,6 +279,36 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg, const Ray *ray, con
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __RAY_STREAM__
+/* Intersect a stream of up to RAY_STREAM_SIZE rays with the same visibility.
+ * Hair is not supported, since curves are intersected with a minimum width
+ * depending on each ray. */
+ccl_device_intersect void scene_intersect_stream(KernelGlobals *kg,
+                                                 const Ray *rays,
+                                                 Intersection *isects,
+                                                 const int num_rays,
+                                                 const uint visibility)
+{
+	kernel_assert(!kernel_data.bvh.have_curves);
+
+#ifdef __OBJECT_MOTION__
+	if(kernel_data.bvh.have_motion) {
+		bvh_intersect_stream_motion(kg, rays, isects, num_rays, visibility);
+		return;
+	}
+#endif /* __OBJECT_MOTION__ */
+
+#ifdef __INSTANCING__
+	if(kernel_data.bvh.have_instancing) {
+		bvh_intersect_stream_instancing(kg, rays, isects, num_rays, visibility);
+		return;
+	}
+#endif /* __INSTANCING__ */
+
+	bvh_intersect_stream(kg, rays, isects, num_rays, visibility);
+}
+#endif
+
 #ifdef __SUBSURFACE__
 ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
                                                      const Ray *ray,
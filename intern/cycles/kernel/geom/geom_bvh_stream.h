@@ -0,0 +1,212 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Common functions for ray stream traversal.
+ *
+ * Rays of a stream are identified by their bit in a mask, so a stream holds
+ * at most 32 rays. */
+
+/* Traversal stack item, a node with the rays still active for it. */
+struct BVHStreamStackItem {
+	int addr;
+	uint mask;
+};
+
+/* Ray parameters, in object space while traversing an instance. */
+struct BVHStreamRay {
+	float3 P;
+	float3 dir;
+	float3 idir;
+	IsectPrecalc isect_precalc;
+	/* bounds to intersect first, by the sign of the direction */
+	int near_x, near_y, near_z;
+#ifdef __KERNEL_SSE2__
+	sse3f org4;
+	sse3f idir4;
+#endif
+#ifdef __OBJECT_MOTION__
+	Transform ob_itfm;
+#endif
+};
+
+/* Children of a node hit by any ray of the stream, with the mask of rays
+ * hitting each child and their distances summed for ordering. */
+struct BVHStreamHits {
+#ifdef __KERNEL_SSE2__
+	ssei mask;
+	ssef num;
+	ssef dist;
+#else
+	int mask[4];
+	float num[4];
+	float dist[4];
+#endif
+};
+
+/* Precompute ray parameters after the direction changed. */
+ccl_device_inline void bvh_stream_ray_update(BVHStreamRay *sray)
+{
+	sray->idir = bvh_inverse_direction(sray->dir);
+	triangle_intersect_precalc(sray->dir, &sray->isect_precalc);
+
+	sray->near_x = (sray->idir.x >= 0.0f)? 0: 1;
+	sray->near_y = (sray->idir.y >= 0.0f)? 2: 3;
+	sray->near_z = (sray->idir.z >= 0.0f)? 4: 5;
+
+#ifdef __KERNEL_SSE2__
+	sray->org4 = sse3f(ssef(sray->P.x), ssef(sray->P.y), ssef(sray->P.z));
+	sray->idir4 = sse3f(ssef(sray->idir.x), ssef(sray->idir.y), ssef(sray->idir.z));
+#endif
+}
+
+/* Return the index of the lowest ray in the mask and remove it. */
+ccl_device_inline int bvh_stream_next_ray(uint *mask)
+{
+#ifdef __KERNEL_SSE2__
+	return (int)__bscf(*mask);
+#else
+	int i = 0;
+	while(!(*mask & (1u << i)))
+		i++;
+	*mask &= *mask - 1;
+	return i;
+#endif
+}
+
+/* Fetch the children of an inner node as four child bounding boxes, in the
+ * QBVH layout: minimum and maximum x, y and z of each child in bounds[0..5].
+ * Children of regular BVH nodes that don't exist or aren't visible get empty
+ * bounds, which are never intersected. */
+ccl_device_inline void bvh_stream_node_fetch(KernelGlobals *kg,
+                                             int nodeAddr,
+                                             const uint visibility,
+                                             float4 bounds[6],
+                                             int children[4])
+{
+#ifdef __QBVH__
+	if(kernel_data.bvh.use_qbvh) {
+		const int offset = nodeAddr*BVH_QNODE_SIZE;
+
+		for(int i = 0; i < 6; i++)
+			bounds[i] = kernel_tex_fetch(__bvh_nodes, offset+i);
+
+		float4 cnodes = kernel_tex_fetch(__bvh_nodes, offset+6);
+		children[0] = __float_as_int(cnodes.x);
+		children[1] = __float_as_int(cnodes.y);
+		children[2] = __float_as_int(cnodes.z);
+		children[3] = __float_as_int(cnodes.w);
+		return;
+	}
+#endif
+
+	const int offset = nodeAddr*BVH_NODE_SIZE;
+	float4 node0 = kernel_tex_fetch(__bvh_nodes, offset+0);
+	float4 node1 = kernel_tex_fetch(__bvh_nodes, offset+1);
+	float4 node2 = kernel_tex_fetch(__bvh_nodes, offset+2);
+	float4 cnodes = kernel_tex_fetch(__bvh_nodes, offset+3);
+
+	bounds[0] = make_float4(node0.x, node0.y, FLT_MAX, FLT_MAX);
+	bounds[1] = make_float4(node0.z, node0.w, -FLT_MAX, -FLT_MAX);
+	bounds[2] = make_float4(node1.x, node1.y, FLT_MAX, FLT_MAX);
+	bounds[3] = make_float4(node1.z, node1.w, -FLT_MAX, -FLT_MAX);
+	bounds[4] = make_float4(node2.x, node2.y, FLT_MAX, FLT_MAX);
+	bounds[5] = make_float4(node2.z, node2.w, -FLT_MAX, -FLT_MAX);
+
+#ifdef __VISIBILITY_FLAG__
+	if((__float_as_uint(cnodes.z) & visibility) == 0) {
+		bounds[0].x = FLT_MAX;
+		bounds[1].x = -FLT_MAX;
+	}
+	if((__float_as_uint(cnodes.w) & visibility) == 0) {
+		bounds[0].y = FLT_MAX;
+		bounds[1].y = -FLT_MAX;
+	}
+#endif
+
+	children[0] = __float_as_int(cnodes.x);
+	children[1] = __float_as_int(cnodes.y);
+	children[2] = 0;
+	children[3] = 0;
+}
+
+ccl_device_inline void bvh_stream_hits_init(BVHStreamHits *hits)
+{
+#ifdef __KERNEL_SSE2__
+	hits->mask = ssei(0);
+	hits->num = ssef(0.0f);
+	hits->dist = ssef(0.0f);
+#else
+	for(int i = 0; i < 4; i++) {
+		hits->mask[i] = 0;
+		hits->num[i] = 0.0f;
+		hits->dist[i] = 0.0f;
+	}
+#endif
+}
+
+/* Intersect a ray with the four children fetched above, adding it to the
+ * children it hits. Bounds are selected by the sign of the direction, so
+ * empty bounds are never hit. */
+ccl_device_inline void bvh_stream_node_intersect(const float4 bounds[6],
+                                                 const BVHStreamRay *sray,
+                                                 const float t,
+                                                 const uint ray_bit,
+                                                 BVHStreamHits *hits)
+{
+	const int near_x = sray->near_x;
+	const int near_y = sray->near_y;
+	const int near_z = sray->near_z;
+
+#ifdef __KERNEL_SSE2__
+	const sse3f& org = sray->org4;
+	const sse3f& idir = sray->idir4;
+
+	const ssef tnear_x = (load4f(bounds[near_x]) - org.x) * idir.x;
+	const ssef tnear_y = (load4f(bounds[near_y]) - org.y) * idir.y;
+	const ssef tnear_z = (load4f(bounds[near_z]) - org.z) * idir.z;
+	const ssef tfar_x = (load4f(bounds[near_x^1]) - org.x) * idir.x;
+	const ssef tfar_y = (load4f(bounds[near_y^1]) - org.y) * idir.y;
+	const ssef tfar_z = (load4f(bounds[near_z^1]) - org.z) * idir.z;
+
+	const ssef tnear = max(max(tnear_x, tnear_y), max(tnear_z, ssef(0.0f)));
+	const ssef tfar = min(min(tfar_x, tfar_y), min(tfar_z, ssef(t)));
+	const sseb hit = tnear <= tfar;
+
+	hits->mask = hits->mask | (ssei(_mm_castps_si128(hit)) & ssei(ray_bit));
+	hits->num = hits->num + select(hit, ssef(1.0f), ssef(0.0f));
+	hits->dist = hits->dist + select(hit, tnear, ssef(0.0f));
+#else
+	const float3 P = sray->P;
+	const float3 idir = sray->idir;
+
+	for(int i = 0; i < 4; i++) {
+		float tnear = max4((bounds[near_x][i] - P.x) * idir.x,
+		                   (bounds[near_y][i] - P.y) * idir.y,
+		                   (bounds[near_z][i] - P.z) * idir.z,
+		                   0.0f);
+		float tfar = min4((bounds[near_x^1][i] - P.x) * idir.x,
+		                  (bounds[near_y^1][i] - P.y) * idir.y,
+		                  (bounds[near_z^1][i] - P.z) * idir.z,
+		                  t);
+
+		if(tnear <= tfar) {
+			hits->mask[i] |= ray_bit;
+			hits->num[i] += 1.0f;
+			hits->dist[i] += tnear;
+		}
+	}
+#endif
+}
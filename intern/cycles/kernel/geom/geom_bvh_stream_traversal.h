@@ -0,0 +1,282 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* This is a template BVH traversal function for a stream of rays, where
+ * various features can be enabled/disabled, like for single rays.
+ *
+ * All rays of the stream traverse the BVH together. Each node is fetched once
+ * and intersected with the rays still active for it, and children are visited
+ * with the subset of rays that hit them, nearest first on average. For
+ * coherent rays, like camera rays of neighboring pixels, this fetches nodes
+ * and primitives once for many rays. Both the regular BVH and QBVH layouts
+ * are supported.
+ *
+ * BVH_INSTANCING: object instancing
+ * BVH_MOTION: motion blur rendering
+ *
+ */
+
+ccl_device void BVH_FUNCTION_NAME(KernelGlobals *kg,
+                                  const Ray *rays,
+                                  Intersection *isects,
+                                  const int num_rays,
+                                  const uint visibility)
+{
+	/* traversal stack */
+	BVHStreamStackItem traversalStack[BVH_QSTACK_SIZE];
+	traversalStack[0].addr = ENTRYPOINT_SENTINEL;
+	traversalStack[0].mask = 0;
+
+	/* traversal variables */
+	int stackPtr = 0;
+	int nodeAddr = kernel_data.bvh.root;
+	uint mask = 0;
+	int object = OBJECT_NONE;
+
+	/* opaque shadow rays are done at their first hit, as in bvh_intersect,
+	 * they stay in the masks on the stack but are not intersected anymore */
+	uint done = 0;
+
+	/* ray parameters */
+	BVHStreamRay stream[RAY_STREAM_SIZE];
+
+	kernel_assert(num_rays <= RAY_STREAM_SIZE);
+
+	for(int i = 0; i < num_rays; i++) {
+		const Ray *ray = &rays[i];
+		Intersection *isect = &isects[i];
+
+		isect->t = ray->t;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+
+#if defined(__KERNEL_DEBUG__)
+		isect->num_traversal_steps = 0;
+		isect->num_traversed_instances = 0;
+#endif
+
+		if(ray->t == 0.0f || !isfinite(ray->P.x))
+			continue;
+
+		stream[i].P = ray->P;
+		stream[i].dir = bvh_clamp_direction(ray->D);
+		bvh_stream_ray_update(&stream[i]);
+
+		mask |= (1u << i);
+	}
+
+	if(mask == 0)
+		return;
+
+	/* traversal loop */
+	for(;;) {
+		if(nodeAddr >= 0 && nodeAddr != ENTRYPOINT_SENTINEL) {
+			/* intersect active rays with the children of an inner node */
+			float4 bounds[6];
+			int children[4];
+
+			bvh_stream_node_fetch(kg, nodeAddr, visibility, bounds, children);
+
+			BVHStreamHits hits;
+			bvh_stream_hits_init(&hits);
+
+			uint ray_mask = mask & ~done;
+			while(ray_mask) {
+				int i = bvh_stream_next_ray(&ray_mask);
+				bvh_stream_node_intersect(bounds, &stream[i], isects[i].t, (1u << i), &hits);
+
+#if defined(__KERNEL_DEBUG__)
+				isects[i].num_traversal_steps++;
+#endif
+			}
+
+			/* sort children hit by any ray by their average distance */
+			int order[4];
+			float order_dist[4];
+			int num_children = 0;
+
+			for(int c = 0; c < 4; c++) {
+				if(hits.mask[c] == 0)
+					continue;
+
+				float d = hits.dist[c] / hits.num[c];
+				int j = num_children++;
+
+				for(; j > 0 && order_dist[j-1] > d; j--) {
+					order[j] = order[j-1];
+					order_dist[j] = order_dist[j-1];
+				}
+
+				order[j] = c;
+				order_dist[j] = d;
+			}
+
+			if(num_children == 0) {
+				/* pop */
+				nodeAddr = traversalStack[stackPtr].addr;
+				mask = traversalStack[stackPtr].mask;
+				--stackPtr;
+				continue;
+			}
+
+			/* push farther children, continue with the nearest */
+			for(int j = num_children - 1; j > 0; j--) {
+				++stackPtr;
+				kernel_assert(stackPtr < BVH_QSTACK_SIZE);
+				traversalStack[stackPtr].addr = children[order[j]];
+				traversalStack[stackPtr].mask = hits.mask[order[j]];
+			}
+
+			nodeAddr = children[order[0]];
+			mask = hits.mask[order[0]];
+		}
+		else if(nodeAddr < 0) {
+			/* if node is leaf, fetch triangle list */
+			float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-nodeAddr-1)*BVH_NODE_LEAF_SIZE);
+			int primAddr = __float_as_int(leaf.x);
+
+#ifdef __VISIBILITY_FLAG__
+			if((__float_as_uint(leaf.z) & visibility) == 0) {
+				/* pop */
+				nodeAddr = traversalStack[stackPtr].addr;
+				mask = traversalStack[stackPtr].mask;
+				--stackPtr;
+				continue;
+			}
+#endif
+
+#if BVH_FEATURE(BVH_INSTANCING)
+			if(primAddr >= 0) {
+#endif
+				const int primAddr2 = __float_as_int(leaf.y);
+				const uint type = __float_as_int(leaf.w);
+
+				/* primitive intersection, each primitive with all active rays */
+				switch(type & PRIMITIVE_ALL) {
+					case PRIMITIVE_TRIANGLE: {
+						for(; primAddr < primAddr2; primAddr++) {
+							kernel_assert(kernel_tex_fetch(__prim_type, primAddr) == type);
+
+							uint ray_mask = mask & ~done;
+							while(ray_mask) {
+								int i = bvh_stream_next_ray(&ray_mask);
+#if defined(__KERNEL_DEBUG__)
+								isects[i].num_traversal_steps++;
+#endif
+								if(triangle_intersect(kg, &stream[i].isect_precalc, &isects[i], stream[i].P, visibility, object, primAddr)) {
+									if(visibility == PATH_RAY_SHADOW_OPAQUE)
+										done |= (1u << i);
+								}
+							}
+						}
+						break;
+					}
+#if BVH_FEATURE(BVH_MOTION)
+					case PRIMITIVE_MOTION_TRIANGLE: {
+						for(; primAddr < primAddr2; primAddr++) {
+							kernel_assert(kernel_tex_fetch(__prim_type, primAddr) == type);
+
+							uint ray_mask = mask & ~done;
+							while(ray_mask) {
+								int i = bvh_stream_next_ray(&ray_mask);
+#if defined(__KERNEL_DEBUG__)
+								isects[i].num_traversal_steps++;
+#endif
+								if(motion_triangle_intersect(kg, &isects[i], stream[i].P, stream[i].dir, rays[i].time, visibility, object, primAddr)) {
+									if(visibility == PATH_RAY_SHADOW_OPAQUE)
+										done |= (1u << i);
+								}
+							}
+						}
+						break;
+					}
+#endif  /* BVH_FEATURE(BVH_MOTION) */
+				}
+
+				/* pop */
+				nodeAddr = traversalStack[stackPtr].addr;
+				mask = traversalStack[stackPtr].mask;
+				--stackPtr;
+#if BVH_FEATURE(BVH_INSTANCING)
+			}
+			else {
+				/* instance push */
+				object = kernel_tex_fetch(__prim_object, -primAddr-1);
+
+				uint ray_mask = mask;
+				while(ray_mask) {
+					int i = bvh_stream_next_ray(&ray_mask);
+					BVHStreamRay *sray = &stream[i];
+
+#if BVH_FEATURE(BVH_MOTION)
+					bvh_instance_motion_push(kg, object, &rays[i], &sray->P, &sray->dir, &sray->idir, &isects[i].t, &sray->ob_itfm);
+#else
+					bvh_instance_push(kg, object, &rays[i], &sray->P, &sray->dir, &sray->idir, &isects[i].t);
+#endif
+					bvh_stream_ray_update(sray);
+
+#if defined(__KERNEL_DEBUG__)
+					isects[i].num_traversed_instances++;
+#endif
+				}
+
+				/* the sentinel remembers which rays to pop */
+				++stackPtr;
+				kernel_assert(stackPtr < BVH_QSTACK_SIZE);
+				traversalStack[stackPtr].addr = ENTRYPOINT_SENTINEL;
+				traversalStack[stackPtr].mask = mask;
+
+				nodeAddr = kernel_tex_fetch(__object_node, object);
+			}
+#endif  /* FEATURE(BVH_INSTANCING) */
+		}
+		else {
+			/* entrypoint sentinel, traversal is done at the bottom of the stack */
+			if(stackPtr < 0)
+				break;
+
+#if BVH_FEATURE(BVH_INSTANCING)
+			kernel_assert(object != OBJECT_NONE);
+
+			/* instance pop */
+			uint ray_mask = mask;
+			while(ray_mask) {
+				int i = bvh_stream_next_ray(&ray_mask);
+				BVHStreamRay *sray = &stream[i];
+
+#if BVH_FEATURE(BVH_MOTION)
+				bvh_instance_motion_pop(kg, object, &rays[i], &sray->P, &sray->dir, &sray->idir, &isects[i].t, &sray->ob_itfm);
+#else
+				bvh_instance_pop(kg, object, &rays[i], &sray->P, &sray->dir, &sray->idir, &isects[i].t);
+#endif
+				bvh_stream_ray_update(sray);
+			}
+
+			object = OBJECT_NONE;
+#endif  /* FEATURE(BVH_INSTANCING) */
+
+			/* pop */
+			nodeAddr = traversalStack[stackPtr].addr;
+			mask = traversalStack[stackPtr].mask;
+			--stackPtr;
+		}
+	}
+}
+
+#undef BVH_FUNCTION_NAME
+#undef BVH_FUNCTION_FEATURES
@@ -40,13 +40,51 @@ enum ObjectVectorTransform {
 	OBJECT_VECTOR_MOTION_POST = 3
 };
 
+enum InstanceTransform {
+	INSTANCE_TRANSFORM = 0,
+	INSTANCE_INVERSE_TRANSFORM = 3,
+	INSTANCE_PROPERTIES = 6
+};
+
+/* Instances of instance arrays are numbered after the objects. They only have
+ * their own transform and random number, everything else is looked up from
+ * the prototype object they instance. */
+
+ccl_device_inline bool object_is_instance(KernelGlobals *kg, int object)
+{
+	return object >= kernel_data.bvh.num_objects;
+}
+
+ccl_device_inline int object_prototype(KernelGlobals *kg, int object)
+{
+	if(object == OBJECT_NONE || !object_is_instance(kg, object))
+		return object;
+
+	int offset = (object - kernel_data.bvh.num_objects)*INSTANCE_SIZE + INSTANCE_PROPERTIES;
+	float4 f = kernel_tex_fetch(__instances, offset);
+	return __float_as_int(f.x);
+}
+
 /* Object to world space transformation */
 
 ccl_device_inline Transform object_fetch_transform(KernelGlobals *kg, int object, enum ObjectTransform type)
 {
+	Transform tfm;
+
+	if(object_is_instance(kg, object)) {
+		int offset = (object - kernel_data.bvh.num_objects)*INSTANCE_SIZE;
+		offset += (type == OBJECT_INVERSE_TRANSFORM)? INSTANCE_INVERSE_TRANSFORM: INSTANCE_TRANSFORM;
+
+		tfm.x = kernel_tex_fetch(__instances, offset + 0);
+		tfm.y = kernel_tex_fetch(__instances, offset + 1);
+		tfm.z = kernel_tex_fetch(__instances, offset + 2);
+		tfm.w = make_float4(0.0f, 0.0f, 0.0f, 1.0f);
+
+		return tfm;
+	}
+
 	int offset = object*OBJECT_SIZE + (int)type;
 
-	Transform tfm;
 	tfm.x = kernel_tex_fetch(__objects, offset + 0);
 	tfm.y = kernel_tex_fetch(__objects, offset + 1);
 	tfm.z = kernel_tex_fetch(__objects, offset + 2);
@@ -59,6 +97,10 @@ ccl_device_inline Transform object_fetch_transform(KernelGlobals *kg, int object
 
 ccl_device_inline Transform object_fetch_vector_transform(KernelGlobals *kg, int object, enum ObjectVectorTransform type)
 {
+	/* instances don't move */
+	if(object_is_instance(kg, object))
+		return transform_identity();
+
 	int offset = object*OBJECT_VECTOR_SIZE + (int)type;
 
 	Transform tfm;
@@ -209,6 +251,8 @@ ccl_device_inline float3 object_location(KernelGlobals *kg, const ShaderData *sd
 
 ccl_device_inline float object_surface_area(KernelGlobals *kg, int object)
 {
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_PROPERTIES;
 	float4 f = kernel_tex_fetch(__objects, offset);
 	return f.x;
@@ -221,6 +265,8 @@ ccl_device_inline float object_pass_id(KernelGlobals *kg, int object)
 	if(object == OBJECT_NONE)
 		return 0.0f;
 
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_PROPERTIES;
 	float4 f = kernel_tex_fetch(__objects, offset);
 	return f.y;
@@ -233,6 +279,12 @@ ccl_device_inline float object_random_number(KernelGlobals *kg, int object)
 	if(object == OBJECT_NONE)
 		return 0.0f;
 
+	if(object_is_instance(kg, object)) {
+		int offset = (object - kernel_data.bvh.num_objects)*INSTANCE_SIZE + INSTANCE_PROPERTIES;
+		float4 f = kernel_tex_fetch(__instances, offset);
+		return f.y;
+	}
+
 	int offset = object*OBJECT_SIZE + OBJECT_PROPERTIES;
 	float4 f = kernel_tex_fetch(__objects, offset);
 	return f.z;
@@ -245,6 +297,8 @@ ccl_device_inline int object_particle_id(KernelGlobals *kg, int object)
 	if(object == OBJECT_NONE)
 		return 0;
 
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_PROPERTIES;
 	float4 f = kernel_tex_fetch(__objects, offset);
 	return __float_as_uint(f.w);
@@ -257,6 +311,8 @@ ccl_device_inline float3 object_dupli_generated(KernelGlobals *kg, int object)
 	if(object == OBJECT_NONE)
 		return make_float3(0.0f, 0.0f, 0.0f);
 
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_DUPLI;
 	float4 f = kernel_tex_fetch(__objects, offset);
 	return make_float3(f.x, f.y, f.z);
@@ -269,6 +325,8 @@ ccl_device_inline float3 object_dupli_uv(KernelGlobals *kg, int object)
 	if(object == OBJECT_NONE)
 		return make_float3(0.0f, 0.0f, 0.0f);
 
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_DUPLI;
 	float4 f = kernel_tex_fetch(__objects, offset + 1);
 	return make_float3(f.x, f.y, 0.0f);
@@ -278,6 +336,8 @@ ccl_device_inline float3 object_dupli_uv(KernelGlobals *kg, int object)
 
 ccl_device_inline void object_motion_info(KernelGlobals *kg, int object, int *numsteps, int *numverts, int *numkeys)
 {
+	object = object_prototype(kg, object);
+
 	int offset = object*OBJECT_SIZE + OBJECT_DUPLI;
 
 	if(numkeys) {
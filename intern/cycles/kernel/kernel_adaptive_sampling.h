@@ -0,0 +1,159 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Pixels stop being sampled once their result agrees with the result of half
+ * their samples, which is accumulated in the auxiliary pass, following
+ * "A hierarchical automatic stopping condition for Monte Carlo global
+ * illumination". The fourth component of the auxiliary pass is non-zero for
+ * converged pixels.
+ *
+ * For every sample a converged pixel skips its passes are scaled up to what
+ * they would have been with one more sample of the same mean, so the whole
+ * buffer is still normalized by a single number of samples. */
+
+ccl_device_inline bool kernel_adaptive_sampling_pass_is_scaled(KernelGlobals *kg, int i)
+{
+	int flag = kernel_data.film.pass_flag;
+
+	/* written on the first sample only */
+	if((flag & PASS_DEPTH) && i == kernel_data.film.pass_depth)
+		return false;
+	if((flag & PASS_OBJECT_ID) && i == kernel_data.film.pass_object_id)
+		return false;
+	if((flag & PASS_MATERIAL_ID) && i == kernel_data.film.pass_material_id)
+		return false;
+
+	/* convergence flag and number of actual samples */
+	if(i == kernel_data.film.pass_adaptive_aux_buffer + 3)
+		return false;
+#ifdef __DENOISING_FEATURES__
+	if((flag & PASS_DENOISING_DATA) && i == kernel_data.film.pass_denoising_data + 8)
+		return false;
+#endif
+#ifdef __KERNEL_DEBUG__
+	if((flag & PASS_SAMPLE_COUNT) && i == kernel_data.film.pass_sample_count)
+		return false;
+#endif
+
+	return true;
+}
+
+ccl_device void kernel_adaptive_sampling_scale(KernelGlobals *kg, ccl_global float *buffer, float scale)
+{
+	for(int i = 0; i < kernel_data.film.pass_stride; i++)
+		if(kernel_adaptive_sampling_pass_is_scaled(kg, i))
+			buffer[i] *= scale;
+}
+
+/* Skip the sample for converged pixels, buffer points to the pixel. */
+
+ccl_device_inline bool kernel_adaptive_sampling_skip(KernelGlobals *kg, ccl_global float *buffer, int sample)
+{
+	if(!(kernel_data.film.pass_flag & PASS_ADAPTIVE_AUX_BUFFER) || sample == 0)
+		return false;
+	if(buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] == 0.0f)
+		return false;
+
+	kernel_adaptive_sampling_scale(kg, buffer, (float)(sample + 1)/(float)sample);
+	return true;
+}
+
+/* Accumulate every other sample twice, for an estimate of the same pixel
+ * value from half the samples. */
+
+ccl_device_inline void kernel_adaptive_sampling_write_aux(KernelGlobals *kg, ccl_global float *buffer, int sample, float4 L)
+{
+	if(!(kernel_data.film.pass_flag & PASS_ADAPTIVE_AUX_BUFFER))
+		return;
+
+	if(sample == 0) {
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+		                         sample,
+		                         make_float4(0.0f, 0.0f, 0.0f, 0.0f));
+	}
+	else if(sample & 1) {
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+		                         sample,
+		                         make_float4(2.0f*L.x, 2.0f*L.y, 2.0f*L.z, 0.0f));
+	}
+}
+
+/* Mark the pixel as converged when the error of its estimate is below the
+ * threshold, after num_samples samples. Returns whether the pixel converged. */
+
+ccl_device bool kernel_adaptive_sampling_convergence_check(KernelGlobals *kg,
+	ccl_global float *buffer, int num_samples, int x, int y, int offset, int stride)
+{
+	int index = offset + x + y*stride;
+	buffer += index*kernel_data.film.pass_stride;
+
+	ccl_global float4 *aux = (ccl_global float4*)(buffer + kernel_data.film.pass_adaptive_aux_buffer);
+
+	if(aux->w != 0.0f)
+		return true;
+
+	float4 I = *((ccl_global float4*)buffer);
+	float4 A = *aux;
+
+	/* error of the pixel relative to the square root of its value, to
+	 * account for the response of the eye to noise, with a small epsilon
+	 * to avoid division by zero */
+	float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	              (num_samples*0.0001f + sqrtf(I.x + I.y + I.z));
+
+	if(error < kernel_data.integrator.adaptive_threshold*(float)num_samples) {
+		aux->w = 1.0f;
+		return true;
+	}
+
+	return false;
+}
+
+/* Unconverged pixels keep their neighbors from converging, to avoid visible
+ * seams between sampled and unsampled areas. num pixels are visited starting
+ * at the given one, delta pixels apart, so this dilates along a row or a
+ * column of the tile. */
+
+ccl_device void kernel_adaptive_sampling_dilate(KernelGlobals *kg,
+	ccl_global float *buffer, int x, int y, int delta, int num, int offset, int stride)
+{
+	int index = offset + x + y*stride;
+	int pass_stride = kernel_data.film.pass_stride;
+	int aux_w = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool prev = false;
+
+	buffer += index*pass_stride;
+
+	for(int i = 0; i < num; i++, buffer += delta*pass_stride) {
+		if(buffer[aux_w] == 0.0f) {
+			if(i > 0 && !prev)
+				buffer[aux_w - delta*pass_stride] = 0.0f;
+			prev = true;
+		}
+		else {
+			if(prev)
+				buffer[aux_w] = 0.0f;
+			prev = false;
+		}
+	}
+}
+
+CCL_NAMESPACE_END
+
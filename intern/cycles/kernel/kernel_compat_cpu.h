@@ -39,6 +39,7 @@
 #include "util_math.h"
 #include "util_simd.h"
 #include "util_half.h"
+#include "util_texture_cache.h"
 #include "util_types.h"
 
 #define ccl_addr_space
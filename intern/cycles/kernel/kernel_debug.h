@@ -45,6 +45,11 @@ ccl_device_inline void kernel_write_debug_passes(KernelGlobals *kg,
 		                        sample,
 		                        debug_data->num_ray_bounces);
 	}
+	if(flag & PASS_SAMPLE_COUNT) {
+		kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count,
+		                        sample,
+		                        1.0f);
+	}
 }
 
 CCL_NAMESPACE_END
@@ -178,9 +178,11 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 	if(!(path_flag & PATH_RAY_MIS_SKIP) && (ccl_fetch(sd, flag) & SD_USE_MIS))
 #endif
 	{
-		/* multiple importance sampling, get triangle light pdf,
-		 * and compute weight with respect to BSDF pdf */
-		float pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+		/* multiple importance sampling, get triangle light pdf from the
+		 * point the ray left, and compute weight with respect to BSDF pdf */
+		float3 P = ccl_fetch(sd, P) + ccl_fetch(sd, I)*t;
+		float pdf_area = triangle_light_area_pdf(kg, P, ccl_fetch(sd, object), ccl_fetch(sd, prim));
+		float pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t, pdf_area);
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -31,6 +31,8 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #endif
 
+class TextureCache;
+
 #define MAX_BYTE_IMAGES   1024
 #define MAX_FLOAT_IMAGES  1024
 
@@ -44,6 +46,9 @@ typedef struct KernelGlobals {
 
 	KernelData __data;
 
+	/* image textures read on demand, NULL if images are loaded in full */
+	TextureCache *texture_cache;
+
 #ifdef __OSL__
 	/* On the CPU, we also have the OSL globals here. Most data structures are shared
 	 * with SVM, the difference is in the shaders and object/mesh attributes. */
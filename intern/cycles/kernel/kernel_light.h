@@ -797,9 +797,8 @@ ccl_device void triangle_light_sample(KernelGlobals *kg, int prim, int object,
 }
 
 ccl_device float triangle_light_pdf(KernelGlobals *kg,
-	const float3 Ng, const float3 I, float t)
+	const float3 Ng, const float3 I, float t, float pdf)
 {
-	float pdf = kernel_data.integrator.pdf_triangles;
 	float cos_pi = fabsf(dot(Ng, I));
 
 	if(cos_pi == 0.0f)
@@ -810,14 +809,14 @@ ccl_device float triangle_light_pdf(KernelGlobals *kg,
 
 /* Light Distribution */
 
-ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
+ccl_device int light_distribution_sample_range(KernelGlobals *kg, float randt, int offset, int num)
 {
 	/* this is basically std::upper_bound as used by pbrt, to find a point light or
 	 * triangle to emit from, proportional to area. a good improvement would be to
 	 * also sample proportional to power, though it's not so well defined with
 	 * OSL shaders. */
-	int first = 0;
-	int len = kernel_data.integrator.num_distribution + 1;
+	int first = offset;
+	int len = num + 1;
 
 	while(len > 0) {
 		int half_len = len >> 1;
@@ -834,7 +833,153 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 
 	/* clamping should not be needed but float rounding errors seem to
 	 * make this fail on rare occasions */
-	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
+	return clamp(first-1, offset, offset+num-1);
+}
+
+ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
+{
+	return light_distribution_sample_range(kg, randt, 0, kernel_data.integrator.num_distribution);
+}
+
+/* Light Tree
+ *
+ * Mesh lights are picked by descending a tree over them, choosing the child
+ * nodes proportionally to their importance for the shading point. Lamps are
+ * picked from the distribution as before, with the same probability as mesh
+ * lights. The leaves reference ranges of triangles in the distribution, from
+ * which a triangle is picked proportionally to area. */
+
+ccl_device_inline float light_select_triangle_probability(KernelGlobals *kg)
+{
+	return (kernel_data.integrator.num_all_lights)? 0.5f: 1.0f;
+}
+
+/* Importance of a node for shading point P: the energy of the emitters below
+ * it over the squared distance, times a bound of the cosine between their
+ * normals and the direction to P. Emission is two sided, so is the bound. */
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+
+	float energy = data0.w;
+
+	if(energy == 0.0f)
+		return 0.0f;
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float3 centroid = 0.5f*(bbox_min + bbox_max);
+	float radius_sq = 0.25f*len_squared(bbox_max - bbox_min);
+	float dist_sq = len_squared(P - centroid);
+
+	/* inside the bounds, emitters can be at any distance and orientation */
+	if(dist_sq <= radius_sq)
+		return energy/radius_sq;
+
+	float3 axis = make_float3(data2.x, data2.y, data2.z);
+	float cos_theta_o = data1.w;
+
+	/* angle to the cone axis, minus the spread of the cone and the angle the
+	 * bounds subtend from P */
+	float dist = sqrtf(dist_sq);
+	float theta = safe_acosf(fabsf(dot(axis, P - centroid))/dist);
+	float theta_o = safe_acosf(cos_theta_o);
+	float theta_u = safe_asinf(sqrtf(radius_sq)/dist);
+	float theta_i = max(theta - theta_o - theta_u, 0.0f);
+
+	return energy*cosf(theta_i)/dist_sq;
+}
+
+ccl_device float light_tree_left_probability(KernelGlobals *kg, int node, float3 P)
+{
+	int right = __float_as_int(kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3).x);
+	float importance_left = light_tree_node_importance(kg, node + 1, P);
+	float importance_right = light_tree_node_importance(kg, right, P);
+	float importance = importance_left + importance_right;
+
+	/* no contribution known from either, pick them equally */
+	return (importance > 0.0f)? importance_left/importance: 0.5f;
+}
+
+/* Pick a triangle, returning its index in the distribution along with the pdf
+ * per unit area of picking a point on it. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float randt, float3 P, float *pdf)
+{
+	int node = 0;
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, LIGHT_TREE_NODE_SIZE - 1);
+
+	*pdf = 1.0f;
+
+	while(__float_as_int(data3.y) == 0) {
+		float p_left = light_tree_left_probability(kg, node, P);
+
+		/* reuse the random number for the next levels */
+		if(randt < p_left) {
+			node = node + 1;
+			randt = randt/p_left;
+			*pdf *= p_left;
+		}
+		else {
+			node = __float_as_int(data3.x);
+			randt = (randt - p_left)/(1.0f - p_left);
+			*pdf *= 1.0f - p_left;
+		}
+
+		data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	}
+
+	int first = __float_as_int(data3.x);
+	int num = __float_as_int(data3.y);
+	float cdf_first = kernel_tex_fetch(__light_distribution, first).x;
+	float cdf_last = kernel_tex_fetch(__light_distribution, first + num).x;
+
+	/* picking proportionally to area within the leaf, the pdf per unit area is
+	 * the same for all its triangles */
+	*pdf *= data3.z;
+
+	return light_distribution_sample_range(kg, cdf_first + randt*(cdf_last - cdf_first), first, num);
+}
+
+/* Pdf per unit area of picking a point on a triangle hit from P, the same as
+ * light_tree_sample gives for it. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, float3 P, int object, int prim)
+{
+	uint offset = kernel_tex_fetch(__light_tree_triangles, object*2 + 0);
+
+	/* not in the tree */
+	if(offset == 0)
+		return 0.0f;
+
+	uint tri_offset = kernel_tex_fetch(__light_tree_triangles, object*2 + 1);
+	int node = kernel_tex_fetch(__light_tree_triangles, offset + prim - tri_offset);
+	int parent = __float_as_int(kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2).w);
+	float pdf = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3).z;
+
+	/* ascend to the root, with the probability of picking each node */
+	while(parent != -1) {
+		float p_left = light_tree_left_probability(kg, parent, P);
+
+		pdf *= (node == parent + 1)? p_left: 1.0f - p_left;
+		node = parent;
+		parent = __float_as_int(kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2).w);
+	}
+
+	return pdf;
+}
+
+/* Pdf per unit area of picking a point on a mesh light, for shading point P. */
+ccl_device float triangle_light_area_pdf(KernelGlobals *kg, float3 P, int object, int prim)
+{
+	/* instance arrays are not sampled as lights */
+	if(object_is_instance(kg, object))
+		return 0.0f;
+
+	if(kernel_data.integrator.use_light_tree)
+		return light_select_triangle_probability(kg)*light_tree_triangle_pdf(kg, P, object, prim);
+
+	return kernel_data.integrator.pdf_triangles;
 }
 
 /* Generic Light */
@@ -848,7 +993,25 @@ ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, i
 ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float randv, float time, float3 P, int bounce, LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	int index;
+	float pdf_area = kernel_data.integrator.pdf_triangles;
+
+	if(kernel_data.integrator.use_light_tree) {
+		float triangle_probability = light_select_triangle_probability(kg);
+
+		if(randt < triangle_probability) {
+			index = light_tree_sample(kg, randt/triangle_probability, P, &pdf_area);
+			pdf_area *= triangle_probability;
+		}
+		else {
+			/* lamps are at the end of the distribution */
+			int num_lamps = kernel_data.integrator.num_all_lights;
+			index = light_distribution_sample_range(kg, randt,
+				kernel_data.integrator.num_distribution - num_lamps, num_lamps);
+		}
+	}
+	else
+		index = light_distribution_sample(kg, randt);
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -862,7 +1025,7 @@ ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float
 
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
+		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t, pdf_area);
 		ls->shader |= shader_flag;
 	}
 	else {
@@ -60,6 +60,47 @@ ccl_device_inline void kernel_write_pass_float4(ccl_global float *buffer, int sa
 #endif // __SPLIT_KERNEL__ && __WORK_STEALING__
 }
 
+#ifdef __DENOISING_FEATURES__
+
+/* Features guiding the denoiser, for the first non-transparent surface hit:
+ * normal and camera distance, followed by the albedo, the square of the
+ * luminance of the sample for the per-pixel variance estimate and the number
+ * of samples the pixel actually got, which differs from the number of samples
+ * of the tile with adaptive sampling. */
+
+ccl_device_inline void kernel_write_denoising_features(KernelGlobals *kg, ccl_global float *buffer,
+	ShaderData *sd, int sample)
+{
+	ccl_global float *denoising_buffer = buffer + kernel_data.film.pass_denoising_data;
+
+	float3 normal = ccl_fetch(sd, N);
+	float depth = camera_distance(kg, ccl_fetch(sd, P));
+	float3 albedo = shader_bsdf_diffuse(kg, sd) + shader_bsdf_glossy(kg, sd) +
+	                shader_bsdf_transmission(kg, sd) + shader_bsdf_subsurface(kg, sd);
+
+	albedo = min(albedo, make_float3(1.0f, 1.0f, 1.0f));
+
+	kernel_write_pass_float4(denoising_buffer, sample, make_float4(normal.x, normal.y, normal.z, depth));
+
+	/* separately, float3 writes would overwrite the luminance */
+	kernel_write_pass_float(denoising_buffer + 4, sample, albedo.x);
+	kernel_write_pass_float(denoising_buffer + 5, sample, albedo.y);
+	kernel_write_pass_float(denoising_buffer + 6, sample, albedo.z);
+}
+
+ccl_device_inline void kernel_write_denoising_variance(KernelGlobals *kg, ccl_global float *buffer,
+	int sample, float4 L)
+{
+	if(!(kernel_data.film.pass_flag & PASS_DENOISING_DATA))
+		return;
+
+	float luminance = average(float4_to_float3(L));
+	kernel_write_pass_float(buffer + kernel_data.film.pass_denoising_data + 7, sample, luminance*luminance);
+	kernel_write_pass_float(buffer + kernel_data.film.pass_denoising_data + 8, sample, 1.0f);
+}
+
+#endif  /* __DENOISING_FEATURES__ */
+
 ccl_device_inline void kernel_write_data_passes(KernelGlobals *kg, ccl_global float *buffer, PathRadiance *L,
 	ShaderData *sd, int sample, ccl_addr_space PathState *state, float3 throughput)
 {
@@ -108,6 +149,10 @@ ccl_device_inline void kernel_write_data_passes(KernelGlobals *kg, ccl_global fl
 				kernel_write_pass_float4(buffer + kernel_data.film.pass_motion, sample, speed);
 				kernel_write_pass_float(buffer + kernel_data.film.pass_motion_weight, sample, 1.0f);
 			}
+#ifdef __DENOISING_FEATURES__
+			if(flag & PASS_DENOISING_DATA)
+				kernel_write_denoising_features(kg, buffer, sd, sample);
+#endif
 
 			state->flag |= PATH_RAY_SINGLE_PASS_DONE;
 		}
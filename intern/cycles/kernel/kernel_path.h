@@ -50,6 +50,10 @@
 #include "kernel_debug.h"
 #endif
 
+#ifdef __ADAPTIVE_SAMPLING__
+#include "kernel_adaptive_sampling.h"
+#endif
+
 CCL_NAMESPACE_BEGIN
 
 ccl_device void kernel_path_indirect(KernelGlobals *kg,
@@ -588,291 +592,434 @@ ccl_device void kernel_path_subsurface_setup_indirect(
 
 #endif  /* __SUBSURFACE__ */
 
-ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, Ray ray, ccl_global float *buffer)
+/* Direct light of a path with its shadow ray not traced yet, so that the
+ * shadow rays of many paths can be intersected together as a ray stream. */
+typedef struct PathShadowRay {
+	Ray ray;
+	BsdfEval L_light;
+	float3 throughput;
+	int bounce;
+	bool is_lamp;
+	bool deferred;
+} PathShadowRay;
+
+/* Outcome of tracing a path along its ray, up to the surface it hit. */
+typedef enum PathSegmentResult {
+	PATH_SEGMENT_SURFACE,   /* surface hit that needs shading */
+	PATH_SEGMENT_CONTINUE,  /* scattered in a volume, trace the next ray */
+	PATH_SEGMENT_END,       /* path terminated */
+} PathSegmentResult;
+
+ccl_device_inline bool kernel_path_scene_intersect(KernelGlobals *kg,
+                                                   RNG *rng,
+                                                   PathState *state,
+                                                   Ray *ray,
+                                                   Intersection *isect)
 {
-	/* initialize */
-	PathRadiance L;
-	float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
-	float L_transparent = 0.0f;
-
-	path_radiance_init(&L, kernel_data.film.use_light_pass);
-
-	PathState state;
-	path_state_init(kg, &state, rng, sample, &ray);
-
-#ifdef __KERNEL_DEBUG__
-	DebugData debug_data;
-	debug_data_init(&debug_data);
-#endif
-
-#ifdef __SUBSURFACE__
-	SubsurfaceIndirectRays ss_indirect;
-	kernel_path_subsurface_init_indirect(&ss_indirect);
-
-	for(;;) {
-#endif
-
-	/* path iteration */
-	for(;;) {
-		/* intersect scene */
-		Intersection isect;
-		uint visibility = path_state_ray_visibility(kg, &state);
+	uint visibility = path_state_ray_visibility(kg, state);
 
 #ifdef __HAIR__
-		float difl = 0.0f, extmax = 0.0f;
-		uint lcg_state = 0;
-
-		if(kernel_data.bvh.have_curves) {
-			if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
-				float3 pixdiff = ray.dD.dx + ray.dD.dy;
-				/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
-				difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
-			}
-
-			extmax = kernel_data.curve.maximum_width;
-			lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
+	float difl = 0.0f, extmax = 0.0f;
+	uint lcg_state = 0;
+
+	if(kernel_data.bvh.have_curves) {
+		if((kernel_data.cam.resolution == 1) && (state->flag & PATH_RAY_CAMERA)) {	
+			float3 pixdiff = ray->dD.dx + ray->dD.dy;
+			/*pixdiff = pixdiff - dot(pixdiff, ray->D)*ray->D;*/
+			difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
 		}
 
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
-#else
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
-#endif
+		extmax = kernel_data.curve.maximum_width;
+		lcg_state = lcg_state_init(rng, state, 0x51633e2d);
+	}
 
-#ifdef __KERNEL_DEBUG__
-		if(state.flag & PATH_RAY_CAMERA) {
-			debug_data.num_bvh_traversal_steps += isect.num_traversal_steps;
-			debug_data.num_bvh_traversed_instances += isect.num_traversed_instances;
-		}
-		debug_data.num_ray_bounces++;
+	return scene_intersect(kg, ray, visibility, isect, &lcg_state, difl, extmax);
+#else
+	return scene_intersect(kg, ray, visibility, isect, NULL, 0.0f, 0.0f);
 #endif
+}
 
+/* Lamp emission, volumes and background along the ray of a path. */
+ccl_device_inline PathSegmentResult kernel_path_integrate_segment(KernelGlobals *kg,
+                                                                  RNG *rng,
+                                                                  PathState *state,
+                                                                  Ray *ray,
+                                                                  Intersection *isect,
+                                                                  bool hit,
+                                                                  PathRadiance *L,
+                                                                  float3 *throughput,
+                                                                  float *L_transparent)
+{
 #ifdef __LAMP_MIS__
-		if(kernel_data.integrator.use_lamp_mis && !(state.flag & PATH_RAY_CAMERA)) {
-			/* ray starting from previous non-transparent bounce */
-			Ray light_ray;
+	if(kernel_data.integrator.use_lamp_mis && !(state->flag & PATH_RAY_CAMERA)) {
+		/* ray starting from previous non-transparent bounce */
+		Ray light_ray;
 
-			light_ray.P = ray.P - state.ray_t*ray.D;
-			state.ray_t += isect.t;
-			light_ray.D = ray.D;
-			light_ray.t = state.ray_t;
-			light_ray.time = ray.time;
-			light_ray.dD = ray.dD;
-			light_ray.dP = ray.dP;
+		light_ray.P = ray->P - state->ray_t*ray->D;
+		state->ray_t += isect->t;
+		light_ray.D = ray->D;
+		light_ray.t = state->ray_t;
+		light_ray.time = ray->time;
+		light_ray.dD = ray->dD;
+		light_ray.dP = ray->dP;
 
-			/* intersect with lamp */
-			float3 emission;
+		/* intersect with lamp */
+		float3 emission;
 
-			if(indirect_lamp_emission(kg, &state, &light_ray, &emission))
-				path_radiance_accum_emission(&L, throughput, emission, state.bounce);
-		}
+		if(indirect_lamp_emission(kg, state, &light_ray, &emission))
+			path_radiance_accum_emission(L, *throughput, emission, state->bounce);
+	}
 #endif
 
 #ifdef __VOLUME__
-		/* volume attenuation, emission, scatter */
-		if(state.volume_stack[0].shader != SHADER_NONE) {
-			Ray volume_ray = ray;
-			volume_ray.t = (hit)? isect.t: FLT_MAX;
+	/* volume attenuation, emission, scatter */
+	if(state->volume_stack[0].shader != SHADER_NONE) {
+		Ray volume_ray = *ray;
+		volume_ray.t = (hit)? isect->t: FLT_MAX;
 
-			bool heterogeneous = volume_stack_is_heterogeneous(kg, state.volume_stack);
+		bool heterogeneous = volume_stack_is_heterogeneous(kg, state->volume_stack);
 
 #ifdef __VOLUME_DECOUPLED__
-			int sampling_method = volume_stack_sampling_method(kg, state.volume_stack);
-			bool decoupled = kernel_volume_use_decoupled(kg, heterogeneous, true, sampling_method);
+		int sampling_method = volume_stack_sampling_method(kg, state->volume_stack);
+		bool decoupled = kernel_volume_use_decoupled(kg, heterogeneous, true, sampling_method);
 
-			if(decoupled) {
-				/* cache steps along volume for repeated sampling */
-				VolumeSegment volume_segment;
-				ShaderData volume_sd;
+		if(decoupled) {
+			/* cache steps along volume for repeated sampling */
+			VolumeSegment volume_segment;
+			ShaderData volume_sd;
 
-				shader_setup_from_volume(kg, &volume_sd, &volume_ray, state.bounce, state.transparent_bounce);
-				kernel_volume_decoupled_record(kg, &state,
-					&volume_ray, &volume_sd, &volume_segment, heterogeneous);
+			shader_setup_from_volume(kg, &volume_sd, &volume_ray, state->bounce, state->transparent_bounce);
+			kernel_volume_decoupled_record(kg, state,
+				&volume_ray, &volume_sd, &volume_segment, heterogeneous);
 
-				volume_segment.sampling_method = sampling_method;
+			volume_segment.sampling_method = sampling_method;
 
-				/* emission */
-				if(volume_segment.closure_flag & SD_EMISSION)
-					path_radiance_accum_emission(&L, throughput, volume_segment.accum_emission, state.bounce);
+			/* emission */
+			if(volume_segment.closure_flag & SD_EMISSION)
+				path_radiance_accum_emission(L, *throughput, volume_segment.accum_emission, state->bounce);
 
-				/* scattering */
-				VolumeIntegrateResult result = VOLUME_PATH_ATTENUATED;
+			/* scattering */
+			VolumeIntegrateResult result = VOLUME_PATH_ATTENUATED;
 
-				if(volume_segment.closure_flag & SD_SCATTER) {
-					bool all = false;
+			if(volume_segment.closure_flag & SD_SCATTER) {
+				bool all = false;
 
-					/* direct light sampling */
-					kernel_branched_path_volume_connect_light(kg, rng, &volume_sd,
-						throughput, &state, &L, all, &volume_ray, &volume_segment);
+				/* direct light sampling */
+				kernel_branched_path_volume_connect_light(kg, rng, &volume_sd,
+					*throughput, state, L, all, &volume_ray, &volume_segment);
 
-					/* indirect sample. if we use distance sampling and take just
-					 * one sample for direct and indirect light, we could share
-					 * this computation, but makes code a bit complex */
-					float rphase = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_PHASE);
-					float rscatter = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_SCATTER_DISTANCE);
+				/* indirect sample. if we use distance sampling and take just
+				 * one sample for direct and indirect light, we could share
+				 * this computation, but makes code a bit complex */
+				float rphase = path_state_rng_1D_for_decision(kg, rng, state, PRNG_PHASE);
+				float rscatter = path_state_rng_1D_for_decision(kg, rng, state, PRNG_SCATTER_DISTANCE);
 
-					result = kernel_volume_decoupled_scatter(kg,
-						&state, &volume_ray, &volume_sd, &throughput,
-						rphase, rscatter, &volume_segment, NULL, true);
-				}
+				result = kernel_volume_decoupled_scatter(kg,
+					state, &volume_ray, &volume_sd, throughput,
+					rphase, rscatter, &volume_segment, NULL, true);
+			}
 
-				/* free cached steps */
-				kernel_volume_decoupled_free(kg, &volume_segment);
+			/* free cached steps */
+			kernel_volume_decoupled_free(kg, &volume_segment);
 
-				if(result == VOLUME_PATH_SCATTERED) {
-					if(kernel_path_volume_bounce(kg, rng, &volume_sd, &throughput, &state, &L, &ray))
-						continue;
-					else
-						break;
-				}
-				else {
-					throughput *= volume_segment.accum_transmittance;
-				}
+			if(result == VOLUME_PATH_SCATTERED) {
+				if(kernel_path_volume_bounce(kg, rng, &volume_sd, throughput, state, L, ray))
+					return PATH_SEGMENT_CONTINUE;
+				else
+					return PATH_SEGMENT_END;
 			}
-			else 
+			else {
+				*throughput *= volume_segment.accum_transmittance;
+			}
+		}
+		else 
 #endif
-			{
-				/* integrate along volume segment with distance sampling */
-				ShaderData volume_sd;
-				VolumeIntegrateResult result = kernel_volume_integrate(
-					kg, &state, &volume_sd, &volume_ray, &L, &throughput, rng, heterogeneous);
+		{
+			/* integrate along volume segment with distance sampling */
+			ShaderData volume_sd;
+			VolumeIntegrateResult result = kernel_volume_integrate(
+				kg, state, &volume_sd, &volume_ray, L, throughput, rng, heterogeneous);
 
 #ifdef __VOLUME_SCATTER__
-				if(result == VOLUME_PATH_SCATTERED) {
-					/* direct lighting */
-					kernel_path_volume_connect_light(kg, rng, &volume_sd, throughput, &state, &L);
+			if(result == VOLUME_PATH_SCATTERED) {
+				/* direct lighting */
+				kernel_path_volume_connect_light(kg, rng, &volume_sd, *throughput, state, L);
 
-					/* indirect light bounce */
-					if(kernel_path_volume_bounce(kg, rng, &volume_sd, &throughput, &state, &L, &ray))
-						continue;
-					else
-						break;
-				}
-#endif
+				/* indirect light bounce */
+				if(kernel_path_volume_bounce(kg, rng, &volume_sd, throughput, state, L, ray))
+					return PATH_SEGMENT_CONTINUE;
+				else
+					return PATH_SEGMENT_END;
 			}
+#endif
 		}
+	}
 #endif
 
-		if(!hit) {
-			/* eval background shader if nothing hit */
-			if(kernel_data.background.transparent && (state.flag & PATH_RAY_CAMERA)) {
-				L_transparent += average(throughput);
+	if(!hit) {
+		/* eval background shader if nothing hit */
+		if(kernel_data.background.transparent && (state->flag & PATH_RAY_CAMERA)) {
+			*L_transparent += average(*throughput);
 
 #ifdef __PASSES__
-				if(!(kernel_data.film.pass_flag & PASS_BACKGROUND))
+			if(!(kernel_data.film.pass_flag & PASS_BACKGROUND))
 #endif
-					break;
-			}
+				return PATH_SEGMENT_END;
+		}
 
 #ifdef __BACKGROUND__
-			/* sample background shader */
-			float3 L_background = indirect_background(kg, &state, &ray);
-			path_radiance_accum_background(&L, throughput, L_background, state.bounce);
+		/* sample background shader */
+		float3 L_background = indirect_background(kg, state, ray);
+		path_radiance_accum_background(L, *throughput, L_background, state->bounce);
 #endif
 
-			break;
-		}
+		return PATH_SEGMENT_END;
+	}
 
-		/* setup shading */
-		ShaderData sd;
-		shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce, state.transparent_bounce);
-		float rbsdf = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_BSDF);
-		shader_eval_surface(kg, &sd, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
+	return PATH_SEGMENT_SURFACE;
+}
 
-		/* holdout */
-#ifdef __HOLDOUT__
-		if((sd.flag & (SD_HOLDOUT|SD_HOLDOUT_MASK)) && (state.flag & PATH_RAY_CAMERA)) {
-			if(kernel_data.background.transparent) {
-				float3 holdout_weight;
-				
-				if(sd.flag & SD_HOLDOUT_MASK)
-					holdout_weight = make_float3(1.0f, 1.0f, 1.0f);
-				else
-					holdout_weight = shader_holdout_eval(kg, &sd);
+/* Shade the surface hit by the ray of a path, accumulate its emission and
+ * direct light, and set up the next bounce. Returns false if the path
+ * terminated. If shadow_ray is given, the shadow ray of the first bounce is
+ * left in it instead of being traced, when it can be traced as opaque. */
+ccl_device_inline bool kernel_path_integrate_surface(KernelGlobals *kg,
+                                                     RNG *rng,
+                                                     int sample,
+                                                     ccl_global float *buffer,
+                                                     ShaderData *sd,
+                                                     Intersection *isect,
+                                                     PathState *state,
+                                                     Ray *ray,
+                                                     PathRadiance *L,
+                                                     float3 *throughput,
+#ifdef __SUBSURFACE__
+                                                     SubsurfaceIndirectRays *ss_indirect,
+#endif
+                                                     float *L_transparent,
+                                                     PathShadowRay *shadow_ray)
+{
+	/* setup shading */
+	shader_setup_from_ray(kg, sd, isect, ray, state->bounce, state->transparent_bounce);
+	float rbsdf = path_state_rng_1D_for_decision(kg, rng, state, PRNG_BSDF);
+	shader_eval_surface(kg, sd, rbsdf, state->flag, SHADER_CONTEXT_MAIN);
 
-				/* any throughput is ok, should all be identical here */
-				L_transparent += average(holdout_weight*throughput);
-			}
+	/* holdout */
+#ifdef __HOLDOUT__
+	if((sd->flag & (SD_HOLDOUT|SD_HOLDOUT_MASK)) && (state->flag & PATH_RAY_CAMERA)) {
+		if(kernel_data.background.transparent) {
+			float3 holdout_weight;
+			
+			if(sd->flag & SD_HOLDOUT_MASK)
+				holdout_weight = make_float3(1.0f, 1.0f, 1.0f);
+			else
+				holdout_weight = shader_holdout_eval(kg, sd);
 
-			if(sd.flag & SD_HOLDOUT_MASK)
-				break;
+			/* any throughput is ok, should all be identical here */
+			*L_transparent += average(holdout_weight*(*throughput));
 		}
+
+		if(sd->flag & SD_HOLDOUT_MASK)
+			return false;
+	}
 #endif
 
-		/* holdout mask objects do not write data passes */
-		kernel_write_data_passes(kg, buffer, &L, &sd, sample, &state, throughput);
+	/* holdout mask objects do not write data passes */
+	kernel_write_data_passes(kg, buffer, L, sd, sample, state, *throughput);
 
-		/* blurring of bsdf after bounces, for rays that have a small likelihood
-		 * of following this particular path (diffuse, rough glossy) */
-		if(kernel_data.integrator.filter_glossy != FLT_MAX) {
-			float blur_pdf = kernel_data.integrator.filter_glossy*state.min_ray_pdf;
+	/* blurring of bsdf after bounces, for rays that have a small likelihood
+	 * of following this particular path (diffuse, rough glossy) */
+	if(kernel_data.integrator.filter_glossy != FLT_MAX) {
+		float blur_pdf = kernel_data.integrator.filter_glossy*state->min_ray_pdf;
 
-			if(blur_pdf < 1.0f) {
-				float blur_roughness = sqrtf(1.0f - blur_pdf)*0.5f;
-				shader_bsdf_blur(kg, &sd, blur_roughness);
-			}
+		if(blur_pdf < 1.0f) {
+			float blur_roughness = sqrtf(1.0f - blur_pdf)*0.5f;
+			shader_bsdf_blur(kg, sd, blur_roughness);
 		}
+	}
 
 #ifdef __EMISSION__
-		/* emission */
-		if(sd.flag & SD_EMISSION) {
-			/* todo: is isect.t wrong here for transparent surfaces? */
-			float3 emission = indirect_primitive_emission(kg, &sd, isect.t, state.flag, state.ray_pdf);
-			path_radiance_accum_emission(&L, throughput, emission, state.bounce);
-		}
+	/* emission */
+	if(sd->flag & SD_EMISSION) {
+		/* todo: is isect->t wrong here for transparent surfaces? */
+		float3 emission = indirect_primitive_emission(kg, sd, isect->t, state->flag, state->ray_pdf);
+		path_radiance_accum_emission(L, *throughput, emission, state->bounce);
+	}
 #endif
 
-		/* path termination. this is a strange place to put the termination, it's
-		 * mainly due to the mixed in MIS that we use. gives too many unneeded
-		 * shader evaluations, only need emission if we are going to terminate */
-		float probability = path_state_terminate_probability(kg, &state, throughput);
+	/* path termination. this is a strange place to put the termination, it's
+	 * mainly due to the mixed in MIS that we use. gives too many unneeded
+	 * shader evaluations, only need emission if we are going to terminate */
+	float probability = path_state_terminate_probability(kg, state, *throughput);
 
-		if(probability == 0.0f) {
-			break;
-		}
-		else if(probability != 1.0f) {
-			float terminate = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_TERMINATE);
+	if(probability == 0.0f) {
+		return false;
+	}
+	else if(probability != 1.0f) {
+		float terminate = path_state_rng_1D_for_decision(kg, rng, state, PRNG_TERMINATE);
 
-			if(terminate >= probability)
-				break;
+		if(terminate >= probability)
+			return false;
 
-			throughput /= probability;
-		}
+		*throughput /= probability;
+	}
 
 #ifdef __AO__
-		/* ambient occlusion */
-		if(kernel_data.integrator.use_ambient_occlusion || (sd.flag & SD_AO)) {
-			kernel_path_ao(kg, &sd, &L, &state, rng, throughput);
-		}
+	/* ambient occlusion */
+	if(kernel_data.integrator.use_ambient_occlusion || (sd->flag & SD_AO)) {
+		kernel_path_ao(kg, sd, L, state, rng, *throughput);
+	}
 #endif
 
 #ifdef __SUBSURFACE__
-		/* bssrdf scatter to a different location on the same object, replacing
-		 * the closures with a diffuse BSDF */
-		if(sd.flag & SD_BSSRDF) {
-			if(kernel_path_subsurface_scatter(kg,
-			                                  &sd,
-			                                  &L,
-			                                  &state,
-			                                  rng,
-			                                  &ray,
-			                                  &throughput,
-			                                  &ss_indirect))
-			{
-				break;
-			}
+	/* bssrdf scatter to a different location on the same object, replacing
+	 * the closures with a diffuse BSDF */
+	if(sd->flag & SD_BSSRDF) {
+		if(kernel_path_subsurface_scatter(kg,
+		                                  sd,
+		                                  L,
+		                                  state,
+		                                  rng,
+		                                  ray,
+		                                  throughput,
+		                                  ss_indirect))
+		{
+			return false;
 		}
+	}
 #endif  /* __SUBSURFACE__ */
 
-		/* direct lighting */
-		kernel_path_surface_connect_light(kg, rng, &sd, throughput, &state, &L);
+	/* direct lighting */
+#ifdef __RAY_STREAM__
+	if(shadow_ray && !shadow_ray->deferred && state->bounce == 0 &&
+	   !kernel_data.integrator.transparent_shadows
+#ifdef __VOLUME__
+	   && state->volume_stack[0].shader == SHADER_NONE
+#endif
+	   )
+	{
+		/* without transparent shadows or volume attenuation, the shadow ray
+		 * only needs to know if anything is hit, which the caller can find
+		 * later together with other paths */
+		shadow_ray->deferred = kernel_path_surface_light_ray(kg,
+		                                                     rng,
+		                                                     sd,
+		                                                     state,
+		                                                     &shadow_ray->ray,
+		                                                     &shadow_ray->L_light,
+		                                                     &shadow_ray->is_lamp);
+		shadow_ray->throughput = *throughput;
+		shadow_ray->bounce = state->bounce;
+	}
+	else
+#endif
+	{
+		kernel_path_surface_connect_light(kg, rng, sd, *throughput, state, L);
+	}
+
+	/* compute direct lighting and next bounce */
+	return kernel_path_surface_bounce(kg, rng, sd, throughput, state, L, ray);
+}
+
+/* Integrate the radiance along a path into L, and return the transparency of
+ * the path. The camera ray is already intersected when camera_isect is given,
+ * and the shadow ray of the first bounce may be left to the caller when
+ * shadow_ray is given, see kernel_path_integrate_surface. */
+ccl_device_inline float kernel_path_integrate_radiance(KernelGlobals *kg,
+                                                      RNG *rng,
+                                                      int sample,
+                                                      Ray ray,
+                                                      ccl_global float *buffer,
+                                                      const Intersection *camera_isect,
+                                                      PathShadowRay *shadow_ray,
+                                                      PathRadiance *L)
+{
+	/* initialize */
+	float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+	float L_transparent = 0.0f;
+
+	path_radiance_init(L, kernel_data.film.use_light_pass);
+
+	PathState state;
+	path_state_init(kg, &state, rng, sample, &ray);
+
+#ifdef __KERNEL_DEBUG__
+	DebugData debug_data;
+	debug_data_init(&debug_data);
+#endif
+
+#ifdef __SUBSURFACE__
+	SubsurfaceIndirectRays ss_indirect;
+	kernel_path_subsurface_init_indirect(&ss_indirect);
+
+	for(;;) {
+#endif
+
+	/* path iteration */
+	for(;;) {
+		/* intersect scene */
+		Intersection isect;
+		bool hit;
+
+		if(camera_isect) {
+			/* camera ray already intersected with the ray stream */
+			isect = *camera_isect;
+			camera_isect = NULL;
+			hit = (isect.prim != PRIM_NONE);
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, rng, &state, &ray, &isect);
+		}
+
+#ifdef __KERNEL_DEBUG__
+		if(state.flag & PATH_RAY_CAMERA) {
+			debug_data.num_bvh_traversal_steps += isect.num_traversal_steps;
+			debug_data.num_bvh_traversed_instances += isect.num_traversed_instances;
+		}
+		debug_data.num_ray_bounces++;
+#endif
+
+		/* lamp emission, volumes and background */
+		PathSegmentResult result = kernel_path_integrate_segment(kg,
+		                                                         rng,
+		                                                         &state,
+		                                                         &ray,
+		                                                         &isect,
+		                                                         hit,
+		                                                         L,
+		                                                         &throughput,
+		                                                         &L_transparent);
+
+		if(result == PATH_SEGMENT_CONTINUE)
+			continue;
+		else if(result == PATH_SEGMENT_END)
+			break;
 
-		/* compute direct lighting and next bounce */
-		if(!kernel_path_surface_bounce(kg, rng, &sd, &throughput, &state, &L, &ray))
+		/* surface shading, direct lighting and next bounce */
+		ShaderData sd;
+
+		if(!kernel_path_integrate_surface(kg,
+		                                  rng,
+		                                  sample,
+		                                  buffer,
+		                                  &sd,
+		                                  &isect,
+		                                  &state,
+		                                  &ray,
+		                                  L,
+		                                  &throughput,
+#ifdef __SUBSURFACE__
+		                                  &ss_indirect,
+#endif
+		                                  &L_transparent,
+		                                  shadow_ray))
+		{
 			break;
+		}
 	}
 
 #ifdef __SUBSURFACE__
-		kernel_path_subsurface_accum_indirect(&ss_indirect, &L);
+		kernel_path_subsurface_accum_indirect(&ss_indirect, L);
 
 		/* Trace indirect subsurface rays by restarting the loop. this uses less
 		 * stack memory than invoking kernel_path_indirect.
@@ -882,7 +1029,7 @@ ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample,
 			                                      &ss_indirect,
 			                                      &state,
 			                                      &ray,
-			                                      &L,
+			                                      L,
 			                                      &throughput);
 		}
 		else {
@@ -891,17 +1038,36 @@ ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample,
 	}
 #endif  /* __SUBSURFACE__ */
 
-	float3 L_sum = path_radiance_clamp_and_sum(kg, &L);
-
-	kernel_write_light_passes(kg, buffer, &L, sample);
-
 #ifdef __KERNEL_DEBUG__
 	kernel_write_debug_passes(kg, buffer, &state, &debug_data, sample);
 #endif
 
+	return L_transparent;
+}
+
+/* Write the light passes of an integrated path, and return its combined value. */
+ccl_device_inline float4 kernel_path_integrate_result(KernelGlobals *kg,
+                                                      ccl_global float *buffer,
+                                                      PathRadiance *L,
+                                                      float L_transparent,
+                                                      int sample)
+{
+	float3 L_sum = path_radiance_clamp_and_sum(kg, L);
+
+	kernel_write_light_passes(kg, buffer, L, sample);
+
 	return make_float4(L_sum.x, L_sum.y, L_sum.z, 1.0f - L_transparent);
 }
 
+ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, Ray ray, ccl_global float *buffer)
+{
+	PathRadiance L;
+	float L_transparent = kernel_path_integrate_radiance(kg, rng, sample, ray, buffer, NULL, NULL, &L);
+
+	return kernel_path_integrate_result(kg, buffer, &L, L_transparent, sample);
+}
+
+
 ccl_device void kernel_path_trace(KernelGlobals *kg,
 	ccl_global float *buffer, ccl_global uint *rng_state,
 	int sample, int x, int y, int offset, int stride)
@@ -913,6 +1079,11 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	rng_state += index;
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_sampling_skip(kg, buffer, sample))
+		return;
+#endif
+
 	/* initialize random numbers and ray */
 	RNG rng;
 	Ray ray;
@@ -930,8 +1101,137 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
 
+#ifdef __DENOISING_FEATURES__
+	kernel_write_denoising_variance(kg, buffer, sample, L);
+#endif
+
+#ifdef __ADAPTIVE_SAMPLING__
+	kernel_adaptive_sampling_write_aux(kg, buffer, sample, L);
+#endif
+
 	path_rng_end(kg, rng_state, rng);
 }
 
+#ifdef __RAY_STREAM__
+/* Path trace a block of up to RAY_STREAM_SIZE pixels, intersecting their
+ * camera rays together as a ray stream before integrating each path, and
+ * the shadow rays of their first bounce together after. */
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int w, int h, int offset, int stride)
+{
+	kernel_assert(w*h <= RAY_STREAM_SIZE);
+
+#ifdef __HAIR__
+	if(kernel_data.bvh.have_curves) {
+		/* curves need a minimum width per camera ray */
+		for(int j = y; j < y + h; j++)
+			for(int i = x; i < x + w; i++)
+				kernel_path_trace(kg, buffer, rng_state, sample, i, j, offset, stride);
+		return;
+	}
+#endif
+
+	int pass_stride = kernel_data.film.pass_stride;
+	int index[RAY_STREAM_SIZE];
+	RNG rng[RAY_STREAM_SIZE];
+	Ray ray[RAY_STREAM_SIZE];
+	Intersection isect[RAY_STREAM_SIZE];
+	PathRadiance L[RAY_STREAM_SIZE];
+	float L_transparent[RAY_STREAM_SIZE];
+	PathShadowRay shadow_ray[RAY_STREAM_SIZE];
+	int num_rays = 0;
+
+	/* initialize random numbers and rays */
+	for(int j = y; j < y + h; j++) {
+		for(int i = x; i < x + w; i++) {
+			int pixel = offset + i + j*stride;
+
+#ifdef __ADAPTIVE_SAMPLING__
+			if(kernel_adaptive_sampling_skip(kg, buffer + pixel*pass_stride, sample))
+				continue;
+#endif
+
+			kernel_path_trace_setup(kg, rng_state + pixel, sample, i, j, &rng[num_rays], &ray[num_rays]);
+			index[num_rays] = pixel;
+			num_rays++;
+		}
+	}
+
+	/* intersect camera rays, with the visibility of path_state_ray_visibility
+	 * for camera rays */
+	scene_intersect_stream(kg, ray, isect, num_rays, PATH_RAY_CAMERA|kernel_data.integrator.layer_flag);
+
+	/* integrate, leaving the shadow ray of the first bounce of each path */
+	for(int r = 0; r < num_rays; r++) {
+		shadow_ray[r].deferred = false;
+
+		if(ray[r].t != 0.0f) {
+			L_transparent[r] = kernel_path_integrate_radiance(kg,
+			                                                  &rng[r],
+			                                                  sample,
+			                                                  ray[r],
+			                                                  buffer + index[r]*pass_stride,
+			                                                  &isect[r],
+			                                                  &shadow_ray[r],
+			                                                  &L[r]);
+		}
+	}
+
+	/* intersect the shadow rays, any hit blocks the light as in shadow_blocked */
+	Ray light_ray[RAY_STREAM_SIZE];
+	int light_path[RAY_STREAM_SIZE];
+	int num_light_rays = 0;
+
+	for(int r = 0; r < num_rays; r++) {
+		if(shadow_ray[r].deferred) {
+			light_ray[num_light_rays] = shadow_ray[r].ray;
+			light_path[num_light_rays] = r;
+			num_light_rays++;
+		}
+	}
+
+	scene_intersect_stream(kg, light_ray, isect, num_light_rays, PATH_RAY_SHADOW_OPAQUE);
+
+	for(int i = 0; i < num_light_rays; i++) {
+		if(isect[i].prim == PRIM_NONE) {
+			int r = light_path[i];
+
+			/* accumulate */
+			path_radiance_accum_light(&L[r],
+			                          shadow_ray[r].throughput,
+			                          &shadow_ray[r].L_light,
+			                          make_float3(1.0f, 1.0f, 1.0f),
+			                          1.0f,
+			                          shadow_ray[r].bounce,
+			                          shadow_ray[r].is_lamp);
+		}
+	}
+
+	for(int r = 0; r < num_rays; r++) {
+		ccl_global float *pixel_buffer = buffer + index[r]*pass_stride;
+		float4 L_sum;
+
+		if(ray[r].t != 0.0f)
+			L_sum = kernel_path_integrate_result(kg, pixel_buffer, &L[r], L_transparent[r], sample);
+		else
+			L_sum = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+		/* accumulate result in output buffer */
+		kernel_write_pass_float4(pixel_buffer, sample, L_sum);
+
+#ifdef __DENOISING_FEATURES__
+		kernel_write_denoising_variance(kg, pixel_buffer, sample, L_sum);
+#endif
+
+#ifdef __ADAPTIVE_SAMPLING__
+		kernel_adaptive_sampling_write_aux(kg, pixel_buffer, sample, L_sum);
+#endif
+
+		path_rng_end(kg, rng_state + index[r], rng[r]);
+	}
+}
+#endif  /* __RAY_STREAM__ */
+
 CCL_NAMESPACE_END
 
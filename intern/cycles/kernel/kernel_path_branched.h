@@ -575,6 +575,11 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	rng_state += index;
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_sampling_skip(kg, buffer, sample))
+		return;
+#endif
+
 	/* initialize random numbers and ray */
 	RNG rng;
 	Ray ray;
@@ -592,6 +597,14 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
 
+#ifdef __DENOISING_FEATURES__
+	kernel_write_denoising_variance(kg, buffer, sample, L);
+#endif
+
+#ifdef __ADAPTIVE_SAMPLING__
+	kernel_adaptive_sampling_write_aux(kg, buffer, sample, L);
+#endif
+
 	path_rng_end(kg, rng_state, rng);
 }
 
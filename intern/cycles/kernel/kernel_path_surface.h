@@ -182,31 +182,43 @@ ccl_device bool kernel_branched_path_surface_bounce(KernelGlobals *kg, RNG *rng,
 #endif
 
 #ifndef __SPLIT_KERNEL__
-/* path tracing: connect path directly to position on a light and add it to L */
-ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg, ccl_addr_space RNG *rng,
-	ShaderData *sd, float3 throughput, ccl_addr_space PathState *state, PathRadiance *L)
+/* path tracing: sample a position on a light, returns false if there is no
+ * shadow ray to trace towards it */
+ccl_device_inline bool kernel_path_surface_light_ray(KernelGlobals *kg, ccl_addr_space RNG *rng,
+	ShaderData *sd, ccl_addr_space PathState *state, Ray *light_ray, BsdfEval *L_light, bool *is_lamp)
 {
 #ifdef __EMISSION__
 	if(!(kernel_data.integrator.use_direct_light && (ccl_fetch(sd, flag) & SD_BSDF_HAS_EVAL)))
-		return;
+		return false;
 
 	/* sample illumination from lights to find path contribution */
 	float light_t = path_state_rng_1D(kg, rng, state, PRNG_LIGHT);
 	float light_u, light_v;
 	path_state_rng_2D(kg, rng, state, PRNG_LIGHT_U, &light_u, &light_v);
 
-	Ray light_ray;
-	BsdfEval L_light;
-	bool is_lamp;
-
 #ifdef __OBJECT_MOTION__
-	light_ray.time = ccl_fetch(sd, time);
+	light_ray->time = ccl_fetch(sd, time);
 #endif
 
 	LightSample ls;
 	light_sample(kg, light_t, light_u, light_v, ccl_fetch(sd, time), ccl_fetch(sd, P), state->bounce, &ls);
 
-	if(direct_emission(kg, sd, &ls, &light_ray, &L_light, &is_lamp, state->bounce, state->transparent_bounce)) {
+	return direct_emission(kg, sd, &ls, light_ray, L_light, is_lamp, state->bounce, state->transparent_bounce);
+#else
+	return false;
+#endif
+}
+
+/* path tracing: connect path directly to position on a light and add it to L */
+ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg, ccl_addr_space RNG *rng,
+	ShaderData *sd, float3 throughput, ccl_addr_space PathState *state, PathRadiance *L)
+{
+#ifdef __EMISSION__
+	Ray light_ray;
+	BsdfEval L_light;
+	bool is_lamp;
+
+	if(kernel_path_surface_light_ray(kg, rng, sd, state, &light_ray, &L_light, &is_lamp)) {
 		/* trace shadow ray */
 		float3 shadow;
 
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Wavefront path tracing on the CPU.
+ *
+ * Like the split kernel, a pool of paths is advanced one bounce at a time,
+ * stage by stage, instead of tracing each path to the end before starting
+ * the next one. Paths that hit a surface are queued and sorted by shader
+ * before shading, so that svm_eval_nodes runs over batches of paths using
+ * the same shader nodes, textures and closures. Finished paths are replaced
+ * by paths for the next pixels, to keep the pool full.
+ *
+ * The stages are the same as the megakernel path iteration, and each path
+ * gives exactly the same result as with kernel_path_trace. */
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __WAVEFRONT__
+
+/* State of a path between stages. */
+typedef struct WavefrontPath {
+	PathRadiance L;
+	PathState state;
+	Ray ray;
+	Intersection isect;
+	float3 throughput;
+	float L_transparent;
+	RNG rng;
+	int index;  /* pixel index in the buffer */
+	bool hit;
+
+#ifdef __SUBSURFACE__
+	SubsurfaceIndirectRays ss_indirect;
+#endif
+
+#ifdef __KERNEL_DEBUG__
+	DebugData debug_data;
+#endif
+} WavefrontPath;
+
+/* Path in the shading queue, sorted by shader. */
+typedef struct WavefrontQueueItem {
+	int shader;
+	int path;
+} WavefrontQueueItem;
+
+ccl_device int wavefront_queue_compare(const void *a, const void *b)
+{
+	const WavefrontQueueItem *qa = (const WavefrontQueueItem*)a;
+	const WavefrontQueueItem *qb = (const WavefrontQueueItem*)b;
+
+	if(qa->shader != qb->shader)
+		return (qa->shader < qb->shader)? -1: 1;
+
+	/* keep paths in order for the same shader */
+	return qa->path - qb->path;
+}
+
+/* Shader of the surface hit by a ray, to sort shading work by. */
+ccl_device_inline int kernel_path_wavefront_shader(KernelGlobals *kg, const Intersection *isect)
+{
+	int prim = kernel_tex_fetch(__prim_index, isect->prim);
+
+#ifdef __HAIR__
+	if(isect->type & PRIMITIVE_ALL_CURVE) {
+		float4 curvedata = kernel_tex_fetch(__curves, prim);
+		return __float_as_int(curvedata.z) & SHADER_MASK;
+	}
+#endif
+
+	return kernel_tex_fetch(__tri_shader, prim) & SHADER_MASK;
+}
+
+/* Start a path for a pixel. Returns false if there is no path to trace,
+ * in which case the pixel is done. */
+ccl_device bool kernel_path_wavefront_start(KernelGlobals *kg,
+                                            WavefrontPath *path,
+                                            ccl_global float *buffer,
+                                            ccl_global uint *rng_state,
+                                            int sample, int x, int y, int index)
+{
+	/* initialize random numbers and ray */
+	path->index = index;
+	kernel_path_trace_setup(kg, rng_state + index, sample, x, y, &path->rng, &path->ray);
+
+	if(path->ray.t == 0.0f) {
+		ccl_global float *pixel_buffer = buffer + index*kernel_data.film.pass_stride;
+		float4 L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+		kernel_write_pass_float4(pixel_buffer, sample, L);
+
+#ifdef __DENOISING_FEATURES__
+		kernel_write_denoising_variance(kg, pixel_buffer, sample, L);
+#endif
+
+#ifdef __ADAPTIVE_SAMPLING__
+		kernel_adaptive_sampling_write_aux(kg, pixel_buffer, sample, L);
+#endif
+
+		path_rng_end(kg, rng_state + index, path->rng);
+		return false;
+	}
+
+	/* initialize path state, as in kernel_path_integrate */
+	path->throughput = make_float3(1.0f, 1.0f, 1.0f);
+	path->L_transparent = 0.0f;
+
+	path_radiance_init(&path->L, kernel_data.film.use_light_pass);
+	path_state_init(kg, &path->state, &path->rng, sample, &path->ray);
+
+#ifdef __SUBSURFACE__
+	kernel_path_subsurface_init_indirect(&path->ss_indirect);
+#endif
+
+#ifdef __KERNEL_DEBUG__
+	debug_data_init(&path->debug_data);
+#endif
+
+	return true;
+}
+
+/* End of the path iteration. Returns true if the path continues with
+ * indirect subsurface rays, otherwise the result is written to the buffer
+ * and the pixel is done. */
+ccl_device bool kernel_path_wavefront_end(KernelGlobals *kg,
+                                          WavefrontPath *path,
+                                          ccl_global float *buffer,
+                                          ccl_global uint *rng_state,
+                                          int sample)
+{
+#ifdef __SUBSURFACE__
+	kernel_path_subsurface_accum_indirect(&path->ss_indirect, &path->L);
+
+	if(path->ss_indirect.num_rays) {
+		kernel_path_subsurface_setup_indirect(kg,
+		                                      &path->ss_indirect,
+		                                      &path->state,
+		                                      &path->ray,
+		                                      &path->L,
+		                                      &path->throughput);
+		return true;
+	}
+#endif  /* __SUBSURFACE__ */
+
+	ccl_global float *pixel_buffer = buffer + path->index*kernel_data.film.pass_stride;
+
+	float3 L_sum = path_radiance_clamp_and_sum(kg, &path->L);
+
+	kernel_write_light_passes(kg, pixel_buffer, &path->L, sample);
+
+#ifdef __KERNEL_DEBUG__
+	kernel_write_debug_passes(kg, pixel_buffer, &path->state, &path->debug_data, sample);
+#endif
+
+	float4 L = make_float4(L_sum.x, L_sum.y, L_sum.z, 1.0f - path->L_transparent);
+
+	/* accumulate result in output buffer */
+	kernel_write_pass_float4(pixel_buffer, sample, L);
+
+#ifdef __DENOISING_FEATURES__
+	kernel_write_denoising_variance(kg, pixel_buffer, sample, L);
+#endif
+
+#ifdef __ADAPTIVE_SAMPLING__
+	kernel_adaptive_sampling_write_aux(kg, pixel_buffer, sample, L);
+#endif
+
+	path_rng_end(kg, rng_state + path->index, path->rng);
+
+	return false;
+}
+
+/* Size of the memory for the paths in flight and their lists, too much for
+ * the stack. It's allocated by the device once per thread, 16 byte aligned. */
+ccl_device size_t kernel_path_wavefront_state_size()
+{
+	return sizeof(WavefrontPath)*WAVEFRONT_SIZE +
+	       sizeof(WavefrontQueueItem)*WAVEFRONT_SIZE +
+	       sizeof(int)*WAVEFRONT_SIZE*3;
+}
+
+/* Path trace one sample for a block of pixels, with a pool of at most
+ * WAVEFRONT_SIZE paths in flight. */
+ccl_device void kernel_path_trace_wavefront(KernelGlobals *kg,
+	void *state, ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int w, int h, int offset, int stride)
+{
+	const int num_pixels = w*h;
+	const int pool_size = min(num_pixels, WAVEFRONT_SIZE);
+
+	WavefrontPath *paths = (WavefrontPath*)state;
+	WavefrontQueueItem *queue = (WavefrontQueueItem*)(paths + WAVEFRONT_SIZE);
+	int *path_lists = (int*)(queue + WAVEFRONT_SIZE);
+	int *active = path_lists;
+	int *next_active = path_lists + pool_size;
+	int *free_paths = path_lists + pool_size*2;
+
+	int num_active = 0;
+	int num_free = pool_size;
+	int next_pixel = 0;
+
+	for(int i = 0; i < pool_size; i++)
+		free_paths[i] = pool_size - 1 - i;
+
+	for(;;) {
+		/* start paths for the next pixels in free slots */
+		while(num_free && next_pixel < num_pixels) {
+			int px = x + next_pixel % w;
+			int py = y + next_pixel / w;
+			int index = offset + px + py*stride;
+
+			next_pixel++;
+
+#ifdef __ADAPTIVE_SAMPLING__
+			if(kernel_adaptive_sampling_skip(kg, buffer + index*kernel_data.film.pass_stride, sample))
+				continue;
+#endif
+
+			int p = free_paths[num_free - 1];
+
+			if(kernel_path_wavefront_start(kg, &paths[p], buffer, rng_state, sample, px, py, index)) {
+				active[num_active++] = p;
+				num_free--;
+			}
+		}
+
+		if(num_active == 0)
+			break;
+
+		/* intersect scene */
+		for(int i = 0; i < num_active; i++) {
+			WavefrontPath *path = &paths[active[i]];
+
+			path->hit = kernel_path_scene_intersect(kg, &path->rng, &path->state, &path->ray, &path->isect);
+
+#ifdef __KERNEL_DEBUG__
+			if(path->state.flag & PATH_RAY_CAMERA) {
+				path->debug_data.num_bvh_traversal_steps += path->isect.num_traversal_steps;
+				path->debug_data.num_bvh_traversed_instances += path->isect.num_traversed_instances;
+			}
+			path->debug_data.num_ray_bounces++;
+#endif
+		}
+
+		/* lamp emission, volumes and background, queue surface hits */
+		int num_queued = 0;
+		int num_next = 0;
+
+		for(int i = 0; i < num_active; i++) {
+			int p = active[i];
+			WavefrontPath *path = &paths[p];
+
+			PathSegmentResult result = kernel_path_integrate_segment(kg,
+			                                                         &path->rng,
+			                                                         &path->state,
+			                                                         &path->ray,
+			                                                         &path->isect,
+			                                                         path->hit,
+			                                                         &path->L,
+			                                                         &path->throughput,
+			                                                         &path->L_transparent);
+
+			if(result == PATH_SEGMENT_SURFACE) {
+				queue[num_queued].shader = kernel_path_wavefront_shader(kg, &path->isect);
+				queue[num_queued].path = p;
+				num_queued++;
+			}
+			else if(result == PATH_SEGMENT_CONTINUE ||
+			        kernel_path_wavefront_end(kg, path, buffer, rng_state, sample))
+			{
+				next_active[num_next++] = p;
+			}
+			else {
+				free_paths[num_free++] = p;
+			}
+		}
+
+		/* sort by shader, so paths evaluating the same shader are shaded together */
+		qsort(queue, num_queued, sizeof(WavefrontQueueItem), wavefront_queue_compare);
+
+		/* surface shading, direct lighting and next bounce */
+		for(int i = 0; i < num_queued; i++) {
+			int p = queue[i].path;
+			WavefrontPath *path = &paths[p];
+			ShaderData sd;
+
+			if(kernel_path_integrate_surface(kg,
+			                                 &path->rng,
+			                                 sample,
+			                                 buffer + path->index*kernel_data.film.pass_stride,
+			                                 &sd,
+			                                 &path->isect,
+			                                 &path->state,
+			                                 &path->ray,
+			                                 &path->L,
+			                                 &path->throughput,
+#ifdef __SUBSURFACE__
+			                                 &path->ss_indirect,
+#endif
+			                                 &path->L_transparent,
+			                                 NULL) ||
+			   kernel_path_wavefront_end(kg, path, buffer, rng_state, sample))
+			{
+				next_active[num_next++] = p;
+			}
+			else {
+				free_paths[num_free++] = p;
+			}
+		}
+
+		/* paths for the next bounce, in shading order */
+		int *tmp = active;
+		active = next_active;
+		next_active = tmp;
+		num_active = num_next;
+	}
+}
+
+#endif  /* __WAVEFRONT__ */
+
+CCL_NAMESPACE_END
+
@@ -36,7 +36,9 @@ CCL_NAMESPACE_BEGIN
 /* constants */
 #define OBJECT_SIZE 		11
 #define OBJECT_VECTOR_SIZE	6
+#define INSTANCE_SIZE		7
 #define LIGHT_SIZE			5
+#define LIGHT_TREE_NODE_SIZE	4
 #define FILTER_TABLE_SIZE	1024
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
@@ -57,6 +59,15 @@ CCL_NAMESPACE_BEGIN
 
 #define VOLUME_STACK_SIZE		16
 
+/* camera rays of a block of pixels traced together on the CPU, at most 32 */
+#define RAY_STREAM_WIDTH		8
+#define RAY_STREAM_HEIGHT		4
+#define RAY_STREAM_SIZE			(RAY_STREAM_WIDTH*RAY_STREAM_HEIGHT)
+
+/* paths in flight for wavefront path tracing on the CPU, 256 and 4096 paths
+ * were not faster than 1024 with 64x64 tiles */
+#define WAVEFRONT_SIZE			1024
+
 /* device capabilities */
 #ifdef __KERNEL_CPU__
 #ifdef __KERNEL_SSE2__
@@ -75,6 +86,10 @@ CCL_NAMESPACE_BEGIN
 #define __VOLUME_SCATTER__
 #define __SHADOW_RECORD_ALL__
 #define __VOLUME_RECORD_ALL__
+#define __ADAPTIVE_SAMPLING__
+#define __DENOISING_FEATURES__
+#define __RAY_STREAM__
+#define __WAVEFRONT__
 #endif
 
 #ifdef __KERNEL_CUDA__
@@ -351,10 +366,13 @@ typedef enum PassType {
 	PASS_SUBSURFACE_INDIRECT = (1 << 23),
 	PASS_SUBSURFACE_COLOR = (1 << 24),
 	PASS_LIGHT = (1 << 25), /* no real pass, used to force use_light_pass */
+	PASS_ADAPTIVE_AUX_BUFFER = (1 << 26),
+	PASS_DENOISING_DATA = (1 << 27),
 #ifdef __KERNEL_DEBUG__
-	PASS_BVH_TRAVERSAL_STEPS = (1 << 26),
-	PASS_BVH_TRAVERSED_INSTANCES = (1 << 27),
-	PASS_RAY_BOUNCES = (1 << 28),
+	PASS_BVH_TRAVERSAL_STEPS = (1 << 28),
+	PASS_BVH_TRAVERSED_INSTANCES = (1 << 29),
+	PASS_RAY_BOUNCES = (1 << 30),
+	PASS_SAMPLE_COUNT = (1u << 31),
 #endif
 } PassType;
 
@@ -896,18 +914,23 @@ typedef struct KernelFilm {
 	int pass_shadow;
 	float pass_shadow_scale;
 	int filter_table_offset;
-	int pass_pad2;
+	int pass_adaptive_aux_buffer;
 
 	int pass_mist;
 	float mist_start;
 	float mist_inv_depth;
 	float mist_falloff;
 
+	int pass_denoising_data;
+	int pass_pad1;
+	int pass_pad2;
+	int pass_pad3;
+
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversal_steps;
 	int pass_bvh_traversed_instances;
 	int pass_ray_bounces;
-	int pass_pad3;
+	int pass_sample_count;
 #endif
 } KernelFilm;
 
@@ -993,7 +1016,12 @@ typedef struct KernelIntegrator {
 	float volume_step_size;
 	int volume_samples;
 
-	int pad;
+	/* light tree */
+	int use_light_tree;
+
+	/* adaptive sampling */
+	float adaptive_threshold;
+	int pad1, pad2, pad3;
 } KernelIntegrator;
 
 typedef struct KernelBVH {
@@ -1004,7 +1032,9 @@ typedef struct KernelBVH {
 	int have_curves;
 	int have_instancing;
 	int use_qbvh;
-	int pad1, pad2;
+	/* instances of instance arrays are numbered after the objects */
+	int num_objects;
+	int pad1;
 } KernelBVH;
 
 typedef enum CurveFlag {
@@ -38,6 +38,8 @@ void kernel_const_copy(KernelGlobals *kg, const char *name, void *host, size_t s
 {
 	if(strcmp(name, "__data") == 0)
 		memcpy(&kg->__data, host, size);
+	else if(strcmp(name, "__texture_cache") == 0)
+		memcpy(&kg->texture_cache, host, size);
 	else
 		assert(0);
 }
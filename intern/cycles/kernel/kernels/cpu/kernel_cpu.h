@@ -24,6 +24,49 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
                                            int offset,
                                            int stride);
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_stream)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  unsigned int *rng_state,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int w, int h,
+                                                  int offset,
+                                                  int stride);
+
+size_t KERNEL_FUNCTION_FULL_NAME(path_trace_wavefront_state_size)();
+
+void KERNEL_FUNCTION_FULL_NAME(path_trace_wavefront)(KernelGlobals *kg,
+                                                     void *state,
+                                                     float *buffer,
+                                                     unsigned int *rng_state,
+                                                     int sample,
+                                                     int x, int y,
+                                                     int w, int h,
+                                                     int offset,
+                                                     int stride);
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_convergence_check)(KernelGlobals *kg,
+                                                           float *buffer,
+                                                           int num_samples,
+                                                           int x, int y,
+                                                           int offset,
+                                                           int stride);
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_dilate)(KernelGlobals *kg,
+                                                float *buffer,
+                                                int x, int y,
+                                                int delta,
+                                                int num,
+                                                int offset,
+                                                int stride);
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_scale)(KernelGlobals *kg,
+                                               float *buffer,
+                                               float scale,
+                                               int x, int y,
+                                               int offset,
+                                               int stride);
+
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
                                                 uchar4 *rgba,
                                                 float *buffer,
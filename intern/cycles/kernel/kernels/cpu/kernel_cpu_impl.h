@@ -27,6 +27,7 @@
 #include "kernel_film.h"
 #include "kernel_path.h"
 #include "kernel_path_branched.h"
+#include "kernel_path_wavefront.h"
 #include "kernel_bake.h"
 
 CCL_NAMESPACE_BEGIN
@@ -58,6 +59,96 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 	}
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_stream)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  unsigned int *rng_state,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int w, int h,
+                                                  int offset,
+                                                  int stride)
+{
+	kernel_path_trace_stream(kg,
+	                         buffer,
+	                         rng_state,
+	                         sample,
+	                         x, y,
+	                         w, h,
+	                         offset,
+	                         stride);
+}
+
+size_t KERNEL_FUNCTION_FULL_NAME(path_trace_wavefront_state_size)()
+{
+	return kernel_path_wavefront_state_size();
+}
+
+void KERNEL_FUNCTION_FULL_NAME(path_trace_wavefront)(KernelGlobals *kg,
+                                                     void *state,
+                                                     float *buffer,
+                                                     unsigned int *rng_state,
+                                                     int sample,
+                                                     int x, int y,
+                                                     int w, int h,
+                                                     int offset,
+                                                     int stride)
+{
+	kernel_path_trace_wavefront(kg,
+	                            state,
+	                            buffer,
+	                            rng_state,
+	                            sample,
+	                            x, y,
+	                            w, h,
+	                            offset,
+	                            stride);
+}
+
+/* Adaptive Sampling */
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_convergence_check)(KernelGlobals *kg,
+                                                           float *buffer,
+                                                           int num_samples,
+                                                           int x, int y,
+                                                           int offset,
+                                                           int stride)
+{
+	return kernel_adaptive_sampling_convergence_check(kg,
+	                                                  buffer,
+	                                                  num_samples,
+	                                                  x, y,
+	                                                  offset,
+	                                                  stride);
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_dilate)(KernelGlobals *kg,
+                                                float *buffer,
+                                                int x, int y,
+                                                int delta,
+                                                int num,
+                                                int offset,
+                                                int stride)
+{
+	kernel_adaptive_sampling_dilate(kg,
+	                                buffer,
+	                                x, y,
+	                                delta,
+	                                num,
+	                                offset,
+	                                stride);
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_scale)(KernelGlobals *kg,
+                                               float *buffer,
+                                               float scale,
+                                               int x, int y,
+                                               int offset,
+                                               int stride)
+{
+	int index = offset + x + y*stride;
+	kernel_adaptive_sampling_scale(kg, buffer + index*kernel_data.film.pass_stride, scale);
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
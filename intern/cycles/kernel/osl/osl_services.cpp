@@ -690,7 +690,7 @@ bool OSLRenderServices::get_object_standard_attribute(KernelGlobals *kg, ShaderD
 		return set_attribute_float3_3(P, type, derivatives, val);
 	}
 	else if(name == u_geom_name) {
-		ustring object_name = kg->osl->object_names[sd->object];
+		ustring object_name = kg->osl->object_names[object_prototype(kg, sd->object)];
 		return set_attribute_string(object_name, type, derivatives, val);
 	}
 	else if(name == u_is_smooth) {
@@ -791,7 +791,7 @@ bool OSLRenderServices::get_attribute(ShaderData *sd, bool derivatives, ustring
 		is_curve = false;
 	}
 	else {
-		object = sd->object;
+		object = object_prototype(kg, sd->object);
 		is_curve = (sd->type & PRIMITIVE_ALL_CURVE) != 0;
 
 		if(object == OBJECT_NONE)
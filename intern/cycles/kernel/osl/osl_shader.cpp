@@ -566,7 +566,7 @@ void OSLShader::bsdf_blur(ShaderClosure *sc, float roughness)
 int OSLShader::find_attribute(KernelGlobals *kg, const ShaderData *sd, uint id, AttributeElement *elem)
 {
 	/* for OSL, a hash map is used to lookup the attribute by name. */
-	int object = sd->object*ATTR_PRIM_TYPES;
+	int object = object_prototype(kg, sd->object)*ATTR_PRIM_TYPES;
 #ifdef __HAIR__
 	if(sd->type & PRIMITIVE_ALL_CURVE) object += ATTR_PRIM_CURVE;
 #endif
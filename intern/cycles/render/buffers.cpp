@@ -118,6 +118,8 @@ void RenderBuffers::device_free()
 		device->mem_free(rng_state);
 		rng_state.clear();
 	}
+
+	denoised.clear();
 }
 
 void RenderBuffers::reset(Device *device, BufferParams& params_)
@@ -203,6 +205,12 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 					pixels[0] = f;
 				}
 			}
+			else if(type == PASS_SAMPLE_COUNT) {
+				for(int i = 0; i < size; i++, in += pass_stride, pixels++) {
+					float f = *in;
+					pixels[0] = f;
+				}
+			}
 #endif
 			else {
 				for(int i = 0; i < size; i++, in += pass_stride, pixels++) {
@@ -315,6 +323,24 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 	return false;
 }
 
+bool RenderBuffers::get_denoised_rect(float exposure, float *pixels)
+{
+	if(denoised.empty())
+		return false;
+
+	int size = params.width*params.height;
+	const float *in = &denoised[0];
+
+	for(int i = 0; i < size; i++, in += 4, pixels += 4) {
+		pixels[0] = in[0]*exposure;
+		pixels[1] = in[1]*exposure;
+		pixels[2] = in[2]*exposure;
+		pixels[3] = saturate(in[3]);
+	}
+
+	return true;
+}
+
 /* Display Buffer */
 
 DisplayBuffer::DisplayBuffer(Device *device_, bool linear)
@@ -72,6 +72,9 @@ public:
 	device_vector<float> buffer;
 	/* random number generator state */
 	device_vector<uint> rng_state;
+	/* denoised RGBA, normalized by the number of samples, empty when the
+	 * buffers were not denoised */
+	vector<float> denoised;
 
 	RenderBuffers(Device *device);
 	~RenderBuffers();
@@ -80,6 +83,7 @@ public:
 
 	bool copy_from_device();
 	bool get_pass_rect(PassType type, float exposure, int sample, int components, float *pixels);
+	bool get_denoised_rect(float exposure, float *pixels);
 
 protected:
 	void device_free();
@@ -0,0 +1,425 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "buffers.h"
+#include "denoising.h"
+
+#include "util_foreach.h"
+#include "util_math.h"
+
+#ifdef __KERNEL_SSE2__
+#include "util_simd.h"
+#endif
+
+CCL_NAMESPACE_BEGIN
+
+/* Non-Local Means Denoising
+ *
+ * Every pixel of the tile is replaced by a weighted average of the pixels in
+ * a window around it, as in "Adaptive Rendering with Non-Local Means
+ * Filtering". The weight of a pixel depends on how much the patch around it
+ * differs from the patch around the filtered pixel, relative to the variance
+ * of both, and on how much the normal, albedo and depth of both differ, which
+ * keeps edges and texture detail that the noisy colors alone can't tell from
+ * noise.
+ *
+ * The filter loops over the offsets in the window, so for each offset the
+ * distances of all pixels are computed at once and patches are summed with
+ * a separable box filter. */
+
+#define DENOISE_PATCH_RADIUS 3
+
+/* scale of squared differences in normal, albedo and relative depth */
+#define DENOISE_NORMAL_SCALE 10.0f
+#define DENOISE_ALBEDO_SCALE 100.0f
+#define DENOISE_DEPTH_SCALE 100.0f
+
+enum DenoisePlane {
+	DENOISE_R = 0,
+	DENOISE_G,
+	DENOISE_B,
+	DENOISE_VARIANCE,
+	DENOISE_NORMAL_X,
+	DENOISE_NORMAL_Y,
+	DENOISE_NORMAL_Z,
+	DENOISE_ALBEDO_R,
+	DENOISE_ALBEDO_G,
+	DENOISE_ALBEDO_B,
+	DENOISE_DEPTH,
+	DENOISE_VALID,
+
+	DENOISE_NUM_PLANES
+};
+
+/* Planar copy of the pixels in and around a tile, with rows padded so that
+ * any four consecutive pixels can be loaded at once. Pixels outside of the
+ * image or any rendered tile are marked as not valid. */
+
+struct DenoiseImage {
+	int x, y, w, h;
+	int stride;
+	vector<float> data;
+
+	DenoiseImage(int x_, int y_, int w_, int h_)
+	: x(x_), y(y_), w(w_), h(h_)
+	{
+		stride = align_up(w + 4, 4);
+		data.resize(stride*h*DENOISE_NUM_PLANES, 0.0f);
+	}
+
+	float *plane(int p)
+	{
+		return &data[p*stride*h];
+	}
+};
+
+static int denoise_pass_offset(BufferParams& params, PassType type)
+{
+	int pass_offset = 0;
+
+	foreach(Pass& pass, params.passes) {
+		if(pass.type == type)
+			return pass_offset;
+		pass_offset += pass.components;
+	}
+
+	return -1;
+}
+
+static void denoise_gather(DenoiseImage& image, RenderBuffers *buffers, int sample)
+{
+	BufferParams& params = buffers->params;
+
+	int x0 = max(image.x, params.full_x);
+	int y0 = max(image.y, params.full_y);
+	int x1 = min(image.x + image.w, params.full_x + params.width);
+	int y1 = min(image.y + image.h, params.full_y + params.height);
+
+	int denoising_offset = denoise_pass_offset(params, PASS_DENOISING_DATA);
+
+	if(x0 >= x1 || y0 >= y1 || denoising_offset == -1)
+		return;
+
+	int pass_stride = params.get_passes_size();
+	float inv_sample = 1.0f/(float)sample;
+
+	float *planes[DENOISE_NUM_PLANES];
+	for(int p = 0; p < DENOISE_NUM_PLANES; p++)
+		planes[p] = image.plane(p);
+
+	for(int y = y0; y < y1; y++) {
+		for(int x = x0; x < x1; x++) {
+			const float *in = (float*)buffers->buffer.data_pointer +
+			                  ((y - params.full_y)*params.width + (x - params.full_x))*pass_stride;
+			const float *data = in + denoising_offset;
+			int i = (y - image.y)*image.stride + (x - image.x);
+
+			float3 color = make_float3(in[0], in[1], in[2])*inv_sample;
+			float luminance = average(color);
+
+			planes[DENOISE_R][i] = color.x;
+			planes[DENOISE_G][i] = color.y;
+			planes[DENOISE_B][i] = color.z;
+			/* Variance of the mean, from the mean of the squared luminance.
+			 * Passes of pixels adaptive sampling stopped early are scaled up
+			 * to the number of samples of the tile, but their mean only got
+			 * the samples that were actually taken. */
+			float pixel_samples = (data[8] > 0.0f)? data[8]: (float)sample;
+			planes[DENOISE_VARIANCE][i] = max(data[7]*inv_sample - luminance*luminance, 0.0f)/pixel_samples;
+			planes[DENOISE_NORMAL_X][i] = data[0]*inv_sample;
+			planes[DENOISE_NORMAL_Y][i] = data[1]*inv_sample;
+			planes[DENOISE_NORMAL_Z][i] = data[2]*inv_sample;
+			planes[DENOISE_DEPTH][i] = data[3]*inv_sample;
+			planes[DENOISE_ALBEDO_R][i] = data[4]*inv_sample;
+			planes[DENOISE_ALBEDO_G][i] = data[5]*inv_sample;
+			planes[DENOISE_ALBEDO_B][i] = data[6]*inv_sample;
+			planes[DENOISE_VALID][i] = 1.0f;
+		}
+	}
+}
+
+/* The variance estimate of a single pixel is itself noisy, average it over
+ * the valid pixels around it. */
+
+static void denoise_smooth_variance(DenoiseImage& image)
+{
+	float *variance = image.plane(DENOISE_VARIANCE);
+	float *valid = image.plane(DENOISE_VALID);
+	vector<float> smooth(image.stride*image.h, 0.0f);
+
+	for(int y = 0; y < image.h; y++) {
+		for(int x = 0; x < image.w; x++) {
+			float sum = 0.0f, num = 0.0f;
+
+			for(int j = max(y - 1, 0); j <= min(y + 1, image.h - 1); j++) {
+				for(int i = max(x - 1, 0); i <= min(x + 1, image.w - 1); i++) {
+					sum += variance[j*image.stride + i];
+					num += valid[j*image.stride + i];
+				}
+			}
+
+			smooth[y*image.stride + x] = (num > 0.0f)? sum/num: 0.0f;
+		}
+	}
+
+	memcpy(variance, &smooth[0], sizeof(float)*smooth.size());
+}
+
+#ifdef __KERNEL_SSE2__
+/* exp() of four non-positive values, see fast_exp2f() */
+static ssef denoise_exp(const ssef& x)
+{
+	ssef t = max(x*ssef(1.0f/M_LN2_F), ssef(-126.0f));
+	ssei m = truncatei(t);
+	t = t - ssef(m);
+
+	ssef r = ssef(1.33336498402e-3f);
+	r = madd(t, r, ssef(9.810352697968e-3f));
+	r = madd(t, r, ssef(5.551834031939e-2f));
+	r = madd(t, r, ssef(0.2401793301105f));
+	r = madd(t, r, ssef(0.693144857883f));
+	r = madd(t, r, ssef(1.0f));
+
+	return cast(cast(r) + (m << 23));
+}
+#endif
+
+/* Distance between the colors of pixels p and p + (dx, dy), for the pixels
+ * of the tile extended by the patch radius. */
+
+static void denoise_pixel_distance(DenoiseImage& image, int dx, int dy, int r, float k2,
+                                   float *dist, int dw, int dh, int dstride)
+{
+	const float *R = image.plane(DENOISE_R);
+	const float *G = image.plane(DENOISE_G);
+	const float *B = image.plane(DENOISE_B);
+	const float *variance = image.plane(DENOISE_VARIANCE);
+	const float *valid = image.plane(DENOISE_VALID);
+	int offset = dy*image.stride + dx;
+
+	for(int y = 0; y < dh; y++) {
+		int row = (y + r)*image.stride + r;
+
+#ifdef __KERNEL_SSE2__
+		for(int x = 0; x < dw; x += 4) {
+			int p = row + x, q = p + offset;
+
+			ssef diff = loadu4f(R + p) - loadu4f(R + q);
+			ssef d = diff*diff;
+			diff = loadu4f(G + p) - loadu4f(G + q);
+			d = madd(diff, diff, d);
+			diff = loadu4f(B + p) - loadu4f(B + q);
+			d = madd(diff, diff, d);
+
+			ssef var_p = loadu4f(variance + p), var_q = loadu4f(variance + q);
+			d = (d*ssef(1.0f/3.0f) - (var_p + min(var_p, var_q))) / madd(ssef(k2), var_p + var_q, ssef(1e-10f));
+
+			storeu4f(dist + y*dstride + x, d*loadu4f(valid + p)*loadu4f(valid + q));
+		}
+#else
+		for(int x = 0; x < dw; x++) {
+			int p = row + x, q = p + offset;
+
+			float d = (R[p] - R[q])*(R[p] - R[q]) + (G[p] - G[q])*(G[p] - G[q]) + (B[p] - B[q])*(B[p] - B[q]);
+			float var_p = variance[p], var_q = variance[q];
+			d = (d*(1.0f/3.0f) - (var_p + min(var_p, var_q))) / (1e-10f + k2*(var_p + var_q));
+
+			dist[y*dstride + x] = d*valid[p]*valid[q];
+		}
+#endif
+	}
+}
+
+/* Average of the distances over the patch around each pixel of the tile. */
+
+static void denoise_patch_distance(const float *dist, int dstride, float *tmp, float *patch,
+                                   int w, int h, int tstride)
+{
+	const int f = DENOISE_PATCH_RADIUS;
+	const float inv_area = 1.0f/((2*f + 1)*(2*f + 1));
+
+	for(int y = 0; y < h + 2*f; y++) {
+		const float *in = dist + y*dstride;
+		float sum = 0.0f;
+
+		for(int x = 0; x < 2*f; x++)
+			sum += in[x];
+
+		for(int x = 0; x < w; x++) {
+			sum += in[x + 2*f];
+			tmp[y*tstride + x] = sum;
+			sum -= in[x];
+		}
+	}
+
+	for(int x = 0; x < w; x++) {
+		float sum = 0.0f;
+
+		for(int y = 0; y < 2*f; y++)
+			sum += tmp[y*tstride + x];
+
+		for(int y = 0; y < h; y++) {
+			sum += tmp[(y + 2*f)*tstride + x];
+			patch[y*tstride + x] = sum*inv_area;
+			sum -= tmp[y*tstride + x];
+		}
+	}
+}
+
+/* Add pixels p + (dx, dy) to the filtered pixels p of the tile. */
+
+static void denoise_accumulate(DenoiseImage& image, int dx, int dy, int r, float inv_feature_strength2,
+                               const float *patch, float *accum, int w, int h, int tstride)
+{
+	const int f = DENOISE_PATCH_RADIUS;
+	const float *planes[DENOISE_NUM_PLANES];
+	for(int i = 0; i < DENOISE_NUM_PLANES; i++)
+		planes[i] = image.plane(i);
+
+	float *accum_r = accum;
+	float *accum_g = accum + tstride*h;
+	float *accum_b = accum + 2*tstride*h;
+	float *accum_w = accum + 3*tstride*h;
+	int offset = dy*image.stride + dx;
+
+	for(int y = 0; y < h; y++) {
+		int row = (y + r + f)*image.stride + r + f;
+
+#ifdef __KERNEL_SSE2__
+		for(int x = 0; x < w; x += 4) {
+			int p = row + x, q = p + offset;
+			int i = y*tstride + x;
+
+			ssef diff = loadu4f(planes[DENOISE_NORMAL_X] + p) - loadu4f(planes[DENOISE_NORMAL_X] + q);
+			ssef dn = diff*diff;
+			diff = loadu4f(planes[DENOISE_NORMAL_Y] + p) - loadu4f(planes[DENOISE_NORMAL_Y] + q);
+			dn = madd(diff, diff, dn);
+			diff = loadu4f(planes[DENOISE_NORMAL_Z] + p) - loadu4f(planes[DENOISE_NORMAL_Z] + q);
+			dn = madd(diff, diff, dn);
+
+			diff = loadu4f(planes[DENOISE_ALBEDO_R] + p) - loadu4f(planes[DENOISE_ALBEDO_R] + q);
+			ssef da = diff*diff;
+			diff = loadu4f(planes[DENOISE_ALBEDO_G] + p) - loadu4f(planes[DENOISE_ALBEDO_G] + q);
+			da = madd(diff, diff, da);
+			diff = loadu4f(planes[DENOISE_ALBEDO_B] + p) - loadu4f(planes[DENOISE_ALBEDO_B] + q);
+			da = madd(diff, diff, da);
+
+			ssef depth_p = loadu4f(planes[DENOISE_DEPTH] + p);
+			diff = depth_p - loadu4f(planes[DENOISE_DEPTH] + q);
+			ssef dd = diff*diff / madd(depth_p, depth_p, ssef(1e-6f));
+
+			ssef df = madd(dn, ssef(DENOISE_NORMAL_SCALE), madd(da, ssef(DENOISE_ALBEDO_SCALE), dd*ssef(DENOISE_DEPTH_SCALE)));
+			df = df*ssef(inv_feature_strength2);
+
+			/* minimum of the color and feature weights */
+			ssef weight = denoise_exp(-max(max(loadu4f(patch + i), df), ssef(0.0f)));
+			weight = weight*loadu4f(planes[DENOISE_VALID] + q);
+
+			storeu4f(accum_r + i, madd(weight, loadu4f(planes[DENOISE_R] + q), loadu4f(accum_r + i)));
+			storeu4f(accum_g + i, madd(weight, loadu4f(planes[DENOISE_G] + q), loadu4f(accum_g + i)));
+			storeu4f(accum_b + i, madd(weight, loadu4f(planes[DENOISE_B] + q), loadu4f(accum_b + i)));
+			storeu4f(accum_w + i, loadu4f(accum_w + i) + weight);
+		}
+#else
+		for(int x = 0; x < w; x++) {
+			int p = row + x, q = p + offset;
+			int i = y*tstride + x;
+
+			float3 normal_p = make_float3(planes[DENOISE_NORMAL_X][p], planes[DENOISE_NORMAL_Y][p], planes[DENOISE_NORMAL_Z][p]);
+			float3 normal_q = make_float3(planes[DENOISE_NORMAL_X][q], planes[DENOISE_NORMAL_Y][q], planes[DENOISE_NORMAL_Z][q]);
+			float3 albedo_p = make_float3(planes[DENOISE_ALBEDO_R][p], planes[DENOISE_ALBEDO_G][p], planes[DENOISE_ALBEDO_B][p]);
+			float3 albedo_q = make_float3(planes[DENOISE_ALBEDO_R][q], planes[DENOISE_ALBEDO_G][q], planes[DENOISE_ALBEDO_B][q]);
+			float depth_p = planes[DENOISE_DEPTH][p];
+			float depth_diff = depth_p - planes[DENOISE_DEPTH][q];
+
+			float df = len_squared(normal_p - normal_q)*DENOISE_NORMAL_SCALE +
+			           len_squared(albedo_p - albedo_q)*DENOISE_ALBEDO_SCALE +
+			           depth_diff*depth_diff/(depth_p*depth_p + 1e-6f)*DENOISE_DEPTH_SCALE;
+			df *= inv_feature_strength2;
+
+			/* minimum of the color and feature weights */
+			float weight = expf(-max(max(patch[i], df), 0.0f));
+			weight *= planes[DENOISE_VALID][q];
+
+			accum_r[i] += weight*planes[DENOISE_R][q];
+			accum_g[i] += weight*planes[DENOISE_G][q];
+			accum_b[i] += weight*planes[DENOISE_B][q];
+			accum_w[i] += weight;
+		}
+#endif
+	}
+}
+
+void denoise_buffers(const DenoiseParams& params, RenderBuffers *buffers,
+                     const vector<RenderBuffers*>& neighbors, int sample)
+{
+	const int f = DENOISE_PATCH_RADIUS;
+	int r = max(params.radius, 0);
+	int w = buffers->params.width;
+	int h = buffers->params.height;
+
+	/* copy the tile and enough pixels around it for all patches in the window */
+	DenoiseImage image(buffers->params.full_x - r - f, buffers->params.full_y - r - f,
+	                   w + 2*(r + f), h + 2*(r + f));
+
+	foreach(RenderBuffers *neighbor, neighbors)
+		denoise_gather(image, neighbor, sample);
+
+	denoise_smooth_variance(image);
+
+	int dw = w + 2*f, dh = h + 2*f;
+	int dstride = align_up(dw, 4);
+	int tstride = align_up(w, 4);
+
+	vector<float> dist(dstride*dh, 0.0f);
+	vector<float> tmp(tstride*dh, 0.0f);
+	vector<float> patch(tstride*h, 0.0f);
+	vector<float> accum(4*tstride*h, 0.0f);
+
+	float k2 = params.strength*params.strength;
+	float inv_feature_strength2 = 1.0f/max(params.feature_strength*params.feature_strength, 1e-6f);
+
+	for(int dy = -r; dy <= r; dy++) {
+		for(int dx = -r; dx <= r; dx++) {
+			denoise_pixel_distance(image, dx, dy, r, k2, &dist[0], dw, dh, dstride);
+			denoise_patch_distance(&dist[0], dstride, &tmp[0], &patch[0], w, h, tstride);
+			denoise_accumulate(image, dx, dy, r, inv_feature_strength2, &patch[0], &accum[0], w, h, tstride);
+		}
+	}
+
+	/* normalize, alpha is not filtered */
+	int pass_stride = buffers->params.get_passes_size();
+	const float *in = (float*)buffers->buffer.data_pointer;
+	float inv_sample = 1.0f/(float)sample;
+
+	buffers->denoised.resize(w*h*4);
+
+	for(int y = 0; y < h; y++) {
+		for(int x = 0; x < w; x++) {
+			int i = y*tstride + x;
+			float *out = &buffers->denoised[(y*w + x)*4];
+			float inv_weight = 1.0f/accum[3*tstride*h + i];
+
+			out[0] = accum[i]*inv_weight;
+			out[1] = accum[tstride*h + i]*inv_weight;
+			out[2] = accum[2*tstride*h + i]*inv_weight;
+			out[3] = in[(y*w + x)*pass_stride + 3]*inv_sample;
+		}
+	}
+}
+
+CCL_NAMESPACE_END
+
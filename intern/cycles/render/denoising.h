@@ -0,0 +1,65 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DENOISING_H__
+#define __DENOISING_H__
+
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class RenderBuffers;
+
+/* Denoising Parameters */
+
+class DenoiseParams {
+public:
+	/* radius of the window searched for similar pixels */
+	int radius;
+	/* how different the colors of pixels can be relative to their variance,
+	 * higher values remove more noise and more detail */
+	float strength;
+	/* how different the normal, albedo and depth of pixels can be */
+	float feature_strength;
+
+	DenoiseParams()
+	{
+		radius = 8;
+		strength = 0.5f;
+		feature_strength = 1.0f;
+	}
+
+	bool modified(const DenoiseParams& params) const
+	{ return !(radius == params.radius
+		&& strength == params.strength
+		&& feature_strength == params.feature_strength); }
+};
+
+/* Denoise the combined pass of a tile with non-local means filtering, guided
+ * by the PASS_DENOISING_DATA features. Pixels around the tile are read from
+ * the neighbors, which may include the tile itself, so tiles are filtered
+ * without seams between them. All buffers must be rendered with the same
+ * number of samples and copied from the device. The result is stored in
+ * buffers->denoised. */
+
+void denoise_buffers(const DenoiseParams& params, RenderBuffers *buffers,
+                     const vector<RenderBuffers*>& neighbors, int sample);
+
+CCL_NAMESPACE_END
+
+#endif /* __DENOISING_H__ */
+
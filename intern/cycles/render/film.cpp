@@ -34,6 +34,9 @@ CCL_NAMESPACE_BEGIN
 
 static bool compare_pass_order(const Pass& a, const Pass& b)
 {
+	/* the kernel writes the combined pass at the start of each pixel */
+	if(a.type == PASS_COMBINED || b.type == PASS_COMBINED)
+		return (a.type == PASS_COMBINED && b.type != PASS_COMBINED);
 	if(a.components == b.components)
 		return (a.type < b.type);
 	return (a.components > b.components);
@@ -153,6 +156,12 @@ void Pass::add(PassType type, vector<Pass>& passes)
 			 */
 			pass.components = 0;
 			break;
+		case PASS_ADAPTIVE_AUX_BUFFER:
+			pass.components = 4;
+			break;
+		case PASS_DENOISING_DATA:
+			pass.components = 9;
+			break;
 #ifdef WITH_CYCLES_DEBUG
 		case PASS_BVH_TRAVERSAL_STEPS:
 			pass.components = 1;
@@ -166,6 +175,10 @@ void Pass::add(PassType type, vector<Pass>& passes)
 			pass.components = 1;
 			pass.exposure = false;
 			break;
+		case PASS_SAMPLE_COUNT:
+			pass.components = 1;
+			pass.exposure = false;
+			break;
 #endif
 	}
 
@@ -404,6 +417,14 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 				kfilm->use_light_pass = 1;
 				break;
 
+			case PASS_ADAPTIVE_AUX_BUFFER:
+				kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+				break;
+
+			case PASS_DENOISING_DATA:
+				kfilm->pass_denoising_data = kfilm->pass_stride;
+				break;
+
 #ifdef WITH_CYCLES_DEBUG
 			case PASS_BVH_TRAVERSAL_STEPS:
 				kfilm->pass_bvh_traversal_steps = kfilm->pass_stride;
@@ -414,6 +435,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 			case PASS_RAY_BOUNCES:
 				kfilm->pass_ray_bounces = kfilm->pass_stride;
 				break;
+			case PASS_SAMPLE_COUNT:
+				kfilm->pass_sample_count = kfilm->pass_stride;
+				break;
 #endif
 
 			case PASS_NONE:
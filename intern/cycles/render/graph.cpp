@@ -16,7 +16,9 @@
 
 #include "attribute.h"
 #include "graph.h"
+#include "image.h"
 #include "nodes.h"
+#include "scene.h"
 #include "shader.h"
 
 #include "util_algorithm.h"
@@ -308,7 +310,8 @@ void ShaderGraph::relink(vector<ShaderInput*> inputs, vector<ShaderInput*> outpu
 void ShaderGraph::finalize(Scene *scene,
                            bool do_bump,
                            bool do_osl,
-                           bool do_simplify)
+                           bool do_simplify,
+                           bool do_optimize)
 {
 	/* before compiling, the shader graph may undergo a number of modifications.
 	 * currently we set default geometry shader inputs, and create automatic bump
@@ -316,13 +319,17 @@ void ShaderGraph::finalize(Scene *scene,
 	 * modified afterwards. */
 
 	if(!finalized) {
-		clean(scene);
+		clean(scene, do_optimize);
 		default_inputs(do_osl);
 		refine_bump_nodes();
 
 		if(do_bump)
 			bump_from_displacement();
 
+		/* mip level selection needs ray differentials of texture coordinates */
+		if(!do_osl && scene->image_manager->get_texture_cache())
+			refine_image_derivatives();
+
 		ShaderInput *surface_in = output()->input("Surface");
 		ShaderInput *volume_in = output()->input("Volume");
 
@@ -648,8 +655,12 @@ void ShaderGraph::constant_fold()
 					scheduled.insert(input->parent);
 				}
 			}
+			if(output->links.empty()) {
+				continue;
+			}
 			/* Optimize current node. */
 			float3 optimized_value = make_float3(0.0f, 0.0f, 0.0f);
+			ShaderInput *bypass_input;
 			if(node->constant_fold(output, &optimized_value)) {
 				/* Apply optimized value to connected sockets. */
 				vector<ShaderInput*> links(output->links);
@@ -659,6 +670,20 @@ void ShaderGraph::constant_fold()
 					disconnect(input);
 				}
 			}
+			else if((bypass_input = node->bypass_input(output)) != NULL) {
+				assert(bypass_input->type == output->type);
+				/* Pass the input link or value on to connected sockets.
+				 * The node is removed later if none of its outputs is used.
+				 */
+				vector<ShaderInput*> links(output->links);
+				foreach(ShaderInput *input, links) {
+					disconnect(input);
+					if(bypass_input->link)
+						connect(bypass_input->link, input);
+					else
+						input->value = bypass_input->value;
+				}
+			}
 		}
 	}
 }
@@ -683,8 +708,8 @@ void ShaderGraph::deduplicate_nodes()
 	 *   already deduplicated.
 	 */
 
-	ShaderNodeSet scheduled;
-	map<ustring, ShaderNodeSet> done;
+	ShaderNodeSet scheduled, done;
+	map<ustring, ShaderNodeSet> candidates;
 	queue<ShaderNode*> traverse_queue;
 
 	/* Schedule nodes which doesn't have any dependencies. */
@@ -698,10 +723,12 @@ void ShaderGraph::deduplicate_nodes()
 	while(!traverse_queue.empty()) {
 		ShaderNode *node = traverse_queue.front();
 		traverse_queue.pop();
-		done[node->name].insert(node);
+		done.insert(node);
 		/* Schedule the nodes which were depending on the current node. */
+		bool has_output_links = false;
 		foreach(ShaderOutput *output, node->outputs) {
 			foreach(ShaderInput *input, output->links) {
+				has_output_links = true;
 				if(scheduled.find(input->parent) != scheduled.end()) {
 					/* Node might not be optimized yet but scheduled already
 					 * by other dependencies. No need to re-schedule it.
@@ -709,22 +736,19 @@ void ShaderGraph::deduplicate_nodes()
 					continue;
 				}
 				/* Schedule node if its inputs are fully done. */
-				if(check_node_inputs_traversed(input->parent, done[input->parent->name])) {
+				if(check_node_inputs_traversed(input->parent, done)) {
 					traverse_queue.push(input->parent);
 					scheduled.insert(input->parent);
 				}
 			}
 		}
+		if(!has_output_links) {
+			/* Nothing to relink, node is removed as unused anyway. */
+			continue;
+		}
 		/* Try to merge this node with another one. */
-		foreach(ShaderNode *other_node, done[node->name]) {
-			if(node == other_node) {
-				/* Don't merge with self. */
-				continue;
-			}
-			if(node->name != other_node->name) {
-				/* Can only de-duplicate nodes of the same type. */
-				continue;
-			}
+		ShaderNode *merge_with = NULL;
+		foreach(ShaderNode *other_node, candidates[node->name]) {
 			if(!check_node_inputs_equals(node, other_node)) {
 				/* Node inputs are different, can't merge them, */
 				continue;
@@ -733,12 +757,20 @@ void ShaderGraph::deduplicate_nodes()
 				/* Node settings are different. */
 				continue;
 			}
-			/* TODO(sergey): Consider making it an utility function. */
+			merge_with = other_node;
+			break;
+		}
+		if(merge_with != NULL) {
+			/* Users of this node now link to the other one, so identical
+			 * nodes depending on both of them get merged in turn.
+			 */
 			for(int i = 0; i < node->outputs.size(); ++i) {
 				vector<ShaderInput*> inputs = node->outputs[i]->links;
-				relink(node->inputs, inputs, other_node->outputs[i]);
+				relink(node->inputs, inputs, merge_with->outputs[i]);
 			}
-			break;
+		}
+		else {
+			candidates[node->name].insert(node);
 		}
 	}
 }
@@ -767,26 +799,31 @@ void ShaderGraph::break_cycles(ShaderNode *node, vector<bool>& visited, vector<b
 	on_stack[node->id] = false;
 }
 
-void ShaderGraph::clean(Scene *scene)
+void ShaderGraph::clean(Scene *scene, bool do_optimize)
 {
 	/* Graph simplification:
 	 *  1: Remove unnecessary nodes
 	 *  2: Constant folding
 	 *  3: Simplification
 	 *  4: De-duplication
+	 *
+	 * Constant folding and de-duplication are skipped without do_optimize,
+	 * to compare against the optimized graph in compiler statistics.
 	 */
 
 	/* 1: Remove proxy and unnecessary nodes. */
 	remove_unneeded_nodes();
 
 	/* 2: Constant folding. */
-	constant_fold();
+	if(do_optimize)
+		constant_fold();
 
 	/* 3: Simplification. */
 	simplify_settings(scene);
 
 	/* 4: De-duplication. */
-	deduplicate_nodes();
+	if(do_optimize)
+		deduplicate_nodes();
 
 	/* we do two things here: find cycles and break them, and remove unused
 	 * nodes that don't feed into the output. how cycles are broken is
@@ -937,6 +974,57 @@ void ShaderGraph::refine_bump_nodes()
 	}
 }
 
+void ShaderGraph::refine_image_derivatives()
+{
+	/* like for bump nodes, we copy the sub-graph defined from the image texture
+	 * "Vector" input twice, shifted by dx and dy, and connect the copies to
+	 * "VectorDX" and "VectorDY", from which the texture cache estimates the
+	 * size of the lookup footprint. Nodes that are already bump samples are
+	 * left alone. */
+
+	vector<ShaderNode*> image_nodes;
+
+	foreach(ShaderNode *node, nodes) {
+		if(node->name == ustring("image_texture") &&
+		   ((ImageTextureNode*)node)->projection == "Flat" &&
+		   (node->bump == SHADER_BUMP_NONE || node->bump == SHADER_BUMP_CENTER) &&
+		   node->input("Vector")->link)
+		{
+			image_nodes.push_back(node);
+		}
+	}
+
+	foreach(ShaderNode *node, image_nodes) {
+		ShaderInput *vector_input = node->input("Vector");
+		ShaderNodeSet nodes_vector;
+
+		ShaderNodeMap nodes_dx;
+		ShaderNodeMap nodes_dy;
+
+		find_dependencies(nodes_vector, vector_input);
+
+		copy_nodes(nodes_vector, nodes_dx);
+		copy_nodes(nodes_vector, nodes_dy);
+
+		foreach(NodePair& pair, nodes_dx)
+			pair.second->bump = SHADER_BUMP_DX;
+		foreach(NodePair& pair, nodes_dy)
+			pair.second->bump = SHADER_BUMP_DY;
+
+		ShaderOutput *out = vector_input->link;
+		ShaderOutput *out_dx = nodes_dx[out->parent]->output(out->name);
+		ShaderOutput *out_dy = nodes_dy[out->parent]->output(out->name);
+
+		connect(out_dx, node->input("VectorDX"));
+		connect(out_dy, node->input("VectorDY"));
+
+		foreach(NodePair& pair, nodes_dx)
+			add(pair.second);
+		foreach(NodePair& pair, nodes_dy)
+			add(pair.second);
+	}
+}
+
 void ShaderGraph::bump_from_displacement()
 {
 	/* generate bump mapping automatically from displacement. bump mapping is
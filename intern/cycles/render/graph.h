@@ -199,6 +199,12 @@ public:
 	/* Check whether the node can be replaced with single constant. */
 	virtual bool constant_fold(ShaderOutput * /*socket*/, float3 * /*optimized_value*/) { return false; }
 
+	/* Check whether the output passes one of the inputs through unchanged,
+	 * in which case the node can be bypassed. The returned input must have
+	 * the same type as the output.
+	 */
+	virtual ShaderInput *bypass_input(ShaderOutput * /*socket*/) { return NULL; }
+
 	/* Simplify settings used by artists to the ones which are simpler to
 	 * evaluate in the kernel but keep the final result unchanged.
 	 */
@@ -313,7 +319,8 @@ public:
 	void finalize(Scene *scene,
 	              bool do_bump = false,
 	              bool do_osl = false,
-	              bool do_simplify = false);
+	              bool do_simplify = false,
+	              bool do_optimize = true);
 
 	int get_num_closures();
 
@@ -329,11 +336,12 @@ protected:
 	void break_cycles(ShaderNode *node, vector<bool>& visited, vector<bool>& on_stack);
 	void bump_from_displacement();
 	void refine_bump_nodes();
+	void refine_image_derivatives();
 	void default_inputs(bool do_osl);
 	void transform_multi_closure(ShaderNode *node, ShaderOutput *weight_out, bool volume);
 
 	/* Graph simplification routines. */
-	void clean(Scene *scene);
+	void clean(Scene *scene, bool do_optimize);
 	void constant_fold();
 	void simplify_settings(Scene *scene);
 	void deduplicate_nodes();
@@ -20,8 +20,10 @@
 
 #include "util_foreach.h"
 #include "util_image.h"
+#include "util_logging.h"
 #include "util_path.h"
 #include "util_progress.h"
+#include "util_texture_cache.h"
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -34,6 +36,7 @@ ImageManager::ImageManager()
 	need_update = true;
 	pack_images = false;
 	osl_texture_system = NULL;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	tex_num_images = TEX_NUM_IMAGES;
@@ -47,6 +50,8 @@ ImageManager::~ImageManager()
 		assert(!images[slot]);
 	for(size_t slot = 0; slot < float_images.size(); slot++)
 		assert(!float_images[slot]);
+
+	delete texture_cache;
 }
 
 void ImageManager::set_pack_images(bool pack_images_)
@@ -59,6 +64,12 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(size_t max_memory)
+{
+	delete texture_cache;
+	texture_cache = new TextureCache(max_memory);
+}
+
 void ImageManager::set_extended_image_limits(const DeviceInfo& info)
 {
 	if(info.type == DEVICE_CPU) {
@@ -691,6 +702,23 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 	if(osl_texture_system && !img->builtin_data)
 		return;
 
+	/* read from file on demand while rendering, falling back to loading the
+	 * whole image if the cache can't read it */
+	if(texture_cache && !img->builtin_data) {
+		thread_scoped_lock device_lock(device_mutex);
+
+		if(texture_cache->add_image(slot,
+		                            img->filename,
+		                            is_float,
+		                            img->use_alpha,
+		                            img->interpolation,
+		                            img->extension))
+		{
+			img->need_load = false;
+			return;
+		}
+	}
+
 	if(is_float) {
 		string filename = path_filename(float_images[slot]->filename);
 		progress->set_status("Updating Images", "Loading " + filename);
@@ -780,6 +808,11 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 	}
 
 	if(img) {
+		if(texture_cache) {
+			thread_scoped_lock device_lock(device_mutex);
+			texture_cache->remove_image(slot);
+		}
+
 		if(osl_texture_system && !img->builtin_data) {
 #ifdef WITH_OSL
 			ustring filename(images[slot]->filename);
@@ -853,6 +886,9 @@ void ImageManager::device_update(Device *device, DeviceScene *dscene, Progress&
 	if(pack_images)
 		device_pack_images(device, dscene, progress);
 
+	if(texture_cache)
+		device->const_copy_to("__texture_cache", &texture_cache, sizeof(texture_cache));
+
 	need_update = false;
 }
 
@@ -951,6 +987,11 @@ void ImageManager::device_free_builtin(Device *device, DeviceScene *dscene)
 
 void ImageManager::device_free(Device *device, DeviceScene *dscene)
 {
+	if(texture_cache) {
+		VLOG(1) << "Texture cache statistics:\n"
+		        << texture_cache->get_stats().full_report();
+	}
+
 	for(size_t slot = 0; slot < images.size(); slot++)
 		device_free_image(device, dscene, slot + tex_image_byte_start);
 	for(size_t slot = 0; slot < float_images.size(); slot++)
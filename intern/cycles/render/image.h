@@ -56,6 +56,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Progress;
+class TextureCache;
 
 class ImageManager {
 public:
@@ -91,6 +92,10 @@ public:
 	void set_pack_images(bool pack_images_);
 	void set_extended_image_limits(const DeviceInfo& info);
 	bool set_animation_frame_update(int frame);
+	void set_texture_cache(size_t max_memory);
+
+	/* NULL unless images are read on demand by the CPU texture cache */
+	TextureCache *get_texture_cache() { return texture_cache; }
 
 	bool need_update;
 
@@ -122,6 +127,7 @@ private:
 	vector<Image*> images;
 	vector<Image*> float_images;
 	void *osl_texture_system;
+	TextureCache *texture_cache;
 	bool pack_images;
 
 	bool file_load_image(Image *img, device_vector<uchar4>& tex_img);
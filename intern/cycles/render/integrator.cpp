@@ -64,6 +64,11 @@ Integrator::Integrator()
 	sample_all_lights_direct = true;
 	sample_all_lights_indirect = true;
 
+	use_light_tree = false;
+
+	adaptive_threshold = 0.0f;
+	adaptive_min_samples = 0;
+
 	method = PATH;
 
 	sampling_pattern = SAMPLING_PATTERN_SOBOL;
@@ -151,6 +156,8 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 	kintegrator->sampling_pattern = sampling_pattern;
 	kintegrator->aa_samples = aa_samples;
 
+	kintegrator->adaptive_threshold = adaptive_threshold;
+
 	/* sobol directions table */
 	int max_samples = 1;
 
@@ -215,7 +222,10 @@ bool Integrator::modified(const Integrator& integrator)
 		motion_blur == integrator.motion_blur &&
 		sampling_pattern == integrator.sampling_pattern &&
 		sample_all_lights_direct == integrator.sample_all_lights_direct &&
-		sample_all_lights_indirect == integrator.sample_all_lights_indirect);
+		sample_all_lights_indirect == integrator.sample_all_lights_indirect &&
+		use_light_tree == integrator.use_light_tree &&
+		adaptive_threshold == integrator.adaptive_threshold &&
+		adaptive_min_samples == integrator.adaptive_min_samples);
 }
 
 void Integrator::tag_update(Scene *scene)
@@ -226,6 +236,9 @@ void Integrator::tag_update(Scene *scene)
 			break;
 		}
 	}
+	/* the light tree is built along with the light distribution */
+	if(use_light_tree != scene->light_manager->use_light_tree)
+		scene->light_manager->tag_update(scene);
 	need_update = true;
 }
 
@@ -64,6 +64,11 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 
+	bool use_light_tree;
+
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	enum Method {
 		BRANCHED_PATH = 0,
 		PATH = 1
@@ -18,8 +18,11 @@
 #include "device.h"
 #include "integrator.h"
 #include "film.h"
+#include "graph.h"
 #include "light.h"
+#include "light_tree.h"
 #include "mesh.h"
+#include "nodes.h"
 #include "object.h"
 #include "scene.h"
 #include "shader.h"
@@ -149,18 +152,139 @@ bool Light::has_contribution(Scene *scene)
 	return scene->shaders[shader]->has_surface_emission;
 }
 
+/* Light Tree */
+
+#define LIGHT_TREE_MAX_LEAF_SIZE 4
+
+/* Estimate of the emission strength of a shader, for the light tree to weight
+ * emitters by. Only constant strength and color of emission nodes are known
+ * before rendering, anything driven by a texture counts as 1. */
+static float shader_emission_estimate(Shader *shader)
+{
+	float estimate = 0.0f;
+	bool found = false;
+
+	if(shader->graph) {
+		foreach(ShaderNode *node, shader->graph->nodes) {
+			if(node->special_type != SHADER_SPECIAL_TYPE_EMISSION)
+				continue;
+
+			ShaderInput *color_in = node->input("Color");
+			ShaderInput *strength_in = node->input("Strength");
+			float color = (color_in->link)? 1.0f: average(color_in->value);
+			float strength = (strength_in->link)? 1.0f: strength_in->value.x;
+
+			estimate = max(estimate, fabsf(color*strength));
+			found = true;
+		}
+	}
+
+	/* emission from OSL scripts or other closures */
+	return (found)? estimate: 1.0f;
+}
+
 /* Light Manager */
 
 LightManager::LightManager()
 {
 	need_update = true;
 	use_light_visibility = false;
+	use_light_tree = false;
 }
 
 LightManager::~LightManager()
 {
 }
 
+float LightManager::device_update_tree(DeviceScene *dscene, Scene *scene, float4 *distribution,
+                                       const vector<LightTreePrimitive>& prims, Progress& progress)
+{
+	progress.set_status("Updating Lights", "Building light tree");
+
+	LightTree tree(prims, LIGHT_TREE_MAX_LEAF_SIZE);
+	size_t num_triangles = prims.size();
+
+	/* reorder the triangles, so that each leaf references consecutive ones */
+	vector<float4> triangles(distribution, distribution + num_triangles);
+	float totarea = 0.0f;
+
+	for(size_t i = 0; i < num_triangles; i++) {
+		int index = tree.prim_order[i];
+
+		distribution[i] = triangles[index];
+		distribution[i].x = totarea;
+		totarea += prims[index].area;
+	}
+
+	if(progress.get_cancel()) return totarea;
+
+	/* nodes */
+	size_t num_nodes = tree.nodes.size();
+	float4 *nodes = dscene->light_tree_nodes.resize(num_nodes*LIGHT_TREE_NODE_SIZE);
+
+	for(size_t i = 0; i < num_nodes; i++) {
+		const LightTreeNode& node = tree.nodes[i];
+		float4 *data = &nodes[i*LIGHT_TREE_NODE_SIZE];
+
+		data[0] = make_float4(node.bounds.min.x, node.bounds.min.y, node.bounds.min.z, node.energy);
+		data[1] = make_float4(node.bounds.max.x, node.bounds.max.y, node.bounds.max.z, node.cos_theta_o);
+		data[2] = make_float4(node.axis.x, node.axis.y, node.axis.z, __int_as_float(node.parent));
+		data[3] = make_float4(__int_as_float(node.child),
+		                      __int_as_float(node.num_prims),
+		                      (node.area > 0.0f)? 1.0f/node.area: 0.0f,
+		                      0.0f);
+	}
+
+	/* leaf lookup by object and triangle, for the pdf of triangles hit by rays.
+	 * for each object it holds the offset of its triangles in the table (zero
+	 * when it has no emitters) and the index of its first triangle */
+	size_t num_objects = scene->objects.size();
+	vector<uint> object_offset(num_objects, 0);
+	size_t table_size = num_objects*2;
+
+	for(size_t i = 0; i < num_triangles; i++) {
+		int object = __float_as_int(distribution[i].w);
+		if(object < 0)
+			object = ~object;
+
+		if(object_offset[object] == 0) {
+			object_offset[object] = table_size;
+			table_size += scene->objects[object]->mesh->triangles.size();
+		}
+	}
+
+	uint *table = dscene->light_tree_triangles.resize(table_size);
+	memset(table, 0, sizeof(uint)*table_size);
+
+	for(size_t i = 0; i < num_objects; i++) {
+		if(object_offset[i]) {
+			table[i*2 + 0] = object_offset[i];
+			table[i*2 + 1] = scene->objects[i]->mesh->tri_offset;
+		}
+	}
+
+	for(size_t i = 0; i < num_nodes; i++) {
+		const LightTreeNode& node = tree.nodes[i];
+
+		if(!node.is_leaf())
+			continue;
+
+		for(int j = node.child; j < node.child + node.num_prims; j++) {
+			int prim = __float_as_int(distribution[j].y);
+			int object = __float_as_int(distribution[j].w);
+			if(object < 0)
+				object = ~object;
+
+			table[object_offset[object] + prim - table[object*2 + 1]] = i;
+		}
+	}
+
+	VLOG(1) << "Light tree built for " << num_triangles << " triangles, "
+	        << num_nodes << " nodes.";
+
+	return totarea;
+}
+
 void LightManager::device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
@@ -189,6 +313,10 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		if(mesh->has_motion_blur())
 			continue;
 
+		/* skip instance arrays, not supported yet */
+		if(object->has_instances())
+			continue;
+
 		/* skip if we have no emission shaders */
 		foreach(uint sindex, mesh->used_shaders) {
 			Shader *shader = scene->shaders[sindex];
@@ -216,6 +344,25 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float4 *distribution = dscene->light_distribution.resize(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* light tree primitives, with the energy estimated from the shaders */
+	use_light_tree = scene->integrator->use_light_tree;
+
+	bool build_light_tree = use_light_tree && num_triangles > 0;
+	vector<LightTreePrimitive> tree_prims;
+	vector<float> shader_estimate;
+
+	if(build_light_tree) {
+		tree_prims.reserve(num_triangles);
+		shader_estimate.resize(scene->shaders.size(), 0.0f);
+
+		for(size_t i = 0; i < scene->shaders.size(); i++) {
+			Shader *shader = scene->shaders[i];
+
+			if(shader->use_mis && shader->has_surface_emission)
+				shader_estimate[i] = shader_emission_estimate(shader);
+		}
+	}
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -236,6 +383,12 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			continue;
 		}
 
+		/* skip instance arrays, not supported yet */
+		if(object->has_instances()) {
+			j++;
+			continue;
+		}
+
 		/* skip if we have no emission shaders */
 		foreach(uint sindex, mesh->used_shaders) {
 			Shader *shader = scene->shaders[sindex];
@@ -294,7 +447,22 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 						p3 = transform_point(&tfm, p3);
 					}
 
-					totarea += triangle_area(p1, p2, p3);
+					float area = triangle_area(p1, p2, p3);
+					totarea += area;
+
+					if(build_light_tree) {
+						LightTreePrimitive prim;
+						float3 N = cross(p2 - p1, p3 - p1);
+
+						prim.bounds = BoundBox(p1);
+						prim.bounds.grow(p2);
+						prim.bounds.grow(p3);
+						prim.normal = (area > 0.0f)? normalize(N): make_float3(0.0f, 0.0f, 1.0f);
+						prim.area = area;
+						prim.energy = area*shader_estimate[mesh->shader[i]];
+
+						tree_prims.push_back(prim);
+					}
 				}
 			}
 		}
@@ -304,6 +472,11 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		j++;
 	}
 
+	if(build_light_tree) {
+		totarea = device_update_tree(dscene, scene, distribution, tree_prims, progress);
+		if(progress.get_cancel()) return;
+	}
+
 	float trianglearea = totarea;
 
 	/* point lights */
@@ -378,6 +551,7 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		}
 
 		kintegrator->use_lamp_mis = use_lamp_mis;
+		kintegrator->use_light_tree = build_light_tree;
 
 		/* bit of an ugly hack to compensate for emitting triangles influencing
 		 * amount of samples we get for this pass */
@@ -392,6 +566,11 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 
+		if(build_light_tree) {
+			device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+			device->tex_alloc("__light_tree_triangles", dscene->light_tree_triangles);
+		}
+
 		/* Portals */
 		if(num_background_lights > 0 && light_index != scene->lights.size()) {
 			kintegrator->portal_offset = light_index;
@@ -406,6 +585,8 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	}
 	else {
 		dscene->light_distribution.clear();
+		dscene->light_tree_nodes.clear();
+		dscene->light_tree_triangles.clear();
 
 		kintegrator->num_distribution = 0;
 		kintegrator->num_all_lights = 0;
@@ -413,6 +594,7 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->pdf_lights = 0.0f;
 		kintegrator->inv_pdf_lights = 0.0f;
 		kintegrator->use_lamp_mis = false;
+		kintegrator->use_light_tree = false;
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
@@ -769,11 +951,15 @@ void LightManager::device_update(Device *device, DeviceScene *dscene, Scene *sce
 void LightManager::device_free(Device *device, DeviceScene *dscene)
 {
 	device->tex_free(dscene->light_distribution);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_triangles);
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
 
 	dscene->light_distribution.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_triangles.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
@@ -28,6 +28,7 @@ class Device;
 class DeviceScene;
 class Progress;
 class Scene;
+struct LightTreePrimitive;
 
 class Light {
 public:
@@ -71,6 +72,7 @@ public:
 class LightManager {
 public:
 	bool use_light_visibility;
+	bool use_light_tree;
 	bool need_update;
 
 	LightManager();
@@ -84,6 +86,8 @@ public:
 protected:
 	void device_update_points(Device *device, DeviceScene *dscene, Scene *scene);
 	void device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	float device_update_tree(DeviceScene *dscene, Scene *scene, float4 *distribution,
+	                         const vector<LightTreePrimitive>& prims, Progress& progress);
 	void device_update_background(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 };
 
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "light_tree.h"
+
+#include "util_algorithm.h"
+#include "util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+#define LIGHT_TREE_NUM_BINS 12
+
+/* Cone bounding a set of normals, with half angle theta_o around axis. */
+
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+
+	LightTreeCone() {}
+	LightTreeCone(const float3& axis_) : axis(axis_), theta_o(0.0f) {}
+};
+
+static LightTreeCone light_tree_cone_merge(LightTreeCone a, LightTreeCone b)
+{
+	/* emission is two sided, so normals can be flipped to get a tighter cone */
+	if(dot(a.axis, b.axis) < 0.0f)
+		b.axis = -b.axis;
+	if(b.theta_o > a.theta_o)
+		swap(a, b);
+
+	float cos_theta_d = dot(a.axis, b.axis);
+	float theta_d = safe_acosf(cos_theta_d);
+
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o)
+		return a;
+
+	float theta_o = 0.5f*(a.theta_o + theta_d + b.theta_o);
+
+	/* any set of normals fits in half a sphere, when they can be flipped */
+	if(theta_o >= M_PI_2_F) {
+		a.theta_o = M_PI_2_F;
+		return a;
+	}
+
+	/* rotate the axis of a towards b, to cover both */
+	float3 ortho = b.axis - a.axis*cos_theta_d;
+	float ortho_len = len(ortho);
+
+	if(ortho_len > 1e-6f) {
+		float theta_r = theta_o - a.theta_o;
+		a.axis = normalize(a.axis*cosf(theta_r) + ortho*(sinf(theta_r)/ortho_len));
+	}
+
+	a.theta_o = theta_o;
+	return a;
+}
+
+/* Solid angle measure of the directions a cone of normals emits into, with the
+ * cosine falloff of 90 degrees of diffuse emission, as proposed in
+ * "Importance Sampling of Many Lights with Adaptive Tree Splitting". */
+
+static float light_tree_cone_measure(const LightTreeCone& cone)
+{
+	float theta_o = cone.theta_o;
+	float theta_w = min(theta_o + M_PI_2_F, M_PI_F);
+	float sin_theta_o = sinf(theta_o);
+	float cos_theta_o = cosf(theta_o);
+
+	return M_2PI_F*(1.0f - cos_theta_o) +
+	       M_PI_2_F*(2.0f*theta_w*sin_theta_o - cosf(theta_o - 2.0f*theta_w) -
+	                 2.0f*theta_o*sin_theta_o + cos_theta_o);
+}
+
+/* Bin of a primitive centroid along dim, for the split search. */
+
+static int light_tree_bin(const LightTreePrimitive& prim, const BoundBox& centroid_bounds, int dim, float scale)
+{
+	int b = (int)((prim.bounds.center()[dim] - centroid_bounds.min[dim])*scale);
+	return clamp(b, 0, LIGHT_TREE_NUM_BINS - 1);
+}
+
+struct LightTreeSplitPredicate {
+	const vector<LightTreePrimitive>& prims;
+	const BoundBox& centroid_bounds;
+	int dim, bin;
+	float scale;
+
+	LightTreeSplitPredicate(const vector<LightTreePrimitive>& prims_, const BoundBox& centroid_bounds_,
+	                        int dim_, int bin_, float scale_)
+	: prims(prims_), centroid_bounds(centroid_bounds_), dim(dim_), bin(bin_), scale(scale_) {}
+
+	bool operator()(int i) const
+	{
+		return light_tree_bin(prims[i], centroid_bounds, dim, scale) < bin;
+	}
+};
+
+/* Light Tree */
+
+LightTree::LightTree(const vector<LightTreePrimitive>& prims_, int max_leaf_size_)
+: prims(prims_), max_leaf_size(max_leaf_size_)
+{
+	if(prims.empty())
+		return;
+
+	prim_order.resize(prims.size());
+	for(size_t i = 0; i < prims.size(); i++)
+		prim_order[i] = i;
+
+	nodes.reserve(2*prims.size()/max_leaf_size + 1);
+
+	build_node(0, prims.size(), -1);
+}
+
+int LightTree::build_node(int start, int end, int parent)
+{
+	LightTreeNode node;
+	LightTreeCone cone(prims[prim_order[start]].normal);
+	BoundBox centroid_bounds = BoundBox::empty;
+
+	node.bounds = BoundBox::empty;
+	node.area = 0.0f;
+	node.energy = 0.0f;
+
+	for(int i = start; i < end; i++) {
+		const LightTreePrimitive& prim = prims[prim_order[i]];
+
+		node.bounds.grow(prim.bounds);
+		node.area += prim.area;
+		node.energy += prim.energy;
+
+		centroid_bounds.grow(prim.bounds.center());
+		cone = light_tree_cone_merge(cone, LightTreeCone(prim.normal));
+	}
+
+	node.axis = cone.axis;
+	node.cos_theta_o = cosf(cone.theta_o);
+	node.parent = parent;
+	node.child = start;
+	node.num_prims = end - start;
+
+	int index = nodes.size();
+	nodes.push_back(node);
+
+	if(end - start <= max_leaf_size)
+		return index;
+
+	/* inner node, nodes may be reallocated while building the children */
+	int mid = find_split(centroid_bounds, node.energy > 0.0f, start, end);
+
+	build_node(start, mid, index);
+	int right = build_node(mid, end, index);
+
+	nodes[index].child = right;
+	nodes[index].num_prims = 0;
+
+	return index;
+}
+
+/* Binned split minimizing the energy, surface area and orientation cost of
+ * the children, partitions prim_order and returns where the right child
+ * starts. Without energy in the node, area is used instead. */
+
+int LightTree::find_split(const BoundBox& centroid_bounds, bool use_energy, int start, int end)
+{
+	struct Bin {
+		BoundBox bounds;
+		LightTreeCone cone;
+		float weight;
+		int count;
+	};
+
+	float3 extent = centroid_bounds.size();
+	float min_cost = FLT_MAX;
+	int min_dim = -1, min_bin = 0;
+	float min_scale = 0.0f;
+
+	for(int dim = 0; dim < 3; dim++) {
+		if(extent[dim] <= 0.0f)
+			continue;
+
+		Bin bins[LIGHT_TREE_NUM_BINS];
+		float right_cost[LIGHT_TREE_NUM_BINS];
+		float scale = LIGHT_TREE_NUM_BINS/extent[dim];
+
+		for(int b = 0; b < LIGHT_TREE_NUM_BINS; b++) {
+			bins[b].bounds = BoundBox::empty;
+			bins[b].weight = 0.0f;
+			bins[b].count = 0;
+		}
+
+		for(int i = start; i < end; i++) {
+			const LightTreePrimitive& prim = prims[prim_order[i]];
+			Bin& bin = bins[light_tree_bin(prim, centroid_bounds, dim, scale)];
+
+			bin.cone = (bin.count == 0)? LightTreeCone(prim.normal):
+			                             light_tree_cone_merge(bin.cone, LightTreeCone(prim.normal));
+			bin.bounds.grow(prim.bounds);
+			bin.weight += (use_energy)? prim.energy: prim.area;
+			bin.count++;
+		}
+
+		/* sweep from the right, cost of everything right of bin b */
+		Bin right;
+		right.bounds = BoundBox::empty;
+		right.weight = 0.0f;
+		right.count = 0;
+
+		for(int b = LIGHT_TREE_NUM_BINS - 1; b > 0; b--) {
+			if(bins[b].count) {
+				right.cone = (right.count == 0)? bins[b].cone: light_tree_cone_merge(right.cone, bins[b].cone);
+				right.bounds.grow(bins[b].bounds);
+				right.weight += bins[b].weight;
+				right.count += bins[b].count;
+			}
+
+			right_cost[b] = (right.count)?
+				right.weight*right.bounds.half_area()*light_tree_cone_measure(right.cone): 0.0f;
+		}
+
+		/* sweep from the left, for a split between bin b - 1 and b */
+		Bin left;
+		left.bounds = BoundBox::empty;
+		left.weight = 0.0f;
+		left.count = 0;
+
+		for(int b = 1; b < LIGHT_TREE_NUM_BINS; b++) {
+			const Bin& bin = bins[b - 1];
+
+			if(bin.count) {
+				left.cone = (left.count == 0)? bin.cone: light_tree_cone_merge(left.cone, bin.cone);
+				left.bounds.grow(bin.bounds);
+				left.weight += bin.weight;
+				left.count += bin.count;
+			}
+
+			if(left.count == 0 || left.count == end - start)
+				continue;
+
+			float cost = left.weight*left.bounds.half_area()*light_tree_cone_measure(left.cone) + right_cost[b];
+
+			if(cost < min_cost) {
+				min_cost = cost;
+				min_dim = dim;
+				min_bin = b;
+				min_scale = scale;
+			}
+		}
+	}
+
+	/* all centroids in the same place, split in the middle */
+	if(min_dim == -1)
+		return (start + end)/2;
+
+	int *first = &prim_order[0] + start;
+	int *mid = std::partition(first, &prim_order[0] + end,
+		LightTreeSplitPredicate(prims, centroid_bounds, min_dim, min_bin, min_scale));
+
+	return start + (int)(mid - first);
+}
+
+CCL_NAMESPACE_END
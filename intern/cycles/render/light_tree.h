@@ -0,0 +1,85 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util_boundbox.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Primitive
+ *
+ * Emitter as seen by the light tree builder: its bounds, the normal it emits
+ * along (emission is two sided, so the sign doesn't matter), its area and
+ * estimated energy. */
+
+struct LightTreePrimitive {
+	BoundBox bounds;
+	float3 normal;
+	float area;
+	float energy;
+};
+
+/* Light Tree Node
+ *
+ * Nodes are stored depth first, so the left child of an inner node directly
+ * follows it, and only the right child is stored. The normals of all emitters
+ * below the node are bounded by a cone around axis with cos_theta_o. */
+
+struct LightTreeNode {
+	BoundBox bounds;
+	float3 axis;
+	float cos_theta_o;
+	float area;
+	float energy;
+
+	int parent;
+	/* right child for inner nodes, first primitive for leaves */
+	int child;
+	/* zero for inner nodes */
+	int num_prims;
+
+	bool is_leaf() const { return num_prims > 0; }
+};
+
+/* Light Tree
+ *
+ * Bounding volume hierarchy over emitters, which the kernel traverses to pick
+ * an emitter with a probability based on the energy, distance and orientation
+ * of the nodes relative to the shading point. Leaves hold a range of prim_order,
+ * the primitives sorted so that each leaf references consecutive ones. */
+
+class LightTree {
+public:
+	vector<LightTreeNode> nodes;
+	vector<int> prim_order;
+
+	LightTree(const vector<LightTreePrimitive>& prims, int max_leaf_size);
+
+protected:
+	const vector<LightTreePrimitive>& prims;
+	int max_leaf_size;
+
+	int build_node(int start, int end, int parent);
+	int find_split(const BoundBox& centroid_bounds, bool use_energy, int start, int end);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
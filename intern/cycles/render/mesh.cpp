@@ -1084,12 +1084,23 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	bparams.use_qbvh = scene->params.use_qbvh;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 
+	bvh_objects.clear();
+
 	delete bvh;
 	bvh = BVH::create(bparams, scene->objects);
 	bvh->build(progress);
 
 	if(progress.get_cancel()) return;
 
+	foreach(Object *object, scene->objects) {
+		BVHObject bvh_object;
+		bvh_object.object = object;
+		bvh_object.mesh = object->mesh;
+		bvh_object.transform_applied = object->mesh->transform_applied;
+		bvh_object.num_instances = object->instance_tfm.size();
+		bvh_objects.push_back(bvh_object);
+	}
+
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
 
@@ -1132,6 +1143,58 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
 }
 
+bool MeshManager::can_refit_bvh(Scene *scene)
+{
+	if(!bvh || bvh_objects.size() != scene->objects.size())
+		return false;
+
+	foreach(Mesh *mesh, scene->meshes)
+		if(mesh->need_update)
+			return false;
+
+	/* same objects in the same order, so object indices in the BVH and the
+	 * merged BVHs of instanced meshes are still valid */
+	for(size_t i = 0; i < bvh_objects.size(); i++) {
+		const BVHObject& bvh_object = bvh_objects[i];
+		Object *object = scene->objects[i];
+
+		if(object != bvh_object.object ||
+		   object->mesh != bvh_object.mesh ||
+		   object->mesh->transform_applied != bvh_object.transform_applied ||
+		   object->instance_tfm.size() != bvh_object.num_instances)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshManager::device_refit_bvh(Device *device, DeviceScene *dscene, Scene * /*scene*/, Progress& progress)
+{
+	progress.set_status("Updating Scene BVH", "Refitting");
+
+	bvh->refit(progress);
+
+	if(progress.get_cancel()) return;
+
+	/* only the nodes changed, other arrays are still on the device */
+	progress.set_status("Updating Scene BVH", "Copying BVH nodes to device");
+
+	PackedBVH& pack = bvh->pack;
+
+	if(pack.nodes.size()) {
+		device->tex_free(dscene->bvh_nodes);
+		dscene->bvh_nodes.reference((float4*)&pack.nodes[0], pack.nodes.size());
+		device->tex_alloc("__bvh_nodes", dscene->bvh_nodes);
+	}
+	if(pack.leaf_nodes.size()) {
+		device->tex_free(dscene->bvh_leaf_nodes);
+		dscene->bvh_leaf_nodes.reference((float4*)&pack.leaf_nodes[0], pack.leaf_nodes.size());
+		device->tex_alloc("__bvh_leaf_nodes", dscene->bvh_leaf_nodes);
+	}
+}
+
 void MeshManager::device_update_flags(Device * /*device*/,
                                       DeviceScene * /*dscene*/,
                                       Scene * scene,
@@ -1208,13 +1271,43 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	if(!need_update)
 		return;
 
-	/* update normals */
+#ifdef __OBJECT_MOTION__
+	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
+	bool motion_blur = need_motion == Scene::MOTION_BLUR;
+#else
+	bool motion_blur = false;
+#endif
+
 	foreach(Mesh *mesh, scene->meshes) {
 		foreach(uint shader, mesh->used_shaders) {
 			if(scene->shaders[shader]->need_update_attributes)
 				mesh->need_update = true;
 		}
+	}
+
+	/* when only objects moved, refit the scene BVH and keep the meshes and
+	 * attributes on the device */
+	if(can_refit_bvh(scene)) {
+		VLOG(1) << "Refitting scene BVH, no meshes changed.";
+
+		foreach(Shader *shader, scene->shaders)
+			shader->need_update_attributes = false;
+
+		foreach(Object *object, scene->objects)
+			object->compute_bounds(motion_blur);
+
+		if(progress.get_cancel()) return;
 
+		device_refit_bvh(device, dscene, scene, progress);
+
+		if(progress.get_cancel()) return;
+
+		need_update = false;
+		return;
+	}
+
+	/* update normals */
+	foreach(Mesh *mesh, scene->meshes) {
 		if(mesh->need_update) {
 			mesh->add_face_normals();
 			mesh->add_vertex_normals();
@@ -1302,13 +1395,6 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	foreach(Shader *shader, scene->shaders)
 		shader->need_update_attributes = false;
 
-#ifdef __OBJECT_MOTION__
-	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
-	bool motion_blur = need_motion == Scene::MOTION_BLUR;
-#else
-	bool motion_blur = false;
-#endif
-
 	/* update obejcts */
 	vector<Object *> volume_objects;
 	foreach(Object *object, scene->objects)
@@ -1333,6 +1419,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 void MeshManager::device_free(Device *device, DeviceScene *dscene)
 {
+	/* arrays need to be packed again before the BVH can be used */
+	bvh_objects.clear();
+
 	device->tex_free(dscene->bvh_nodes);
 	device->tex_free(dscene->bvh_leaf_nodes);
 	device->tex_free(dscene->object_node);
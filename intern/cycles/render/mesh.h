@@ -34,6 +34,7 @@ class BVH;
 class Device;
 class DeviceScene;
 class Mesh;
+class Object;
 class Progress;
 class Scene;
 class SceneParams;
@@ -168,9 +169,24 @@ public:
 	void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_flags(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_displacement_images(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
+	void device_refit_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
 
 	void tag_update(Scene *scene);
+
+protected:
+	/* objects in the scene BVH as it was built, it can be refit while only
+	 * their transforms or visibility change */
+	struct BVHObject {
+		Object *object;
+		Mesh *mesh;
+		bool transform_applied;
+		size_t num_instances;
+	};
+
+	vector<BVHObject> bvh_objects;
+
+	bool can_refit_bvh(Scene *scene);
 };
 
 CCL_NAMESPACE_END
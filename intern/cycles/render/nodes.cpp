@@ -19,6 +19,7 @@
 #include "nodes.h"
 #include "scene.h"
 #include "svm.h"
+#include "svm_color_util.h"
 #include "svm_math_util.h"
 #include "osl.h"
 #include "sky_model.h"
@@ -220,6 +221,9 @@ ImageTextureNode::ImageTextureNode()
 	animated = false;
 
 	add_input("Vector", SHADER_SOCKET_POINT, ShaderInput::TEXTURE_UV);
+	/* vector shifted by ray differentials, see refine_image_derivatives() */
+	add_input("VectorDX", SHADER_SOCKET_POINT, ShaderInput::NONE, ShaderInput::USE_SVM);
+	add_input("VectorDY", SHADER_SOCKET_POINT, ShaderInput::NONE, ShaderInput::USE_SVM);
 	add_output("Color", SHADER_SOCKET_COLOR);
 	add_output("Alpha", SHADER_SOCKET_FLOAT);
 }
@@ -262,6 +266,8 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 void ImageTextureNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector_in = input("Vector");
+	ShaderInput *vector_dx_in = input("VectorDX");
+	ShaderInput *vector_dy_in = input("VectorDY");
 	ShaderOutput *color_out = output("Color");
 	ShaderOutput *alpha_out = output("Alpha");
 
@@ -296,6 +302,25 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 			tex_mapping.compile(compiler, vector_in->stack_offset, vector_offset);
 		}
 
+		/* shifted texture coordinates for the texture cache to pick a mip
+		 * level, only linked when it's used */
+		int dx_offset = SVM_STACK_INVALID;
+		int dy_offset = SVM_STACK_INVALID;
+
+		if(vector_dx_in->link && vector_dy_in->link) {
+			compiler.stack_assign(vector_dx_in);
+			compiler.stack_assign(vector_dy_in);
+			dx_offset = vector_dx_in->stack_offset;
+			dy_offset = vector_dy_in->stack_offset;
+
+			if(!tex_mapping.skip()) {
+				dx_offset = compiler.stack_find_offset(SHADER_SOCKET_VECTOR);
+				tex_mapping.compile(compiler, vector_dx_in->stack_offset, dx_offset);
+				dy_offset = compiler.stack_find_offset(SHADER_SOCKET_VECTOR);
+				tex_mapping.compile(compiler, vector_dy_in->stack_offset, dy_offset);
+			}
+		}
+
 		if(projection != "Box") {
 			compiler.add_node(NODE_TEX_IMAGE,
 				slot,
@@ -304,7 +329,11 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 					color_out->stack_offset,
 					alpha_out->stack_offset,
 					srgb),
-				projection_enum[projection]);
+				compiler.encode_uchar4(
+					projection_enum[projection],
+					dx_offset,
+					dy_offset,
+					0));
 		}
 		else {
 			compiler.add_node(NODE_TEX_IMAGE_BOX,
@@ -319,6 +348,10 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 
 		if(vector_offset != vector_in->stack_offset)
 			compiler.stack_clear_offset(vector_in->type, vector_offset);
+		if(dx_offset != vector_dx_in->stack_offset)
+			compiler.stack_clear_offset(vector_dx_in->type, dx_offset);
+		if(dy_offset != vector_dy_in->stack_offset)
+			compiler.stack_clear_offset(vector_dy_in->type, dy_offset);
 	}
 	else {
 		/* image not found */
@@ -3330,6 +3363,28 @@ MixClosureNode::MixClosureNode()
 	add_output("Closure",  SHADER_SOCKET_CLOSURE);
 }
 
+ShaderInput *MixClosureNode::bypass_input(ShaderOutput * /*socket*/)
+{
+	ShaderInput *fac_in = input("Fac");
+	ShaderInput *closure1_in = input("Closure1");
+	ShaderInput *closure2_in = input("Closure2");
+
+	/* mixing a closure with itself */
+	if(closure1_in->link == closure2_in->link)
+		return closure1_in;
+
+	/* with factor 0.0 or 1.0 the other closure is a dead branch, bypassing
+	 * the node with an unconnected closure input removes the mix entirely */
+	if(fac_in->link == NULL) {
+		if(fac_in->value.x <= 0.0f)
+			return closure1_in;
+		else if(fac_in->value.x >= 1.0f)
+			return closure2_in;
+	}
+
+	return NULL;
+}
+
 void MixClosureNode::compile(SVMCompiler& /*compiler*/)
 {
 	/* handled in the SVM compiler */
@@ -3444,6 +3499,82 @@ static ShaderEnum mix_type_init()
 
 ShaderEnum MixNode::type_enum = mix_type_init();
 
+bool MixNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
+{
+	ShaderInput *fac_in = input("Fac");
+	ShaderInput *color1_in = input("Color1");
+	ShaderInput *color2_in = input("Color2");
+
+	if(socket == output("Color")) {
+		if(fac_in->link == NULL && color1_in->link == NULL && color2_in->link == NULL) {
+			*optimized_value = svm_mix((NodeMix)type_enum[type],
+			                           fac_in->value.x,
+			                           color1_in->value,
+			                           color2_in->value);
+
+			if(use_clamp) {
+				*optimized_value = svm_mix_clamp(*optimized_value);
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+ShaderInput *MixNode::bypass_input(ShaderOutput *socket)
+{
+	ShaderInput *fac_in = input("Fac");
+	ShaderInput *color1_in = input("Color1");
+	ShaderInput *color2_in = input("Color2");
+
+	if(socket != output("Color") || use_clamp)
+		return NULL;
+
+	NodeMix mix_type = (NodeMix)type_enum[type];
+
+	if(fac_in->link == NULL) {
+		if(fac_in->value.x <= 0.0f) {
+			/* factor 0.0 gives the first color, except for blend types which
+			 * clamp it or convert it to HSV and back */
+			switch(mix_type) {
+				case NODE_MIX_LIGHT:
+				case NODE_MIX_DODGE:
+				case NODE_MIX_BURN:
+				case NODE_MIX_SAT:
+				case NODE_MIX_VAL:
+					break;
+				default:
+					return color1_in;
+			}
+		}
+		else if(fac_in->value.x >= 1.0f && mix_type == NODE_MIX_BLEND) {
+			return color2_in;
+		}
+	}
+
+	/* blending with black or white which leaves the first color unchanged */
+	if(color2_in->link == NULL) {
+		if((mix_type == NODE_MIX_ADD || mix_type == NODE_MIX_SUB) &&
+		   color2_in->value == make_float3(0.0f, 0.0f, 0.0f))
+		{
+			return color1_in;
+		}
+		else if(mix_type == NODE_MIX_MUL &&
+		        color2_in->value == make_float3(1.0f, 1.0f, 1.0f))
+		{
+			return color1_in;
+		}
+	}
+
+	/* mixing a color with itself */
+	if(mix_type == NODE_MIX_BLEND && color1_in->link && color1_in->link == color2_in->link)
+		return color1_in;
+
+	return NULL;
+}
+
 void MixNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *fac_in = input("Fac");
@@ -4174,11 +4305,65 @@ bool MathNode::constant_fold(ShaderOutput *socket, float3 *optimized_value)
 
 			return true;
 		}
+
+		/* multiplying by zero */
+		if(type_enum[type] == NODE_MATH_MULTIPLY &&
+		   ((value1_in->link == NULL && value1_in->value.x == 0.0f) ||
+		    (value2_in->link == NULL && value2_in->value.x == 0.0f)))
+		{
+			optimized_value->x = 0.0f;
+			return true;
+		}
 	}
 
 	return false;
 }
 
+ShaderInput *MathNode::bypass_input(ShaderOutput *socket)
+{
+	ShaderInput *value1_in = input("Value1");
+	ShaderInput *value2_in = input("Value2");
+
+	if(socket != output("Value") || use_clamp)
+		return NULL;
+
+	bool value1_const = (value1_in->link == NULL);
+	bool value2_const = (value2_in->link == NULL);
+
+	/* operations with an identity element as one of the values */
+	switch(type_enum[type]) {
+		case NODE_MATH_ADD:
+			if(value1_const && value1_in->value.x == 0.0f)
+				return value2_in;
+			if(value2_const && value2_in->value.x == 0.0f)
+				return value1_in;
+			break;
+		case NODE_MATH_SUBTRACT:
+			if(value2_const && value2_in->value.x == 0.0f)
+				return value1_in;
+			break;
+		case NODE_MATH_MULTIPLY:
+			if(value1_const && value1_in->value.x == 1.0f)
+				return value2_in;
+			if(value2_const && value2_in->value.x == 1.0f)
+				return value1_in;
+			break;
+		case NODE_MATH_DIVIDE:
+			if(value2_const && value2_in->value.x == 1.0f)
+				return value1_in;
+			break;
+		case NODE_MATH_MINIMUM:
+		case NODE_MATH_MAXIMUM:
+			if(!value1_const && value1_in->link == value2_in->link)
+				return value1_in;
+			break;
+		default:
+			break;
+	}
+
+	return NULL;
+}
+
 void MathNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *value1_in = input("Value1");
@@ -4262,6 +4447,35 @@ bool VectorMathNode::constant_fold(ShaderOutput *socket, float3 *optimized_value
 	return false;
 }
 
+ShaderInput *VectorMathNode::bypass_input(ShaderOutput *socket)
+{
+	ShaderInput *vector1_in = input("Vector1");
+	ShaderInput *vector2_in = input("Vector2");
+
+	if(socket != output("Vector"))
+		return NULL;
+
+	float3 zero = make_float3(0.0f, 0.0f, 0.0f);
+
+	/* adding or subtracting a zero vector */
+	switch(type_enum[type]) {
+		case NODE_VECTOR_MATH_ADD:
+			if(vector1_in->link == NULL && vector1_in->value == zero)
+				return vector2_in;
+			if(vector2_in->link == NULL && vector2_in->value == zero)
+				return vector1_in;
+			break;
+		case NODE_VECTOR_MATH_SUBTRACT:
+			if(vector2_in->link == NULL && vector2_in->value == zero)
+				return vector1_in;
+			break;
+		default:
+			break;
+	}
+
+	return NULL;
+}
+
 void VectorMathNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector1_in = input("Vector1");
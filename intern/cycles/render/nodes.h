@@ -684,6 +684,7 @@ public:
 class MixClosureNode : public ShaderNode {
 public:
 	SHADER_NODE_CLASS(MixClosureNode)
+	ShaderInput *bypass_input(ShaderOutput *socket);
 };
 
 class MixClosureWeightNode : public ShaderNode {
@@ -703,6 +704,8 @@ public:
 	SHADER_NODE_CLASS(MixNode)
 
 	virtual int get_group() { return NODE_GROUP_LEVEL_3; }
+	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	ShaderInput *bypass_input(ShaderOutput *socket);
 
 	bool use_clamp;
 
@@ -822,6 +825,13 @@ public:
 	virtual int get_group() { return NODE_GROUP_LEVEL_3; }
 
 	bool use_pixel_size;
+
+	virtual bool equals(const ShaderNode *other)
+	{
+		const WireframeNode *wireframe_node = (const WireframeNode*)other;
+		return ShaderNode::equals(other) &&
+		       use_pixel_size == wireframe_node->use_pixel_size;
+	}
 };
 
 class WavelengthNode : public ShaderNode {
@@ -844,6 +854,7 @@ public:
 	SHADER_NODE_CLASS(MathNode)
 	virtual int get_group() { return NODE_GROUP_LEVEL_1; }
 	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	ShaderInput *bypass_input(ShaderOutput *socket);
 
 	bool use_clamp;
 
@@ -879,6 +890,7 @@ public:
 	SHADER_NODE_CLASS(VectorMathNode)
 	virtual int get_group() { return NODE_GROUP_LEVEL_1; }
 	bool constant_fold(ShaderOutput *socket, float3 *optimized_value);
+	ShaderInput *bypass_input(ShaderOutput *socket);
 
 	ustring type;
 	static ShaderEnum type_enum;
@@ -24,9 +24,12 @@
 #include "scene.h"
 
 #include "util_foreach.h"
+#include "util_hash.h"
 #include "util_logging.h"
 #include "util_map.h"
 #include "util_progress.h"
+#include "util_task.h"
+#include "util_time.h"
 #include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -51,6 +54,7 @@ Object::Object()
 	use_holdout = false;
 	dupli_generated = make_float3(0.0f, 0.0f, 0.0f);
 	dupli_uv = make_float2(0.0f, 0.0f);
+	instance_offset = 0;
 }
 
 Object::~Object()
@@ -77,6 +81,12 @@ void Object::compute_bounds(bool motion_blur)
 			bounds.grow(mbounds.transformed(&ttfm));
 		}
 	}
+	else if(has_instances()) {
+		bounds = BoundBox::empty;
+
+		for(size_t i = 0; i < instance_tfm.size(); i++)
+			bounds.grow(mbounds.transformed(&instance_tfm[i]));
+	}
 	else {
 		if(mesh->transform_applied) {
 			bounds = mbounds;
@@ -219,6 +229,23 @@ vector<float> Object::motion_times()
 	return times;
 }
 
+Object *object_find_instance_array(const vector<Object*>& instance_arrays, int index)
+{
+	/* last array starting before the instance */
+	size_t lo = 0, hi = instance_arrays.size();
+
+	while(hi - lo > 1) {
+		size_t mid = (lo + hi)/2;
+
+		if(instance_arrays[mid]->instance_offset <= index)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return instance_arrays[lo];
+}
+
 /* Object Manager */
 
 ObjectManager::ObjectManager()
@@ -331,7 +358,7 @@ void ObjectManager::device_update_transforms(Device *device, DeviceScene *dscene
 		}
 #ifdef __OBJECT_MOTION__
 		else if(need_motion == Scene::MOTION_BLUR) {
-			if(ob->use_motion) {
+			if(ob->use_motion && !ob->has_instances()) {
 				/* decompose transformations for interpolation */
 				DecompMotionTransform decomp;
 
@@ -376,6 +403,73 @@ void ObjectManager::device_update_transforms(Device *device, DeviceScene *dscene
 	dscene->data.bvh.have_motion = have_motion;
 	dscene->data.bvh.have_curves = have_curves;
 	dscene->data.bvh.have_instancing = true;
+	dscene->data.bvh.num_objects = scene->objects.size();
+}
+
+static void pack_instances(const Object *ob, int prototype, size_t start, size_t end, float4 *instances)
+{
+	for(size_t j = start; j < end; j++) {
+		float4 *data = &instances[(ob->instance_offset + j)*INSTANCE_SIZE];
+		Transform tfm = ob->instance_tfm[j];
+		Transform itfm = transform_inverse(tfm);
+		uint random_id = (j < ob->instance_random_id.size())? ob->instance_random_id[j]: hash_int_2d(ob->random_id, j);
+		float random_number = (float)random_id * (1.0f/(float)0xFFFFFFFF);
+
+		/* INSTANCE_TRANSFORM */
+		memcpy(&data[0], &tfm, sizeof(float4)*3);
+		/* INSTANCE_INVERSE_TRANSFORM */
+		memcpy(&data[3], &itfm, sizeof(float4)*3);
+		/* INSTANCE_PROPERTIES */
+		data[6] = make_float4(__int_as_float(prototype), random_number, 0.0f, 0.0f);
+	}
+}
+
+void ObjectManager::device_update_instances(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+{
+	size_t num_instances = 0;
+
+	foreach(Object *ob, scene->objects)
+		num_instances += ob->instance_tfm.size();
+
+	if(num_instances == 0)
+		return;
+
+	double time_start = time_dt();
+	float4 *instances = dscene->instances.resize(INSTANCE_SIZE*num_instances);
+
+	/* instances are numbered after the objects in the kernel, offsets of the
+	 * instances in the array were assigned in device_update */
+	const size_t chunk_size = 65536;
+	TaskPool pool;
+	int prototype = 0;
+
+	foreach(Object *ob, scene->objects) {
+		size_t num = ob->instance_tfm.size();
+
+		for(size_t start = 0; start < num; start += chunk_size) {
+			size_t end = (num - start > chunk_size)? start + chunk_size: num;
+
+			pool.push(function_bind(&pack_instances,
+			                        ob,
+			                        prototype,
+			                        start,
+			                        end,
+			                        instances));
+		}
+
+		prototype++;
+	}
+
+	pool.wait_work();
+
+	if(progress.get_cancel()) return;
+
+	device->tex_alloc("__instances", dscene->instances);
+
+	VLOG(1) << "Packed " << num_instances << " instances in "
+	        << time_dt() - time_start << " seconds, using "
+	        << string_printf("%.2fM", dscene->instances.size()*sizeof(float4)/(1024.0*1024.0))
+	        << " of device memory.";
 }
 
 void ObjectManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
@@ -390,8 +484,16 @@ void ObjectManager::device_update(Device *device, DeviceScene *dscene, Scene *sc
 	if(scene->objects.size() == 0)
 		return;
 
+	/* instances of instance arrays get kernel object indices after the objects */
+	size_t num_instances = 0;
+
+	foreach(Object *ob, scene->objects) {
+		ob->instance_offset = scene->objects.size() + num_instances;
+		num_instances += ob->instance_tfm.size();
+	}
+
 	/* object info flag */
-	uint *object_flag = dscene->object_flag.resize(scene->objects.size());
+	uint *object_flag = dscene->object_flag.resize(scene->objects.size() + num_instances);
 
 	/* set object transform matrices, before applying static transforms */
 	progress.set_status("Updating Objects", "Copying Transformations to device");
@@ -399,6 +501,13 @@ void ObjectManager::device_update(Device *device, DeviceScene *dscene, Scene *sc
 
 	if(progress.get_cancel()) return;
 
+	if(num_instances) {
+		progress.set_status("Updating Objects", "Copying Instances to device");
+		device_update_instances(device, dscene, scene, progress);
+
+		if(progress.get_cancel()) return;
+	}
+
 	/* prepare for static BVH building */
 	/* todo: do before to support getting object level coords? */
 	if(scene->params.bvh_type == SceneParams::BVH_STATIC) {
@@ -465,6 +574,14 @@ void ObjectManager::device_update_flags(Device *device,
 		++object_index;
 	}
 
+	/* instances share the flags of their object */
+	object_index = 0;
+	foreach(Object *object, scene->objects) {
+		for(size_t j = 0; j < object->instance_tfm.size(); j++)
+			object_flag[object->instance_offset + j] = object_flag[object_index];
+		++object_index;
+	}
+
 	/* allocate object flag */
 	device->tex_alloc("__object_flag", dscene->object_flag);
 }
@@ -477,6 +594,9 @@ void ObjectManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->objects_vector);
 	dscene->objects_vector.clear();
 
+	device->tex_free(dscene->instances);
+	dscene->instances.clear();
+
 	device->tex_free(dscene->object_flag);
 	dscene->object_flag.clear();
 }
@@ -510,9 +630,10 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, u
 
 	if(progress.get_cancel()) return;
 
-	/* apply transforms for objects with single user meshes */
+	/* apply transforms for objects with single user meshes, instance arrays
+	 * keep their mesh in object space to be instanced */
 	foreach(Object *object, scene->objects) {
-		if(mesh_users[object->mesh] == 1 &&
+		if(mesh_users[object->mesh] == 1 && !object->has_instances() &&
 		   object->mesh->displacement_method == Mesh::DISPLACE_BUMP)
 		{
 			if(!(motion_blur && object->use_motion)) {
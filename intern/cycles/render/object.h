@@ -53,18 +53,34 @@ public:
 
 	ParticleSystem *particle_system;
 	int particle_index;
+
+	/* Instance arrays: when not empty the mesh is rendered once for each of
+	 * these world space transforms, in place of the object itself. Instances
+	 * share everything with the object except their random id, and don't
+	 * support motion blur or being sampled as mesh lights. */
+	vector<Transform> instance_tfm;
+	vector<uint> instance_random_id;
+	/* first kernel object index of the instances, set on device update */
+	int instance_offset;
 	
 	Object();
 	~Object();
 
 	void tag_update(Scene *scene);
 
+	bool has_instances() const { return !instance_tfm.empty(); }
+
 	void compute_bounds(bool motion_blur);
 	void apply_transform(bool apply_to_motion);
 
 	vector<float> motion_times();
 };
 
+/* Instances of instance arrays are numbered after the objects, find the
+ * object an instance belongs to among the objects with instances, which
+ * are in the same order as in the scene. */
+Object *object_find_instance_array(const vector<Object*>& instance_arrays, int index);
+
 /* Object Manager */
 
 class ObjectManager {
@@ -77,6 +93,7 @@ public:
 
 	void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_transforms(Device *device, DeviceScene *dscene, Scene *scene, uint *object_flag, Progress& progress);
+	void device_update_instances(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_update_flags(Device *device,
 	                         DeviceScene *dscene,
 	                         Scene *scene,
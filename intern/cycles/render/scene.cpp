@@ -70,6 +70,14 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 
 	/* Extended image limits for CPU and GPUs */
 	image_manager->set_extended_image_limits(device_info_);
+
+	/* Image textures read on demand, SVM on the CPU only */
+	if(device_info_.type == DEVICE_CPU &&
+	   params.shadingsystem == SHADINGSYSTEM_SVM &&
+	   params.texture_cache_size > 0)
+	{
+		image_manager->set_texture_cache(params.texture_cache_size);
+	}
 }
 
 Scene::~Scene()
@@ -82,6 +82,7 @@ public:
 	/* objects */
 	device_vector<float4> objects;
 	device_vector<float4> objects_vector;
+	device_vector<float4> instances;
 
 	/* attributes */
 	device_vector<uint4> attributes_map;
@@ -91,6 +92,8 @@ public:
 
 	/* lights */
 	device_vector<float4> light_distribution;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_triangles;
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
@@ -128,7 +131,15 @@ public:
 	enum BVHType { BVH_DYNAMIC, BVH_STATIC } bvh_type;
 	bool use_bvh_spatial_split;
 	bool use_qbvh;
+	/* trace camera rays of neighboring pixels together on the CPU */
+	bool use_ray_stream;
+	/* path trace bounces of many paths together, shading them sorted by
+	 * shader, on the CPU */
+	bool use_wavefront;
 	bool persistent_data;
+	/* memory limit of the CPU image texture cache in bytes, 0 to load
+	 * images in full */
+	size_t texture_cache_size;
 
 	SceneParams()
 	{
@@ -136,7 +147,10 @@ public:
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_spatial_split = false;
 		use_qbvh = false;
+		use_ray_stream = false;
+		use_wavefront = false;
 		persistent_data = false;
+		texture_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -144,7 +158,10 @@ public:
 		&& bvh_type == params.bvh_type
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_qbvh == params.use_qbvh
-		&& persistent_data == params.persistent_data); }
+		&& use_ray_stream == params.use_ray_stream
+		&& use_wavefront == params.use_wavefront
+		&& persistent_data == params.persistent_data
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
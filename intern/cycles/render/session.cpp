@@ -20,6 +20,7 @@
 #include "buffers.h"
 #include "camera.h"
 #include "device.h"
+#include "film.h"
 #include "graph.h"
 #include "integrator.h"
 #include "mesh.h"
@@ -28,6 +29,7 @@
 #include "session.h"
 #include "bake.h"
 
+#include "util_algorithm.h"
 #include "util_foreach.h"
 #include "util_function.h"
 #include "util_logging.h"
@@ -405,8 +407,9 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 
 	RenderBuffers *tilebuffers;
 
-	/* allocate buffers */
-	if(params.progressive_refine) {
+	/* allocate buffers, which are kept for progressive refine and for
+	 * denoising, which needs the pixels of the tiles around each tile */
+	if(params.progressive_refine || params.use_denoising) {
 		tile_lock.lock();
 
 		if(tile_buffers.size() == 0)
@@ -467,6 +470,18 @@ void Session::release_tile(RenderTile& rtile)
 
 	if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
+			if(params.use_denoising) {
+				/* written when all tiles are rendered, unless canceled */
+				if(!progress.get_cancel())
+					return;
+
+				/* clear the slot rather than erasing it, other threads may
+				 * still look up their tiles by index */
+				vector<RenderBuffers*>::iterator it = std::find(tile_buffers.begin(), tile_buffers.end(), rtile.buffers);
+				if(it != tile_buffers.end())
+					*it = NULL;
+			}
+
 			/* todo: optimize this by making it thread safe and removing lock */
 			write_render_tile_cb(rtile);
 
@@ -603,6 +618,15 @@ void Session::run_cpu()
 
 	if(!tiles_written)
 		update_progressive_refine(true);
+
+	if(params.use_denoising && !params.progressive_refine) {
+		if(!progress.get_cancel())
+			denoise(tile_manager.num_samples);
+		else
+			clear_denoised();
+
+		write_tile_buffers(tile_manager.num_samples);
+	}
 }
 
 DeviceRequestedFeatures Session::get_requested_device_features()
@@ -730,7 +754,7 @@ void Session::reset(BufferParams& buffer_params, int samples)
 	else
 		reset_cpu(buffer_params, samples);
 
-	if(params.progressive_refine) {
+	if(params.progressive_refine || params.use_denoising) {
 		thread_scoped_lock buffers_lock(buffers_mutex);
 
 		foreach(RenderBuffers *buffers, tile_buffers)
@@ -917,6 +941,13 @@ void Session::path_trace()
 	task.update_progress_sample = function_bind(&Session::update_progress_sample, this);
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
+	task.integrator_adaptive = scene->integrator->adaptive_threshold > 0.0f &&
+	                           Pass::contains(scene->film->passes, PASS_ADAPTIVE_AUX_BUFFER);
+	task.adaptive_min_samples = scene->integrator->adaptive_min_samples;
+	if(task.adaptive_min_samples == 0)
+		task.adaptive_min_samples = max(4, (int)sqrtf((float)tile_manager.num_samples));
+	task.use_ray_stream = scene->params.use_ray_stream;
+	task.use_wavefront = scene->params.use_wavefront;
 	task.requested_tile_size = params.tile_size;
 
 	device->task_add(task);
@@ -962,6 +993,13 @@ bool Session::update_progressive_refine(bool cancel)
 	}
 
 	if(params.progressive_refine) {
+		if(params.use_denoising) {
+			if(write && !cancel)
+				denoise(sample);
+			else
+				clear_denoised();  /* an earlier result doesn't match the buffers anymore */
+		}
+
 		foreach(RenderBuffers *buffers, tile_buffers) {
 			RenderTile rtile;
 			rtile.buffers = buffers;
@@ -983,6 +1021,55 @@ bool Session::update_progressive_refine(bool cancel)
 	return write;
 }
 
+void Session::denoise(int sample)
+{
+	vector<RenderBuffers*> neighbors;
+
+	progress.set_status("Denoising");
+
+	foreach(RenderBuffers *buffers, tile_buffers) {
+		if(buffers && buffers->copy_from_device())
+			neighbors.push_back(buffers);
+	}
+
+	/* every tile reads the pixels of the tiles it overlaps, skipping others */
+	TaskPool pool;
+
+	foreach(RenderBuffers *buffers, neighbors)
+		pool.push(function_bind(&denoise_buffers, params.denoising, buffers, neighbors, sample));
+
+	pool.wait_work();
+}
+
+void Session::clear_denoised()
+{
+	foreach(RenderBuffers *buffers, tile_buffers) {
+		if(buffers)
+			buffers->denoised.clear();
+	}
+}
+
+void Session::write_tile_buffers(int sample)
+{
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	foreach(RenderBuffers *buffers, tile_buffers) {
+		if(!buffers)
+			continue;
+
+		RenderTile rtile;
+		rtile.buffers = buffers;
+		rtile.sample = sample;
+
+		if(write_render_tile_cb)
+			write_render_tile_cb(rtile);
+
+		delete buffers;
+	}
+
+	tile_buffers.clear();
+}
+
 void Session::device_free()
 {
 	scene->device_free();
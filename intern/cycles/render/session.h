@@ -18,6 +18,7 @@
 #define __SESSION_H__
 
 #include "buffers.h"
+#include "denoising.h"
 #include "device.h"
 #include "shader.h"
 #include "tile.h"
@@ -57,6 +58,9 @@ public:
 
 	bool display_buffer_linear;
 
+	bool use_denoising;
+	DenoiseParams denoising;
+
 	double cancel_timeout;
 	double reset_timeout;
 	double text_timeout;
@@ -79,6 +83,8 @@ public:
 
 		display_buffer_linear = false;
 
+		use_denoising = false;
+
 		cancel_timeout = 0.1;
 		reset_timeout = 0.1;
 		text_timeout = 1.0;
@@ -101,6 +107,8 @@ public:
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
 		&& display_buffer_linear == params.display_buffer_linear
+		&& use_denoising == params.use_denoising
+		&& !denoising.modified(params.denoising)
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
 		&& text_timeout == params.text_timeout
@@ -204,6 +212,11 @@ protected:
 	double last_update_time;
 	bool update_progressive_refine(bool cancel);
 
+	/* denoising, of the tiles in tile_buffers once all are rendered */
+	void denoise(int sample);
+	void clear_denoised();
+	void write_tile_buffers(int sample);
+
 	vector<RenderBuffers *> tile_buffers;
 
 	DeviceRequestedFeatures get_requested_device_features();
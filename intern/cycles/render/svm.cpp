@@ -79,6 +79,15 @@ void SVMShaderManager::device_update(Device *device, DeviceScene *dscene, Scene
 		SVMCompiler::Summary summary;
 		SVMCompiler compiler(scene->shader_manager, scene->image_manager);
 		compiler.background = ((int)i == scene->default_background);
+
+		/* Count SVM nodes without optimizations on a copy of the graph first,
+		 * it can only be finalized once. */
+		if(VLOG_IS_ON(1) && !shader->graph->finalized) {
+			SVMCompiler unoptimized_compiler(scene->shader_manager, scene->image_manager);
+			unoptimized_compiler.background = compiler.background;
+			summary.num_svm_nodes_unoptimized = unoptimized_compiler.compile_unoptimized(scene, shader);
+		}
+
 		compiler.compile(scene, shader, svm_nodes, i, &summary);
 
 		VLOG(1) << "Compilation summary:\n"
@@ -807,10 +816,49 @@ void SVMCompiler::compile(Scene *scene,
 	}
 }
 
+int SVMCompiler::compile_unoptimized(Scene *scene, Shader *shader)
+{
+	/* compile copies of the graphs with constant folding and de-duplication
+	 * disabled, and only count the SVM nodes for compiler statistics */
+	ShaderGraph *graph = shader->graph->copy();
+	ShaderGraph *graph_bump = NULL;
+	ShaderNode *node = graph->output();
+	int num_svm_nodes = 0;
+
+	if(node->input("Surface")->link && node->input("Displacement")->link)
+		graph_bump = graph->copy();
+
+	graph->finalize(scene, false, false, false, false);
+	if(graph_bump)
+		graph_bump->finalize(scene, true, false, false, false);
+
+	current_shader = shader;
+
+	compile_type(shader, graph, SHADER_TYPE_SURFACE);
+	num_svm_nodes += svm_nodes.size();
+
+	if(graph_bump) {
+		compile_type(shader, graph_bump, SHADER_TYPE_SURFACE);
+		num_svm_nodes += svm_nodes.size();
+	}
+
+	compile_type(shader, graph, SHADER_TYPE_VOLUME);
+	num_svm_nodes += svm_nodes.size();
+
+	compile_type(shader, graph, SHADER_TYPE_DISPLACEMENT);
+	num_svm_nodes += svm_nodes.size();
+
+	delete graph;
+	delete graph_bump;
+
+	return num_svm_nodes;
+}
+
 /* Compiler summary implementation. */
 
 SVMCompiler::Summary::Summary()
 	: num_svm_nodes(0),
+	  num_svm_nodes_unoptimized(0),
 	  peak_stack_usage(0),
 	  time_finalize(0.0),
 	  time_finalize_bump(0.0),
@@ -826,6 +874,9 @@ string SVMCompiler::Summary::full_report() const
 {
 	string report = "";
 	report += string_printf("Number of SVM nodes: %d\n", num_svm_nodes);
+	if(num_svm_nodes_unoptimized != 0) {
+		report += string_printf("  Unoptimized:       %d\n", num_svm_nodes_unoptimized);
+	}
 	report += string_printf("Peak stack usage:    %d\n", peak_stack_usage);
 
 	report += string_printf("Time (in seconds):\n");
@@ -58,6 +58,11 @@ public:
 		/* Number of SVM nodes shader was compiled into. */
 		int num_svm_nodes;
 
+		/* Number of SVM nodes without constant folding and de-duplication,
+		 * zero if it was not counted.
+		 */
+		int num_svm_nodes_unoptimized;
+
 		/* Peak stack usage during shader evaluation. */
 		int peak_stack_usage;
 
@@ -94,6 +99,7 @@ public:
 	             vector<int4>& svm_nodes,
 	             int index,
 	             Summary *summary = NULL);
+	int compile_unoptimized(Scene *scene, Shader *shader);
 
 	void stack_assign(ShaderOutput *output);
 	void stack_assign(ShaderInput *input);
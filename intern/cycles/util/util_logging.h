@@ -40,6 +40,7 @@ public:
 #  define LOG_SUPPRESS() (true) ? (void) 0 : LogMessageVoidify() & StubStream()
 #  define LOG(severity) LOG_SUPPRESS()
 #  define VLOG(severity) LOG_SUPPRESS()
+#  define VLOG_IS_ON(severity) false
 
 #endif
 
@@ -0,0 +1,859 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "util_texture_cache.h"
+
+#include "util_aligned_malloc.h"
+#include "util_atomic.h"
+#include "util_hash.h"
+#include "util_image.h"
+#include "util_list.h"
+#include "util_logging.h"
+#include "util_map.h"
+#include "util_math.h"
+#include "util_path.h"
+#include "util_thread.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* tiles are spread over shards with their own lock and memory limit, so
+ * threads rarely wait for each other */
+#define TEXTURE_CACHE_NUM_SHARDS 16
+
+/* tiles held by a single lookup, enough for trilinear filtering */
+#define TEXTURE_CACHE_MAX_TILE_REFS 8
+
+/* size of the tiles files that are not tiled are split into */
+#define TEXTURE_CACHE_TILE_SIZE 64
+
+struct TextureCache::Tile {
+	uint64_t key;
+	void *data;
+	size_t size;
+
+	/* number of lookups reading the tile, it's not freed while in use */
+	uint32_t users;
+	list<Tile*>::iterator lru;
+};
+
+struct TextureCache::Image {
+	int slot;
+	string filename;
+	bool is_float;
+	bool use_alpha;
+	bool cmyk;
+	/* channels in the file, and stored in tiles: 1 for gray, 3 for RGB
+	 * and 4 for RGBA, so images without alpha don't take more memory */
+	int components;
+	int channels;
+	InterpolationType interpolation;
+	ExtensionType extension;
+
+	/* width and height of every mip level */
+	vector<int2> levels;
+	int tile_width;
+	int tile_height;
+
+	/* open file for reading tiles from, NULL if the file is not tiled */
+	ImageInput *in;
+	thread_mutex mutex;
+
+	/* reading a file that is not tiled failed, don't try again */
+	bool read_failed;
+};
+
+struct TextureCache::Shard {
+	thread_mutex mutex;
+	unordered_map<uint64_t, Tile*> tiles;
+	/* most recently used tiles first */
+	list<Tile*> lru;
+	size_t mem_used;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+
+	Shard() : mem_used(0), hits(0), misses(0), evictions(0) {}
+};
+
+/* Tiles acquired by a lookup, released when it's done. */
+
+struct TextureCache::TileRefs {
+	TextureCache *cache;
+	Tile *tiles[TEXTURE_CACHE_MAX_TILE_REFS];
+	uint64_t keys[TEXTURE_CACHE_MAX_TILE_REFS];
+	int num;
+
+	TileRefs(TextureCache *cache_) : cache(cache_), num(0) {}
+
+	~TileRefs()
+	{
+		for(int i = 0; i < num; i++)
+			if(tiles[i])
+				cache->release_tile(tiles[i]);
+	}
+};
+
+/* Utilities */
+
+static inline uint64_t texture_cache_tile_key(int slot, int level, int tx, int ty)
+{
+	return ((uint64_t)slot << 48) | ((uint64_t)level << 40) | ((uint64_t)ty << 20) | (uint64_t)tx;
+}
+
+static inline int texture_cache_shard(uint64_t key)
+{
+	return hash_int_2d((uint)key, (uint)(key >> 32)) % TEXTURE_CACHE_NUM_SHARDS;
+}
+
+static inline size_t texture_cache_pixel_size(const TextureCache::Image *image)
+{
+	return image->channels*((image->is_float)? sizeof(float): sizeof(uchar));
+}
+
+/* Channels stored for a file, alpha is dropped when it's not used and gray
+ * is kept as a single channel. */
+static int texture_cache_channels(int components, bool cmyk, bool use_alpha)
+{
+	if(cmyk)
+		return 3;
+	if(components == 1 || (components == 2 && !use_alpha))
+		return 1;
+	if(components == 3 || (components >= 4 && !use_alpha))
+		return 3;
+	return 4;
+}
+
+static inline int texture_cache_wrap_periodic(int x, int width)
+{
+	x %= width;
+	if(x < 0)
+		x += width;
+	return x;
+}
+
+static inline int texture_cache_wrap_clamp(int x, int width)
+{
+	return clamp(x, 0, width-1);
+}
+
+static inline float texture_cache_frac(float x, int *ix)
+{
+	int i = float_to_int(x) - ((x < 0.0f)? 1: 0);
+	*ix = i;
+	return x - (float)i;
+}
+
+template<typename T>
+static inline float4 texture_cache_pixel(const T *p, int channels, float f)
+{
+	if(channels == 1)
+		return make_float4(p[0]*f, p[0]*f, p[0]*f, 1.0f);
+	else if(channels == 3)
+		return make_float4(p[0]*f, p[1]*f, p[2]*f, 1.0f);
+	else
+		return make_float4(p[0]*f, p[1]*f, p[2]*f, p[3]*f);
+}
+
+static inline float4 texture_cache_pixel(const TextureCache::Image *image, const void *data, size_t index)
+{
+	int channels = image->channels;
+
+	if(image->is_float)
+		return texture_cache_pixel((const float*)data + index*channels, channels, 1.0f);
+	else
+		return texture_cache_pixel((const uchar*)data + index*channels, channels, 1.0f/255.0f);
+}
+
+static inline uchar texture_cache_mul(uchar a, uchar b) { return (uchar)((a*b)/255); }
+static inline float texture_cache_mul(float a, float b) { return a*b; }
+
+static inline uchar texture_cache_box(uchar a, uchar b, uchar c, uchar d) { return (uchar)((a + b + c + d + 2)/4); }
+static inline float texture_cache_box(float a, float b, float c, float d) { return (a + b + c + d)*0.25f; }
+
+/* Convert pixels as read from the file to the stored channels, matching
+ * the RGBA conversion of the image manager. */
+
+template<typename T>
+static void texture_cache_convert(const TextureCache::Image *image, const T *src, T *dst, size_t num_pixels)
+{
+	int components = image->components;
+	int channels = image->channels;
+
+	for(size_t i = 0; i < num_pixels; i++, src += components, dst += channels) {
+		if(image->cmyk) {
+			dst[0] = texture_cache_mul(src[0], src[3]);
+			dst[1] = texture_cache_mul(src[1], src[3]);
+			dst[2] = texture_cache_mul(src[2], src[3]);
+		}
+		else if(channels == 1) {
+			dst[0] = src[0];
+		}
+		else if(components <= 2) {
+			/* gray with alpha */
+			dst[0] = dst[1] = dst[2] = src[0];
+			dst[3] = src[1];
+		}
+		else {
+			for(int c = 0; c < channels; c++)
+				dst[c] = src[c];
+		}
+	}
+}
+
+/* Next mip level, with a box filter.
+ *
+ * Byte images are filtered on their stored values. For sRGB color textures
+ * this slightly darkens high contrast detail at lower levels, the cache does
+ * not know whether a byte image holds color or non-color data, so it can't
+ * filter in linear space. Converting to a tiled .tx file with maketx avoids
+ * this, since it makes the mip levels itself. */
+
+template<typename T>
+static void texture_cache_downsample(const T *src, int width, int height, int channels,
+                                     T *dst, int dst_width, int dst_height)
+{
+	for(int y = 0; y < dst_height; y++) {
+		const T *row0 = src + (size_t)min(2*y, height-1)*width*channels;
+		const T *row1 = src + (size_t)min(2*y+1, height-1)*width*channels;
+
+		for(int x = 0; x < dst_width; x++) {
+			int x0 = min(2*x, width-1)*channels;
+			int x1 = min(2*x+1, width-1)*channels;
+
+			for(int c = 0; c < channels; c++)
+				dst[c] = texture_cache_box(row0[x0+c], row0[x1+c], row1[x0+c], row1[x1+c]);
+
+			dst += channels;
+		}
+	}
+}
+
+/* Copy a tile out of a mip level, repeating the last row and column for
+ * tiles at the edge. */
+
+static void texture_cache_copy_tile(const uchar *src, int width, int height, size_t pixel_size,
+                                    int tx, int ty, int tile_width, int tile_height, uchar *dst)
+{
+	int x0 = tx*tile_width;
+	int y0 = ty*tile_height;
+	int w = min(tile_width, width - x0);
+
+	for(int y = 0; y < tile_height; y++) {
+		const uchar *row = src + ((size_t)min(y0 + y, height-1)*width + x0)*pixel_size;
+		uchar *dst_row = dst + (size_t)y*tile_width*pixel_size;
+
+		memcpy(dst_row, row, w*pixel_size);
+		for(int x = w; x < tile_width; x++)
+			memcpy(dst_row + x*pixel_size, row + (w-1)*pixel_size, pixel_size);
+	}
+}
+
+/* Texture Cache Statistics */
+
+TextureCacheStats::TextureCacheStats()
+: hits(0), misses(0), evictions(0), full_reads(0), mem_used(0), mem_peak(0)
+{
+}
+
+string TextureCacheStats::full_report() const
+{
+	uint64_t lookups = hits + misses;
+
+	string report = "";
+	report += string_printf("Tile lookups:        %llu\n", (unsigned long long)lookups);
+	report += string_printf("  Hits:              %llu (%.2f%%)\n",
+	                        (unsigned long long)hits,
+	                        (lookups)? 100.0*hits/lookups: 0.0);
+	report += string_printf("  Misses:            %llu\n", (unsigned long long)misses);
+	report += string_printf("Evicted tiles:       %llu\n", (unsigned long long)evictions);
+	report += string_printf("Full image reads:    %llu\n", (unsigned long long)full_reads);
+	report += string_printf("Memory used:         %.2fM\n", mem_used/(1024.0*1024.0));
+	report += string_printf("Peak memory:         %.2fM\n", mem_peak/(1024.0*1024.0));
+
+	return report;
+}
+
+/* Texture Cache */
+
+TextureCache::TextureCache(size_t max_memory_)
+: max_memory(max_memory_), mem_used(0), mem_peak(0), full_reads(0)
+{
+	shards = new Shard[TEXTURE_CACHE_NUM_SHARDS];
+}
+
+TextureCache::~TextureCache()
+{
+	for(size_t slot = 0; slot < images.size(); slot++)
+		remove_image(slot);
+
+	delete [] shards;
+}
+
+bool TextureCache::add_image(int slot,
+                             const string& filename,
+                             bool is_float,
+                             bool use_alpha,
+                             InterpolationType interpolation,
+                             ExtensionType extension)
+{
+	remove_image(slot);
+
+	if(filename == "")
+		return false;
+
+	/* prefer a tiled and mip-mapped version of the image next to it */
+	string name = path_filename(filename);
+	size_t dot = name.rfind('.');
+	string tx_filename = path_join(path_dirname(filename),
+	                               ((dot == string::npos)? name: name.substr(0, dot)) + ".tx");
+
+	/* a .tx file older than the image is out of date */
+	string read_filename = filename;
+
+	if(path_exists(tx_filename)) {
+		if(path_modified_time(tx_filename) >= path_modified_time(filename))
+			read_filename = tx_filename;
+		else
+			VLOG(1) << "Texture cache: " << tx_filename << " is older than " << filename << ", not using it.";
+	}
+
+	ImageInput *in = ImageInput::create(read_filename);
+
+	if(!in)
+		return false;
+
+	ImageSpec spec = ImageSpec();
+	ImageSpec config = ImageSpec();
+
+	if(use_alpha == false)
+		config.attribute("oiio:UnassociatedAlpha", 1);
+
+	if(!in->open(read_filename, spec, config)) {
+		delete in;
+		return false;
+	}
+
+	/* only 2D images are cached */
+	if(spec.nchannels < 1 || spec.width < 1 || spec.height < 1 || spec.depth > 1) {
+		in->close();
+		delete in;
+		return false;
+	}
+
+	Image *image = new Image();
+	image->slot = slot;
+	image->read_failed = false;
+	image->filename = read_filename;
+	image->is_float = is_float;
+	image->use_alpha = use_alpha;
+	image->cmyk = strcmp(in->format_name(), "jpeg") == 0 && spec.nchannels == 4;
+	image->components = spec.nchannels;
+	image->channels = texture_cache_channels(spec.nchannels, image->cmyk, use_alpha);
+	image->interpolation = interpolation;
+	image->extension = extension;
+
+	if(spec.tile_width > 0 && spec.tile_height > 0) {
+		/* read tiles from the file as needed, using its mip levels */
+		image->tile_width = spec.tile_width;
+		image->tile_height = spec.tile_height;
+
+		ImageSpec level_spec;
+		for(int level = 0; in->seek_subimage(0, level, level_spec); level++)
+			image->levels.push_back(make_int2(level_spec.width, level_spec.height));
+
+		image->in = in;
+	}
+	else {
+		/* read the whole image when one of its tiles is needed, and make mip
+		 * levels from it, split into tiles */
+		image->tile_width = TEXTURE_CACHE_TILE_SIZE;
+		image->tile_height = TEXTURE_CACHE_TILE_SIZE;
+
+		int width = spec.width, height = spec.height;
+		image->levels.push_back(make_int2(width, height));
+
+		while(width > 1 || height > 1) {
+			width = max(width/2, 1);
+			height = max(height/2, 1);
+			image->levels.push_back(make_int2(width, height));
+		}
+
+		image->in = NULL;
+		in->close();
+		delete in;
+
+		VLOG(1) << "Texture cache: " << read_filename << " is not tiled and mip-mapped, "
+		        << "it will be read in full whenever its tiles are needed, "
+		        << "convert it with maketx for faster loading.";
+	}
+
+	if(slot >= (int)images.size())
+		images.resize(slot + 1, NULL);
+	images[slot] = image;
+
+	return true;
+}
+
+void TextureCache::remove_image(int slot)
+{
+	if(slot < 0 || slot >= (int)images.size() || !images[slot])
+		return;
+
+	Image *image = images[slot];
+
+	for(int i = 0; i < TEXTURE_CACHE_NUM_SHARDS; i++) {
+		Shard& shard = shards[i];
+		thread_scoped_lock lock(shard.mutex);
+
+		unordered_map<uint64_t, Tile*>::iterator it = shard.tiles.begin();
+
+		while(it != shard.tiles.end()) {
+			Tile *tile = it->second;
+
+			if((int)(tile->key >> 48) != slot) {
+				++it;
+				continue;
+			}
+
+			shard.lru.erase(tile->lru);
+			shard.mem_used -= tile->size;
+			atomic_sub_z(&mem_used, tile->size);
+
+			util_aligned_free(tile->data);
+			delete tile;
+
+			shard.tiles.erase(it++);
+		}
+	}
+
+	if(image->in) {
+		image->in->close();
+		delete image->in;
+	}
+
+	delete image;
+	images[slot] = NULL;
+}
+
+TextureCacheStats TextureCache::get_stats()
+{
+	TextureCacheStats stats;
+
+	for(int i = 0; i < TEXTURE_CACHE_NUM_SHARDS; i++) {
+		Shard& shard = shards[i];
+		thread_scoped_lock lock(shard.mutex);
+
+		stats.hits += shard.hits;
+		stats.misses += shard.misses;
+		stats.evictions += shard.evictions;
+	}
+
+	stats.full_reads = full_reads;
+	stats.mem_used = mem_used;
+	stats.mem_peak = mem_peak;
+
+	return stats;
+}
+
+/* Lookup */
+
+float4 TextureCache::lookup_image(Image *image, float x, float y, float width)
+{
+	TileRefs refs(this);
+
+	if(image->interpolation == INTERPOLATION_CLOSEST)
+		return lookup_closest(image, 0, x, y, refs);
+
+	/* mip level with about one texel in the footprint, blending between the
+	 * two nearest levels */
+	int num_levels = image->levels.size();
+	float lod = 0.0f;
+
+	if(width > 0.0f && num_levels > 1) {
+		const int2& size = image->levels[0];
+		lod = clamp(log2f(width*max(size.x, size.y)), 0.0f, (float)(num_levels - 1));
+	}
+
+	int level;
+	float t = texture_cache_frac(lod, &level);
+
+	float4 r = lookup_linear(image, level, x, y, refs);
+
+	if(t > 0.0f && level + 1 < num_levels)
+		r = (1.0f - t)*r + t*lookup_linear(image, level + 1, x, y, refs);
+
+	return r;
+}
+
+float4 TextureCache::lookup_closest(Image *image, int level, float x, float y, TileRefs& refs)
+{
+	const int2& size = image->levels[level];
+	int ix, iy;
+
+	texture_cache_frac(x*(float)size.x, &ix);
+	texture_cache_frac(y*(float)size.y, &iy);
+
+	switch(image->extension) {
+		case EXTENSION_REPEAT:
+			ix = texture_cache_wrap_periodic(ix, size.x);
+			iy = texture_cache_wrap_periodic(iy, size.y);
+			break;
+		case EXTENSION_CLIP:
+			if(x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f)
+				return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+			/* Fall through. */
+		case EXTENSION_EXTEND:
+			ix = texture_cache_wrap_clamp(ix, size.x);
+			iy = texture_cache_wrap_clamp(iy, size.y);
+			break;
+	}
+
+	return texel(image, level, ix, iy, refs);
+}
+
+float4 TextureCache::lookup_linear(Image *image, int level, float x, float y, TileRefs& refs)
+{
+	const int2& size = image->levels[level];
+	int ix, iy, nix, niy;
+
+	float tx = texture_cache_frac(x*(float)size.x - 0.5f, &ix);
+	float ty = texture_cache_frac(y*(float)size.y - 0.5f, &iy);
+
+	switch(image->extension) {
+		case EXTENSION_REPEAT:
+			ix = texture_cache_wrap_periodic(ix, size.x);
+			iy = texture_cache_wrap_periodic(iy, size.y);
+
+			nix = texture_cache_wrap_periodic(ix+1, size.x);
+			niy = texture_cache_wrap_periodic(iy+1, size.y);
+			break;
+		case EXTENSION_CLIP:
+			if(x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f)
+				return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+			/* Fall through. */
+		default:
+			nix = texture_cache_wrap_clamp(ix+1, size.x);
+			niy = texture_cache_wrap_clamp(iy+1, size.y);
+
+			ix = texture_cache_wrap_clamp(ix, size.x);
+			iy = texture_cache_wrap_clamp(iy, size.y);
+			break;
+	}
+
+	float4 r = (1.0f - ty)*(1.0f - tx)*texel(image, level, ix, iy, refs);
+	r += (1.0f - ty)*tx*texel(image, level, nix, iy, refs);
+	r += ty*(1.0f - tx)*texel(image, level, ix, niy, refs);
+	r += ty*tx*texel(image, level, nix, niy, refs);
+
+	return r;
+}
+
+float4 TextureCache::texel(Image *image, int level, int x, int y, TileRefs& refs)
+{
+	/* texture coordinates start at the bottom, tiles are stored top row
+	 * first like in the file */
+	y = image->levels[level].y - 1 - y;
+
+	int tx = x/image->tile_width;
+	int ty = y/image->tile_height;
+	uint64_t key = texture_cache_tile_key(image->slot, level, tx, ty);
+
+	Tile *tile = NULL;
+	bool release = false;
+	int i;
+
+	for(i = 0; i < refs.num; i++) {
+		if(refs.keys[i] == key) {
+			tile = refs.tiles[i];
+			break;
+		}
+	}
+
+	if(i == refs.num) {
+		tile = acquire_tile(image, level, tx, ty);
+
+		if(refs.num < TEXTURE_CACHE_MAX_TILE_REFS) {
+			refs.tiles[refs.num] = tile;
+			refs.keys[refs.num] = key;
+			refs.num++;
+		}
+		else {
+			release = (tile != NULL);
+		}
+	}
+
+	if(!tile)
+		return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+	size_t index = (x - tx*image->tile_width) + (size_t)(y - ty*image->tile_height)*image->tile_width;
+	float4 r = texture_cache_pixel(image, tile->data, index);
+
+	if(release)
+		release_tile(tile);
+
+	return r;
+}
+
+/* Tiles */
+
+TextureCache::Tile *TextureCache::find_tile(Image *image, int level, int tx, int ty)
+{
+	uint64_t key = texture_cache_tile_key(image->slot, level, tx, ty);
+	Shard& shard = shards[texture_cache_shard(key)];
+	thread_scoped_lock lock(shard.mutex);
+
+	unordered_map<uint64_t, Tile*>::iterator it = shard.tiles.find(key);
+
+	if(it == shard.tiles.end())
+		return NULL;
+
+	/* users are only added with the shard locked, so tiles can't get in use
+	 * while evicting them */
+	Tile *tile = it->second;
+	atomic_add_uint32(&tile->users, 1);
+	shard.lru.splice(shard.lru.begin(), shard.lru, tile->lru);
+	shard.hits++;
+
+	return tile;
+}
+
+TextureCache::Tile *TextureCache::acquire_tile(Image *image, int level, int tx, int ty)
+{
+	Tile *tile = find_tile(image, level, tx, ty);
+
+	if(tile)
+		return tile;
+
+	uint64_t key = texture_cache_tile_key(image->slot, level, tx, ty);
+	atomic_add_uint64(&shards[texture_cache_shard(key)].misses, 1);
+
+	return load_tile(image, level, tx, ty);
+}
+
+void TextureCache::release_tile(Tile *tile)
+{
+	atomic_sub_uint32(&tile->users, 1);
+}
+
+TextureCache::Tile *TextureCache::insert_tile(Image *image, int level, int tx, int ty,
+                                              void *data, size_t size, bool acquire)
+{
+	uint64_t key = texture_cache_tile_key(image->slot, level, tx, ty);
+	Shard& shard = shards[texture_cache_shard(key)];
+	size_t shard_max_memory = max_memory/TEXTURE_CACHE_NUM_SHARDS;
+	thread_scoped_lock lock(shard.mutex);
+
+	unordered_map<uint64_t, Tile*>::iterator it = shard.tiles.find(key);
+	Tile *tile;
+
+	if(it != shard.tiles.end()) {
+		/* loaded by another thread meanwhile */
+		util_aligned_free(data);
+
+		tile = it->second;
+		shard.lru.splice(shard.lru.begin(), shard.lru, tile->lru);
+	}
+	else {
+		/* free least recently used tiles that are not in use */
+		list<Tile*>::iterator lru_it = shard.lru.end();
+
+		while(shard.mem_used + size > shard_max_memory && lru_it != shard.lru.begin()) {
+			--lru_it;
+			Tile *old_tile = *lru_it;
+
+			if(old_tile->users)
+				continue;
+
+			lru_it = shard.lru.erase(lru_it);
+			shard.tiles.erase(old_tile->key);
+			shard.mem_used -= old_tile->size;
+			shard.evictions++;
+			atomic_sub_z(&mem_used, old_tile->size);
+
+			util_aligned_free(old_tile->data);
+			delete old_tile;
+		}
+
+		tile = new Tile();
+		tile->key = key;
+		tile->data = data;
+		tile->size = size;
+		tile->users = 0;
+
+		shard.lru.push_front(tile);
+		tile->lru = shard.lru.begin();
+		shard.tiles[key] = tile;
+		shard.mem_used += size;
+
+		atomic_update_max_z(&mem_peak, atomic_add_z(&mem_used, size));
+	}
+
+	if(!acquire)
+		return NULL;
+
+	atomic_add_uint32(&tile->users, 1);
+	return tile;
+}
+
+/* Read a single tile from a tiled file. */
+
+TextureCache::Tile *TextureCache::load_tile(Image *image, int level, int tx, int ty)
+{
+	if(!image->in)
+		return load_image(image, level, tx, ty);
+
+	thread_scoped_lock lock(image->mutex);
+
+	ImageSpec spec;
+
+	if(!image->in->seek_subimage(0, level, spec))
+		return NULL;
+
+	size_t num_pixels = ((size_t)image->tile_width)*image->tile_height;
+	size_t size = num_pixels*texture_cache_pixel_size(image);
+	void *data = util_aligned_malloc(size, 16);
+	bool ok;
+
+	if(image->is_float) {
+		vector<float> pixels(num_pixels*image->components);
+		ok = image->in->read_tile(tx*image->tile_width, ty*image->tile_height, 0,
+		                          TypeDesc::FLOAT, &pixels[0]);
+		if(ok)
+			texture_cache_convert(image, &pixels[0], (float*)data, num_pixels);
+	}
+	else {
+		vector<uchar> pixels(num_pixels*image->components);
+		ok = image->in->read_tile(tx*image->tile_width, ty*image->tile_height, 0,
+		                          TypeDesc::UINT8, &pixels[0]);
+		if(ok)
+			texture_cache_convert(image, &pixels[0], (uchar*)data, num_pixels);
+	}
+
+	if(!ok) {
+		util_aligned_free(data);
+		return NULL;
+	}
+
+	return insert_tile(image, level, tx, ty, data, size, true);
+}
+
+/* Read a file that is not tiled in full, make its mip levels and insert
+ * them into the cache as tiles. These are evicted like any other tile, the
+ * file is read again when one of them is needed after that. */
+
+TextureCache::Tile *TextureCache::load_image(Image *image, int level, int tx, int ty)
+{
+	thread_scoped_lock lock(image->mutex);
+
+	/* another thread may have read the image meanwhile */
+	Tile *tile = find_tile(image, level, tx, ty);
+
+	if(tile || image->read_failed)
+		return tile;
+
+	int num_levels = image->levels.size();
+	size_t pixel_size = texture_cache_pixel_size(image);
+	vector<uchar> src, dst;
+	bool ok = false;
+
+	ImageInput *in = ImageInput::create(image->filename);
+
+	if(in) {
+		ImageSpec spec = ImageSpec();
+		ImageSpec config = ImageSpec();
+
+		if(image->use_alpha == false)
+			config.attribute("oiio:UnassociatedAlpha", 1);
+
+		if(in->open(image->filename, spec, config)) {
+			size_t num_pixels = ((size_t)spec.width)*spec.height;
+
+			dst.resize(num_pixels*pixel_size);
+
+			if(image->is_float) {
+				vector<float> pixels(num_pixels*image->components);
+				ok = in->read_image(TypeDesc::FLOAT, &pixels[0]);
+				if(ok)
+					texture_cache_convert(image, &pixels[0], (float*)&dst[0], num_pixels);
+			}
+			else {
+				vector<uchar> pixels(num_pixels*image->components);
+				ok = in->read_image(TypeDesc::UINT8, &pixels[0]);
+				if(ok)
+					texture_cache_convert(image, &pixels[0], &dst[0], num_pixels);
+			}
+
+			in->close();
+		}
+
+		delete in;
+	}
+
+	if(!ok) {
+		image->read_failed = true;
+		return NULL;
+	}
+
+	atomic_add_uint64(&full_reads, 1);
+
+	size_t tile_size = ((size_t)image->tile_width)*image->tile_height*pixel_size;
+
+	for(int l = 0; l < num_levels; l++) {
+		const int2& size = image->levels[l];
+
+		if(l > 0) {
+			const int2& src_size = image->levels[l-1];
+
+			src.swap(dst);
+			dst.resize(((size_t)size.x)*size.y*pixel_size);
+
+			if(image->is_float) {
+				texture_cache_downsample((float*)&src[0], src_size.x, src_size.y, image->channels,
+				                         (float*)&dst[0], size.x, size.y);
+			}
+			else {
+				texture_cache_downsample(&src[0], src_size.x, src_size.y, image->channels,
+				                         &dst[0], size.x, size.y);
+			}
+		}
+
+		int num_tiles_x = (size.x + image->tile_width - 1)/image->tile_width;
+		int num_tiles_y = (size.y + image->tile_height - 1)/image->tile_height;
+
+		for(int y = 0; y < num_tiles_y; y++) {
+			for(int x = 0; x < num_tiles_x; x++) {
+				uchar *data = (uchar*)util_aligned_malloc(tile_size, 16);
+				texture_cache_copy_tile(&dst[0], size.x, size.y, pixel_size,
+				                        x, y, image->tile_width, image->tile_height, data);
+
+				/* the requested tile is held, so it's not evicted by the ones after it */
+				bool acquire = (l == level && x == tx && y == ty);
+				Tile *new_tile = insert_tile(image, l, x, y, data, tile_size, acquire);
+
+				if(acquire)
+					tile = new_tile;
+			}
+		}
+	}
+
+	return tile;
+}
+
+CCL_NAMESPACE_END
+
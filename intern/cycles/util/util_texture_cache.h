@@ -0,0 +1,121 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util_string.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache Statistics */
+
+class TextureCacheStats {
+public:
+	/* tile requests found in the cache, and loaded from file */
+	uint64_t hits;
+	uint64_t misses;
+	/* tiles freed to stay within the memory limit */
+	uint64_t evictions;
+	/* reads of images that are not tiled and mip-mapped, these are read in
+	 * full again when their tiles were evicted */
+	uint64_t full_reads;
+
+	size_t mem_used;
+	size_t mem_peak;
+
+	TextureCacheStats();
+
+	string full_report() const;
+};
+
+/* Texture Cache
+ *
+ * Image textures for the CPU kernel, read on demand in tiles at the mip level
+ * matching the footprint of each lookup. Tiles are read directly from tiled
+ * and mip-mapped files, such as the .tx files made by maketx, which are used
+ * in place of the original image when found next to it and up to date. Other
+ * files are read in full when one of their tiles is needed, to build their
+ * mip levels and split them into tiles.
+ *
+ * Tiles store only the channels the image needs, gray and RGB images without
+ * alpha take one and three channels.
+ *
+ * Once the memory limit is reached the least recently used tiles are freed.
+ * Lookups are thread safe, images are added and removed while not rendering. */
+
+class TextureCache {
+public:
+	explicit TextureCache(size_t max_memory);
+	~TextureCache();
+
+	/* images are identified by their slot in the image manager, returns false
+	 * for images the cache can't read */
+	bool add_image(int slot,
+	               const string& filename,
+	               bool is_float,
+	               bool use_alpha,
+	               InterpolationType interpolation,
+	               ExtensionType extension);
+	void remove_image(int slot);
+
+	/* Filtered lookup, width is the size of the footprint in texture
+	 * coordinates. Returns false for images not in the cache. */
+	bool lookup(int slot, float x, float y, float width, float4 *result)
+	{
+		if(slot < 0 || slot >= (int)images.size() || images[slot] == NULL)
+			return false;
+
+		*result = lookup_image(images[slot], x, y, width);
+		return true;
+	}
+
+	TextureCacheStats get_stats();
+
+	struct Image;
+	struct Tile;
+	struct TileRefs;
+	struct Shard;
+
+protected:
+	vector<Image*> images;
+	Shard *shards;
+	size_t max_memory;
+	size_t mem_used;
+	size_t mem_peak;
+	uint64_t full_reads;
+
+	float4 lookup_image(Image *image, float x, float y, float width);
+	float4 lookup_closest(Image *image, int level, float x, float y, TileRefs& refs);
+	float4 lookup_linear(Image *image, int level, float x, float y, TileRefs& refs);
+	float4 texel(Image *image, int level, int x, int y, TileRefs& refs);
+
+	Tile *find_tile(Image *image, int level, int tx, int ty);
+	Tile *acquire_tile(Image *image, int level, int tx, int ty);
+	void release_tile(Tile *tile);
+	Tile *insert_tile(Image *image, int level, int tx, int ty,
+	                  void *data, size_t size, bool acquire);
+
+	Tile *load_tile(Image *image, int level, int tx, int ty);
+	Tile *load_image(Image *image, int level, int tx, int ty);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
+
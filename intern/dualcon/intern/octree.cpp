@@ -46,6 +46,16 @@
 #define dc_printf(...) do {} while (0)
 #endif
 
+/* minimum number of cells or quads to compute them in parallel */
+#define DC_OMP_LIMIT 10000
+
+/* triangles scan converted at once, and the minimum to do so in parallel */
+#define DC_SCAN_BATCH 4096
+#define DC_SCAN_OMP_LIMIT 256
+
+/* octree levels the contour traversal is split into tasks for, 8 levels give up to 64 cell tasks */
+#define DC_CONTOUR_SPLIT_LEVELS 2
+
 Octree::Octree(ModelReader *mr,
                DualConAllocOutput alloc_output_func,
                DualConAddVert add_vert_func,
@@ -269,61 +279,54 @@ void Octree::addAllTriangles()
 
 #if DC_DEBUG
 	int total = reader->getNumTriangles();
-	int unitcount = 1000;
 	dc_printf("\nScan converting to depth %d...\n", maxDepth);
 #endif
 
 	srand(0);
 
-	while ((trian = reader->getNextTriangle()) != NULL) {
-		// Drop triangles
-		{
-			addTriangle(trian, count);
+	// Triangles are scan converted in parallel, only reading the octree parameters,
+	// then added in order, since the first triangle crossing a cell edge sets its intersection
+	Triangle **trians = new Triangle *[DC_SCAN_BATCH];
+	ScanTriangle *scans = new ScanTriangle[DC_SCAN_BATCH];
+
+	while (true) {
+		int tottrian = 0;
+		while (tottrian < DC_SCAN_BATCH && (trian = reader->getNextTriangle()) != NULL) {
+			trians[tottrian++] = trian;
 		}
-		delete trian;
 
-		count++;
+		if (tottrian == 0) {
+			break;
+		}
 
-#if DC_DEBUG
-		if (count % unitcount == 0) {
-			putchar(13);
-
-			switch ((count / unitcount) % 4) {
-				case 0: dc_printf("-");
-					break;
-				case 1: dc_printf("/");
-					break;
-				case 2: dc_printf("|");
-					break;
-				case 3: dc_printf("\\");
-					break;
-			}
+#pragma omp parallel for schedule(dynamic, 64) if (tottrian > DC_SCAN_OMP_LIMIT)
+		for (int i = 0; i < tottrian; i++) {
+			scanTriangle(trians[i], count + i, &scans[i]);
+		}
 
-			float percent = (float) count / total;
+		for (int i = 0; i < tottrian; i++) {
+			const ScanTriangle *scan = &scans[i];
+			root = (Node *)addTriangle(&root->internal, scan, 0, (int)scan->cells.size(), maxDepth);
+			delete trians[i];
+		}
 
-			/*
-			   int totbars = 50;
-			   int bars =(int)(percent * totbars);
-			   for(int i = 0; i < bars; i ++) {
-			    putchar(219);
-			   }
-			   for(i = bars; i < totbars; i ++) {
-			    putchar(176);
-			   }
-			 */
+		count += tottrian;
 
-			dc_printf(" %d triangles: ", count);
-			dc_printf(" %f%% complete.", 100 * percent);
-		}
+#if DC_DEBUG
+		dc_printf("\r %d triangles: ", count);
+		dc_printf(" %f%% complete.", 100 * (float)count / total);
 #endif
-
 	}
+
+	delete [] trians;
+	delete [] scans;
+
 	putchar(13);
 }
 
-/* Prepare a triangle for insertion into the octree; call the other
-   addTriangle() to (recursively) build the octree */
-void Octree::addTriangle(Triangle *trian, int triind)
+/* Prepare a triangle for insertion into the octree; call scanCells()
+   to (recursively) find the cells it intersects */
+void Octree::scanTriangle(Triangle *trian, int triind, ScanTriangle *scan) const
 {
 	int i, j;
 
@@ -341,26 +344,23 @@ void Octree::addTriangle(Triangle *trian, int triind)
 			trig[i][j] = (int64_t)(trian->vt[i][j]);
 	}
 
-	/* Add triangle to the octree */
+	/* Find the cells of the octree the triangle intersects */
 	int64_t errorvec = (int64_t)(0);
 	CubeTriangleIsect *proj = new CubeTriangleIsect(cube, trig, errorvec, triind);
-	root = (Node *)addTriangle(&root->internal, proj, maxDepth);
+
+	for (i = 0; i < 3; i++) {
+		scan->norm[i] = (float)proj->inherit->norm[i];
+	}
+	scan->cells.clear();
+	scanCells(proj, maxDepth, scan->cells);
 
 	delete proj->inherit;
 	delete proj;
 }
 
-#if 0
-static void print_depth(int height, int maxDepth)
-{
-	for (int i = 0; i < maxDepth - height; i++)
-		printf("  ");
-}
-#endif
-
-InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height)
+void Octree::scanCells(CubeTriangleIsect *p, int height, std::vector<ScanCell>& cells) const
 {
-	int i;
+	int i, j;
 	const int vertdiff[8][3] = {
 		{0,  0,  0},
 		{0,  0,  1},
@@ -371,12 +371,11 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 		{0,  1, -1},
 		{0,  0,  1}};
 	unsigned char boxmask = p->getBoxMask();
-	CubeTriangleIsect *subp = new CubeTriangleIsect(p);
-	
-	int count = 0;
+	CubeTriangleIsect subp(p);
+
 	int tempdiff[3] = {0, 0, 0};
 
-	/* Check triangle against each of the input node's children */
+	/* Check triangle against each of the input cell's children */
 	for (i = 0; i < 8; i++) {
 		tempdiff[0] += vertdiff[i][0];
 		tempdiff[1] += vertdiff[i][1];
@@ -384,36 +383,63 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 
 		/* Quick pruning using bounding box */
 		if (boxmask & (1 << i)) {
-			subp->shift(tempdiff);
+			subp.shift(tempdiff);
 			tempdiff[0] = tempdiff[1] = tempdiff[2] = 0;
 
 			/* Pruning using intersection test */
-			if (subp->isIntersecting()) {
-				if (!node->has_child(i)) {
-					if (height == 1)
-						node = addLeafChild(node, i, count, createLeaf(0));
-					else
-						node = addInternalChild(node, i, count, createInternal(0));
+			if (subp.isIntersecting()) {
+				const int index = (int)cells.size();
+				ScanCell cell;
+
+				cell.child = i;
+				cell.edges = 0;
+
+				if (height == 1) {
+					for (j = 0; j < 3; j++) {
+						if (subp.isIntersectingPrimary(j)) {
+							cell.edges |= (1 << j);
+							cell.offs[j] = subp.getIntersectionPrimary(j);
+						}
+					}
+					cell.end = index + 1;
+					cells.push_back(cell);
+				}
+				else {
+					cells.push_back(cell);
+					scanCells(&subp, height - 1, cells);
+					cells[index].end = (int)cells.size();
 				}
-				Node *chd = node->get_child(count);
-
-				if (node->is_child_leaf(i))
-					node->set_child(count, (Node *)updateCell(&chd->leaf, subp));
-				else
-					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1));
 			}
 		}
-
-		if (node->has_child(i))
-			count++;
 	}
+}
+
+/* Add the cells a triangle intersects to the octree, from begin to end */
+InternalNode *Octree::addTriangle(InternalNode *node, const ScanTriangle *scan, int begin, int end, int height)
+{
+	for (int c = begin; c < end; c = scan->cells[c].end) {
+		const ScanCell *cell = &scan->cells[c];
+		const int i = cell->child;
+		const int count = node->get_child_count(i);
+
+		if (!node->has_child(i)) {
+			if (height == 1)
+				node = addLeafChild(node, i, count, createLeaf(0));
+			else
+				node = addInternalChild(node, i, count, createInternal(0));
+		}
+		Node *chd = node->get_child(count);
 
-	delete subp;
+		if (node->is_child_leaf(i))
+			node->set_child(count, (Node *)updateCell(&chd->leaf, cell, scan->norm));
+		else
+			node->set_child(count, (Node *)addTriangle(&chd->internal, scan, c + 1, cell->end, height - 1));
+	}
 
 	return node;
 }
 
-LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
+LeafNode *Octree::updateCell(LeafNode *node, const ScanCell *cell, const float norm[3])
 {
 	int i;
 
@@ -425,13 +451,13 @@ LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
 
 	for (i = 0; i < 3; i++) {
 		if (!getEdgeParity(node, mask[i])) {
-			if (p->isIntersectingPrimary(i)) {
+			if (cell->edges & (1 << i)) {
 				// actualQuads ++;
 				setEdge(node, mask[i]);
-				offs[newc] = p->getIntersectionPrimary(i);
-				a[newc] = (float) p->inherit->norm[0];
-				b[newc] = (float) p->inherit->norm[1];
-				c[newc] = (float) p->inherit->norm[2];
+				offs[newc] = cell->offs[i];
+				a[newc] = norm[0];
+				b[newc] = norm[1];
+				c[newc] = norm[2];
 				newc++;
 			}
 		}
@@ -2063,8 +2089,52 @@ void Octree::writeOut()
 	actualVerts = 0;
 	actualQuads = 0;
 
-	generateMinimizer(root, st, dimen, maxDepth, offset);
-	cellProcContour(root, 0, maxDepth);
+	// Each cell places at least one vertex, so there are no more cells than vertices
+	MinimizerCell *cells = new MinimizerCell[numVertices];
+	float (*minimizers)[3] = new float[numVertices][3];
+	int totcell = 0;
+
+	generateMinimizer(root, st, dimen, maxDepth, offset, cells, totcell);
+
+	// Cells only read the octree, so their minimizers are independent
+#pragma omp parallel for schedule(dynamic, 256) if (totcell > DC_OMP_LIMIT)
+	for (int i = 0; i < totcell; i++) {
+		computeCellMinimizer(&cells[i], minimizers[i]);
+	}
+
+	// Vertices are added in octree order, as their indices were assigned
+	for (int i = 0; i < totcell; i++) {
+		for (int j = 0; j < cells[i].mult; j++) {
+			add_vert(output_mesh, minimizers[i]);
+		}
+	}
+
+	delete [] cells;
+	delete [] minimizers;
+
+	// Then the quads, the contour traversal only reads the octree, so its tasks are independent
+	std::vector<ContourTask> tasks;
+	splitCellContour(root, 0, maxDepth, DC_CONTOUR_SPLIT_LEVELS, tasks);
+
+	const int tottask = (int)tasks.size();
+	ContourQuads *task_quads = new ContourQuads[tottask];
+
+#pragma omp parallel for schedule(dynamic, 1) if (numQuads > DC_OMP_LIMIT)
+	for (int i = 0; i < tottask; i++) {
+		processContourTask(tasks[i], task_quads[i]);
+	}
+
+	// Quads are added in traversal order, as the serial traversal would
+	for (int i = 0; i < tottask; i++) {
+		const ContourQuads& quads = task_quads[i];
+		for (size_t j = 0; j < quads.size(); j += 4) {
+			add_quad(output_mesh, &quads[j]);
+			actualQuads++;
+		}
+	}
+
+	delete [] task_quads;
+
 	dc_printf("Vertices written: %d Quads written: %d \n", offset, actualQuads);
 }
 
@@ -2257,27 +2327,28 @@ void Octree::computeMinimizer(const LeafNode *leaf, int st[3], int len,
 	}
 }
 
-void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset)
+void Octree::computeCellMinimizer(const MinimizerCell *cell, float rvalue[3]) const
 {
-	int i, j;
+	int st[3] = {cell->st[0], cell->st[1], cell->st[2]};
+	int len = cell->len;
 
-	if (height == 0) {
-		// Leaf cell, generate
+	rvalue[0] = (float) st[0] + len / 2;
+	rvalue[1] = (float) st[1] + len / 2;
+	rvalue[2] = (float) st[2] + len / 2;
+	computeMinimizer(cell->leaf, st, len, rvalue);
 
-		// First, find minimizer
-		float rvalue[3];
-		rvalue[0] = (float) st[0] + len / 2;
-		rvalue[1] = (float) st[1] + len / 2;
-		rvalue[2] = (float) st[2] + len / 2;
-		computeMinimizer(&node->leaf, st, len, rvalue);
+	for (int j = 0; j < 3; j++) {
+		rvalue[j] = rvalue[j] * range / dimen + origin[j];
+	}
+}
 
-		// Update
-		//float fnst[3];
-		for (j = 0; j < 3; j++) {
-			rvalue[j] = rvalue[j] * range / dimen + origin[j];
-			//fnst[j] = st[j] * range / dimen + origin[j];
-		}
+void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+                               MinimizerCell *cells, int& totcell)
+{
+	int i, j;
 
+	if (height == 0) {
+		// Leaf cell, the minimizer is computed later for cells placing vertices
 		int mult = 0, smask = getSignMask(&node->leaf);
 
 		if (use_manifold) {
@@ -2289,8 +2360,15 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 			}
 		}
 
-		for (j = 0; j < mult; j++) {
-			add_vert(output_mesh, rvalue);
+		if (mult > 0) {
+			MinimizerCell *cell = &cells[totcell++];
+
+			cell->leaf = &node->leaf;
+			for (j = 0; j < 3; j++) {
+				cell->st[j] = st[j];
+			}
+			cell->len = len;
+			cell->mult = mult;
 		}
 
 		// Store the index
@@ -2310,14 +2388,14 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 				nst[2] = st[2] + vertmap[i][2] * len;
 
 				generateMinimizer(node->internal.get_child(count),
-				                  nst, len, height - 1, offset);
+				                  nst, len, height - 1, offset, cells, totcell);
 				count++;
 			}
 		}
 	}
 }
 
-void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, int dir)
+void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, int dir, ContourQuads& quads)
 {
 	//int color = 0;
 
@@ -2369,7 +2447,7 @@ void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, i
 						ind[3] = getMinimizerIndex((LeafNode *)(node[2]));
 					}
 
-					add_quad(output_mesh, ind);
+					quads.insert(quads.end(), ind, ind + 4);
 				}
 			}
 			return;
@@ -2381,13 +2459,13 @@ void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, i
 }
 
 
-void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir)
+void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir, ContourQuads& quads)
 {
 	if (!(node[0] && node[1] && node[2] && node[3])) {
 		return;
 	}
 	if (leaf[0] && leaf[1] && leaf[2] && leaf[3]) {
-		processEdgeWrite(node, depth, maxdep, dir);
+		processEdgeWrite(node, depth, maxdep, dir, quads);
 	}
 	else {
 		int i, j;
@@ -2423,13 +2501,13 @@ void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4]);
+			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4], quads);
 		}
 
 	}
 }
 
-void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir)
+void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir, ContourQuads& quads)
 {
 	if (!(node[0] && node[1])) {
 		return;
@@ -2465,7 +2543,7 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 					df[j] = depth[j] - 1;
 				}
 			}
-			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2]);
+			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2], quads);
 		}
 
 		// 4 edge calls
@@ -2492,13 +2570,50 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5]);
+			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5], quads);
 		}
 	}
 }
 
 
-void Octree::cellProcContour(Node *node, int leaf, int depth)
+// Children of an internal cell, NULL where there is none
+static void cell_children(Node *node, Node *chd[8])
+{
+	for (int i = 0; i < 8; i++) {
+		chd[i] = node->internal.has_child(i) ?
+		         node->internal.get_child(node->internal.get_child_count(i)) : NULL;
+	}
+}
+
+// Face between two children of an internal cell
+static void cell_face_task(Node *node, Node *chd[8], int depth, int i, ContourTask *task)
+{
+	task->type = ContourTask::FACE;
+	for (int j = 0; j < 2; j++) {
+		int c = cellProcFaceMask[i][j];
+		task->node[j] = chd[c];
+		task->leaf[j] = node->internal.is_child_leaf(c);
+		task->depth[j] = depth - 1;
+	}
+	task->maxdep = depth - 1;
+	task->dir = cellProcFaceMask[i][2];
+}
+
+// Edge between four children of an internal cell
+static void cell_edge_task(Node *node, Node *chd[8], int depth, int i, ContourTask *task)
+{
+	task->type = ContourTask::EDGE;
+	for (int j = 0; j < 4; j++) {
+		int c = cellProcEdgeMask[i][j];
+		task->node[j] = chd[c];
+		task->leaf[j] = node->internal.is_child_leaf(c);
+		task->depth[j] = depth - 1;
+	}
+	task->maxdep = depth - 1;
+	task->dir = cellProcEdgeMask[i][4];
+}
+
+void Octree::cellProcContour(Node *node, int leaf, int depth, ContourQuads& quads)
 {
 	if (node == NULL) {
 		return;
@@ -2509,48 +2624,85 @@ void Octree::cellProcContour(Node *node, int leaf, int depth)
 
 		// Fill children nodes
 		Node *chd[8];
-		for (i = 0; i < 8; i++) {
-			chd[i] = ((!leaf) && node->internal.has_child(i)) ?
-			         node->internal.get_child(node->internal.get_child_count(i)) : NULL;
-		}
+		cell_children(node, chd);
 
 		// 8 Cell calls
 		for (i = 0; i < 8; i++) {
-			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1);
+			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1, quads);
 		}
 
 		// 12 face calls
-		Node *nf[2];
-		int lf[2];
-		int df[2] = {depth - 1, depth - 1};
+		ContourTask task;
 		for (i = 0; i < 12; i++) {
-			int c[2] = {cellProcFaceMask[i][0], cellProcFaceMask[i][1]};
-
-			lf[0] = node->internal.is_child_leaf(c[0]);
-			lf[1] = node->internal.is_child_leaf(c[1]);
-
-			nf[0] = chd[c[0]];
-			nf[1] = chd[c[1]];
-
-			faceProcContour(nf, lf, df, depth - 1, cellProcFaceMask[i][2]);
+			cell_face_task(node, chd, depth, i, &task);
+			faceProcContour(task.node, task.leaf, task.depth, task.maxdep, task.dir, quads);
 		}
 
 		// 6 edge calls
-		Node *ne[4];
-		int le[4];
-		int de[4] = {depth - 1, depth - 1, depth - 1, depth - 1};
 		for (i = 0; i < 6; i++) {
-			int c[4] = {cellProcEdgeMask[i][0], cellProcEdgeMask[i][1], cellProcEdgeMask[i][2], cellProcEdgeMask[i][3]};
+			cell_edge_task(node, chd, depth, i, &task);
+			edgeProcContour(task.node, task.leaf, task.depth, task.maxdep, task.dir, quads);
+		}
+	}
 
-			for (int j = 0; j < 4; j++) {
-				le[j] = node->internal.is_child_leaf(c[j]);
-				ne[j] = chd[c[j]];
-			}
+}
 
-			edgeProcContour(ne, le, de, depth - 1, cellProcEdgeMask[i][4]);
-		}
+void Octree::splitCellContour(Node *node, int leaf, int depth, int levels, std::vector<ContourTask>& tasks)
+{
+	// Leaf cells have no quads inside
+	if (node == NULL || leaf) {
+		return;
+	}
+
+	// Zeroed, so the unused nodes of cell and face tasks are defined
+	ContourTask task = ContourTask();
+
+	if (levels == 0) {
+		task.type = ContourTask::CELL;
+		task.node[0] = node;
+		task.leaf[0] = leaf;
+		task.depth[0] = depth;
+		tasks.push_back(task);
+		return;
 	}
 
+	// Same order as cellProcContour
+	Node *chd[8];
+	cell_children(node, chd);
+
+	for (int i = 0; i < 8; i++) {
+		splitCellContour(chd[i], node->internal.is_child_leaf(i), depth - 1, levels - 1, tasks);
+	}
+
+	for (int i = 0; i < 12; i++) {
+		cell_face_task(node, chd, depth, i, &task);
+		tasks.push_back(task);
+	}
+
+	for (int i = 0; i < 6; i++) {
+		cell_edge_task(node, chd, depth, i, &task);
+		tasks.push_back(task);
+	}
+}
+
+void Octree::processContourTask(const ContourTask& task, ContourQuads& quads)
+{
+	// Copies, the traversal functions take non-const arrays
+	Node *node[4] = {task.node[0], task.node[1], task.node[2], task.node[3]};
+	int leaf[4] = {task.leaf[0], task.leaf[1], task.leaf[2], task.leaf[3]};
+	int depth[4] = {task.depth[0], task.depth[1], task.depth[2], task.depth[3]};
+
+	switch (task.type) {
+		case ContourTask::CELL:
+			cellProcContour(node[0], leaf[0], depth[0], quads);
+			break;
+		case ContourTask::FACE:
+			faceProcContour(node, leaf, depth, task.maxdep, task.dir, quads);
+			break;
+		case ContourTask::EDGE:
+			edgeProcContour(node, leaf, depth, task.maxdep, task.dir, quads);
+			break;
+	}
 }
 
 void Octree::processEdgeParity(LeafNode *node[4], int /*depth*/[4], int /*maxdep*/, int dir)
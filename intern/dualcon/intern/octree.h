@@ -27,6 +27,7 @@
 #include <cstring>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
 #include "GeoCommon.h"
 #include "Projections.h"
 #include "ModelReader.h"
@@ -222,6 +223,64 @@ struct PathList {
 	PathList *next;
 };
 
+/**
+ * Leaf cell placing vertices on the dual surface, collected so the
+ * minimizers of the cells can be computed in parallel
+ */
+
+struct MinimizerCell {
+	const LeafNode *leaf;
+
+	// Origin and size of the cell
+	int st[3];
+	int len;
+
+	// Number of vertices placed at the minimizer
+	int mult;
+};
+
+/**
+ * Cell of the octree intersected by a triangle, recorded in traversal order,
+ * so triangles can be scan converted in parallel and added in order
+ */
+
+struct ScanCell {
+	// Index past the cells inside this one
+	int end;
+
+	// Index of the cell in its parent
+	unsigned char child;
+
+	// Leaf cells: mask of the primary edges the triangle intersects, and where
+	unsigned char edges;
+	float offs[3];
+};
+
+struct ScanTriangle {
+	float norm[3];
+	std::vector<ScanCell> cells;
+};
+
+/**
+ * Part of the contour traversal that only depends on its own nodes:
+ * the quads inside a cell, between two cells sharing a face, or around
+ * four cells sharing an edge. Tasks are generated in traversal order, so
+ * their quads can be computed in parallel and output in order.
+ */
+
+struct ContourTask {
+	enum { CELL, FACE, EDGE } type;
+
+	Node *node[4];
+	int leaf[4];
+	int depth[4];
+	int maxdep;
+	int dir;
+};
+
+/// Vertex indices of the generated quads, four per quad
+typedef std::vector<int> ContourQuads;
+
 
 /**
  * Class for building and processing an octree
@@ -336,13 +395,14 @@ class Octree
 	 * Add triangles to the tree
 	 */
 	void addAllTriangles();
-	void addTriangle(Triangle *trian, int triind);
-	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height);
+	void scanTriangle(Triangle *trian, int triind, ScanTriangle *scan) const;
+	void scanCells(CubeTriangleIsect *p, int height, std::vector<ScanCell>& cells) const;
+	InternalNode *addTriangle(InternalNode *node, const ScanTriangle *scan, int begin, int end, int height);
 
 	/**
 	 * Method to update minimizer in a cell: update edge intersections instead
 	 */
-	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p);
+	LeafNode *updateCell(LeafNode *node, const ScanCell *cell, const float norm[3]);
 
 	/* Routines to detect and patch holes */
 	int numRings;
@@ -421,17 +481,21 @@ class Octree
 	void writeOut();
 
 	void countIntersection(Node *node, int height, int& nedge, int& ncell, int& nface);
-	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset);
+	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+	                       MinimizerCell *cells, int& totcell);
 	void computeMinimizer(const LeafNode * leaf, int st[3], int len,
 	                      float rvalue[3]) const;
+	void computeCellMinimizer(const MinimizerCell *cell, float rvalue[3]) const;
 	/**
 	 * Traversal functions to generate polygon model
 	 * op: 0 for counting, 1 for writing OBJ, 2 for writing OFF, 3 for writing PLY
 	 */
-	void cellProcContour(Node *node, int leaf, int depth);
-	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir);
-	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir);
-	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir);
+	void cellProcContour(Node *node, int leaf, int depth, ContourQuads& quads);
+	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir, ContourQuads& quads);
+	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir, ContourQuads& quads);
+	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir, ContourQuads& quads);
+	void splitCellContour(Node *node, int leaf, int depth, int levels, std::vector<ContourTask>& tasks);
+	void processContourTask(const ContourTask& task, ContourQuads& quads);
 
 	/* output callbacks/data */
 	DualConAllocOutput alloc_output;
@@ -41,6 +41,10 @@
 #include <opensubdiv/osd/mesh.h>
 #include <opensubdiv/osd/types.h>
 
+#ifdef OPENSUBDIV_HAS_OPENMP
+#  include <opensubdiv/osd/ompEvaluator.h>
+#endif  /* OPENSUBDIV_HAS_OPENMP */
+
 #include "opensubdiv_intern.h"
 
 #include "MEM_guardedalloc.h"
@@ -140,6 +144,10 @@ protected:
 };
 
 /* Volatile evaluator which can be used from threads.
+ *
+ * Stencils are evaluated with STENCIL_EVALUATOR, which refines all the
+ * coarse positions at once and could be a threaded one, while patches are
+ * evaluated one coordinate at a time (from threads already) with EVALUATOR.
  *
  * TODO(sergey): Make it possible to evaluate coordinates in chuncks.
  */
@@ -148,10 +156,12 @@ template<typename SRC_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
          typename EVALUATOR,
+         typename STENCIL_EVALUATOR = EVALUATOR,
          typename DEVICE_CONTEXT = void>
 class VolatileEvalOutput {
 public:
 	typedef OpenSubdiv::Osd::EvaluatorCacheT<EVALUATOR> EvaluatorCache;
+	typedef OpenSubdiv::Osd::EvaluatorCacheT<STENCIL_EVALUATOR> StencilEvaluatorCache;
 
 	VolatileEvalOutput(const StencilTable *vertex_stencils,
 	                   const StencilTable *varying_stencils,
@@ -159,11 +169,13 @@ public:
 	                   int num_total_verts,
 	                   const PatchTable *patch_table,
 	                   EvaluatorCache *evaluator_cache = NULL,
+	                   StencilEvaluatorCache *stencil_evaluator_cache = NULL,
 	                   DEVICE_CONTEXT *device_context = NULL)
 	    : src_desc_(        /*offset*/ 0, /*length*/ 3, /*stride*/ 3),
 	      src_varying_desc_(/*offset*/ 0, /*length*/ 3, /*stride*/ 3),
 	      num_coarse_verts_(num_coarse_verts),
 	      evaluator_cache_ (evaluator_cache),
+	      stencil_evaluator_cache_(stencil_evaluator_cache),
 	      device_context_(device_context)
 	{
 		using OpenSubdiv::Osd::convertToCompatibleStencilTable;
@@ -204,31 +216,31 @@ public:
 		BufferDescriptor dst_desc = src_desc_;
 		dst_desc.offset += num_coarse_verts_ * src_desc_.stride;
 
-		const EVALUATOR *eval_instance =
-		        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
-		                                                 src_desc_,
-		                                                 dst_desc,
-		                                                 device_context_);
+		const STENCIL_EVALUATOR *eval_instance =
+		        OpenSubdiv::Osd::GetEvaluator<STENCIL_EVALUATOR>(stencil_evaluator_cache_,
+		                                                         src_desc_,
+		                                                         dst_desc,
+		                                                         device_context_);
 
-		EVALUATOR::EvalStencils(src_data_, src_desc_,
-		                        src_data_, dst_desc,
-		                        vertex_stencils_,
-		                        eval_instance,
-		                        device_context_);
+		STENCIL_EVALUATOR::EvalStencils(src_data_, src_desc_,
+		                                src_data_, dst_desc,
+		                                vertex_stencils_,
+		                                eval_instance,
+		                                device_context_);
 
 		dst_desc = src_varying_desc_;
 		dst_desc.offset += num_coarse_verts_ * src_varying_desc_.stride;
 		eval_instance =
-		        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
-		                                                 src_varying_desc_,
-		                                                 dst_desc,
-		                                                 device_context_);
-
-		EVALUATOR::EvalStencils(src_varying_data_, src_varying_desc_,
-		                        src_varying_data_, dst_desc,
-		                        varying_stencils_,
-		                        eval_instance,
-		                        device_context_);
+		        OpenSubdiv::Osd::GetEvaluator<STENCIL_EVALUATOR>(stencil_evaluator_cache_,
+		                                                         src_varying_desc_,
+		                                                         dst_desc,
+		                                                         device_context_);
+
+		STENCIL_EVALUATOR::EvalStencils(src_varying_data_, src_varying_desc_,
+		                                src_varying_data_, dst_desc,
+		                                varying_stencils_,
+		                                eval_instance,
+		                                device_context_);
 	}
 
 	void EvalPatchCoord(PatchCoord& patch_coord, float P[3])
@@ -319,16 +331,27 @@ private:
 	const STENCIL_TABLE *varying_stencils_;
 
 	EvaluatorCache *evaluator_cache_;
+	StencilEvaluatorCache *stencil_evaluator_cache_;
 	DEVICE_CONTEXT *device_context_;
 };
 
 }  /* namespace */
 
+/* Coarse positions are refined with OpenMP when it's available, it's
+ * the only part re-evaluated when the mesh is deformed.
+ */
+#ifdef OPENSUBDIV_HAS_OPENMP
+typedef OpenSubdiv::Osd::OmpEvaluator CpuStencilEvaluator;
+#else
+typedef OpenSubdiv::Osd::CpuEvaluator CpuStencilEvaluator;
+#endif  /* OPENSUBDIV_HAS_OPENMP */
+
 typedef VolatileEvalOutput<OpenSubdiv::Osd::CpuVertexBuffer,
                            OpenSubdiv::Osd::CpuVertexBuffer,
                            OpenSubdiv::Far::StencilTable,
                            OpenSubdiv::Osd::CpuPatchTable,
-                           OpenSubdiv::Osd::CpuEvaluator> CpuEvalOutput;
+                           OpenSubdiv::Osd::CpuEvaluator,
+                           CpuStencilEvaluator> CpuEvalOutput;
 
 typedef struct OpenSubdiv_EvaluatorDescr {
 	CpuEvalOutput *eval_output;
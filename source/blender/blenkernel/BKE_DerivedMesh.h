@@ -779,7 +779,9 @@ void DM_vertex_attributes_from_gpu(
 
 void DM_draw_attrib_vertex(DMVertexAttribs *attribs, int a, int index, int vert, int loop);
 
+void DM_calc_loop_tangents_ex(DerivedMesh *dm, const bool use_threading, const bool use_cache);
 void DM_calc_loop_tangents(DerivedMesh *dm);
+void DM_tangent_cache_exit(void);
 void DM_calc_auto_bump_scale(DerivedMesh *dm);
 
 /** Set object's bounding box based on DerivedMesh min/max data */
@@ -27,6 +27,9 @@
  * General operations for brushes.
  */
 
+/* defines BLI_INLINE */
+#include "BLI_utildefines.h"
+
 struct Brush;
 struct ImBuf;
 struct ImagePool;
@@ -69,6 +72,12 @@ void BKE_brush_curve_preset(struct Brush *b, int preset);
 float BKE_brush_curve_strength_clamped(struct Brush *br, float p, const float len);
 float BKE_brush_curve_strength(struct Brush *br, float p, const float len);
 
+/* brush curve sampled into a table, for evaluating it per vertex in tight loops */
+#define BRUSH_CURVE_TABLE_SIZE 1024
+void BKE_brush_curve_strength_table(struct Brush *br, float table[BRUSH_CURVE_TABLE_SIZE + 1]);
+BLI_INLINE float BKE_brush_curve_strength_table_lookup(
+        const float table[BRUSH_CURVE_TABLE_SIZE + 1], float p, const float len);
+
 /* sampling */
 float BKE_brush_sample_tex_3D(const Scene *scene, struct Brush *br, const float point[3],
                               float rgba[4], const int thread, struct ImagePool *pool);
@@ -117,5 +126,27 @@ void BKE_brush_scale_size(
 /* debugging only */
 void BKE_brush_debug_print_state(struct Brush *br);
 
+/* -------------------------------------------------------------------- */
+/* Inline Functions */
+
+/**
+ * Same as #BKE_brush_curve_strength, using a table filled by #BKE_brush_curve_strength_table.
+ */
+BLI_INLINE float BKE_brush_curve_strength_table_lookup(
+        const float table[BRUSH_CURVE_TABLE_SIZE + 1], float p, const float len)
+{
+	float fac;
+	int i;
+
+	if (p >= len) return 0;
+
+	fac = (p / len) * (float)BRUSH_CURVE_TABLE_SIZE;
+	/* p / len may round up to 1.0 */
+	i = MIN2((int)fac, BRUSH_CURVE_TABLE_SIZE - 1);
+	fac -= (float)i;
+
+	return table[i] + (table[i + 1] - table[i]) * fac;
+}
+
 #endif
 
@@ -114,6 +114,9 @@ BVHTree *bvhtree_from_mesh_looptri_ex(
         const struct MLoopTri *looptri, const int looptri_num, const bool looptri_allocated,
         BLI_bitmap *mask, int looptri_num_active,
         float epsilon, int tree_type, int axis);
+BVHTree *bvhtree_from_mesh_looptri_refit(
+        struct BVHTreeFromMesh *data, struct DerivedMesh *mesh, struct BVHTree *tree,
+        float epsilon, int tree_type, int axis);
 
 /**
  * Frees data allocated by a call to bvhtree_from_mesh_*.
@@ -66,9 +66,17 @@ void curve_deform_verts(struct Scene *scene, struct Object *cuOb, struct Object
 void curve_deform_vector(struct Scene *scene, struct Object *cuOb, struct Object *target,
                          float orco[3], float vec[3], float mat[3][3], int no_rot_axis);
 
+struct LatticeDeformBind;
+struct LatticeDeformBind *BKE_lattice_deform_bind_new(void) ATTR_WARN_UNUSED_RESULT;
+void BKE_lattice_deform_bind_free(struct LatticeDeformBind *bind);
+
 void lattice_deform_verts(struct Object *laOb, struct Object *target,
                           struct DerivedMesh *dm, float (*vertexCos)[3],
                           int numVerts, const char *vgroup, float influence);
+void lattice_deform_verts_ex(struct Object *laOb, struct Object *target,
+                             struct DerivedMesh *dm, float (*vertexCos)[3],
+                             int numVerts, const char *vgroup, float influence,
+                             struct LatticeDeformBind *bind);
 void armature_deform_verts(struct Object *armOb, struct Object *target,
                            struct DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
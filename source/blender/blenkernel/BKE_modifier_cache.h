@@ -0,0 +1,93 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+#ifndef __BKE_MODIFIER_CACHE_H__
+#define __BKE_MODIFIER_CACHE_H__
+
+/** \file BKE_modifier_cache.h
+ *  \ingroup bke
+ *
+ * Persistent cache of intermediate modifier stack results.
+ *
+ * The result of constructive modifiers is kept per object, keyed by a 64 bit chain
+ * hash of the stack input and the settings of every modifier evaluated so far.
+ * When only a later modifier (or its inputs) changed, #mesh_calc_modifiers
+ * resumes evaluation from the deepest valid result instead of the base mesh.
+ */
+
+#include "BLI_sys_types.h"
+
+struct DerivedMesh;
+struct Main;
+struct Mesh;
+struct ModifierData;
+struct Object;
+struct Scene;
+
+typedef struct ModifierCacheStats {
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int stores;
+	unsigned int rejects;    /* results not stored because of the memory limit */
+	unsigned int evictions;  /* results freed to make room for deeper ones */
+	unsigned int entries;
+	size_t mem_in_use;
+	size_t mem_limit;
+} ModifierCacheStats;
+
+#define MODIFIER_CACHE_NUM_COUNTS 5
+
+/* State of a single modifier stack evaluation, lives on the stack of the caller. */
+typedef struct ModifierCacheEval {
+	struct Object *ob;
+	struct ModifierStackCache *cache;
+	uint64_t hash;          /* running chain hash */
+	uint64_t *chain;        /* chain hash per stack index for this evaluation, 0 when unset */
+	/* element counts of the stack input, compared exactly since hashes can collide */
+	int counts[MODIFIER_CACHE_NUM_COUNTS];
+	int chain_len;
+	int last_constructive;  /* stack index of the last constructive modifier, never stored */
+	bool valid;             /* false once a modifier which can't be hashed was evaluated */
+} ModifierCacheEval;
+
+void BKE_modifier_cache_set_limit(size_t limit);
+size_t BKE_modifier_cache_get_limit(void);
+
+void BKE_modifier_cache_free(struct Object *ob);
+void BKE_modifier_cache_free_all(struct Main *bmain);
+
+void BKE_modifier_cache_tag_modifier(struct Object *ob, struct ModifierData *md);
+void BKE_modifier_cache_tag_mesh(struct Main *bmain, struct Mesh *me);
+
+bool BKE_modifier_cache_eval_begin(
+        ModifierCacheEval *mce, struct Object *ob,
+        const float (*vertCos)[3], int numVerts,
+        uint64_t dataMask, int flag);
+struct ModifierData *BKE_modifier_cache_eval_lookup(
+        ModifierCacheEval *mce, struct Scene *scene, struct ModifierData *md_first,
+        const bool need_mapping, struct DerivedMesh **r_dm);
+void BKE_modifier_cache_eval_step(
+        ModifierCacheEval *mce, struct ModifierData *md, struct DerivedMesh *dm);
+void BKE_modifier_cache_eval_end(ModifierCacheEval *mce);
+
+void BKE_modifier_cache_stats_get(ModifierCacheStats *r_stats);
+void BKE_modifier_cache_stats_reset(void);
+void BKE_modifier_cache_stats_print(void);
+
+#endif  /* __BKE_MODIFIER_CACHE_H__ */
@@ -69,7 +69,8 @@ typedef enum {
 	MULTIRES_USE_LOCAL_MMD = 1,
 	MULTIRES_USE_RENDER_PARAMS = 2,
 	MULTIRES_ALLOC_PAINT_MASK = 4,
-	MULTIRES_IGNORE_SIMPLIFY = 8
+	MULTIRES_IGNORE_SIMPLIFY = 8,
+	MULTIRES_IS_FINAL_CALC = 16
 } MultiresFlags;
 
 struct DerivedMesh *multires_make_derived_from_derived(struct DerivedMesh *dm,
@@ -77,6 +78,8 @@ struct DerivedMesh *multires_make_derived_from_derived(struct DerivedMesh *dm,
                                                        struct Object *ob,
                                                        MultiresFlags flags);
 
+void multires_subdiv_cache_free(struct MultiresModifierData *mmd);
+
 struct MultiresModifierData *find_multires_modifier_before(struct Scene *scene,
                                                            struct ModifierData *lastmd);
 struct MultiresModifierData *get_multires_modifier(struct Scene *scene, struct Object *ob, bool use_first);
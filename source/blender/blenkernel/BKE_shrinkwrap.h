@@ -54,6 +54,7 @@ struct ShrinkwrapModifierData;
 struct MDeformVert;
 struct BVHTree;
 struct SpaceTransform;
+struct ShrinkwrapTreeCache;
 
 
 typedef struct ShrinkwrapCalcData {
@@ -73,11 +74,15 @@ typedef struct ShrinkwrapCalcData {
 
 	float keepDist;                 //Distance to keep above target surface (units are in local space)
 
+	int *order;                     //Vertex indices in spatially coherent query order, NULL for index order
+
 } ShrinkwrapCalcData;
 
 void shrinkwrapModifier_deform(struct ShrinkwrapModifierData *smd, struct Object *ob, struct DerivedMesh *dm,
                                float (*vertexCos)[3], int numVerts, bool for_render);
 
+void BKE_shrinkwrap_tree_cache_free(struct ShrinkwrapTreeCache *cache);
+
 /*
  * This function casts a ray in the given BVHTree.. but it takes into consideration the space_transform, that is:
  *
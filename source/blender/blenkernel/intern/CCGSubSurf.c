@@ -312,6 +312,11 @@ CCGSubSurf *ccgSubSurf_new(CCGMeshIFC *ifc, int subdivLevels, CCGAllocatorIFC *a
 		ss->osd_coarse_coords_invalid = false;
 		ss->osd_vao = 0;
 		ss->skip_grids = false;
+		ss->osd_topology = NULL;
+		ss->osd_topology_num_verts = 0;
+		ss->osd_topology_num_edges = 0;
+		ss->osd_topology_num_loops = 0;
+		ss->osd_topology_num_polys = 0;
 		ss->osd_compute = 0;
 		ss->osd_uvs_invalid = true;
 		ss->osd_subsurf_uv = 0;
@@ -345,6 +350,9 @@ void ccgSubSurf_free(CCGSubSurf *ss)
 	if (ss->osd_topology_refiner != NULL) {
 		openSubdiv_deleteTopologyRefinerDescr(ss->osd_topology_refiner);
 	}
+	if (ss->osd_topology != NULL) {
+		MEM_freeN(ss->osd_topology);
+	}
 #endif
 
 	if (ss->syncState) {
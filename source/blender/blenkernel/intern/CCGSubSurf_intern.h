@@ -213,6 +213,16 @@ struct CCGSubSurf {
 	 */
 	bool skip_grids;
 
+	/* Base mesh topology the refiner, GL mesh and evaluator were created
+	 * for, used to detect topology changes: face sizes, face vertices, then
+	 * edge vertices and creases.
+	 */
+	int *osd_topology;
+	int osd_topology_num_verts;
+	int osd_topology_num_edges;
+	int osd_topology_num_loops;
+	int osd_topology_num_polys;
+
 	/* ** GPU backend. ** */
 
 	/* Compute device used by GL mesh. */
@@ -48,112 +48,79 @@
 
 #define OSD_LOG if (false) printf
 
-static bool compare_ccg_derivedmesh_topology(CCGSubSurf *ss, DerivedMesh *dm)
+/* Compare the base mesh topology to the one the refiner, GL mesh and evaluator
+ * were created for, storing it when it changed. Cheaper than comparing to the
+ * topology in the refiner or the CCG on every evaluation.
+ *
+ * The topology is stored as face sizes, face vertices, then edge vertices and
+ * creases. Vertex coordinates are not included, so deformation (i.e. an
+ * armature before subsurf) keeps using the refiner, GL mesh and evaluator.
+ */
+static bool derivedmesh_topology_update(CCGSubSurf *ss, DerivedMesh *dm)
 {
 	const int num_verts = dm->getNumVerts(dm);
 	const int num_edges = dm->getNumEdges(dm);
+	const int num_loops = dm->getNumLoops(dm);
 	const int num_polys = dm->getNumPolys(dm);
 	const MEdge *medge = dm->getEdgeArray(dm);
 	const MLoop *mloop = dm->getLoopArray(dm);
 	const MPoly *mpoly = dm->getPolyArray(dm);
+	int *face_sizes, *face_verts, *edges;
+	bool match;
+	int i;
 
-	/* Quick preliminary tests based on the number of verts and facces. */
-	{
-		if (num_verts != ss->vMap->numEntries ||
-		    num_edges != ss->eMap->numEntries ||
-		    num_polys != ss->fMap->numEntries)
-		{
-			return false;
+	match = (ss->osd_topology != NULL &&
+	         ss->osd_topology_num_verts == num_verts &&
+	         ss->osd_topology_num_edges == num_edges &&
+	         ss->osd_topology_num_loops == num_loops &&
+	         ss->osd_topology_num_polys == num_polys);
+
+	if (!match) {
+		if (ss->osd_topology != NULL) {
+			MEM_freeN(ss->osd_topology);
 		}
+		ss->osd_topology = MEM_mallocN(sizeof(int) * (num_polys + num_loops + num_edges * 3 + 1),
+		                               "osd topology");
+		ss->osd_topology_num_verts = num_verts;
+		ss->osd_topology_num_edges = num_edges;
+		ss->osd_topology_num_loops = num_loops;
+		ss->osd_topology_num_polys = num_polys;
 	}
 
-	/* Rather slow check for faces topology change. */
-	{
-		CCGFaceIterator ccg_face_iter;
-		for (ccgSubSurf_initFaceIterator(ss, &ccg_face_iter);
-		     !ccgFaceIterator_isStopped(&ccg_face_iter);
-		     ccgFaceIterator_next(&ccg_face_iter))
-		{
-			/*const*/ CCGFace *ccg_face = ccgFaceIterator_getCurrent(&ccg_face_iter);
-			const int poly_index = GET_INT_FROM_POINTER(ccgSubSurf_getFaceFaceHandle(ccg_face));
-			const MPoly *mp = &mpoly[poly_index];
-			int corner;
-			if (ccg_face->numVerts != mp->totloop) {
-				return false;
-			}
-			for (corner = 0; corner < ccg_face->numVerts; corner++) {
-				/*const*/ CCGVert *ccg_vert = FACE_getVerts(ccg_face)[corner];
-				const int vert_index = GET_INT_FROM_POINTER(ccgSubSurf_getVertVertHandle(ccg_vert));
-				if (vert_index != mloop[mp->loopstart + corner].v) {
-					return false;
-				}
-			}
+	face_sizes = ss->osd_topology;
+	face_verts = face_sizes + num_polys;
+	edges = face_verts + num_loops;
+
+	for (i = 0; i < num_polys; i++) {
+		if (match && face_sizes[i] != mpoly[i].totloop) {
+			match = false;
 		}
+		face_sizes[i] = mpoly[i].totloop;
 	}
-
-	/* Check for edge topology change. */
-	{
-		CCGEdgeIterator ccg_edge_iter;
-		for (ccgSubSurf_initEdgeIterator(ss, &ccg_edge_iter);
-		     !ccgEdgeIterator_isStopped(&ccg_edge_iter);
-		     ccgEdgeIterator_next(&ccg_edge_iter))
-		{
-			/* const */ CCGEdge *ccg_edge = ccgEdgeIterator_getCurrent(&ccg_edge_iter);
-			/* const */ CCGVert *ccg_vert1 = ccg_edge->v0;
-			/* const */ CCGVert *ccg_vert2 = ccg_edge->v1;
-			const int ccg_vert1_index = GET_INT_FROM_POINTER(ccgSubSurf_getVertVertHandle(ccg_vert1));
-			const int ccg_vert2_index = GET_INT_FROM_POINTER(ccgSubSurf_getVertVertHandle(ccg_vert2));
-			const int edge_index = GET_INT_FROM_POINTER(ccgSubSurf_getEdgeEdgeHandle(ccg_edge));
-			const MEdge *me = &medge[edge_index];
-			if (me->v1 != ccg_vert1_index || me->v2 != ccg_vert2_index) {
-				return false;
-			}
+	for (i = 0; i < num_loops; i++) {
+		if (match && face_verts[i] != (int)mloop[i].v) {
+			match = false;
 		}
+		face_verts[i] = (int)mloop[i].v;
 	}
-
-	/* TODO(sergey): Crease topology changes detection. */
-	{
-		CCGEdgeIterator ccg_edge_iter;
-		for (ccgSubSurf_initEdgeIterator(ss, &ccg_edge_iter);
-		     !ccgEdgeIterator_isStopped(&ccg_edge_iter);
-		     ccgEdgeIterator_next(&ccg_edge_iter))
+	for (i = 0; i < num_edges; i++, edges += 3) {
+		if (match &&
+		    (edges[0] != (int)medge[i].v1 ||
+		     edges[1] != (int)medge[i].v2 ||
+		     edges[2] != medge[i].crease))
 		{
-			/* const */ CCGEdge *ccg_edge = ccgEdgeIterator_getCurrent(&ccg_edge_iter);
-			const int edge_index = GET_INT_FROM_POINTER(ccgSubSurf_getEdgeEdgeHandle(ccg_edge));
-			if (ccg_edge->crease != medge[edge_index].crease) {
-				return false;
-			}
+			match = false;
 		}
+		edges[0] = (int)medge[i].v1;
+		edges[1] = (int)medge[i].v2;
+		edges[2] = medge[i].crease;
 	}
 
-	return true;
-}
-
-static bool compare_osd_derivedmesh_topology(CCGSubSurf *ss, DerivedMesh *dm)
-{
-	const OpenSubdiv_TopologyRefinerDescr *topology_refiner;
-	OpenSubdiv_Converter converter;
-	bool result;
-	if (ss->osd_mesh == NULL && ss->osd_topology_refiner == NULL) {
-		return true;
-	}
-	/* TODO(sergey): De-duplicate with topology counter at the bottom of
-	 * the file.
-	 */
-	if (ss->osd_topology_refiner != NULL) {
-		topology_refiner = ss->osd_topology_refiner;
-	}
-	else {
-		topology_refiner = openSubdiv_getGLMeshTopologyRefiner(ss->osd_mesh);
-	}
-	ccgSubSurf_converter_setup_from_derivedmesh(ss, dm, &converter);
-	result = openSubdiv_topologyRefnerCompareConverter(topology_refiner,
-	                                                   &converter);
-	ccgSubSurf_converter_free(&converter);
-	return result;
+	return match;
 }
 
-static bool opensubdiv_is_topology_changed(CCGSubSurf *ss, DerivedMesh *dm)
+static bool opensubdiv_is_topology_changed(CCGSubSurf *ss,
+                                           bool topology_match)
 {
 	if (ss->osd_compute != U.opensubdiv_compute_type) {
 		return true;
@@ -161,7 +128,7 @@ static bool opensubdiv_is_topology_changed(CCGSubSurf *ss, DerivedMesh *dm)
 	if (ss->osd_topology_refiner != NULL) {
 		int levels = openSubdiv_topologyRefinerGetSubdivLevel(
 		        ss->osd_topology_refiner);
-		BLI_assert(ss->osd_mesh_invalid == true);
+		BLI_assert(ss->osd_mesh == NULL || ss->osd_mesh_invalid == true);
 		if (levels != ss->subdivLevels) {
 			return true;
 		}
@@ -175,18 +142,21 @@ static bool opensubdiv_is_topology_changed(CCGSubSurf *ss, DerivedMesh *dm)
 			return true;
 		}
 	}
-	if (ss->skip_grids == false) {
-		return compare_ccg_derivedmesh_topology(ss, dm) == false;
-	}
-	else {
-		return compare_osd_derivedmesh_topology(ss, dm) == false;
+	if (ss->osd_mesh == NULL &&
+	    ss->osd_topology_refiner == NULL &&
+	    ss->osd_evaluator == NULL)
+	{
+		/* Nothing was created for the previous topology. */
+		return false;
 	}
-	return false;
+	return !topology_match;
 }
 
 void ccgSubSurf_checkTopologyChanged(CCGSubSurf *ss, DerivedMesh *dm)
 {
-	if (opensubdiv_is_topology_changed(ss, dm)) {
+	const bool topology_match = derivedmesh_topology_update(ss, dm);
+
+	if (opensubdiv_is_topology_changed(ss, topology_match)) {
 		/* ** Make sure both GPU and CPU backends are properly reset. ** */
 
 		ss->osd_coarse_coords_invalid = true;
@@ -827,11 +797,15 @@ CCGError ccgSubSurf_initOpenSubdivSync(CCGSubSurf *ss)
 
 void ccgSubSurf_prepareTopologyRefiner(CCGSubSurf *ss, DerivedMesh *dm)
 {
-	if (ss->osd_mesh == NULL || ss->osd_mesh_invalid) {
+	/* Refiner is kept until the topology changes, so evaluating a deformed
+	 * mesh again before the GL mesh is created doesn't re-create it.
+	 */
+	if ((ss->osd_mesh == NULL || ss->osd_mesh_invalid) &&
+	    ss->osd_topology_refiner == NULL)
+	{
 		if (dm->getNumPolys(dm) != 0) {
 			OpenSubdiv_Converter converter;
 			ccgSubSurf_converter_setup_from_derivedmesh(ss, dm, &converter);
-			/* TODO(sergey): Remove possibly previously allocated refiner. */
 			ss->osd_topology_refiner = openSubdiv_createTopologyRefinerDescr(&converter);
 			ccgSubSurf_converter_free(&converter);
 		}
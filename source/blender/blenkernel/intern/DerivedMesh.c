@@ -49,6 +49,9 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_editmesh.h"
@@ -56,6 +59,7 @@
 #include "BKE_library.h"
 #include "BKE_material.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_object.h"
@@ -1752,6 +1756,11 @@ static void mesh_calc_modifiers(
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
 	ModifierApplyFlag deform_app_flags = app_flags;
 
+	/* Intermediate results are only reused for regular viewport evaluation,
+	 * partial stacks, orco and preview layers are always computed from scratch. */
+	ModifierCacheEval modifier_cache;
+	bool use_modifier_cache = (!useRenderParams && useDeform > 0 && index == -1 &&
+	                           !inputVertexCos && !sculpt_mode && !do_init_wmcol);
 
 	if (useCache)
 		app_flags |= MOD_APPLY_USECACHE;
@@ -1792,6 +1801,10 @@ static void mesh_calc_modifiers(
 	datamasks = modifiers_calcDataMasks(scene, ob, md, dataMask, required_mode, previewmd, previewmask);
 	curr = datamasks;
 
+	if (previewmd || ((datamasks ? datamasks->mask : dataMask) & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO))) {
+		use_modifier_cache = false;
+	}
+
 	if (r_deform) {
 		*r_deform = NULL;
 	}
@@ -1861,6 +1874,32 @@ static void mesh_calc_modifiers(
 	orcodm = NULL;
 	clothorcodm = NULL;
 
+	if (use_modifier_cache) {
+		use_modifier_cache = BKE_modifier_cache_eval_begin(
+		        &modifier_cache, ob, (const float (*)[3])deformedVerts, numVerts, dataMask,
+		        (need_mapping ? 1 : 0) | (build_shapekey_layers ? 2 : 0) | (allow_gpu ? 4 : 0));
+	}
+
+	if (use_modifier_cache) {
+		ModifierData *md_cached = BKE_modifier_cache_eval_lookup(&modifier_cache, scene, md, need_mapping, &dm);
+
+		if (md_cached) {
+			/* continue after the modifier which produced the cached result,
+			 * leading deformations are already part of it */
+			while (md != md_cached) {
+				md = md->next;
+				curr = curr->next;
+			}
+			md = md->next;
+			curr = curr->next;
+
+			if (deformedVerts) {
+				MEM_freeN(deformedVerts);
+				deformedVerts = NULL;
+			}
+		}
+	}
+
 	for (; md; md = md->next, curr = curr->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
@@ -2108,6 +2147,10 @@ static void mesh_calc_modifiers(
 			}
 		}
 
+		if (use_modifier_cache) {
+			BKE_modifier_cache_eval_step(&modifier_cache, md, dm);
+		}
+
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
 
 		/* grab modifiers until index i */
@@ -2119,6 +2162,10 @@ static void mesh_calc_modifiers(
 		}
 	}
 
+	if (use_modifier_cache) {
+		BKE_modifier_cache_eval_end(&modifier_cache);
+	}
+
 	for (md = firstmd; md; md = md->next)
 		modifier_freeTemporaryData(md);
 
@@ -2997,10 +3044,16 @@ typedef struct {
 	MVert *mvert;       /* vertices & normals */
 	float (*orco)[3];
 	float (*tangent)[4];    /* destination */
+	const int *face_map;    /* looptri indices of the faces when only a part of the mesh is computed, or NULL */
 	int numTessFaces;
 
 } SGLSLMeshToTangent;
 
+BLI_INLINE const MLoopTri *tangent_looptri_get(const SGLSLMeshToTangent *pMesh, const int face_num)
+{
+	return &pMesh->looptri[pMesh->face_map ? pMesh->face_map[face_num] : face_num];
+}
+
 /* interface */
 #include "mikktspace.h"
 
@@ -3021,7 +3074,7 @@ static void GetPosition(const SMikkTSpaceContext *pContext, float r_co[3], const
 {
 	//assert(vert_index >= 0 && vert_index < 4);
 	SGLSLMeshToTangent *pMesh = (SGLSLMeshToTangent *) pContext->m_pUserData;
-	const MLoopTri *lt = &pMesh->looptri[face_num];
+	const MLoopTri *lt = tangent_looptri_get(pMesh, face_num);
 	const float *co = pMesh->mvert[pMesh->mloop[lt->tri[vert_index]].v].co;
 	copy_v3_v3(r_co, co);
 }
@@ -3030,7 +3083,7 @@ static void GetTextureCoordinate(const SMikkTSpaceContext *pContext, float r_uv[
 {
 	//assert(vert_index >= 0 && vert_index < 4);
 	SGLSLMeshToTangent *pMesh = (SGLSLMeshToTangent *) pContext->m_pUserData;
-	const MLoopTri *lt = &pMesh->looptri[face_num];
+	const MLoopTri *lt = tangent_looptri_get(pMesh, face_num);
 
 	if (pMesh->mloopuv != NULL) {
 		const float *uv = pMesh->mloopuv[lt->tri[vert_index]].uv;
@@ -3046,7 +3099,7 @@ static void GetNormal(const SMikkTSpaceContext *pContext, float r_no[3], const i
 {
 	//assert(vert_index >= 0 && vert_index < 4);
 	SGLSLMeshToTangent *pMesh = (SGLSLMeshToTangent *) pContext->m_pUserData;
-	const MLoopTri *lt = &pMesh->looptri[face_num];
+	const MLoopTri *lt = tangent_looptri_get(pMesh, face_num);
 	const bool smoothnormal = (pMesh->mpoly[lt->poly].flag & ME_SMOOTH) != 0;
 
 	if (pMesh->precomputedLoopNormals) {
@@ -3074,13 +3127,379 @@ static void SetTSpace(const SMikkTSpaceContext *pContext, const float fvTangent[
 {
 	//assert(vert_index >= 0 && vert_index < 4);
 	SGLSLMeshToTangent *pMesh = (SGLSLMeshToTangent *) pContext->m_pUserData;
-	const MLoopTri *lt = &pMesh->looptri[face_num];
+	const MLoopTri *lt = tangent_looptri_get(pMesh, face_num);
 	float *pRes = pMesh->tangent[lt->tri[vert_index]];
 	copy_v3_v3(pRes, fvTangent);
 	pRes[3] = fSign;
 }
 
-void DM_calc_loop_tangents(DerivedMesh *dm)
+static void calc_loop_tangents_do(SGLSLMeshToTangent *mesh2tangent)
+{
+	SMikkTSpaceContext sContext = {NULL};
+	SMikkTSpaceInterface sInterface = {NULL};
+
+	sContext.m_pUserData = mesh2tangent;
+	sContext.m_pInterface = &sInterface;
+	sInterface.m_getNumFaces = GetNumFaces;
+	sInterface.m_getNumVerticesOfFace = GetNumVertsOfFace;
+	sInterface.m_getPosition = GetPosition;
+	sInterface.m_getTexCoord = GetTextureCoordinate;
+	sInterface.m_getNormal = GetNormal;
+	sInterface.m_setTSpaceBasic = SetTSpace;
+
+	/* 0 if failed */
+	genTangSpaceDefault(&sContext);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tangent islands
+ *
+ * Mikktspace welds corners with exactly the same position, normal and texture coordinate (not the same vertex index),
+ * and only shares tangent space between triangles connected through welded corners.
+ * So triangles are merged into islands when they share a corner with the same key as mikktspace would see it,
+ * read through the same callbacks. These islands may contain several mikktspace groups but never split one,
+ * they are packed into batches which are computed in parallel, keeping the face order within each island. */
+
+typedef struct TangentCornerKey {
+	float key[8];  /* position, normal and texture coordinate */
+	int corner;
+} TangentCornerKey;
+
+static int tangent_corner_key_cmp(const void *a_v, const void *b_v)
+{
+	const float *a = ((const TangentCornerKey *)a_v)->key;
+	const float *b = ((const TangentCornerKey *)b_v)->key;
+	int i;
+
+	/* compare values rather than bits, like mikktspace does when welding */
+	for (i = 0; i < 8; i++) {
+		if (a[i] < b[i]) return -1;
+		if (a[i] > b[i]) return 1;
+	}
+	return 0;
+}
+
+BLI_INLINE int tangent_island_find(int *parent, int i)
+{
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+BLI_INLINE void tangent_island_join(int *parent, int a, int b)
+{
+	a = tangent_island_find(parent, a);
+	b = tangent_island_find(parent, b);
+	if (a != b) {
+		parent[max_ii(a, b)] = min_ii(a, b);
+	}
+}
+
+/**
+ * Sort the faces of the mesh by island into \a r_faces, and split them in batches of similar size.
+ * Returns the number of batches, their ranges in \a r_faces are stored in \a r_batch_offsets.
+ */
+static int calc_loop_tangents_batches(
+        SGLSLMeshToTangent *mesh2tangent, const int num_batches_max,
+        int *r_faces, int *r_batch_offsets)
+{
+	SMikkTSpaceContext sContext = {NULL};
+	const int totface = mesh2tangent->numTessFaces;
+	const int totcorner = totface * 3;
+	const int batch_size = max_ii(1, totface / num_batches_max);
+	TangentCornerKey *keys = MEM_mallocN(sizeof(*keys) * (size_t)totcorner, __func__);
+	int *parent = MEM_mallocN(sizeof(int) * (size_t)totface, __func__);
+	int *island_offsets;
+	int i, num_batches;
+
+	/* corners with their welding key */
+	sContext.m_pUserData = mesh2tangent;
+	for (i = 0; i < totcorner; i++) {
+		GetPosition(&sContext, &keys[i].key[0], i / 3, i % 3);
+		GetNormal(&sContext, &keys[i].key[3], i / 3, i % 3);
+		GetTextureCoordinate(&sContext, &keys[i].key[6], i / 3, i % 3);
+		keys[i].corner = i;
+	}
+
+	qsort(keys, (size_t)totcorner, sizeof(*keys), tangent_corner_key_cmp);
+
+	for (i = 0; i < totface; i++) {
+		parent[i] = i;
+	}
+
+	/* corners welded by mikktspace are adjacent once sorted */
+	for (i = 1; i < totcorner; i++) {
+		if (tangent_corner_key_cmp(&keys[i - 1], &keys[i]) == 0) {
+			tangent_island_join(parent, keys[i - 1].corner / 3, keys[i].corner / 3);
+		}
+	}
+
+	MEM_freeN(keys);
+
+	/* counting sort of the faces by island root, roots are always the lowest index of their island */
+	island_offsets = MEM_callocN(sizeof(int) * (size_t)(totface + 1), __func__);
+	for (i = 0; i < totface; i++) {
+		parent[i] = tangent_island_find(parent, i);
+		island_offsets[parent[i] + 1]++;
+	}
+	for (i = 0; i < totface; i++) {
+		island_offsets[i + 1] += island_offsets[i];
+	}
+
+	/* islands are contiguous in the sorted faces, split at island boundaries once a batch is full */
+	num_batches = 0;
+	r_batch_offsets[num_batches++] = 0;
+	for (i = 0; i < totface; i++) {
+		if (parent[i] == i) {
+			const int island_start = island_offsets[i];
+			if (island_start - r_batch_offsets[num_batches - 1] >= batch_size && num_batches < num_batches_max) {
+				r_batch_offsets[num_batches++] = island_start;
+			}
+		}
+	}
+	r_batch_offsets[num_batches] = totface;
+
+	for (i = 0; i < totface; i++) {
+		r_faces[island_offsets[parent[i]]++] = i;
+	}
+
+	MEM_freeN(island_offsets);
+	MEM_freeN(parent);
+
+	return num_batches;
+}
+
+typedef struct TangentBatchData {
+	const SGLSLMeshToTangent *mesh2tangent;
+	const int *faces;
+	const int *batch_offsets;
+} TangentBatchData;
+
+static void calc_loop_tangents_batch_cb(void *userdata, void *UNUSED(userdata_chunk), int batch)
+{
+	const TangentBatchData *data = userdata;
+	SGLSLMeshToTangent mesh2tangent = *data->mesh2tangent;
+
+	mesh2tangent.face_map = data->faces + data->batch_offsets[batch];
+	mesh2tangent.numTessFaces = data->batch_offsets[batch + 1] - data->batch_offsets[batch];
+
+	calc_loop_tangents_do(&mesh2tangent);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tangent cache
+ *
+ * Mesh evaluation recreates the derived mesh even when the geometry doesn't change (time or object updates),
+ * keep the last computed tangent layers keyed by a hash of all their inputs.
+ *
+ * TANGENT_CACHE_MEM_MAX is shared by all entries, an entry larger than that evicts all others,
+ * so the most recent mesh is always cached however dense it is. */
+
+#define TANGENT_CACHE_SIZE 4
+#define TANGENT_CACHE_MEM_MAX ((size_t)256 * 1024 * 1024)
+#define TANGENT_CACHE_KEY_PARTS 8
+
+/* All inputs of the tangent computation. The hash only selects candidates,
+ * entries keep a copy of the inputs which is compared in full, since hashes can collide. */
+typedef struct TangentCacheKey {
+	int counts[7];  /* element counts, and which optional layers are used */
+	const void *data[TANGENT_CACHE_KEY_PARTS];
+	size_t size[TANGENT_CACHE_KEY_PARTS];
+	int num_parts;
+	size_t size_total;
+} TangentCacheKey;
+
+typedef struct TangentCacheEntry {
+	uint32_t hash;
+	size_t key_size;
+	void *key;          /* copy of the key parts, concatenated */
+	int totloop;
+	float (*tangent)[4];
+} TangentCacheEntry;
+
+static struct {
+	TangentCacheEntry entries[TANGENT_CACHE_SIZE];  /* most recently used first */
+	size_t mem_in_use;
+} tangent_cache = {{{0}}};
+static ThreadMutex tangent_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static void tangent_cache_key_add(TangentCacheKey *key, const void *data, size_t size)
+{
+	BLI_assert(key->num_parts < TANGENT_CACHE_KEY_PARTS);
+	key->data[key->num_parts] = data;
+	key->size[key->num_parts] = size;
+	key->num_parts++;
+	key->size_total += size;
+}
+
+static void tangent_cache_key_init(
+        TangentCacheKey *key, const SGLSLMeshToTangent *mesh2tangent, int totvert, int totpoly, int totloop)
+{
+	key->counts[0] = totvert;
+	key->counts[1] = totpoly;
+	key->counts[2] = totloop;
+	key->counts[3] = mesh2tangent->numTessFaces;
+	key->counts[4] = mesh2tangent->mloopuv != NULL;
+	key->counts[5] = mesh2tangent->precomputedLoopNormals != NULL;
+	key->counts[6] = mesh2tangent->precomputedFaceNormals != NULL;
+	key->num_parts = 0;
+	key->size_total = 0;
+
+	tangent_cache_key_add(key, key->counts, sizeof(key->counts));
+	tangent_cache_key_add(key, mesh2tangent->mvert, sizeof(MVert) * (size_t)totvert);
+	tangent_cache_key_add(key, mesh2tangent->mpoly, sizeof(MPoly) * (size_t)totpoly);
+	tangent_cache_key_add(key, mesh2tangent->mloop, sizeof(MLoop) * (size_t)totloop);
+	tangent_cache_key_add(key, mesh2tangent->looptri, sizeof(MLoopTri) * (size_t)mesh2tangent->numTessFaces);
+	if (mesh2tangent->mloopuv) {
+		tangent_cache_key_add(key, mesh2tangent->mloopuv, sizeof(MLoopUV) * (size_t)totloop);
+	}
+	else {
+		tangent_cache_key_add(key, mesh2tangent->orco, sizeof(float[3]) * (size_t)totvert);
+	}
+	if (mesh2tangent->precomputedLoopNormals) {
+		tangent_cache_key_add(key, mesh2tangent->precomputedLoopNormals, sizeof(float[3]) * (size_t)totloop);
+	}
+	if (mesh2tangent->precomputedFaceNormals) {
+		tangent_cache_key_add(key, mesh2tangent->precomputedFaceNormals, sizeof(float[3]) * (size_t)totpoly);
+	}
+}
+
+static uint32_t tangent_cache_key_hash(const TangentCacheKey *key)
+{
+	BLI_HashMurmur2A mm2;
+	int i;
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	for (i = 0; i < key->num_parts; i++) {
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)key->data[i], key->size[i]);
+	}
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+static bool tangent_cache_key_equals(const TangentCacheKey *key, const TangentCacheEntry *entry)
+{
+	const char *entry_key = entry->key;
+	int i;
+
+	if (entry->key_size != key->size_total) {
+		return false;
+	}
+
+	for (i = 0; i < key->num_parts; i++) {
+		if (memcmp(entry_key, key->data[i], key->size[i]) != 0) {
+			return false;
+		}
+		entry_key += key->size[i];
+	}
+
+	return true;
+}
+
+static void tangent_cache_entry_free(TangentCacheEntry *entry)
+{
+	if (entry->tangent) {
+		tangent_cache.mem_in_use -= sizeof(*entry->tangent) * (size_t)entry->totloop + entry->key_size;
+		MEM_freeN(entry->tangent);
+		MEM_freeN(entry->key);
+	}
+	memset(entry, 0, sizeof(*entry));
+}
+
+/* Move entry \a index to the front, shifting the more recently used ones down. */
+static void tangent_cache_entry_touch(int index)
+{
+	TangentCacheEntry entry = tangent_cache.entries[index];
+
+	memmove(&tangent_cache.entries[1], &tangent_cache.entries[0], sizeof(entry) * (size_t)index);
+	tangent_cache.entries[0] = entry;
+}
+
+static bool tangent_cache_lookup(const TangentCacheKey *key, uint32_t hash, int totloop, float (*r_tangent)[4])
+{
+	bool found = false;
+	int i;
+
+	BLI_mutex_lock(&tangent_cache_lock);
+	for (i = 0; i < TANGENT_CACHE_SIZE; i++) {
+		TangentCacheEntry *entry = &tangent_cache.entries[i];
+
+		if (entry->tangent && entry->hash == hash && entry->totloop == totloop &&
+		    tangent_cache_key_equals(key, entry))
+		{
+			memcpy(r_tangent, entry->tangent, sizeof(*r_tangent) * (size_t)totloop);
+			tangent_cache_entry_touch(i);
+			found = true;
+			break;
+		}
+	}
+	BLI_mutex_unlock(&tangent_cache_lock);
+
+	return found;
+}
+
+static void tangent_cache_store(const TangentCacheKey *key, uint32_t hash, int totloop, float (*tangent)[4])
+{
+	const size_t tangent_size = sizeof(*tangent) * (size_t)totloop;
+	const size_t size = tangent_size + key->size_total;
+	TangentCacheEntry *entry;
+	const size_t mem_max = MAX2(size, TANGENT_CACHE_MEM_MAX);
+	char *entry_key;
+	int i;
+
+	BLI_mutex_lock(&tangent_cache_lock);
+
+	/* evict least recently used entries until it fits */
+	for (i = TANGENT_CACHE_SIZE - 1; i >= 0; i--) {
+		if (tangent_cache.entries[TANGENT_CACHE_SIZE - 1].tangent == NULL &&
+		    tangent_cache.mem_in_use + size <= mem_max)
+		{
+			break;
+		}
+		if (tangent_cache.entries[i].tangent) {
+			tangent_cache_entry_free(&tangent_cache.entries[i]);
+		}
+	}
+
+	/* the last slot is now free */
+	tangent_cache_entry_touch(TANGENT_CACHE_SIZE - 1);
+	entry = &tangent_cache.entries[0];
+	entry->hash = hash;
+	entry->totloop = totloop;
+	entry->tangent = MEM_mallocN(tangent_size, "DM tangent cache");
+	memcpy(entry->tangent, tangent, tangent_size);
+
+	entry->key_size = key->size_total;
+	entry->key = MEM_mallocN(key->size_total, "DM tangent cache key");
+	entry_key = entry->key;
+	for (i = 0; i < key->num_parts; i++) {
+		memcpy(entry_key, key->data[i], key->size[i]);
+		entry_key += key->size[i];
+	}
+
+	tangent_cache.mem_in_use += size;
+
+	BLI_mutex_unlock(&tangent_cache_lock);
+}
+
+void DM_tangent_cache_exit(void)
+{
+	int i;
+
+	BLI_mutex_lock(&tangent_cache_lock);
+	for (i = 0; i < TANGENT_CACHE_SIZE; i++) {
+		tangent_cache_entry_free(&tangent_cache.entries[i]);
+	}
+	BLI_mutex_unlock(&tangent_cache_lock);
+}
+
+/**
+ * \param use_threading: Compute islands of the mesh in parallel, only done for large meshes.
+ * \param use_cache: Reuse tangents computed earlier from the same inputs.
+ */
+void DM_calc_loop_tangents_ex(DerivedMesh *dm, const bool use_threading, const bool use_cache)
 {
 	/* mesh vars */
 	const MLoopTri *looptri;
@@ -3089,9 +3508,12 @@ void DM_calc_loop_tangents(DerivedMesh *dm)
 	MPoly *mpoly;
 	MLoop *mloop;
 	float (*orco)[3] = NULL, (*tangent)[4];
-	int /* totvert, */ totface;
+	int totvert, totface, totloop;
 	float (*fnors)[3];
 	float (*tlnors)[3];
+	SGLSLMeshToTangent mesh2tangent = {NULL};
+	TangentCacheKey key;
+	uint32_t hash = 0;
 
 	if (CustomData_get_layer_index(&dm->loopData, CD_TANGENT) != -1)
 		return;
@@ -3103,7 +3525,8 @@ void DM_calc_loop_tangents(DerivedMesh *dm)
 	tlnors = dm->getLoopDataArray(dm, CD_NORMAL);
 
 	/* check we have all the needed layers */
-	/* totvert = dm->getNumVerts(dm); */ /* UNUSED */
+	totvert = dm->getNumVerts(dm);
+	totloop = dm->getNumLoops(dm);
 	looptri = dm->getLoopTriArray(dm);
 	totface = dm->getNumLoopTri(dm);
 
@@ -3123,34 +3546,56 @@ void DM_calc_loop_tangents(DerivedMesh *dm)
 	tangent = DM_get_loop_data_layer(dm, CD_TANGENT);
 	
 	/* new computation method */
-	{
-		SGLSLMeshToTangent mesh2tangent = {NULL};
-		SMikkTSpaceContext sContext = {NULL};
-		SMikkTSpaceInterface sInterface = {NULL};
-
-		mesh2tangent.precomputedFaceNormals = fnors;
-		mesh2tangent.precomputedLoopNormals = tlnors;
-		mesh2tangent.looptri = looptri;
-		mesh2tangent.mloopuv = mloopuv;
-		mesh2tangent.mpoly = mpoly;
-		mesh2tangent.mloop = mloop;
-		mesh2tangent.mvert = mvert;
-		mesh2tangent.orco = orco;
-		mesh2tangent.tangent = tangent;
-		mesh2tangent.numTessFaces = totface;
-
-		sContext.m_pUserData = &mesh2tangent;
-		sContext.m_pInterface = &sInterface;
-		sInterface.m_getNumFaces = GetNumFaces;
-		sInterface.m_getNumVerticesOfFace = GetNumVertsOfFace;
-		sInterface.m_getPosition = GetPosition;
-		sInterface.m_getTexCoord = GetTextureCoordinate;
-		sInterface.m_getNormal = GetNormal;
-		sInterface.m_setTSpaceBasic = SetTSpace;
-
-		/* 0 if failed */
-		genTangSpaceDefault(&sContext);
+	mesh2tangent.precomputedFaceNormals = fnors;
+	mesh2tangent.precomputedLoopNormals = tlnors;
+	mesh2tangent.looptri = looptri;
+	mesh2tangent.mloopuv = mloopuv;
+	mesh2tangent.mpoly = mpoly;
+	mesh2tangent.mloop = mloop;
+	mesh2tangent.mvert = mvert;
+	mesh2tangent.orco = orco;
+	mesh2tangent.tangent = tangent;
+	mesh2tangent.numTessFaces = totface;
+
+	if (use_cache) {
+		tangent_cache_key_init(&key, &mesh2tangent, totvert, dm->getNumPolys(dm), totloop);
+		hash = tangent_cache_key_hash(&key);
+		if (tangent_cache_lookup(&key, hash, totloop, tangent)) {
+			return;
+		}
 	}
+
+	if (use_threading && totface > BKE_MESH_OMP_LIMIT) {
+		TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+		const int num_batches_max = BLI_task_scheduler_num_threads(task_scheduler) * 4;
+		int *faces = MEM_mallocN(sizeof(int) * (size_t)totface, __func__);
+		int *batch_offsets = MEM_mallocN(sizeof(int) * (size_t)(num_batches_max + 1), __func__);
+		const int num_batches = calc_loop_tangents_batches(&mesh2tangent, num_batches_max, faces, batch_offsets);
+
+		if (num_batches > 1) {
+			TangentBatchData data = {&mesh2tangent, faces, batch_offsets};
+
+			BLI_task_parallel_range_ex(0, num_batches, &data, NULL, 0, calc_loop_tangents_batch_cb, true, false);
+		}
+		else {
+			calc_loop_tangents_do(&mesh2tangent);
+		}
+
+		MEM_freeN(faces);
+		MEM_freeN(batch_offsets);
+	}
+	else {
+		calc_loop_tangents_do(&mesh2tangent);
+	}
+
+	if (use_cache) {
+		tangent_cache_store(&key, hash, totloop, tangent);
+	}
+}
+
+void DM_calc_loop_tangents(DerivedMesh *dm)
+{
+	DM_calc_loop_tangents_ex(dm, true, true);
 }
 
 void DM_calc_auto_bump_scale(DerivedMesh *dm)
@@ -1012,6 +1012,20 @@ float BKE_brush_curve_strength(Brush *br, float p, const float len)
 	return strength;
 }
 
+/**
+ * Samples the brush curve control into \a table, so it can be looked up per vertex
+ * with #BKE_brush_curve_strength_table_lookup instead of evaluating the curve mapping.
+ * The curve mapping must be initialized.
+ */
+void BKE_brush_curve_strength_table(Brush *br, float table[BRUSH_CURVE_TABLE_SIZE + 1])
+{
+	int i;
+
+	for (i = 0; i <= BRUSH_CURVE_TABLE_SIZE; i++) {
+		table[i] = curvemapping_evaluateF(br->curve, 0, (float)i / (float)BRUSH_CURVE_TABLE_SIZE);
+	}
+}
+
 
 /* Uses the brush curve control to find a strength value between 0 and 1 */
 float BKE_brush_curve_strength_clamped(Brush *br, float p, const float len)
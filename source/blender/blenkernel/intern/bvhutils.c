@@ -1110,6 +1110,72 @@ BVHTree *bvhtree_from_mesh_looptri_ex(
 	return data->tree;
 }
 
+/**
+ * Builds a looptri tree owned by the caller rather than the mesh BVH cache, so it can outlive \a dm.
+ *
+ * When \a tree is given it must have been returned by this function for a mesh with the same
+ * triangulation, its leaves are moved to the vertex positions of \a dm and the bounds refitted,
+ * which is much cheaper than a rebuild for deforming meshes.
+ */
+BVHTree *bvhtree_from_mesh_looptri_refit(
+        BVHTreeFromMesh *data, DerivedMesh *dm, BVHTree *tree,
+        float epsilon, int tree_type, int axis)
+{
+	MVert *mvert;
+	MPoly *mpoly;
+	MLoop *mloop;
+	const MLoopTri *looptri;
+	bool vert_allocated = false;
+	bool poly_allocated = false;
+	bool loop_allocated = false;
+	bool looptri_allocated = false;
+	const int looptri_num = dm->getNumLoopTri(dm);
+
+	mvert = DM_get_vert_array(dm, &vert_allocated);
+	mpoly = DM_get_poly_array(dm, &poly_allocated);
+	mloop = DM_get_loop_array(dm, &loop_allocated);
+	looptri = DM_get_looptri_array(
+	        dm,
+	        mvert,
+	        mpoly, dm->getNumPolys(dm),
+	        mloop, dm->getNumLoops(dm),
+	        &looptri_allocated);
+
+	if (poly_allocated) {
+		MEM_freeN(mpoly);
+	}
+
+	if (tree == NULL) {
+		tree = bvhtree_from_mesh_looptri_create_tree(
+		        epsilon, tree_type, axis,
+		        NULL, false,
+		        mvert, mloop, looptri, looptri_num, NULL, -1);
+	}
+	else {
+		int i;
+
+		for (i = 0; i < looptri_num; i++) {
+			float co[3][3];
+
+			copy_v3_v3(co[0], mvert[mloop[looptri[i].tri[0]].v].co);
+			copy_v3_v3(co[1], mvert[mloop[looptri[i].tri[1]].v].co);
+			copy_v3_v3(co[2], mvert[mloop[looptri[i].tri[2]].v].co);
+
+			BLI_bvhtree_update_node(tree, i, co[0], NULL, 3);
+		}
+		BLI_bvhtree_update_tree(tree);
+	}
+
+	/* Setup BVHTreeFromMesh, the tree isn't freed with it */
+	bvhtree_from_mesh_looptri_setup_data(
+	        data, tree, true, epsilon, NULL,
+	        mvert, vert_allocated,
+	        mloop, loop_allocated,
+	        looptri, looptri_allocated);
+
+	return data->tree;
+}
+
 /** \} */
 
 
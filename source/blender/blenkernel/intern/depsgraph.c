@@ -74,6 +74,7 @@
 #include "BKE_material.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_object.h"
 #include "BKE_paint.h"
 #include "BKE_particle.h"
@@ -2896,6 +2897,11 @@ void DAG_ids_clear_recalc(Main *bmain)
 
 void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 {
+	if (id && GS(id->name) == ID_ME) {
+		/* topology and custom data edits aren't covered by the modifier cache hash */
+		BKE_modifier_cache_tag_mesh(bmain, (Mesh *)id);
+	}
+
 	if (!DEG_depsgraph_use_legacy()) {
 		DEG_id_tag_update_ex(bmain, id, flag);
 		return;
@@ -3585,6 +3591,10 @@ void DAG_id_tag_update(ID *id, short flag)
 
 void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 {
+	if (id && GS(id->name) == ID_ME) {
+		BKE_modifier_cache_tag_mesh(bmain, (Mesh *)id);
+	}
+
 	DEG_id_tag_update_ex(bmain, id, flag);
 }
 
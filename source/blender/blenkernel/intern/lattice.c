@@ -33,6 +33,7 @@
 #include <string.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -40,6 +41,7 @@
 #include "BLI_listbase.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -372,8 +374,32 @@ typedef struct LatticeDeformData {
 	Object *object;
 	float *latticedata;
 	float latmat[4][4];
+
+	/* lattice vertex group, looked up once instead of per deformed vertex */
+	MDeformVert *dvert;
+	int defgrp_index;
 } LatticeDeformData;
 
+/* Per vertex lattice cell and B-spline basis weights along each axis. */
+typedef struct LatticeDeformBindVert {
+	int cell[3];
+	float weights[3][4];
+} LatticeDeformBindVert;
+
+/* Cached binding of deformed vertices to the lattice, valid as long as the
+ * lattice resolution, the relative transform and the input coordinates match. */
+typedef struct LatticeDeformBind {
+	int numVerts;
+	int pnts[3];
+	char type[3], pad;
+	float fuvw[3], duvw[3];
+	float latmat[4][4];
+
+	LatticeDeformBindVert *verts;
+	/* input coordinates the weights were computed for, compared in full since hashes can collide */
+	float (*vertexCos)[3];
+} LatticeDeformBind;
+
 LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 {
 	/* we make an array with all differences */
@@ -434,68 +460,61 @@ LatticeDeformData *init_latt_deform(Object *oblatt, Object *ob)
 	lattice_deform_data->object = oblatt;
 	copy_m4_m4(lattice_deform_data->latmat, latmat);
 
+	lattice_deform_data->dvert = BKE_lattice_deform_verts_get(oblatt);
+	lattice_deform_data->defgrp_index = -1;
+	if (lt->vgroup[0] && lattice_deform_data->dvert) {
+		lattice_deform_data->defgrp_index = defgroup_name_index(oblatt, lt->vgroup);
+	}
+
 	return lattice_deform_data;
 }
 
-void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+/* Lattice cell and basis weights of \a co, which is in the local space of the deformed object. */
+static void latt_deform_bind_vert(
+        const Lattice *lt, float latmat[4][4], const float co[3], LatticeDeformBindVert *bv)
 {
-	Object *ob = lattice_deform_data->object;
-	Lattice *lt = ob->data;
-	float u, v, w, tu[4], tv[4], tw[4];
+	const int pnts[3] = {lt->pntsu, lt->pntsv, lt->pntsw};
+	const float fuvw[3] = {lt->fu, lt->fv, lt->fw};
+	const float duvw[3] = {lt->du, lt->dv, lt->dw};
+	const char type[3] = {lt->typeu, lt->typev, lt->typew};
 	float vec[3];
-	int idx_w, idx_v, idx_u;
-	int ui, vi, wi, uu, vv, ww;
-
-	/* vgroup influence */
-	int defgrp_index = -1;
-	float co_prev[3], weight_blend = 0.0f;
-	MDeformVert *dvert = BKE_lattice_deform_verts_get(ob);
-
-
-	if (lt->editlatt) lt = lt->editlatt->latt;
-	if (lattice_deform_data->latticedata == NULL) return;
-
-	if (lt->vgroup[0] && dvert) {
-		defgrp_index = defgroup_name_index(ob, lt->vgroup);
-		copy_v3_v3(co_prev, co);
-	}
+	int axis;
 
 	/* co is in local coords, treat with latmat */
-	mul_v3_m4v3(vec, lattice_deform_data->latmat, co);
+	mul_v3_m4v3(vec, latmat, co);
 
 	/* u v w coords */
-
-	if (lt->pntsu > 1) {
-		u = (vec[0] - lt->fu) / lt->du;
-		ui = (int)floor(u);
-		u -= ui;
-		key_curve_position_weights(u, tu, lt->typeu);
-	}
-	else {
-		tu[0] = tu[2] = tu[3] = 0.0; tu[1] = 1.0;
-		ui = 0;
+	for (axis = 0; axis < 3; axis++) {
+		if (pnts[axis] > 1) {
+			float t = (vec[axis] - fuvw[axis]) / duvw[axis];
+			bv->cell[axis] = (int)floor(t);
+			t -= bv->cell[axis];
+			key_curve_position_weights(t, bv->weights[axis], type[axis]);
+		}
+		else {
+			bv->weights[axis][0] = bv->weights[axis][2] = bv->weights[axis][3] = 0.0f;
+			bv->weights[axis][1] = 1.0f;
+			bv->cell[axis] = 0;
+		}
 	}
+}
 
-	if (lt->pntsv > 1) {
-		v = (vec[1] - lt->fv) / lt->dv;
-		vi = (int)floor(v);
-		v -= vi;
-		key_curve_position_weights(v, tv, lt->typev);
-	}
-	else {
-		tv[0] = tv[2] = tv[3] = 0.0; tv[1] = 1.0;
-		vi = 0;
-	}
+/* Weighted gather of the lattice point offsets around the bound cell. */
+static void latt_deform_gather(
+        const LatticeDeformData *lattice_deform_data, const Lattice *lt,
+        const LatticeDeformBindVert *bv, float co[3], float weight)
+{
+	const float *tu = bv->weights[0], *tv = bv->weights[1], *tw = bv->weights[2];
+	const int ui = bv->cell[0], vi = bv->cell[1], wi = bv->cell[2];
+	const int defgrp_index = lattice_deform_data->defgrp_index;
+	const MDeformVert *dvert = lattice_deform_data->dvert;
+	float co_prev[3], weight_blend = 0.0f;
+	float u, v, w;
+	int idx_w, idx_v, idx_u;
+	int uu, vv, ww;
 
-	if (lt->pntsw > 1) {
-		w = (vec[2] - lt->fw) / lt->dw;
-		wi = (int)floor(w);
-		w -= wi;
-		key_curve_position_weights(w, tw, lt->typew);
-	}
-	else {
-		tw[0] = tw[2] = tw[3] = 0.0; tw[1] = 1.0;
-		wi = 0;
+	if (defgrp_index != -1) {
+		copy_v3_v3(co_prev, co);
 	}
 
 	for (ww = wi - 1; ww <= wi + 2; ww++) {
@@ -547,7 +566,23 @@ void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float
 
 	if (defgrp_index != -1)
 		interp_v3_v3v3(co, co_prev, co, weight_blend);
+}
+
+static const Lattice *latt_deform_lattice(const LatticeDeformData *lattice_deform_data)
+{
+	const Lattice *lt = lattice_deform_data->object->data;
+	return lt->editlatt ? lt->editlatt->latt : lt;
+}
+
+void calc_latt_deform(LatticeDeformData *lattice_deform_data, float co[3], float weight)
+{
+	const Lattice *lt = latt_deform_lattice(lattice_deform_data);
+	LatticeDeformBindVert bv;
 
+	if (lattice_deform_data->latticedata == NULL) return;
+
+	latt_deform_bind_vert(lt, lattice_deform_data->latmat, co, &bv);
+	latt_deform_gather(lattice_deform_data, lt, &bv, co, weight);
 }
 
 void end_latt_deform(LatticeDeformData *lattice_deform_data)
@@ -558,6 +593,104 @@ void end_latt_deform(LatticeDeformData *lattice_deform_data)
 	MEM_freeN(lattice_deform_data);
 }
 
+void BKE_lattice_deform_bind_free(LatticeDeformBind *bind)
+{
+	if (bind->verts) {
+		MEM_freeN(bind->verts);
+		MEM_freeN(bind->vertexCos);
+	}
+	MEM_freeN(bind);
+}
+
+/**
+ * Ensure \a bind matches the lattice and \a vertexCos.
+ * \return true when the stored weights can be used as they are.
+ */
+static bool latt_deform_bind_validate(
+        LatticeDeformBind *bind, const LatticeDeformData *lattice_deform_data,
+        float (*vertexCos)[3], int numVerts)
+{
+	const Lattice *lt = latt_deform_lattice(lattice_deform_data);
+	LatticeDeformBind key = {0};
+
+	key.numVerts = numVerts;
+	key.pnts[0] = lt->pntsu;
+	key.pnts[1] = lt->pntsv;
+	key.pnts[2] = lt->pntsw;
+	key.type[0] = lt->typeu;
+	key.type[1] = lt->typev;
+	key.type[2] = lt->typew;
+	copy_v3_fl3(key.fuvw, lt->fu, lt->fv, lt->fw);
+	copy_v3_fl3(key.duvw, lt->du, lt->dv, lt->dw);
+	copy_m4_m4(key.latmat, (float (*)[4])lattice_deform_data->latmat);
+
+	if (bind->verts &&
+	    memcmp(&key, bind, offsetof(LatticeDeformBind, verts)) == 0 &&
+	    memcmp(vertexCos, bind->vertexCos, sizeof(*vertexCos) * (size_t)numVerts) == 0)
+	{
+		return true;
+	}
+
+	if (bind->verts == NULL || bind->numVerts != numVerts) {
+		MEM_SAFE_FREE(bind->verts);
+		MEM_SAFE_FREE(bind->vertexCos);
+		bind->verts = MEM_mallocN(sizeof(*bind->verts) * (size_t)numVerts, "LatticeDeformBindVert");
+		bind->vertexCos = MEM_mallocN(sizeof(*bind->vertexCos) * (size_t)numVerts, "LatticeDeformBindCos");
+	}
+	memcpy(bind, &key, offsetof(LatticeDeformBind, verts));
+	memcpy(bind->vertexCos, vertexCos, sizeof(*vertexCos) * (size_t)numVerts);
+
+	return false;
+}
+
+typedef struct LatticeDeformUserdata {
+	const LatticeDeformData *lattice_deform_data;
+	const Lattice *lt;
+	float (*vertexCos)[3];
+	const MDeformVert *dvert;
+	int defgrp_index;
+	float fac;
+
+	/* NULL when deforming without a binding */
+	LatticeDeformBindVert *bind_verts;
+	bool bind_is_valid;
+} LatticeDeformUserdata;
+
+static void lattice_deform_vert_task(void *userdata, void *UNUSED(userdata_chunk), int index)
+{
+	const LatticeDeformUserdata *data = userdata;
+	float *co = data->vertexCos[index];
+	float weight = data->fac;
+	LatticeDeformBindVert bv_local, *bv;
+
+	if (data->bind_verts) {
+		bv = &data->bind_verts[index];
+		/* bind all vertices, vertex group weights are not part of the binding */
+		if (!data->bind_is_valid) {
+			latt_deform_bind_vert(data->lt, (float (*)[4])data->lattice_deform_data->latmat, co, bv);
+		}
+	}
+	else {
+		bv = NULL;
+	}
+
+	if (data->dvert) {
+		const float dvert_weight = defvert_find_weight(&data->dvert[index], data->defgrp_index);
+
+		if (dvert_weight <= 0.0f) {
+			return;
+		}
+		weight *= dvert_weight;
+	}
+
+	if (bv == NULL) {
+		bv = &bv_local;
+		latt_deform_bind_vert(data->lt, (float (*)[4])data->lattice_deform_data->latmat, co, bv);
+	}
+
+	latt_deform_gather(data->lattice_deform_data, data->lt, bv, co, weight);
+}
+
 /* calculations is in local space of deformed object
  * so we store in latmat transform from path coord inside object
  */
@@ -885,11 +1018,18 @@ void curve_deform_vector(Scene *scene, Object *cuOb, Object *target,
 
 }
 
-void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
-                          float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
+/**
+ * Deform \a vertexCos by the lattice \a laOb, evaluated in parallel.
+ *
+ * \param bind: Optional binding, weights stored in it are reused for as long as the
+ * lattice resolution, the relative transform and the input coordinates don't change.
+ */
+void lattice_deform_verts_ex(Object *laOb, Object *target, DerivedMesh *dm,
+                             float (*vertexCos)[3], int numVerts, const char *vgroup, float fac,
+                             LatticeDeformBind *bind)
 {
 	LatticeDeformData *lattice_deform_data;
-	int a;
+	LatticeDeformUserdata data = {NULL};
 	bool use_vgroups;
 
 	if (laOb->type != OB_LATTICE)
@@ -914,33 +1054,48 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 	else {
 		use_vgroups = false;
 	}
-	
+
+	data.lattice_deform_data = lattice_deform_data;
+	data.lt = latt_deform_lattice(lattice_deform_data);
+	data.vertexCos = vertexCos;
+	data.fac = fac;
+
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
 		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
 
 		if (defgrp_index >= 0 && (me->dvert || dm)) {
-			MDeformVert *dvert = me->dvert;
-			
-			for (a = 0; a < numVerts; a++, dvert++) {
-				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
-
-				weight = defvert_find_weight(dvert, defgrp_index);
-
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
-			}
+			data.dvert = dm ? dm->getVertDataArray(dm, CD_MDEFORMVERT) : me->dvert;
+			data.defgrp_index = defgrp_index;
 		}
-	}
-	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
+		else {
+			/* vertex group not found, nothing is deformed */
+			end_latt_deform(lattice_deform_data);
+			return;
 		}
 	}
+
+	if (bind) {
+		data.bind_is_valid = latt_deform_bind_validate(bind, lattice_deform_data, vertexCos, numVerts);
+		data.bind_verts = bind->verts;
+	}
+
+	BLI_task_parallel_range_ex(0, numVerts, &data, NULL, 0, lattice_deform_vert_task, numVerts > 1000, false);
+
 	end_latt_deform(lattice_deform_data);
 }
 
+void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
+                          float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
+{
+	lattice_deform_verts_ex(laOb, target, dm, vertexCos, numVerts, vgroup, fac, NULL);
+}
+
+LatticeDeformBind *BKE_lattice_deform_bind_new(void)
+{
+	return MEM_callocN(sizeof(LatticeDeformBind), "LatticeDeformBind");
+}
+
 bool object_deform_mball(Object *ob, ListBase *dispbase)
 {
 	if (ob->parent && ob->parent->type == OB_LATTICE && ob->partype == PARSKEL) {
@@ -45,6 +45,8 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_global.h"
 
@@ -58,6 +60,12 @@
 /* experimental (faster) normal calculation */
 // #define USE_ACCUM_NORMAL
 
+/* Vertex positions and normals are evaluated in parallel once the surface is walked,
+ * split in at most this many chunks per thread (one BVH queue per chunk). */
+#define MB_TASK_CHUNKS_PER_THREAD 4
+/* Minimum number of vertices per chunk, less don't pay off threading. */
+#define MB_TASK_CHUNK_MIN 64
+
 /* Data types */
 
 typedef struct corner {         /* corner of a cube */
@@ -118,8 +126,9 @@ typedef struct process {        /* parameters, storage */
 	MetaballBVHNode metaball_bvh; /* The simplest bvh */
 	Box allbb;                   /* Bounding box of all metaelems */
 
-	MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
+	MetaballBVHNode **bvh_queue; /* Queues used during bvh traversal, one per parallel chunk */
 	unsigned int bvh_queue_size;
+	unsigned int bvh_queue_tot;  /* number of queues */
 
 	CUBES *cubes;               /* stack of cubes waiting for polygonization */
 	CENTERLIST **centers;       /* cube center hash table */
@@ -131,6 +140,7 @@ typedef struct process {        /* parameters, storage */
 	unsigned int curindex;		/* number of currently added indices */
 
 	float (*co)[3], (*no)[3];   /* surface vertices - positions and normals */
+	const CORNER *(*vertex_corners)[2];  /* edge each vertex lies on, positions are evaluated from these */
 	unsigned int totvertex;		/* memory size */
 	unsigned int curvertex;		/* currently added vertices */
 
@@ -142,7 +152,9 @@ typedef struct process {        /* parameters, storage */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2);
 static void add_cube(PROCESS *process, int i, int j, int k);
 static void make_face(PROCESS *process, int i1, int i2, int i3, int i4);
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3]);
+static void converge(
+        const PROCESS *process, MetaballBVHNode **bvh_queue,
+        const CORNER *c1, const CORNER *c2, float r_p[3]);
 
 /* ******************* SIMPLE BVH ********************* */
 
@@ -361,26 +373,26 @@ static float densfunc(const MetaElem *ball, float x, float y, float z)
 
 /**
  * Computes density at given position form all metaballs which contain this point in their box.
- * Traverses BVH using a queue.
+ * Traverses BVH using a queue, \a bvh_queue must be owned by the calling thread.
  */
-static float metaball(PROCESS *process, float x, float y, float z)
+static float metaball(const PROCESS *process, MetaballBVHNode **bvh_queue, float x, float y, float z)
 {
 	int i;
 	float dens = 0.0f;
 	unsigned int front = 0, back = 0;
-	MetaballBVHNode *node;
+	const MetaballBVHNode *node;
 
-	process->bvh_queue[front++] = &process->metaball_bvh;
+	bvh_queue[front++] = (MetaballBVHNode *)&process->metaball_bvh;
 
 	while (front != back) {
-		node = process->bvh_queue[back++];
+		node = bvh_queue[back++];
 
 		for (i = 0; i < 2; i++) {
 			if ((node->bb[i].min[0] <= x) && (node->bb[i].max[0] >= x) &&
 			    (node->bb[i].min[1] <= y) && (node->bb[i].max[1] >= y) &&
 			    (node->bb[i].min[2] <= z) && (node->bb[i].max[2] >= z))
 			{
-				if (node->child[i])	process->bvh_queue[front++] = node->child[i];
+				if (node->child[i])	bvh_queue[front++] = node->child[i];
 				else dens += densfunc(node->bb[i].ml, x, y, z);
 			}
 		}
@@ -396,10 +408,6 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 {
 	int *cur;
 
-#ifdef USE_ACCUM_NORMAL
-	float n[3];
-#endif
-
 	if (UNLIKELY(process->totindex == process->curindex)) {
 		process->totindex += 4096;
 		process->indices = MEM_reallocN(process->indices, sizeof(int[4]) * process->totindex);
@@ -419,28 +427,42 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 	else {
 		cur[3] = i4;
 	}
+}
 
 #ifdef USE_ACCUM_NORMAL
-	if (i4 == 0) {
-		normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
-		accumulate_vertex_normals(
-		        process->no[i1], process->no[i2], process->no[i3], NULL, n,
-		        process->co[i1], process->co[i2], process->co[i3], NULL);
-	}
-	else {
-		normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-		accumulate_vertex_normals(
-		        process->no[i1], process->no[i2], process->no[i3], process->no[i4], n,
-		        process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-	}
-#endif
+/**
+ * Accumulates face normals to vertices, done once all vertex positions are known.
+ */
+static void accumulate_normals(PROCESS *process)
+{
+	unsigned int a;
+	float n[3];
+
+	for (a = 0; a < process->curindex; a++) {
+		const int *cur = process->indices[a];
+		const int i1 = cur[0], i2 = cur[1], i3 = cur[2], i4 = cur[3];
 
+		if (i4 == i3) {
+			normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
+			accumulate_vertex_normals(
+			        process->no[i1], process->no[i2], process->no[i3], NULL, n,
+			        process->co[i1], process->co[i2], process->co[i3], NULL);
+		}
+		else {
+			normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+			accumulate_vertex_normals(
+			        process->no[i1], process->no[i2], process->no[i3], process->no[i4], n,
+			        process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+		}
+	}
 }
+#endif
 
 /* Frees allocated memory */
 static void freepolygonize(PROCESS *process)
 {
 	if (process->corners) MEM_freeN(process->corners);
+	if (process->vertex_corners) MEM_freeN(process->vertex_corners);
 	if (process->edges) MEM_freeN(process->edges);
 	if (process->centers) MEM_freeN(process->centers);
 	if (process->mainb) MEM_freeN(process->mainb);
@@ -467,6 +489,8 @@ static void freepolygonize(PROCESS *process)
 
 static INTLISTS *cubetable[256];
 static char faces[256];
+/* the table is made once, until freed by #BKE_mball_cubeTable_free */
+static bool cubetable_is_done = false;
 
 /* edge: LB, LT, LN, LF, RB, RT, RN, RF, BN, BF, TN, TF */
 static int corner1[12] = {
@@ -595,7 +619,8 @@ static CORNER *setcorner(PROCESS *process, int i, int j, int k)
 	c->k = k;
 	c->co[2] = ((float)k - 0.5f) * process->size;
 
-	c->value = metaball(process, c->co[0], c->co[1], c->co[2]);
+	/* serial, uses the first queue */
+	c->value = metaball(process, process->bvh_queue, c->co[0], c->co[1], c->co[2]);
 
 	c->next = process->corners[index];
 	process->corners[index] = c;
@@ -651,11 +676,10 @@ static int otherface(int edge, int face)
  */
 static void makecubetable(void)
 {
-	static bool is_done = false;
 	int i, e, c, done[12], pos[8];
 
-	if (is_done) return;
-	is_done = true;
+	if (cubetable_is_done) return;
+	cubetable_is_done = true;
 
 	for (i = 0; i < 256; i++) {
 		for (e = 0; e < 12; e++) done[e] = 0;
@@ -730,6 +754,8 @@ void BKE_mball_cubeTable_free(void)
 		}
 		cubetable[i] = NULL;
 	}
+
+	cubetable_is_done = false;
 }
 
 /**** Storage ****/
@@ -828,18 +854,20 @@ static int getedge(EDGELIST *table[],
 }
 
 /**
- * Adds a vertex, expands memory if needed.
+ * Adds a vertex lying on the edge between two corners, expands memory if needed.
+ * Its position and normal are evaluated later, see #vertices_eval.
  */
-static void addtovertices(PROCESS *process, const float v[3], const float no[3])
+static void addtovertices(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
 	if (process->curvertex == process->totvertex) {
 		process->totvertex += 4096;
 		process->co = MEM_reallocN(process->co, process->totvertex * sizeof(float[3]));
 		process->no = MEM_reallocN(process->no, process->totvertex * sizeof(float[3]));
+		process->vertex_corners = MEM_reallocN(process->vertex_corners, process->totvertex * sizeof(CORNER *[2]));
 	}
 
-	copy_v3_v3(process->co[process->curvertex], v);
-	copy_v3_v3(process->no[process->curvertex], no);
+	process->vertex_corners[process->curvertex][0] = c1;
+	process->vertex_corners[process->curvertex][1] = c2;
 
 	process->curvertex++;
 }
@@ -850,14 +878,14 @@ static void addtovertices(PROCESS *process, const float v[3], const float no[3])
  *
  * \note Doesn't do normalization!
  */
-static void vnormal(PROCESS *process, const float point[3], float r_no[3])
+static void vnormal(const PROCESS *process, MetaballBVHNode **bvh_queue, const float point[3], float r_no[3])
 {
 	const float delta = process->delta;
-	const float f = metaball(process, point[0], point[1], point[2]);
+	const float f = metaball(process, bvh_queue, point[0], point[1], point[2]);
 
-	r_no[0] = metaball(process, point[0] + delta, point[1], point[2]) - f;
-	r_no[1] = metaball(process, point[0], point[1] + delta, point[2]) - f;
-	r_no[2] = metaball(process, point[0], point[1], point[2] + delta) - f;
+	r_no[0] = metaball(process, bvh_queue, point[0] + delta, point[1], point[2]) - f;
+	r_no[1] = metaball(process, bvh_queue, point[0], point[1] + delta, point[2]) - f;
+	r_no[2] = metaball(process, bvh_queue, point[0], point[1], point[2] + delta) - f;
 
 #if 0
 	f = normalize_v3(r_no);
@@ -885,24 +913,15 @@ static void vnormal(PROCESS *process, const float point[3], float r_no[3])
 /**
  * \return the id of vertex between two corners.
  *
- * If it wasn't previously computed, does #converge() and adds vertex to process.
+ * If it wasn't previously added, adds vertex to process (its position is computed later).
  */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
-	float v[3], no[3];
 	int vid = getedge(process->edges, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
 
 	if (vid != -1) return vid;  /* previously computed */
 
-	converge(process, c1, c2, v);  /* position */
-
-#ifdef USE_ACCUM_NORMAL
-	zero_v3(no);
-#else
-	vnormal(process, v, no);
-#endif
-
-	addtovertices(process, v, no);            /* save vertex */
+	addtovertices(process, c1, c2);            /* save vertex */
 	vid = (int)process->curvertex - 1;
 	setedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k, vid);
 
@@ -913,7 +932,9 @@ static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
  * Given two corners, computes approximation of surface intersection point between them.
  * In case of small threshold, do bisection.
  */
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3])
+static void converge(
+        const PROCESS *process, MetaballBVHNode **bvh_queue,
+        const CORNER *c1, const CORNER *c2, float r_p[3])
 {
 	float tmp, dens;
 	unsigned int i;
@@ -936,7 +957,7 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 
 	for (i = 0; i < process->converge_res; i++) {
 		interp_v3_v3v3(r_p, c1_co, c2_co, 0.5f);
-		dens = metaball(process, r_p[0], r_p[1], r_p[2]);
+		dens = metaball(process, bvh_queue, r_p[0], r_p[1], r_p[2]);
 
 		if (dens > 0.0f) {
 			c1_value = dens;
@@ -1043,21 +1064,105 @@ static void find_first_points(PROCESS *process, const unsigned int em)
 	}
 }
 
+/**** Parallel evaluation ****/
+
+typedef struct MetaballTaskData {
+	PROCESS *process;
+	unsigned int len;
+	unsigned int chunk_len;
+} MetaballTaskData;
+
+/**
+ * Splits the range in chunks, each chunk traverses the BVH with its own queue.
+ * \return the number of chunks.
+ */
+static unsigned int metaball_task_data_init(
+        MetaballTaskData *data, PROCESS *process, const unsigned int len)
+{
+	unsigned int chunks = len / MB_TASK_CHUNK_MIN;
+
+	CLAMP(chunks, 1, process->bvh_queue_tot);
+
+	data->process = process;
+	data->len = len;
+	data->chunk_len = (len + chunks - 1) / chunks;
+
+	return chunks;
+}
+
+static void metaball_task_range(
+        const MetaballTaskData *data, const int chunk,
+        unsigned int *r_start, unsigned int *r_end, MetaballBVHNode ***r_bvh_queue)
+{
+	const unsigned int offset = data->chunk_len * (unsigned int)chunk;
+
+	*r_start = offset;
+	*r_end = MIN2(offset + data->chunk_len, data->len);
+	*r_bvh_queue = data->process->bvh_queue + data->process->bvh_queue_size * (unsigned int)chunk;
+}
+
+static void vertices_eval_cb(void *userdata, void *UNUSED(userdata_chunk), int chunk)
+{
+	const MetaballTaskData *data = userdata;
+	PROCESS *process = data->process;
+	MetaballBVHNode **bvh_queue;
+	unsigned int i, end;
+
+	metaball_task_range(data, chunk, &i, &end, &bvh_queue);
+
+	for (; i < end; i++) {
+		converge(process, bvh_queue, process->vertex_corners[i][0], process->vertex_corners[i][1], process->co[i]);
+
+#ifdef USE_ACCUM_NORMAL
+		zero_v3(process->no[i]);
+#else
+		vnormal(process, bvh_queue, process->co[i], process->no[i]);
+#endif
+	}
+}
+
+/**
+ * Computes positions and normals of all vertices.
+ */
+static void vertices_eval(PROCESS *process)
+{
+	MetaballTaskData data;
+	const unsigned int chunks = metaball_task_data_init(&data, process, process->curvertex);
+
+	if (process->curvertex == 0) {
+		return;
+	}
+
+	BLI_task_parallel_range_ex(
+	        0, (int)chunks, &data, NULL, 0, vertices_eval_cb,
+	        chunks > 1, true);
+
+#ifdef USE_ACCUM_NORMAL
+	accumulate_normals(process);
+#endif
+}
+
 /**
  * The main polygonization proc.
  * Allocates memory, makes cubetable,
  * finds starting surface points
  * and processes cubes on the stack until none left.
+ *
+ * Vertices are only added while walking the surface,
+ * their positions and normals (most of the density evaluations) are computed in parallel afterwards.
  */
 static void polygonize(PROCESS *process)
 {
 	CUBE c;
 	unsigned int i;
 
+	process->bvh_queue_tot = (unsigned int)BLI_system_thread_count() * MB_TASK_CHUNKS_PER_THREAD;
+
 	process->centers = MEM_callocN(HASHSIZE * sizeof(CENTERLIST *), "mbproc->centers");
 	process->corners = MEM_callocN(HASHSIZE * sizeof(CORNER *), "mbproc->corners");
 	process->edges = MEM_callocN(2 * HASHSIZE * sizeof(EDGELIST *), "mbproc->edges");
-	process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size, "Metaball BVH Queue");
+	process->bvh_queue = MEM_callocN(
+	        sizeof(MetaballBVHNode *) * process->bvh_queue_size * process->bvh_queue_tot, "Metaball BVH Queue");
 
 	makecubetable();
 
@@ -1071,6 +1176,8 @@ static void polygonize(PROCESS *process)
 
 		docube(process, &c);
 	}
+
+	vertices_eval(process);
 }
 
 /**
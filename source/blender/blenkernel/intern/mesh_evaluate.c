@@ -627,6 +627,9 @@ typedef struct LoopSplitTaskDataCommon {
 
 	int numPolys;
 
+	/* Only used without split normals. */
+	int *r_loop_to_poly;
+
 	/* ***** Workers communication. ***** */
 	ThreadQueue *task_queue;
 
@@ -1123,6 +1126,29 @@ static void loop_split_generator(TaskPool * __restrict UNUSED(pool), void *taskd
 	loop_split_generator_do(common_data, true);
 }
 
+/* Without split normals, each poly only writes to its own loops. */
+static void loop_split_nosplit_poly_cb(void *userdata, void *UNUSED(userdata_chunk), int mp_index)
+{
+	LoopSplitTaskDataCommon *common_data = userdata;
+	const MPoly *mp = &common_data->mpolys[mp_index];
+	int ml_index = mp->loopstart;
+	const int ml_index_end = ml_index + mp->totloop;
+	const bool is_poly_flat = ((mp->flag & ME_SMOOTH) == 0);
+
+	for (; ml_index < ml_index_end; ml_index++) {
+		if (common_data->r_loop_to_poly) {
+			common_data->r_loop_to_poly[ml_index] = mp_index;
+		}
+		if (is_poly_flat) {
+			copy_v3_v3(common_data->loopnors[ml_index], common_data->polynors[mp_index]);
+		}
+		else {
+			normal_short_to_float_v3(common_data->loopnors[ml_index],
+			                         common_data->mverts[common_data->mloops[ml_index].v].no);
+		}
+	}
+}
+
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry (splitting edges).
@@ -1144,26 +1170,17 @@ void BKE_mesh_normals_loop_split(
 		 * since we may want to use lnors even when mesh's 'autosmooth' is disabled (see e.g. mesh mapping code).
 		 * As usual, we could handle that on case-by-case basis, but simpler to keep it well confined here.
 		 */
-		int mp_index;
+		LoopSplitTaskDataCommon common_data = {NULL};
 
-		for (mp_index = 0; mp_index < numPolys; mp_index++) {
-			MPoly *mp = &mpolys[mp_index];
-			int ml_index = mp->loopstart;
-			const int ml_index_end = ml_index + mp->totloop;
-			const bool is_poly_flat = ((mp->flag & ME_SMOOTH) == 0);
+		common_data.loopnors = r_loopnors;
+		common_data.mverts = mverts;
+		common_data.mloops = mloops;
+		common_data.mpolys = mpolys;
+		common_data.polynors = polynors;
+		common_data.r_loop_to_poly = r_loop_to_poly;
 
-			for (; ml_index < ml_index_end; ml_index++) {
-				if (r_loop_to_poly) {
-					r_loop_to_poly[ml_index] = mp_index;
-				}
-				if (is_poly_flat) {
-					copy_v3_v3(r_loopnors[ml_index], polynors[mp_index]);
-				}
-				else {
-					normal_short_to_float_v3(r_loopnors[ml_index], mverts[mloops[ml_index].v].no);
-				}
-			}
-		}
+		BLI_task_parallel_range_ex(0, numPolys, &common_data, NULL, 0, loop_split_nosplit_poly_cb,
+		                           numPolys > BKE_MESH_OMP_LIMIT, false);
 		return;
 	}
 
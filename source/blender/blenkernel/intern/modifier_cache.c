@@ -0,0 +1,705 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Persistent per-object cache of intermediate modifier stack results.
+ *
+ * Every evaluated modifier extends a 64 bit chain hash which covers the stack input
+ * (vertex coordinates and evaluation options), the DNA settings of the modifier
+ * and the state of the objects it links to. After a constructive modifier the
+ * resulting DerivedMesh can be stored under its stack index and chain hash,
+ * a later evaluation with an identical prefix then resumes from a copy of it.
+ * Entries also keep the element counts of the stack input, which are compared
+ * exactly along with the hash.
+ *
+ * Modifiers whose result depends on data the hash doesn't cover (simulations,
+ * textures, time, multires displacement) end the cacheable part of the stack.
+ * Edits of the base mesh are reported through #BKE_modifier_cache_tag_mesh.
+ *
+ * All stored results share a global memory limit, results are only stored
+ * when they fit, evicting shallower results of the same object first so
+ * caches of objects being evaluated in other threads are never touched.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_action_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+
+#include "atomic_ops.h"
+
+typedef struct ModifierCacheEntry {
+	struct ModifierCacheEntry *next, *prev;
+	int stack_index;
+	uint64_t hash;
+	int counts[MODIFIER_CACHE_NUM_COUNTS];
+	DerivedMesh *dm;
+	size_t mem_size;
+} ModifierCacheEntry;
+
+typedef struct ModifierStackCache {
+	ListBase entries;  /* ModifierCacheEntry, sorted by stack index */
+
+	/* chain hashes of the previous evaluation, only results which are
+	 * stable across two evaluations get stored */
+	uint64_t *prev_chain;
+	int prev_chain_len;
+
+	/* first stack index invalidated by a tag since the last evaluation, -1 when untagged */
+	int tag_index;
+} ModifierStackCache;
+
+static struct {
+	size_t limit;
+	size_t mem_in_use;
+	unsigned int entries;
+	unsigned int hits, misses, stores, rejects, evictions;
+} modcache = {0};
+
+/* -------------------------------------------------------------------- */
+/* Memory accounting */
+
+static size_t modifier_cache_customdata_size(const CustomData *data, int totelem)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+
+	return size;
+}
+
+static size_t modifier_cache_dm_size(DerivedMesh *dm)
+{
+	return (sizeof(DerivedMesh) +
+	        modifier_cache_customdata_size(&dm->vertData, dm->getNumVerts(dm)) +
+	        modifier_cache_customdata_size(&dm->edgeData, dm->getNumEdges(dm)) +
+	        modifier_cache_customdata_size(&dm->faceData, dm->getNumTessFaces(dm)) +
+	        modifier_cache_customdata_size(&dm->loopData, dm->getNumLoops(dm)) +
+	        modifier_cache_customdata_size(&dm->polyData, dm->getNumPolys(dm)));
+}
+
+static bool modifier_cache_mem_reserve(size_t size)
+{
+	size_t mem_in_use;
+
+	do {
+		mem_in_use = modcache.mem_in_use;
+		if (mem_in_use + size > modcache.limit) {
+			return false;
+		}
+	} while (atomic_cas_z(&modcache.mem_in_use, mem_in_use, mem_in_use + size) != mem_in_use);
+
+	return true;
+}
+
+static void modifier_cache_entry_free(ModifierStackCache *cache, ModifierCacheEntry *entry)
+{
+	BLI_remlink(&cache->entries, entry);
+
+	entry->dm->needsFree = 1;
+	entry->dm->release(entry->dm);
+
+	atomic_sub_z(&modcache.mem_in_use, entry->mem_size);
+	atomic_sub_u(&modcache.entries, 1);
+
+	MEM_freeN(entry);
+}
+
+static void modifier_cache_free_from(ModifierStackCache *cache, int stack_index)
+{
+	ModifierCacheEntry *entry, *entry_next;
+
+	for (entry = cache->entries.first; entry; entry = entry_next) {
+		entry_next = entry->next;
+		if (entry->stack_index >= stack_index) {
+			modifier_cache_entry_free(cache, entry);
+		}
+	}
+}
+
+static ModifierCacheEntry *modifier_cache_find(
+        ModifierStackCache *cache, const ModifierCacheEval *mce, int stack_index, uint64_t hash)
+{
+	ModifierCacheEntry *entry;
+
+	for (entry = cache->entries.first; entry; entry = entry->next) {
+		if (entry->stack_index == stack_index && entry->hash == hash &&
+		    memcmp(entry->counts, mce->counts, sizeof(entry->counts)) == 0)
+		{
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* -------------------------------------------------------------------- */
+/* Hashing */
+
+/* 64 bit hash made of two murmur hashes with different seeds,
+ * a 32 bit hash collides too easily with the number of evaluations done in a session. */
+typedef struct ModifierCacheHash {
+	BLI_HashMurmur2A mm2[2];
+} ModifierCacheHash;
+
+static void modifier_cache_hash_init(ModifierCacheHash *mch, uint64_t seed)
+{
+	BLI_hash_mm2a_init(&mch->mm2[0], (uint32_t)seed);
+	BLI_hash_mm2a_init(&mch->mm2[1], (uint32_t)(seed >> 32) ^ 0x9e3779b9u);
+}
+
+static void modifier_cache_hash_add(ModifierCacheHash *mch, const void *data, size_t len)
+{
+	BLI_hash_mm2a_add(&mch->mm2[0], data, len);
+	BLI_hash_mm2a_add(&mch->mm2[1], data, len);
+}
+
+static void modifier_cache_hash_add_int(ModifierCacheHash *mch, int data)
+{
+	BLI_hash_mm2a_add_int(&mch->mm2[0], data);
+	BLI_hash_mm2a_add_int(&mch->mm2[1], data);
+}
+
+static uint64_t modifier_cache_hash_end(ModifierCacheHash *mch)
+{
+	const uint64_t lo = BLI_hash_mm2a_end(&mch->mm2[0]);
+	const uint64_t hi = BLI_hash_mm2a_end(&mch->mm2[1]);
+
+	return (hi << 32) | lo;
+}
+
+typedef struct ModifierHashLinkData {
+	Object *ob;
+	ModifierCacheHash *mch;
+	bool valid;
+} ModifierHashLinkData;
+
+static void modifier_cache_hash_object(ModifierHashLinkData *data, Object *ob_link)
+{
+	ModifierCacheHash *mch = data->mch;
+
+	modifier_cache_hash_add(mch, ob_link->obmat, sizeof(ob_link->obmat));
+
+	switch (ob_link->type) {
+		case OB_EMPTY:
+			break;
+		case OB_MESH:
+		{
+			DerivedMesh *dm = ob_link->derivedFinal;
+
+			if (ob_link->mode & OB_MODE_EDIT) {
+				data->valid = false;
+			}
+			else if (dm) {
+				modifier_cache_hash_add_int(mch, dm->getNumVerts(dm));
+				modifier_cache_hash_add_int(mch, dm->getNumEdges(dm));
+				modifier_cache_hash_add_int(mch, dm->getNumPolys(dm));
+				modifier_cache_hash_add(mch, dm->getVertArray(dm), sizeof(MVert) * (size_t)dm->getNumVerts(dm));
+			}
+			else {
+				Mesh *me = ob_link->data;
+				modifier_cache_hash_add_int(mch, me->totvert);
+				modifier_cache_hash_add_int(mch, me->totpoly);
+				modifier_cache_hash_add(mch, me->mvert, sizeof(MVert) * (size_t)me->totvert);
+			}
+			break;
+		}
+		case OB_ARMATURE:
+		{
+			bPoseChannel *pchan;
+
+			if (ob_link->pose == NULL) {
+				data->valid = false;
+				break;
+			}
+			for (pchan = ob_link->pose->chanbase.first; pchan; pchan = pchan->next) {
+				modifier_cache_hash_add(mch, pchan->chan_mat, sizeof(pchan->chan_mat));
+			}
+			break;
+		}
+		default:
+			/* curves, lattices... keep their evaluated state in places we don't hash */
+			data->valid = false;
+			break;
+	}
+}
+
+static void modifier_cache_hash_id_link(void *userData, Object *UNUSED(ob), ID **idpoin, int UNUSED(cd_flag))
+{
+	ModifierHashLinkData *data = userData;
+	ID *id = *idpoin;
+
+	if (id == NULL) {
+		return;
+	}
+
+	switch (GS(id->name)) {
+		case ID_OB:
+			if ((Object *)id != data->ob) {
+				modifier_cache_hash_object(data, (Object *)id);
+			}
+			break;
+		case ID_TE:
+			/* texture results aren't hashed */
+			data->valid = false;
+			break;
+		default:
+			/* the ID pointer is part of the modifier settings already */
+			break;
+	}
+}
+
+/**
+ * Extend \a hash with the settings of \a md.
+ * \return false when the result of \a md can't be reproduced from the hash.
+ */
+static bool modifier_cache_hash_modifier(Object *ob, ModifierData *md, uint64_t *hash)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	ModifierCacheHash mch;
+	ModifierHashLinkData data;
+
+	if ((mti->flags & eModifierTypeFlag_UsesPointCache) ||
+	    (mti->dependsOnTime && mti->dependsOnTime(md)) ||
+	    ELEM(md->type, eModifierType_ParticleSystem, eModifierType_Multires))
+	{
+		return false;
+	}
+
+	modifier_cache_hash_init(&mch, *hash);
+	modifier_cache_hash_add_int(&mch, md->type);
+	modifier_cache_hash_add_int(&mch, md->mode & (eModifierMode_Realtime | eModifierMode_Render));
+
+	/* all settings following the generic header */
+	if (mti->structSize > (int)sizeof(ModifierData)) {
+		modifier_cache_hash_add(&mch, md + 1, (size_t)mti->structSize - sizeof(ModifierData));
+	}
+
+	/* levels are limited by the scene simplify settings, see get_render_subsurf_level() */
+	if (ELEM(md->type, eModifierType_Subsurf, eModifierType_Multires) && md->scene) {
+		const RenderData *r = &md->scene->r;
+
+		modifier_cache_hash_add_int(&mch, r->mode & R_SIMPLIFY);
+		modifier_cache_hash_add_int(&mch, r->simplify_subsurf);
+		modifier_cache_hash_add_int(&mch, r->simplify_subsurf_render);
+	}
+
+	data.ob = ob;
+	data.mch = &mch;
+	data.valid = true;
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_cache_hash_id_link, &data);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_cache_hash_id_link, &data);
+	}
+
+	if (mti->foreachObjectLink || mti->foreachIDLink) {
+		/* linked objects are used relative to the modified object */
+		modifier_cache_hash_add(&mch, ob->obmat, sizeof(ob->obmat));
+	}
+
+	*hash = modifier_cache_hash_end(&mch);
+
+	/* zero marks unset chain slots */
+	if (*hash == 0) {
+		*hash = 1;
+	}
+
+	return data.valid;
+}
+
+/* -------------------------------------------------------------------- */
+/* Public API */
+
+void BKE_modifier_cache_set_limit(size_t limit)
+{
+	modcache.limit = limit;
+}
+
+size_t BKE_modifier_cache_get_limit(void)
+{
+	return modcache.limit;
+}
+
+void BKE_modifier_cache_free(Object *ob)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+
+	if (cache) {
+		modifier_cache_free_from(cache, 0);
+		MEM_SAFE_FREE(cache->prev_chain);
+		MEM_freeN(cache);
+		ob->modifier_cache = NULL;
+	}
+}
+
+void BKE_modifier_cache_free_all(Main *bmain)
+{
+	Object *ob;
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		BKE_modifier_cache_free(ob);
+	}
+}
+
+/**
+ * Invalidate results of \a md and all modifiers following it,
+ * the actual freeing happens on the next evaluation of the object.
+ */
+void BKE_modifier_cache_tag_modifier(Object *ob, ModifierData *md)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+	int index;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	index = BLI_findindex(&ob->modifiers, md);
+	if (index == -1) {
+		index = 0;
+	}
+
+	if (cache->tag_index == -1 || index < cache->tag_index) {
+		cache->tag_index = index;
+	}
+}
+
+/**
+ * Invalidate all results of objects using \a me,
+ * for edits the input hash doesn't cover (topology, custom data).
+ */
+void BKE_modifier_cache_tag_mesh(Main *bmain, Mesh *me)
+{
+	Object *ob;
+
+	if (modcache.entries == 0) {
+		return;
+	}
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		if (ob->data == me && ob->modifier_cache) {
+			ob->modifier_cache->tag_index = 0;
+		}
+	}
+}
+
+/**
+ * Start caching an evaluation of the modifier stack of \a ob.
+ *
+ * \param vertCos: Input coordinates of the stack, NULL to use the mesh coordinates.
+ * \param flag: Extra evaluation options which affect the result.
+ * \return false when the cache is disabled.
+ */
+bool BKE_modifier_cache_eval_begin(
+        ModifierCacheEval *mce, Object *ob,
+        const float (*vertCos)[3], int numVerts,
+        uint64_t dataMask, int flag)
+{
+	Mesh *me = ob->data;
+	ModifierStackCache *cache;
+	ModifierCacheHash mch;
+
+	memset(mce, 0, sizeof(*mce));
+
+	if (modcache.limit == 0) {
+		BKE_modifier_cache_free(ob);
+		return false;
+	}
+
+	if (ob->modifier_cache == NULL) {
+		ob->modifier_cache = MEM_callocN(sizeof(ModifierStackCache), "ModifierStackCache");
+		ob->modifier_cache->tag_index = -1;
+	}
+	cache = ob->modifier_cache;
+
+	if (cache->tag_index != -1) {
+		modifier_cache_free_from(cache, cache->tag_index);
+		cache->tag_index = -1;
+	}
+
+	mce->counts[0] = me->totvert;
+	mce->counts[1] = me->totedge;
+	mce->counts[2] = me->totloop;
+	mce->counts[3] = me->totpoly;
+	mce->counts[4] = vertCos ? numVerts : -1;
+
+	modifier_cache_hash_init(&mch, 0);
+	modifier_cache_hash_add(&mch, &me, sizeof(me));
+	modifier_cache_hash_add(&mch, &dataMask, sizeof(dataMask));
+	modifier_cache_hash_add_int(&mch, flag);
+	if (vertCos) {
+		modifier_cache_hash_add(&mch, vertCos, sizeof(*vertCos) * (size_t)numVerts);
+	}
+	else {
+		modifier_cache_hash_add(&mch, me->mvert, sizeof(MVert) * (size_t)me->totvert);
+	}
+
+	mce->ob = ob;
+	mce->cache = cache;
+	mce->hash = modifier_cache_hash_end(&mch);
+	mce->chain_len = BLI_listbase_count(&ob->modifiers);
+	mce->chain = MEM_callocN(sizeof(*mce->chain) * (size_t)max_ii(mce->chain_len, 1), "ModifierCacheEval chain");
+	mce->last_constructive = -1;
+	mce->valid = true;
+
+	return true;
+}
+
+/**
+ * Find the deepest stored result matching the current stack.
+ *
+ * The modifier skipping rules mirror the viewport evaluation in #mesh_calc_modifiers.
+ *
+ * \return The modifier after which evaluation can resume with \a r_dm, or NULL.
+ */
+ModifierData *BKE_modifier_cache_eval_lookup(
+        ModifierCacheEval *mce, struct Scene *scene, ModifierData *md_first,
+        const bool need_mapping, DerivedMesh **r_dm)
+{
+	ModifierStackCache *cache = mce->cache;
+	ModifierCacheEntry *entry, *entry_hit = NULL;
+	ModifierData *md, *md_hit = NULL;
+	uint64_t hash = mce->hash;
+	bool has_dm = false, valid = true;
+	int i;
+
+	*r_dm = NULL;
+
+	for (md = md_first; md; md = md->next) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+		int index;
+
+		if (!modifier_isEnabled(scene, md, eModifierMode_Realtime)) {
+			continue;
+		}
+		if ((mti->flags & eModifierTypeFlag_RequiresOriginalData) && has_dm) {
+			continue;
+		}
+		if (need_mapping && !modifier_supportsMapping(md)) {
+			continue;
+		}
+
+		if (valid) {
+			valid = modifier_cache_hash_modifier(mce->ob, md, &hash);
+		}
+
+		if (mti->type == eModifierTypeType_OnlyDeform) {
+			continue;
+		}
+
+		has_dm = true;
+		index = BLI_findindex(&mce->ob->modifiers, md);
+		if (index == -1) {
+			continue;
+		}
+		mce->last_constructive = index;
+
+		if (valid) {
+			mce->chain[index] = hash;
+			if ((entry = modifier_cache_find(cache, mce, index, hash))) {
+				entry_hit = entry;
+				md_hit = md;
+			}
+		}
+	}
+
+	if (entry_hit == NULL) {
+		memset(mce->chain, 0, sizeof(*mce->chain) * (size_t)mce->chain_len);
+		if (mce->last_constructive != -1) {
+			atomic_add_u(&modcache.misses, 1);
+		}
+		return NULL;
+	}
+
+	/* the remaining part of the chain gets filled while evaluating */
+	for (i = entry_hit->stack_index + 1; i < mce->chain_len; i++) {
+		mce->chain[i] = 0;
+	}
+
+	mce->hash = entry_hit->hash;
+	*r_dm = CDDM_copy(entry_hit->dm);
+
+	atomic_add_u(&modcache.hits, 1);
+
+	return md_hit;
+}
+
+static void modifier_cache_store(ModifierCacheEval *mce, int stack_index, DerivedMesh *dm)
+{
+	ModifierStackCache *cache = mce->cache;
+	ModifierCacheEntry *entry, *entry_prev;
+	const size_t mem_size = modifier_cache_dm_size(dm);
+
+	while (!modifier_cache_mem_reserve(mem_size)) {
+		/* make room by dropping shallower results of this object,
+		 * deeper results save more evaluation time */
+		entry = cache->entries.first;
+		if (entry == NULL || entry->stack_index >= stack_index) {
+			atomic_add_u(&modcache.rejects, 1);
+			return;
+		}
+		modifier_cache_entry_free(cache, entry);
+		atomic_add_u(&modcache.evictions, 1);
+	}
+
+	entry = MEM_callocN(sizeof(ModifierCacheEntry), "ModifierCacheEntry");
+	entry->stack_index = stack_index;
+	entry->hash = mce->hash;
+	memcpy(entry->counts, mce->counts, sizeof(entry->counts));
+	entry->dm = CDDM_copy(dm);
+	entry->mem_size = mem_size;
+
+	for (entry_prev = cache->entries.last; entry_prev; entry_prev = entry_prev->prev) {
+		if (entry_prev->stack_index <= stack_index) {
+			break;
+		}
+	}
+	BLI_insertlinkafter(&cache->entries, entry_prev, entry);
+
+	atomic_add_u(&modcache.entries, 1);
+	atomic_add_u(&modcache.stores, 1);
+}
+
+/**
+ * Extend the chain with \a md which was just evaluated, storing its result \a dm when worthwhile.
+ */
+void BKE_modifier_cache_eval_step(ModifierCacheEval *mce, ModifierData *md, DerivedMesh *dm)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	ModifierStackCache *cache = mce->cache;
+	int index;
+
+	if (!mce->valid) {
+		return;
+	}
+
+	if (!modifier_cache_hash_modifier(mce->ob, md, &mce->hash)) {
+		mce->valid = false;
+		return;
+	}
+
+	if (mti->type == eModifierTypeType_OnlyDeform || dm == NULL) {
+		return;
+	}
+
+	index = BLI_findindex(&mce->ob->modifiers, md);
+	if (index == -1) {
+		return;
+	}
+
+	mce->chain[index] = mce->hash;
+
+	/* the final result is owned by the object already */
+	if (index >= mce->last_constructive) {
+		return;
+	}
+
+	/* results of animated input would fill the cache without ever being reused */
+	if (index >= cache->prev_chain_len || cache->prev_chain[index] != mce->hash) {
+		return;
+	}
+
+	if (modifier_cache_find(cache, mce, index, mce->hash)) {
+		return;
+	}
+
+	modifier_cache_store(mce, index, dm);
+}
+
+void BKE_modifier_cache_eval_end(ModifierCacheEval *mce)
+{
+	ModifierStackCache *cache = mce->cache;
+	ModifierCacheEntry *entry, *entry_next;
+
+	/* free results which don't match the current stack anymore */
+	for (entry = cache->entries.first; entry; entry = entry_next) {
+		entry_next = entry->next;
+		if (entry->stack_index >= mce->chain_len || mce->chain[entry->stack_index] != entry->hash ||
+		    memcmp(entry->counts, mce->counts, sizeof(entry->counts)) != 0)
+		{
+			modifier_cache_entry_free(cache, entry);
+		}
+	}
+
+	MEM_SAFE_FREE(cache->prev_chain);
+	cache->prev_chain = mce->chain;
+	cache->prev_chain_len = mce->chain_len;
+
+	mce->chain = NULL;
+}
+
+void BKE_modifier_cache_stats_get(ModifierCacheStats *r_stats)
+{
+	r_stats->hits = modcache.hits;
+	r_stats->misses = modcache.misses;
+	r_stats->stores = modcache.stores;
+	r_stats->rejects = modcache.rejects;
+	r_stats->evictions = modcache.evictions;
+	r_stats->entries = modcache.entries;
+	r_stats->mem_in_use = modcache.mem_in_use;
+	r_stats->mem_limit = modcache.limit;
+}
+
+void BKE_modifier_cache_stats_reset(void)
+{
+	modcache.hits = modcache.misses = 0;
+	modcache.stores = modcache.rejects = modcache.evictions = 0;
+}
+
+void BKE_modifier_cache_stats_print(void)
+{
+	ModifierCacheStats stats;
+
+	BKE_modifier_cache_stats_get(&stats);
+
+	printf("Modifier cache: %u hits, %u misses, %u stored, %u rejected, %u evicted\n",
+	       stats.hits, stats.misses, stats.stores, stats.rejects, stats.evictions);
+	printf("  %u entries, %.2f of %.2f MB in use\n",
+	       stats.entries,
+	       (double)stats.mem_in_use / (1024.0 * 1024.0),
+	       (double)stats.mem_limit / (1024.0 * 1024.0));
+}
@@ -32,6 +32,7 @@
 
 #include "BLI_math.h"
 #include "BLI_alloca.h"
+#include "BLI_task.h"
 
 #include "BKE_DerivedMesh.h"
 #include "BKE_editmesh.h"
@@ -53,6 +54,100 @@ static BMFace *bm_face_create_from_mpoly(
 	return BM_face_create(bm, verts, edges, mp->totloop, NULL, BM_CREATE_SKIP_CD);
 }
 
+/* Custom-data blocks are allocated while creating elements (which must be done serially),
+ * see #BM_mesh_cd_block_alloc, then filled in by a threaded pass over the element tables. */
+typedef struct DMToBMeshData {
+	DerivedMesh *dm;
+	BMesh *bm;
+
+	const MVert *mvert;
+	const MEdge *medge;
+	const MPoly *mpoly;
+	const float (*face_normals)[3];
+
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+
+	bool calc_face_normal;
+	char has_orig_htype;
+} DMToBMeshData;
+
+static void dm_to_bmesh_vert_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	DMToBMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	const MVert *mv = &data->mvert[i];
+	BMVert *v = data->vtable[i];
+
+	CustomData_to_bmesh_block(&data->dm->vertData, &bm->vdata, i, &v->head.data, true);
+
+	/* add bevel weight */
+	if (data->cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, data->cd_vert_bweight_offset, (float)mv->bweight / 255.0f);
+
+	if (UNLIKELY(data->has_orig_htype & BM_VERT)) {
+		int *orig_index = CustomData_bmesh_get(&bm->vdata, v->head.data, CD_ORIGINDEX);
+		*orig_index = ORIGINDEX_NONE;
+	}
+}
+
+static void dm_to_bmesh_edge_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	DMToBMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	const MEdge *me = &data->medge[i];
+	BMEdge *e = data->etable[i];
+
+	CustomData_to_bmesh_block(&data->dm->edgeData, &bm->edata, i, &e->head.data, true);
+
+	if (data->cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)me->bweight / 255.0f);
+	if (data->cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset,  (float)me->crease  / 255.0f);
+
+	if (UNLIKELY(data->has_orig_htype & BM_EDGE)) {
+		int *orig_index = CustomData_bmesh_get(&bm->edata, e->head.data, CD_ORIGINDEX);
+		*orig_index = ORIGINDEX_NONE;
+	}
+}
+
+static void dm_to_bmesh_face_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	DMToBMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	BMFace *f = data->ftable[i];
+	BMLoop *l_iter, *l_first;
+	int j;
+
+	if (f == NULL) {
+		return;
+	}
+
+	j = data->mpoly[i].loopstart;
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		CustomData_to_bmesh_block(&data->dm->loopData, &bm->ldata, j++, &l_iter->head.data, true);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	CustomData_to_bmesh_block(&data->dm->polyData, &bm->pdata, i, &f->head.data, true);
+
+	if (data->calc_face_normal) {
+		if (data->face_normals) {
+			copy_v3_v3(f->no, data->face_normals[i]);
+		}
+		else {
+			BM_face_normal_update(f);
+		}
+	}
+
+	if (UNLIKELY(data->has_orig_htype & BM_FACE)) {
+		int *orig_index = CustomData_bmesh_get(&bm->pdata, f->head.data, CD_ORIGINDEX);
+		*orig_index = ORIGINDEX_NONE;
+	}
+}
+
 /**
  * The main function for copying DerivedMesh data into BMesh.
  *
@@ -66,9 +161,9 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 	MLoop *mloop;
 	BMVert *v, **vtable;
 	BMEdge *e, **etable;
-	float (*face_normals)[3];
-	BMFace *f;
-	int i, j, totvert, totedge /* , totface */ /* UNUSED */ ;
+	BMFace *f, **ftable;
+	DMToBMeshData data;
+	int i, totvert, totedge, totpoly;
 	bool is_init = (bm->totvert == 0) && (bm->totedge == 0) && (bm->totface == 0);
 	bool is_cddm = (dm->type == DM_TYPE_CDDM);  /* duplicate the arrays for non cddm */
 	char has_orig_htype = 0;
@@ -100,10 +195,22 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 
 	totvert = dm->getNumVerts(dm);
 	totedge = dm->getNumEdges(dm);
-	/* totface = dm->getNumPolys(dm); */ /* UNUSED */
+	totpoly = dm->getNumPolys(dm);
 
 	vtable = MEM_mallocN(sizeof(*vtable) * totvert, __func__);
 	etable = MEM_mallocN(sizeof(*etable) * totedge, __func__);
+	ftable = MEM_mallocN(sizeof(*ftable) * totpoly, __func__);
+
+	data.dm = dm;
+	data.bm = bm;
+	data.vtable = vtable;
+	data.etable = etable;
+	data.ftable = ftable;
+	data.cd_vert_bweight_offset = cd_vert_bweight_offset;
+	data.cd_edge_bweight_offset = cd_edge_bweight_offset;
+	data.cd_edge_crease_offset = cd_edge_crease_offset;
+	data.calc_face_normal = calc_face_normal;
+	data.has_orig_htype = has_orig_htype;
 
 	/*do verts*/
 	mv = mvert = is_cddm ? dm->getVertArray(dm) : dm->dupVertArray(dm);
@@ -113,17 +220,13 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 		v->head.hflag = BM_vert_flag_from_mflag(mv->flag);
 		BM_elem_index_set(v, i); /* set_inline */
 
-		CustomData_to_bmesh_block(&dm->vertData, &bm->vdata, i, &v->head.data, true);
+		BM_mesh_cd_block_alloc(&bm->vdata, &v->head.data);
 		vtable[i] = v;
-
-		/* add bevel weight */
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mv->bweight / 255.0f);
-
-		if (UNLIKELY(has_orig_htype & BM_VERT)) {
-			int *orig_index = CustomData_bmesh_get(&bm->vdata, v->head.data, CD_ORIGINDEX);
-			*orig_index = ORIGINDEX_NONE;
-		}
 	}
+	data.mvert = mvert;
+	BLI_task_parallel_range_ex(
+	        0, totvert, &data, NULL, 0, dm_to_bmesh_vert_cb,
+	        totvert >= BM_OMP_LIMIT, false);
 	if (!is_cddm) MEM_freeN(mvert);
 	if (is_init) bm->elem_index_dirty &= ~BM_VERT;
 
@@ -136,17 +239,13 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 		e->head.hflag = BM_edge_flag_from_mflag(me->flag);
 		BM_elem_index_set(e, i); /* set_inline */
 
-		CustomData_to_bmesh_block(&dm->edgeData, &bm->edata, i, &e->head.data, true);
+		BM_mesh_cd_block_alloc(&bm->edata, &e->head.data);
 		etable[i] = e;
-
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)me->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)me->crease  / 255.0f);
-
-		if (UNLIKELY(has_orig_htype & BM_EDGE)) {
-			int *orig_index = CustomData_bmesh_get(&bm->edata, e->head.data, CD_ORIGINDEX);
-			*orig_index = ORIGINDEX_NONE;
-		}
 	}
+	data.medge = medge;
+	BLI_task_parallel_range_ex(
+	        0, totedge, &data, NULL, 0, dm_to_bmesh_edge_cb,
+	        totedge >= BM_OMP_LIMIT, false);
 	if (!is_cddm) MEM_freeN(medge);
 	if (is_init) bm->elem_index_dirty &= ~BM_EDGE;
 
@@ -154,13 +253,14 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 	/* note: i_alt is aligned with bmesh faces which may not always align with mpolys */
 	mp = dm->getPolyArray(dm);
 	mloop = dm->getLoopArray(dm);
-	face_normals = (dm->dirty & DM_DIRTY_NORMALS) ? NULL : CustomData_get_layer(&dm->polyData, CD_NORMAL);
-	for (i = 0; i < dm->numPolyData; i++, mp++) {
+	for (i = 0; i < totpoly; i++, mp++) {
 		BMLoop *l_iter;
 		BMLoop *l_first;
+		int j;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
+		f = ftable[i] = bm_face_create_from_mpoly(
+		        mp, mloop + mp->loopstart,
+		        bm, vtable, etable);
 
 		if (UNLIKELY(f == NULL)) {
 			continue;
@@ -174,30 +274,22 @@ void DM_to_bmesh_ex(DerivedMesh *dm, BMesh *bm, const bool calc_face_normal)
 		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
 		do {
 			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&dm->loopData, &bm->ldata, j, &l_iter->head.data, true);
 			BM_elem_index_set(l_iter, j++); /* set_inline */
+			BM_mesh_cd_block_alloc(&bm->ldata, &l_iter->head.data);
 		} while ((l_iter = l_iter->next) != l_first);
 
-		CustomData_to_bmesh_block(&dm->polyData, &bm->pdata, i, &f->head.data, true);
-
-		if (calc_face_normal) {
-			if (face_normals) {
-				copy_v3_v3(f->no, face_normals[i]);
-			}
-			else {
-				BM_face_normal_update(f);
-			}
-		}
-
-		if (UNLIKELY(has_orig_htype & BM_FACE)) {
-			int *orig_index = CustomData_bmesh_get(&bm->pdata, f->head.data, CD_ORIGINDEX);
-			*orig_index = ORIGINDEX_NONE;
-		}
+		BM_mesh_cd_block_alloc(&bm->pdata, &f->head.data);
 	}
+	data.mpoly = dm->getPolyArray(dm);
+	data.face_normals = (dm->dirty & DM_DIRTY_NORMALS) ? NULL : CustomData_get_layer(&dm->polyData, CD_NORMAL);
+	BLI_task_parallel_range_ex(
+	        0, totpoly, &data, NULL, 0, dm_to_bmesh_face_cb,
+	        totpoly >= BM_OMP_LIMIT, false);
 	if (is_init) bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP);
 
 	MEM_freeN(vtable);
 	MEM_freeN(etable);
+	MEM_freeN(ftable);
 }
 
 /* converts a cddm to a BMEditMesh.  if existing is non-NULL, the
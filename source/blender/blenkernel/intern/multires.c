@@ -43,6 +43,7 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_pbvh.h"
@@ -1003,6 +1004,100 @@ static void grid_tangent_matrix(float mat[3][3], const CCGKey *key,
 	copy_v3_v3(mat[2], CCG_grid_elem_no(key, grid, x, y));
 }
 
+typedef struct MultiresThreadedData {
+	DispOp op;
+	CCGElem **gridData, **subGridData;
+	CCGKey *key;
+	MPoly *mpoly;
+	MDisps *mdisps;
+	GridPaintMask *grid_paint_mask;
+	int *gridOffset;
+	int gridSize, dGridSize, dSkip;
+} MultiresThreadedData;
+
+static void multires_disp_run_cb(void *userdata, void *UNUSED(userdata_chunk), int pidx)
+{
+	MultiresThreadedData *tdata = userdata;
+
+	DispOp op = tdata->op;
+	CCGElem **gridData = tdata->gridData;
+	CCGElem **subGridData = tdata->subGridData;
+	CCGKey *key = tdata->key;
+	MPoly *mpoly = tdata->mpoly;
+	MDisps *mdisps = tdata->mdisps;
+	GridPaintMask *grid_paint_mask = tdata->grid_paint_mask;
+	int *gridOffset = tdata->gridOffset;
+	int gridSize = tdata->gridSize;
+	int dGridSize = tdata->dGridSize;
+	int dSkip = tdata->dSkip;
+
+	const int numVerts = mpoly[pidx].totloop;
+	int S, x, y, gIndex = gridOffset[pidx];
+
+	for (S = 0; S < numVerts; ++S, ++gIndex) {
+		GridPaintMask *gpm = grid_paint_mask ? &grid_paint_mask[gIndex] : NULL;
+		MDisps *mdisp = &mdisps[mpoly[pidx].loopstart + S];
+		CCGElem *grid = gridData[gIndex];
+		CCGElem *subgrid = subGridData[gIndex];
+		float (*dispgrid)[3] = mdisp->disps;
+
+		for (y = 0; y < gridSize; y++) {
+			for (x = 0; x < gridSize; x++) {
+				float *co = CCG_grid_elem_co(key, grid, x, y);
+				float *sco = CCG_grid_elem_co(key, subgrid, x, y);
+				float *data = dispgrid[dGridSize * y * dSkip + x * dSkip];
+				float mat[3][3], disp[3], d[3], mask;
+
+				/* construct tangent space matrix */
+				grid_tangent_matrix(mat, key, x, y, subgrid);
+
+				switch (op) {
+					case APPLY_DISPLACEMENTS:
+						/* Convert displacement to object space
+						 * and add to grid points */
+						mul_v3_m3v3(disp, mat, data);
+						add_v3_v3v3(co, sco, disp);
+						break;
+					case CALC_DISPLACEMENTS:
+						/* Calculate displacement between new and old
+						 * grid points and convert to tangent space */
+						sub_v3_v3v3(disp, co, sco);
+						invert_m3(mat);
+						mul_v3_m3v3(data, mat, disp);
+						break;
+					case ADD_DISPLACEMENTS:
+						/* Convert subdivided displacements to tangent
+						 * space and add to the original displacements */
+						invert_m3(mat);
+						mul_v3_m3v3(d, mat, co);
+						add_v3_v3(data, d);
+						break;
+				}
+
+				if (gpm) {
+					switch (op) {
+						case APPLY_DISPLACEMENTS:
+							/* Copy mask from gpm to DM */
+							*CCG_grid_elem_mask(key, grid, x, y) =
+							    paint_grid_paint_mask(gpm, key->level, x, y);
+							break;
+						case CALC_DISPLACEMENTS:
+							/* Copy mask from DM to gpm */
+							mask = *CCG_grid_elem_mask(key, grid, x, y);
+							gpm->data[y * gridSize + x] = CLAMPIS(mask, 0, 1);
+							break;
+						case ADD_DISPLACEMENTS:
+							/* Add mask displacement to gpm */
+							gpm->data[y * gridSize + x] +=
+							    *CCG_grid_elem_mask(key, grid, x, y);
+							break;
+					}
+				}
+			}
+		}
+	}
+}
+
 /* XXX WARNING: subsurf elements from dm and oldGridData *must* be of the same format (size),
  *              because this code uses CCGKey's info from dm to access oldGridData's normals
  *              (through the call to grid_tangent_matrix())! */
@@ -1015,9 +1110,9 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 	MDisps *mdisps = CustomData_get_layer(&me->ldata, CD_MDISPS);
 	GridPaintMask *grid_paint_mask = NULL;
 	int *gridOffset;
-	int i, k, /*numGrids, */ gridSize, dGridSize, dSkip;
+	int i, gridSize, dGridSize, dSkip;
 	int totloop, totpoly;
-	
+
 	/* this happens in the dm made by bmesh_mdisps_space_set */
 	if (dm2 && CustomData_has_layer(&dm2->loopData, CD_MDISPS)) {
 		mpoly = CustomData_get_layer(&dm2->polyData, CD_MPOLY);
@@ -1029,7 +1124,7 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 		totloop = me->totloop;
 		totpoly = me->totpoly;
 	}
-	
+
 	if (!mdisps) {
 		if (op == CALC_DISPLACEMENTS)
 			mdisps = CustomData_add_layer(&me->ldata, CD_MDISPS, CD_DEFAULT, NULL, me->totloop);
@@ -1051,98 +1146,54 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 	if (key.has_mask)
 		grid_paint_mask = CustomData_get_layer(&me->ldata, CD_GRID_PAINT_MASK);
 
-	k = 0; /*current loop/mdisp index within the mloop array*/
-
-#pragma omp parallel for private(i) if (totloop * gridSize * gridSize >= CCG_OMP_LIMIT)
+	/* allocation isn't thread safe, done before running over the grids */
 
-	for (i = 0; i < totpoly; ++i) {
-		const int numVerts = mpoly[i].totloop;
-		int S, x, y, gIndex = gridOffset[i];
-
-		for (S = 0; S < numVerts; ++S, ++gIndex, ++k) {
-			GridPaintMask *gpm = grid_paint_mask ? &grid_paint_mask[gIndex] : NULL;
-			MDisps *mdisp = &mdisps[mpoly[i].loopstart + S];
-			CCGElem *grid = gridData[gIndex];
-			CCGElem *subgrid = subGridData[gIndex];
-			float (*dispgrid)[3] = NULL;
+	/* when adding new faces in edit mode, need to allocate disps */
+	for (i = 0; i < totloop; ++i) {
+		if (!mdisps[i].disps) {
+			multires_reallocate_mdisps(totloop, mdisps, totlvl);
+			break;
+		}
+	}
 
-			/* when adding new faces in edit mode, need to allocate disps */
-			if (!mdisp->disps)
-#pragma omp critical
-			{
-				multires_reallocate_mdisps(totloop, mdisps, totlvl);
-			}
+	/* if needed, reallocate multires paint mask */
+	if (grid_paint_mask) {
+		for (i = 0; i < totpoly; ++i) {
+			const int numVerts = mpoly[i].totloop;
+			int S, gIndex = gridOffset[i];
 
-			dispgrid = mdisp->disps;
+			for (S = 0; S < numVerts; ++S, ++gIndex) {
+				GridPaintMask *gpm = &grid_paint_mask[gIndex];
 
-			/* if needed, reallocate multires paint mask */
-			if (gpm && gpm->level < key.level) {
-				gpm->level = key.level;
-#pragma omp critical
-				{
+				if (gpm->level < key.level) {
+					gpm->level = key.level;
 					if (gpm->data)
 						MEM_freeN(gpm->data);
 					gpm->data = MEM_callocN(sizeof(float) * key.grid_area, "gpm.data");
 				}
 			}
+		}
+	}
 
-			for (y = 0; y < gridSize; y++) {
-				for (x = 0; x < gridSize; x++) {
-					float *co = CCG_grid_elem_co(&key, grid, x, y);
-					float *sco = CCG_grid_elem_co(&key, subgrid, x, y);
-					float *data = dispgrid[dGridSize * y * dSkip + x * dSkip];
-					float mat[3][3], disp[3], d[3], mask;
-
-					/* construct tangent space matrix */
-					grid_tangent_matrix(mat, &key, x, y, subgrid);
-
-					switch (op) {
-						case APPLY_DISPLACEMENTS:
-							/* Convert displacement to object space
-							 * and add to grid points */
-							mul_v3_m3v3(disp, mat, data);
-							add_v3_v3v3(co, sco, disp);
-							break;
-						case CALC_DISPLACEMENTS:
-							/* Calculate displacement between new and old
-							 * grid points and convert to tangent space */
-							sub_v3_v3v3(disp, co, sco);
-							invert_m3(mat);
-							mul_v3_m3v3(data, mat, disp);
-							break;
-						case ADD_DISPLACEMENTS:
-							/* Convert subdivided displacements to tangent
-							 * space and add to the original displacements */
-							invert_m3(mat);
-							mul_v3_m3v3(d, mat, co);
-							add_v3_v3(data, d);
-							break;
-					}
+	{
+		MultiresThreadedData data = {
+			.op = op,
+			.gridData = gridData,
+			.subGridData = subGridData,
+			.key = &key,
+			.mpoly = mpoly,
+			.mdisps = mdisps,
+			.grid_paint_mask = grid_paint_mask,
+			.gridOffset = gridOffset,
+			.gridSize = gridSize,
+			.dGridSize = dGridSize,
+			.dSkip = dSkip,
+		};
 
-					if (gpm) {
-						switch (op) {
-							case APPLY_DISPLACEMENTS:
-								/* Copy mask from gpm to DM */
-								*CCG_grid_elem_mask(&key, grid, x, y) =
-								    paint_grid_paint_mask(gpm, key.level, x, y);
-								break;
-							case CALC_DISPLACEMENTS:
-								/* Copy mask from DM to gpm */
-								mask = *CCG_grid_elem_mask(&key, grid, x, y);
-								gpm->data[y * gridSize + x] = CLAMPIS(mask, 0, 1);
-								break;
-							case ADD_DISPLACEMENTS:
-								/* Add mask displacement to gpm */
-								gpm->data[y * gridSize + x] +=
-								    *CCG_grid_elem_mask(&key, grid, x, y);
-								break;
-						}
-					}
-				}
-			}
-		}
+		BLI_task_parallel_range_ex(0, totpoly, &data, NULL, 0, multires_disp_run_cb,
+		                           totloop * gridSize * gridSize >= CCG_OMP_LIMIT, false);
 	}
-	
+
 	if (op == APPLY_DISPLACEMENTS) {
 		ccgSubSurf_stitchFaces(ccgdm->ss, 0, NULL, 0);
 		ccgSubSurf_updateNormals(ccgdm->ss, NULL, 0);
@@ -1425,6 +1476,147 @@ void multires_stitch_grids(Object *ob)
 	}
 }
 
+/**** Subdivision cache ****
+ *
+ * The subdivided base mesh of the final derived mesh is kept between evaluations of the modifier
+ * (as the subsurf modifier's incremental mode does), syncing the base mesh then only subdivides
+ * again the faces affected by changes of the base topology or deformation.
+ * Displacements are applied to the subdivided grids in place, so a copy of the undisplaced grids
+ * is kept too, and restored before syncing.
+ */
+
+typedef struct MultiresSubdivCache {
+	CCGSubSurf *ss;
+
+	/* settings the subdivision was made with, changing these subdivides from scratch */
+	int lvl;
+	bool simple, has_mask;
+
+	/* undisplaced grids and the grids of the subdivision they are copied from,
+	 * ordered as the grids of the derived mesh */
+	CCGElem **grids, **ss_grids;
+	void *grids_data;
+	int totgrid;
+	size_t grid_bytes;
+} MultiresSubdivCache;
+
+static void multires_subdiv_cache_grids_free(MultiresSubdivCache *cache)
+{
+	if (cache->grids) {
+		MEM_freeN(cache->grids);
+		MEM_freeN(cache->ss_grids);
+		MEM_freeN(cache->grids_data);
+		cache->grids = cache->ss_grids = NULL;
+		cache->grids_data = NULL;
+	}
+	cache->totgrid = 0;
+	cache->grid_bytes = 0;
+}
+
+void multires_subdiv_cache_free(MultiresModifierData *mmd)
+{
+	MultiresSubdivCache *cache = mmd->subdiv_cache;
+
+	if (cache) {
+		if (cache->ss)
+			ccgSubSurf_free(cache->ss);
+		multires_subdiv_cache_grids_free(cache);
+		MEM_freeN(cache);
+		mmd->subdiv_cache = NULL;
+	}
+}
+
+/* Copies back the undisplaced grids to the subdivision. */
+static void multires_subdiv_cache_restore(MultiresSubdivCache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->totgrid; i++)
+		memcpy(cache->ss_grids[i], cache->grids[i], cache->grid_bytes);
+
+	/* edges, vertices and face centers of the subdivision are copied from the grids */
+	ccgSubSurf_stitchFaces(cache->ss, 0, NULL, 0);
+}
+
+/* Copies the grids of a newly synced subdivision, before displacements are applied. */
+static void multires_subdiv_cache_store(MultiresSubdivCache *cache, DerivedMesh *dm)
+{
+	CCGElem **gridData = dm->getGridData(dm);
+	const int totgrid = dm->getNumGrids(dm);
+	size_t grid_bytes;
+	CCGKey key;
+	int i;
+
+	dm->getGridKey(dm, &key);
+	grid_bytes = (size_t)key.elem_size * (size_t)key.grid_area;
+
+	if (cache->totgrid != totgrid || cache->grid_bytes != grid_bytes || cache->grids == NULL) {
+		multires_subdiv_cache_grids_free(cache);
+
+		cache->grids = MEM_mallocN(sizeof(CCGElem *) * totgrid, "MultiresSubdivCache.grids");
+		cache->ss_grids = MEM_mallocN(sizeof(CCGElem *) * totgrid, "MultiresSubdivCache.ss_grids");
+		cache->grids_data = MEM_mallocN(grid_bytes * totgrid, "MultiresSubdivCache.grids_data");
+		cache->totgrid = totgrid;
+		cache->grid_bytes = grid_bytes;
+
+		for (i = 0; i < totgrid; i++)
+			cache->grids[i] = (CCGElem *)((char *)cache->grids_data + grid_bytes * i);
+	}
+
+	for (i = 0; i < totgrid; i++) {
+		cache->ss_grids[i] = gridData[i];
+		memcpy(cache->grids[i], gridData[i], grid_bytes);
+	}
+}
+
+/* Same as #subsurf_dm_create_local, reusing the subdivision kept in the modifier. */
+static DerivedMesh *multires_subdiv_cache_dm_create(DerivedMesh *dm, MultiresModifierData *mmd,
+                                                    int lvl, bool alloc_paint_mask)
+{
+	MultiresSubdivCache *cache = mmd->subdiv_cache;
+	SubsurfModifierData smd = {{NULL}};
+	SubsurfFlags flags = SUBSURF_IS_FINAL_CALC;
+	const bool simple = mmd->simple != 0;
+	DerivedMesh *result;
+
+	if (cache == NULL) {
+		cache = mmd->subdiv_cache = MEM_callocN(sizeof(MultiresSubdivCache), "MultiresSubdivCache");
+	}
+	else if (cache->ss) {
+		if (cache->lvl != lvl || cache->simple != simple || cache->has_mask != alloc_paint_mask) {
+			ccgSubSurf_free(cache->ss);
+			cache->ss = NULL;
+		}
+		else {
+			multires_subdiv_cache_restore(cache);
+		}
+	}
+
+	smd.levels = smd.renderLevels = lvl;
+	smd.flags |= eSubsurfModifierFlag_Incremental;
+	if (!(mmd->flags & eMultiresModifierFlag_PlainUv))
+		smd.flags |= eSubsurfModifierFlag_SubsurfUv;
+	if (simple)
+		smd.subdivType = ME_SIMPLE_SUBSURF;
+	if (mmd->flags & eMultiresModifierFlag_ControlEdges)
+		smd.flags |= eSubsurfModifierFlag_ControlEdges;
+	smd.mCache = cache->ss;
+
+	if (alloc_paint_mask)
+		flags |= SUBSURF_ALLOC_PAINT_MASK;
+
+	result = subsurf_make_derived_from_derived(dm, &smd, NULL, flags);
+
+	cache->ss = smd.mCache;
+	cache->lvl = lvl;
+	cache->simple = simple;
+	cache->has_mask = alloc_paint_mask;
+
+	multires_subdiv_cache_store(cache, result);
+
+	return result;
+}
+
 DerivedMesh *multires_make_derived_from_derived(DerivedMesh *dm,
                                                 MultiresModifierData *mmd,
                                                 Object *ob,
@@ -1437,16 +1629,25 @@ DerivedMesh *multires_make_derived_from_derived(DerivedMesh *dm,
 	CCGKey key;
 	const bool render = (flags & MULTIRES_USE_RENDER_PARAMS) != 0;
 	const bool ignore_simplify = (flags & MULTIRES_IGNORE_SIMPLIFY) != 0;
+	/* only the final derived mesh keeps the subdivision, others may exist at the same time */
+	const bool use_cache = ((flags & MULTIRES_IS_FINAL_CALC) &&
+	                        !(flags & (MULTIRES_USE_LOCAL_MMD | MULTIRES_USE_RENDER_PARAMS)) &&
+	                        !(ob->mode & OB_MODE_EDIT));
 	int lvl = multires_get_level(ob, mmd, render, ignore_simplify);
 	int i, gridSize, numGrids;
 
 	if (lvl == 0)
 		return dm;
 
-	result = subsurf_dm_create_local(ob, dm, lvl,
-	                                 mmd->simple, mmd->flags & eMultiresModifierFlag_ControlEdges,
-	                                 mmd->flags & eMultiresModifierFlag_PlainUv,
-	                                 flags & MULTIRES_ALLOC_PAINT_MASK);
+	if (use_cache) {
+		result = multires_subdiv_cache_dm_create(dm, mmd, lvl, (flags & MULTIRES_ALLOC_PAINT_MASK) != 0);
+	}
+	else {
+		result = subsurf_dm_create_local(ob, dm, lvl,
+		                                 mmd->simple, mmd->flags & eMultiresModifierFlag_ControlEdges,
+		                                 mmd->flags & eMultiresModifierFlag_PlainUv,
+		                                 flags & MULTIRES_ALLOC_PAINT_MASK);
+	}
 
 	if (!(flags & MULTIRES_USE_LOCAL_MMD)) {
 		ccgdm = (CCGDerivedMesh *)result;
@@ -1464,11 +1665,17 @@ DerivedMesh *multires_make_derived_from_derived(DerivedMesh *dm,
 	gridData = result->getGridData(result);
 	result->getGridKey(result, &key);
 
-	subGridData = MEM_mallocN(sizeof(CCGElem *) * numGrids, "subGridData*");
+	if (use_cache) {
+		/* undisplaced grids are kept in the cache */
+		subGridData = ((MultiresSubdivCache *)mmd->subdiv_cache)->grids;
+	}
+	else {
+		subGridData = MEM_mallocN(sizeof(CCGElem *) * numGrids, "subGridData*");
 
-	for (i = 0; i < numGrids; i++) {
-		subGridData[i] = MEM_mallocN(key.elem_size * gridSize * gridSize, "subGridData");
-		memcpy(subGridData[i], gridData[i], key.elem_size * gridSize * gridSize);
+		for (i = 0; i < numGrids; i++) {
+			subGridData[i] = MEM_mallocN(key.elem_size * gridSize * gridSize, "subGridData");
+			memcpy(subGridData[i], gridData[i], key.elem_size * gridSize * gridSize);
+		}
 	}
 
 	multires_set_tot_mdisps(me, mmd->totlvl);
@@ -1481,9 +1688,11 @@ DerivedMesh *multires_make_derived_from_derived(DerivedMesh *dm,
 	if (ccgdm)
 		multires_output_hidden_to_ccgdm(ccgdm, me, lvl);
 
-	for (i = 0; i < numGrids; i++)
-		MEM_freeN(subGridData[i]);
-	MEM_freeN(subGridData);
+	if (!use_cache) {
+		for (i = 0; i < numGrids; i++)
+			MEM_freeN(subGridData[i]);
+		MEM_freeN(subGridData);
+	}
 
 	return result;
 }
@@ -98,6 +98,7 @@
 #include "BKE_editmesh.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_multires.h"
 #include "BKE_node.h"
 #include "BKE_object.h"
@@ -214,6 +215,8 @@ void BKE_object_free_modifiers(Object *ob)
 
 	/* modifiers may have stored data in the DM cache */
 	BKE_object_free_derived_caches(ob);
+
+	BKE_modifier_cache_free(ob);
 }
 
 void BKE_object_modifier_hook_reset(Object *ob, HookModifierData *hmd)
@@ -360,6 +363,9 @@ void BKE_object_free_caches(Object *object)
 		}
 	}
 
+	/* Free intermediate modifier stack results, they are rebuilt on demand. */
+	BKE_modifier_cache_free(object);
+
 	/* Free memory used by cached derived meshes in the particle system modifiers. */
 	for (md = object->modifiers.first; md != NULL; md = md->next) {
 		if (md->type == eModifierType_ParticleSystem) {
@@ -1573,6 +1579,7 @@ Object *BKE_object_copy_ex(Main *bmain, Object *ob, bool copy_caches)
 
 	/* Copy runtime surve data. */
 	obn->curve_cache = NULL;
+	obn->modifier_cache = NULL;
 
 	if (ob->id.lib) {
 		BKE_id_lib_local_paths(bmain, ob->id.lib, &obn->id);
@@ -30,6 +30,7 @@
 #include "BLI_heap.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 
 #include "BKE_ccg.h"
 #include "BKE_DerivedMesh.h"
@@ -65,6 +66,13 @@
 
 // #define USE_VERIFY
 
+/* Minimum number of nodes to gather edge queues and update normals in parallel. */
+#ifdef DEBUG
+#  define PBVH_BMESH_THREAD_LIMIT 0
+#else
+#  define PBVH_BMESH_THREAD_LIMIT 8
+#endif
+
 #ifdef USE_VERIFY
 static void pbvh_bmesh_verify(PBVH *bvh);
 #endif
@@ -590,6 +598,19 @@ typedef struct {
 	int cd_face_node_offset;
 } EdgeQueueContext;
 
+/* Edge which may be added to the queue, found by the (threaded) scan of a node */
+typedef struct EdgeQueueCandidate {
+	BMLoop *l;  /* loop of the edge, in the face which is inside the sphere */
+	float len_sq;
+} EdgeQueueCandidate;
+
+typedef struct EdgeQueueThreadData {
+	const EdgeQueue *q;
+	PBVHNode *node;
+	EdgeQueueCandidate *candidates;
+	int totcandidate;
+} EdgeQueueThreadData;
+
 /* only tag'd edges are in the queue */
 #ifdef USE_EDGEQUEUE_TAG
 #  define EDGE_QUEUE_TEST(e)   (BM_elem_flag_test((CHECK_TYPE_INLINE(e, BMEdge *),    e), BM_ELEM_TAG))
@@ -749,34 +770,25 @@ static void long_edge_queue_edge_add_recursive(
 }
 #endif  /* USE_EDGEQUEUE_EVEN_SUBDIV */
 
-static void short_edge_queue_edge_add(
-        EdgeQueueContext *eq_ctx,
-        BMEdge *e)
+/* Face checks shared by the long and short edge queues */
+static bool edge_queue_face_test(const EdgeQueue *q, BMFace *f)
 {
-#ifdef USE_EDGEQUEUE_TAG
-	if (EDGE_QUEUE_TEST(e) == false)
-#endif
-	{
-		const float len_sq = BM_edge_calc_length_squared(e);
-		if (len_sq < eq_ctx->q->limit_len_squared) {
-			edge_queue_insert(eq_ctx, e, len_sq);
+#ifdef USE_EDGEQUEUE_FRONTFACE
+	if (q->use_view_normal) {
+		if (dot_v3v3(f->no, q->view_normal) < 0.0f) {
+			return false;
 		}
 	}
+#endif
+
+	return edge_queue_tri_in_sphere(q, f);
 }
 
 static void long_edge_queue_face_add(
         EdgeQueueContext *eq_ctx,
         BMFace *f)
 {
-#ifdef USE_EDGEQUEUE_FRONTFACE
-	if (eq_ctx->q->use_view_normal) {
-		if (dot_v3v3(f->no, eq_ctx->q->view_normal) < 0.0f) {
-			return;
-		}
-	}
-#endif
-
-	if (edge_queue_tri_in_sphere(eq_ctx->q, f)) {
+	if (edge_queue_face_test(eq_ctx->q, f)) {
 		/* Check each edge of the face */
 		BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
 		BMLoop *l_iter = l_first;
@@ -795,28 +807,105 @@ static void long_edge_queue_face_add(
 	}
 }
 
-static void short_edge_queue_face_add(
-        EdgeQueueContext *eq_ctx,
-        BMFace *f)
+/**
+ * Collects the edges of a node's faces which are longer (or shorter) than the queue limit.
+ *
+ * Only reads the mesh, so nodes can be scanned in parallel,
+ * the candidates are added to the queue afterwards (in node order, so the result doesn't depend on threading).
+ */
+static void edge_queue_node_scan(EdgeQueueThreadData *tdata, const bool use_long)
 {
-#ifdef USE_EDGEQUEUE_FRONTFACE
-	if (eq_ctx->q->use_view_normal) {
-		if (dot_v3v3(f->no, eq_ctx->q->view_normal) < 0.0f) {
-			return;
+	const EdgeQueue *q = tdata->q;
+	const int totface = BLI_gset_size(tdata->node->bm_faces);
+	GSetIterator gs_iter;
+
+	tdata->totcandidate = 0;
+	if (totface == 0) {
+		tdata->candidates = NULL;
+		return;
+	}
+
+	/* faces are all triangles */
+	tdata->candidates = MEM_mallocN(sizeof(*tdata->candidates) * (size_t)(totface * 3), __func__);
+
+	GSET_ITER (gs_iter, tdata->node->bm_faces) {
+		BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+		if (edge_queue_face_test(q, f)) {
+			/* Check each edge of the face */
+			BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
+			BMLoop *l_iter = l_first;
+
+			BLI_assert(f->len == 3);
+			do {
+				const float len_sq = BM_edge_calc_length_squared(l_iter->e);
+				if (use_long ?
+				    (len_sq > q->limit_len_squared) :
+				    (len_sq < q->limit_len_squared))
+				{
+					EdgeQueueCandidate *c = &tdata->candidates[tdata->totcandidate++];
+					c->l = l_iter;
+					c->len_sq = len_sq;
+				}
+			} while ((l_iter = l_iter->next) != l_first);
 		}
 	}
-#endif
+}
+
+static void long_edge_queue_task_cb(void *userdata, void *UNUSED(userdata_chunk), int n)
+{
+	EdgeQueueThreadData *tdata = &((EdgeQueueThreadData *)userdata)[n];
+	edge_queue_node_scan(tdata, true);
+}
 
-	if (edge_queue_tri_in_sphere(eq_ctx->q, f)) {
-		BMLoop *l_iter;
-		BMLoop *l_first;
+static void short_edge_queue_task_cb(void *userdata, void *UNUSED(userdata_chunk), int n)
+{
+	EdgeQueueThreadData *tdata = &((EdgeQueueThreadData *)userdata)[n];
+	edge_queue_node_scan(tdata, false);
+}
 
-		/* Check each edge of the face */
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			short_edge_queue_edge_add(eq_ctx, l_iter->e);
-		} while ((l_iter = l_iter->next) != l_first);
+/**
+ * Scans all leaf nodes marked for topology update, in parallel.
+ * \return the number of scanned nodes, free with #edge_queue_thread_data_free.
+ */
+static int edge_queue_nodes_scan(
+        const EdgeQueue *q, PBVH *bvh,
+        TaskParallelRangeFunc func,
+        EdgeQueueThreadData **r_tdata)
+{
+	EdgeQueueThreadData *tdata = MEM_mallocN(sizeof(*tdata) * (size_t)bvh->totnode, __func__);
+	int tdata_len = 0;
+
+	for (int n = 0; n < bvh->totnode; n++) {
+		PBVHNode *node = &bvh->nodes[n];
+
+		/* Check leaf nodes marked for topology update */
+		if ((node->flag & PBVH_Leaf) &&
+		    (node->flag & PBVH_UpdateTopology) &&
+		    !(node->flag & PBVH_FullyHidden))
+		{
+			tdata[tdata_len].q = q;
+			tdata[tdata_len].node = node;
+			tdata_len++;
+		}
 	}
+
+	BLI_task_parallel_range_ex(
+	        0, tdata_len, tdata, NULL, 0, func,
+	        tdata_len > PBVH_BMESH_THREAD_LIMIT, true);
+
+	*r_tdata = tdata;
+	return tdata_len;
+}
+
+static void edge_queue_thread_data_free(EdgeQueueThreadData *tdata, const int tdata_len)
+{
+	for (int n = 0; n < tdata_len; n++) {
+		if (tdata[n].candidates) {
+			MEM_freeN(tdata[n].candidates);
+		}
+	}
+	MEM_freeN(tdata);
 }
 
 /* Create a priority queue containing vertex pairs connected by a long
@@ -852,24 +941,28 @@ static void long_edge_queue_create(
 	pbvh_bmesh_edge_tag_verify(bvh);
 #endif
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
+	EdgeQueueThreadData *tdata;
+	const int tdata_len = edge_queue_nodes_scan(eq_ctx->q, bvh, long_edge_queue_task_cb, &tdata);
 
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				long_edge_queue_face_add(eq_ctx, f);
+	for (int n = 0; n < tdata_len; n++) {
+		for (int i = 0; i < tdata[n].totcandidate; i++) {
+			const EdgeQueueCandidate *c = &tdata[n].candidates[i];
+#ifdef USE_EDGEQUEUE_EVEN_SUBDIV
+			long_edge_queue_edge_add_recursive(
+			        eq_ctx, c->l->radial_next, c->l,
+			        c->len_sq, eq_ctx->q->limit_len);
+#else
+#  ifdef USE_EDGEQUEUE_TAG
+			if (EDGE_QUEUE_TEST(c->l->e) == false)
+#  endif
+			{
+				edge_queue_insert(eq_ctx, c->l->e, -c->len_sq);
 			}
+#endif
 		}
 	}
+
+	edge_queue_thread_data_free(tdata, tdata_len);
 }
 
 /* Create a priority queue containing vertex pairs connected by a
@@ -901,24 +994,22 @@ static void short_edge_queue_create(
 	UNUSED_VARS(view_normal);
 #endif
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
+	EdgeQueueThreadData *tdata;
+	const int tdata_len = edge_queue_nodes_scan(eq_ctx->q, bvh, short_edge_queue_task_cb, &tdata);
 
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				short_edge_queue_face_add(eq_ctx, f);
+	for (int n = 0; n < tdata_len; n++) {
+		for (int i = 0; i < tdata[n].totcandidate; i++) {
+			const EdgeQueueCandidate *c = &tdata[n].candidates[i];
+#ifdef USE_EDGEQUEUE_TAG
+			if (EDGE_QUEUE_TEST(c->l->e) == false)
+#endif
+			{
+				edge_queue_insert(eq_ctx, c->l->e, c->len_sq);
 			}
 		}
 	}
+
+	edge_queue_thread_data_free(tdata, tdata_len);
 }
 
 /*************************** Topology update **************************/
@@ -1383,20 +1474,51 @@ bool BKE_pbvh_bmesh_node_raycast_detail(
 }
 
 
+static void pbvh_bmesh_normals_update_faces_cb(void *userdata, void *UNUSED(userdata_chunk), int n)
+{
+	PBVHNode *node = ((PBVHNode **)userdata)[n];
+
+	if (node->flag & PBVH_UpdateNormals) {
+		GSetIterator gs_iter;
+
+		GSET_ITER (gs_iter, node->bm_faces) {
+			BM_face_normal_update(BLI_gsetIterator_getKey(&gs_iter));
+		}
+	}
+}
+
+static void pbvh_bmesh_normals_update_verts_cb(void *userdata, void *UNUSED(userdata_chunk), int n)
+{
+	PBVHNode *node = ((PBVHNode **)userdata)[n];
+
+	if (node->flag & PBVH_UpdateNormals) {
+		GSetIterator gs_iter;
+
+		/* unique verts are only owned by this node, no other thread writes them */
+		GSET_ITER (gs_iter, node->bm_unique_verts) {
+			BM_vert_normal_update(BLI_gsetIterator_getKey(&gs_iter));
+		}
+	}
+}
+
 void pbvh_bmesh_normals_update(PBVHNode **nodes, int totnode)
 {
+	const bool use_threading = totnode > PBVH_BMESH_THREAD_LIMIT;
+
+	/* vertex normals use the normals of faces from neighbor nodes, update all faces first */
+	BLI_task_parallel_range_ex(
+	        0, totnode, nodes, NULL, 0, pbvh_bmesh_normals_update_faces_cb,
+	        use_threading, true);
+	BLI_task_parallel_range_ex(
+	        0, totnode, nodes, NULL, 0, pbvh_bmesh_normals_update_verts_cb,
+	        use_threading, true);
+
 	for (int n = 0; n < totnode; n++) {
 		PBVHNode *node = nodes[n];
 
 		if (node->flag & PBVH_UpdateNormals) {
 			GSetIterator gs_iter;
 
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BM_face_normal_update(BLI_gsetIterator_getKey(&gs_iter));
-			}
-			GSET_ITER (gs_iter, node->bm_unique_verts) {
-				BM_vert_normal_update(BLI_gsetIterator_getKey(&gs_iter));
-			}
 			/* This should be unneeded normally */
 			GSET_ITER (gs_iter, node->bm_other_verts) {
 				BM_vert_normal_update(BLI_gsetIterator_getKey(&gs_iter));
@@ -43,6 +43,8 @@
 #include "DNA_mesh_types.h"
 
 #include "BLI_math.h"
+#include "BLI_sort_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_shrinkwrap.h"
@@ -56,31 +58,246 @@
 
 #include "BLI_strict_flags.h"
 
-/* for timing... */
-#if 0
-#  include "PIL_time.h"
-#else
-#  define TIMEIT_BENCH(expr, id) (expr)
-#endif
+#include "MEM_guardedalloc.h"
 
 /* Util macros */
 #define OUT_OF_MEMORY() ((void)printf("Shrinkwrap: Out of memory\n"))
 
+/* Target tree kept by the modifier between evaluations, refitted while the target topology is unchanged */
+typedef struct ShrinkwrapTreeCache {
+	BVHTree *tree;
+	int tree_type;
+	int totvert;
+	int looptri_num;
+	/* vertex indices of every looptri the tree was built for */
+	unsigned int (*looptri_verts)[3];
+} ShrinkwrapTreeCache;
+
+/* Data shared by all vertices of a query pass */
+typedef struct ShrinkwrapCalcCBData {
+	ShrinkwrapCalcData *calc;
+
+	BVHTreeFromMesh *treeData;
+	BVHTreeFromMesh *auxData;
+	SpaceTransform *local2aux;
+
+	float *proj_axis;
+	float proj_limit_squared;
+} ShrinkwrapCalcCBData;
+
+void BKE_shrinkwrap_tree_cache_free(ShrinkwrapTreeCache *cache)
+{
+	if (cache->tree) {
+		BLI_bvhtree_free(cache->tree);
+	}
+	MEM_SAFE_FREE(cache->looptri_verts);
+	MEM_freeN(cache);
+}
+
+/**
+ * Compare the triangulation of \a dm to the one the cached tree was built for, storing it when different.
+ * An exact comparison, since refitting a tree to a different triangulation gives wrong results.
+ */
+static bool shrinkwrap_tree_cache_topology_update(ShrinkwrapTreeCache *cache, DerivedMesh *dm)
+{
+	const MLoopTri *looptri = dm->getLoopTriArray(dm);
+	const MLoop *mloop = dm->getLoopArray(dm);
+	const int totvert = dm->getNumVerts(dm);
+	const int looptri_num = dm->getNumLoopTri(dm);
+	bool match = (cache->looptri_verts && cache->totvert == totvert && cache->looptri_num == looptri_num);
+	int i;
+
+	if (!match) {
+		MEM_SAFE_FREE(cache->looptri_verts);
+		cache->looptri_verts = MEM_mallocN(sizeof(*cache->looptri_verts) * (size_t)looptri_num, __func__);
+		cache->totvert = totvert;
+		cache->looptri_num = looptri_num;
+	}
+
+	for (i = 0; i < looptri_num; i++) {
+		unsigned int *verts = cache->looptri_verts[i];
+		const unsigned int v[3] = {
+		    mloop[looptri[i].tri[0]].v,
+		    mloop[looptri[i].tri[1]].v,
+		    mloop[looptri[i].tri[2]].v,
+		};
+
+		if (match && (verts[0] != v[0] || verts[1] != v[1] || verts[2] != v[2])) {
+			match = false;
+		}
+		verts[0] = v[0];
+		verts[1] = v[1];
+		verts[2] = v[2];
+	}
+
+	return match;
+}
+
+/**
+ * Get the looptri tree of the target. Outside of rendering the tree is kept in the modifier
+ * and refitted to the new target positions as long as its triangulation doesn't change,
+ * instead of building a new tree every time an animated target is evaluated.
+ */
+static BVHTree *shrinkwrap_target_looptri_tree(
+        ShrinkwrapCalcData *calc, BVHTreeFromMesh *treeData, int tree_type, bool for_render)
+{
+	ShrinkwrapTreeCache *cache = calc->smd->cache;
+	DerivedMesh *target = calc->target;
+	bool topology_match;
+
+	if (for_render || treeData->em_evil) {
+		return bvhtree_from_mesh_looptri(treeData, target, 0.0, tree_type, 6);
+	}
+
+	if (cache == NULL) {
+		cache = calc->smd->cache = MEM_callocN(sizeof(*cache), __func__);
+	}
+
+	topology_match = shrinkwrap_tree_cache_topology_update(cache, target);
+
+	if (cache->tree && (cache->tree_type != tree_type || !topology_match)) {
+		BLI_bvhtree_free(cache->tree);
+		cache->tree = NULL;
+	}
+
+	cache->tree = bvhtree_from_mesh_looptri_refit(treeData, target, cache->tree, 0.0, tree_type, 6);
+	cache->tree_type = tree_type;
+
+	return cache->tree;
+}
+
+/* Spread the bits of a 10 bit integer to every third bit */
+BLI_INLINE unsigned int shrinkwrap_morton_expand(unsigned int v)
+{
+	v &= 0x3ffu;
+	v = (v | (v << 16)) & 0x030000ffu;
+	v = (v | (v << 8))  & 0x0300f00fu;
+	v = (v | (v << 4))  & 0x030c30c3u;
+	v = (v | (v << 2))  & 0x09249249u;
+	return v;
+}
+
+/**
+ * Order the vertices along a Morton curve, so neighboring queries (and the chunks handed to each thread)
+ * are close in space. This keeps the traversed tree nodes in cache and makes the previous hit
+ * a good initial distance for nearest searches.
+ */
+static int *shrinkwrap_calc_query_order(ShrinkwrapCalcData *calc)
+{
+	struct SortIntByInt *sort;
+	float min[3], max[3], scale[3];
+	int *order;
+	int i, j;
+
+	INIT_MINMAX(min, max);
+	for (i = 0; i < calc->numVerts; i++) {
+		minmax_v3v3_v3(min, max, calc->vertexCos[i]);
+	}
+
+	for (j = 0; j < 3; j++) {
+		const float extent = max[j] - min[j];
+		scale[j] = (extent > FLT_EPSILON) ? 1023.0f / extent : 0.0f;
+	}
+
+	sort = MEM_mallocN(sizeof(*sort) * (size_t)calc->numVerts, __func__);
+	for (i = 0; i < calc->numVerts; i++) {
+		const float *co = calc->vertexCos[i];
+		unsigned int code = 0;
+
+		for (j = 0; j < 3; j++) {
+			const unsigned int q = (unsigned int)((co[j] - min[j]) * scale[j]);
+			code |= shrinkwrap_morton_expand(q) << j;
+		}
+
+		sort[i].sort_value = (int)code;
+		sort[i].data = i;
+	}
+
+	qsort(sort, (size_t)calc->numVerts, sizeof(*sort), BLI_sortutil_cmp_int);
+
+	order = MEM_mallocN(sizeof(*order) * (size_t)calc->numVerts, __func__);
+	for (i = 0; i < calc->numVerts; i++) {
+		order[i] = sort[i].data;
+	}
+
+	MEM_freeN(sort);
+
+	return order;
+}
+
+BLI_INLINE int shrinkwrap_vert_index(const ShrinkwrapCalcData *calc, int iter)
+{
+	return calc->order ? calc->order[iter] : iter;
+}
+
 /*
  * Shrinkwrap to the nearest vertex
  *
  * it builds a kdtree of vertexs we can attach to and then
  * for each vertex performs a nearest vertex search on the tree
  */
-static void shrinkwrap_calc_nearest_vertex(ShrinkwrapCalcData *calc)
+static void shrinkwrap_calc_nearest_vertex_cb(void *userdata, void *userdata_chunk, int iter)
 {
-	int i;
+	ShrinkwrapCalcCBData *data = userdata;
+	ShrinkwrapCalcData *calc = data->calc;
+	BVHTreeFromMesh *treeData = data->treeData;
+	BVHTreeNearest *nearest = userdata_chunk;
+
+	const int i = shrinkwrap_vert_index(calc, iter);
+	float *co = calc->vertexCos[i];
+	float tmp_co[3];
+	float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
+
+	if (weight == 0.0f) {
+		return;
+	}
+
+	/* Convert the vertex to tree coordinates */
+	if (calc->vert) {
+		copy_v3_v3(tmp_co, calc->vert[i].co);
+	}
+	else {
+		copy_v3_v3(tmp_co, co);
+	}
+	BLI_space_transform_apply(&calc->local2target, tmp_co);
+
+	/* Use local proximity heuristics (to reduce the nearest search)
+	 *
+	 * If we already had an hit before.. we assume this vertex is going to have a close hit to that other vertex
+	 * so we can initiate the "nearest.dist" with the expected value to that last hit.
+	 * This will lead in pruning of the search tree. */
+	if (nearest->index != -1)
+		nearest->dist_sq = len_squared_v3v3(tmp_co, nearest->co);
+	else
+		nearest->dist_sq = FLT_MAX;
+
+	BLI_bvhtree_find_nearest(treeData->tree, tmp_co, nearest, treeData->nearest_callback, treeData);
+
+
+	/* Found the nearest vertex */
+	if (nearest->index != -1) {
+		/* Adjusting the vertex weight,
+		 * so that after interpolating it keeps a certain distance from the nearest position */
+		if (nearest->dist_sq > FLT_EPSILON) {
+			const float dist = sqrtf(nearest->dist_sq);
+			weight *= (dist - calc->keepDist) / dist;
+		}
 
+		/* Convert the coordinates back to mesh coordinates */
+		copy_v3_v3(tmp_co, nearest->co);
+		BLI_space_transform_invert(&calc->local2target, tmp_co);
+
+		interp_v3_v3v3(co, co, tmp_co, weight);  /* linear interpolation */
+	}
+}
+
+static void shrinkwrap_calc_nearest_vertex(ShrinkwrapCalcData *calc)
+{
 	BVHTreeFromMesh treeData = NULL_BVHTreeFromMesh;
 	BVHTreeNearest nearest  = NULL_BVHTreeNearest;
+	ShrinkwrapCalcCBData data = {NULL};
 
-
-	TIMEIT_BENCH(bvhtree_from_mesh_verts(&treeData, calc->target, 0.0, 2, 6), bvhtree_verts);
+	bvhtree_from_mesh_verts(&treeData, calc->target, 0.0, 2, 6);
 	if (treeData.tree == NULL) {
 		OUT_OF_MEMORY();
 		return;
@@ -89,56 +306,12 @@ static void shrinkwrap_calc_nearest_vertex(ShrinkwrapCalcData *calc)
 	/* Setup nearest */
 	nearest.index = -1;
 	nearest.dist_sq = FLT_MAX;
-#ifndef __APPLE__
-#pragma omp parallel for default(none) private(i) firstprivate(nearest) shared(treeData, calc) schedule(static) if (calc->numVerts > BKE_MESH_OMP_LIMIT)
-#endif
-	for (i = 0; i < calc->numVerts; ++i) {
-		float *co = calc->vertexCos[i];
-		float tmp_co[3];
-		float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
-		if (weight == 0.0f) {
-			continue;
-		}
-
-
-		/* Convert the vertex to tree coordinates */
-		if (calc->vert) {
-			copy_v3_v3(tmp_co, calc->vert[i].co);
-		}
-		else {
-			copy_v3_v3(tmp_co, co);
-		}
-		BLI_space_transform_apply(&calc->local2target, tmp_co);
 
-		/* Use local proximity heuristics (to reduce the nearest search)
-		 *
-		 * If we already had an hit before.. we assume this vertex is going to have a close hit to that other vertex
-		 * so we can initiate the "nearest.dist" with the expected value to that last hit.
-		 * This will lead in pruning of the search tree. */
-		if (nearest.index != -1)
-			nearest.dist_sq = len_squared_v3v3(tmp_co, nearest.co);
-		else
-			nearest.dist_sq = FLT_MAX;
+	data.calc = calc;
+	data.treeData = &treeData;
 
-		BLI_bvhtree_find_nearest(treeData.tree, tmp_co, &nearest, treeData.nearest_callback, &treeData);
-
-
-		/* Found the nearest vertex */
-		if (nearest.index != -1) {
-			/* Adjusting the vertex weight,
-			 * so that after interpolating it keeps a certain distance from the nearest position */
-			if (nearest.dist_sq > FLT_EPSILON) {
-				const float dist = sqrtf(nearest.dist_sq);
-				weight *= (dist - calc->keepDist) / dist;
-			}
-
-			/* Convert the coordinates back to mesh coordinates */
-			copy_v3_v3(tmp_co, nearest.co);
-			BLI_space_transform_invert(&calc->local2target, tmp_co);
-
-			interp_v3_v3v3(co, co, tmp_co, weight);  /* linear interpolation */
-		}
-	}
+	BLI_task_parallel_range_ex(0, calc->numVerts, &data, &nearest, sizeof(nearest),
+	                           shrinkwrap_calc_nearest_vertex_cb, calc->numVerts > BKE_MESH_OMP_LIMIT, false);
 
 	free_bvhtree_from_mesh(&treeData);
 }
@@ -226,20 +399,99 @@ bool BKE_shrinkwrap_project_normal(
 }
 
 
-static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc, bool for_render)
+static void shrinkwrap_calc_normal_projection_cb(void *userdata, void *UNUSED(userdata_chunk), int iter)
 {
-	int i;
-
-	/* Options about projection direction */
-	const float proj_limit_squared = calc->smd->projLimit * calc->smd->projLimit;
-	float proj_axis[3]      = {0.0f, 0.0f, 0.0f};
+	ShrinkwrapCalcCBData *data = userdata;
+	ShrinkwrapCalcData *calc = data->calc;
+	BVHTreeFromMesh *treeData = data->treeData;
+	BVHTreeFromMesh *auxData = data->auxData;
 
-	/* Raycast and tree stuff */
+	const int i = shrinkwrap_vert_index(calc, iter);
+	float *co = calc->vertexCos[i];
+	float tmp_co[3], tmp_no[3];
+	const float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
 
 	/** \note 'hit.dist' is kept in the targets space, this is only used
 	 * for finding the best hit, to get the real dist,
 	 * measure the len_v3v3() from the input coord to hit.co */
 	BVHTreeRayHit hit;
+
+	if (weight == 0.0f) {
+		return;
+	}
+
+	if (calc->vert) {
+		/* calc->vert contains verts from derivedMesh  */
+		/* this coordinated are deformed by vertexCos only for normal projection (to get correct normals) */
+		/* for other cases calc->varts contains undeformed coordinates and vertexCos should be used */
+		if (calc->smd->projAxis == MOD_SHRINKWRAP_PROJECT_OVER_NORMAL) {
+			copy_v3_v3(tmp_co, calc->vert[i].co);
+			normal_short_to_float_v3(tmp_no, calc->vert[i].no);
+		}
+		else {
+			copy_v3_v3(tmp_co, co);
+			copy_v3_v3(tmp_no, data->proj_axis);
+		}
+	}
+	else {
+		copy_v3_v3(tmp_co, co);
+		copy_v3_v3(tmp_no, data->proj_axis);
+	}
+
+
+	hit.index = -1;
+	hit.dist = 10000.0f; /* TODO: we should use FLT_MAX here, but sweepsphere code isn't prepared for that */
+
+	/* Project over positive direction of axis */
+	if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_PROJECT_ALLOW_POS_DIR) {
+
+		if (auxData->tree) {
+			BKE_shrinkwrap_project_normal(0, tmp_co, tmp_no,
+			                              data->local2aux, auxData->tree, &hit,
+			                              auxData->raycast_callback, auxData);
+		}
+
+		BKE_shrinkwrap_project_normal(calc->smd->shrinkOpts, tmp_co, tmp_no,
+		                              &calc->local2target, treeData->tree, &hit,
+		                              treeData->raycast_callback, treeData);
+	}
+
+	/* Project over negative direction of axis */
+	if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_PROJECT_ALLOW_NEG_DIR) {
+		float inv_no[3];
+		negate_v3_v3(inv_no, tmp_no);
+
+		if (auxData->tree) {
+			BKE_shrinkwrap_project_normal(0, tmp_co, inv_no,
+			                              data->local2aux, auxData->tree, &hit,
+			                              auxData->raycast_callback, auxData);
+		}
+
+		BKE_shrinkwrap_project_normal(calc->smd->shrinkOpts, tmp_co, inv_no,
+		                              &calc->local2target, treeData->tree, &hit,
+		                              treeData->raycast_callback, treeData);
+	}
+
+	/* don't set the initial dist (which is more efficient),
+	 * because its calculated in the targets space, we want the dist in our own space */
+	if (data->proj_limit_squared != 0.0f) {
+		if (len_squared_v3v3(hit.co, co) > data->proj_limit_squared) {
+			hit.index = -1;
+		}
+	}
+
+	if (hit.index != -1) {
+		madd_v3_v3v3fl(hit.co, hit.co, tmp_no, calc->keepDist);
+		interp_v3_v3v3(co, co, hit.co, weight);
+	}
+}
+
+static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc, bool for_render)
+{
+	/* Options about projection direction */
+	float proj_axis[3]      = {0.0f, 0.0f, 0.0f};
+
+	/* Raycast and tree stuff */
 	BVHTreeFromMesh treeData = NULL_BVHTreeFromMesh;
 
 	/* auxiliary target */
@@ -247,6 +499,8 @@ static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc, bool for
 	BVHTreeFromMesh auxData = NULL_BVHTreeFromMesh;
 	SpaceTransform local2aux;
 
+	ShrinkwrapCalcCBData data = {NULL};
+
 	/* If the user doesn't allows to project in any direction of projection axis
 	 * then theres nothing todo. */
 	if ((calc->smd->shrinkOpts & (MOD_SHRINKWRAP_PROJECT_ALLOW_POS_DIR | MOD_SHRINKWRAP_PROJECT_ALLOW_NEG_DIR)) == 0)
@@ -289,88 +543,21 @@ static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc, bool for
 		auxData.em_evil_all = true;
 	}
 
+	shrinkwrap_target_looptri_tree(calc, &treeData, 4, for_render);
+
 	/* After sucessufuly build the trees, start projection vertexs */
-	if (bvhtree_from_mesh_looptri(&treeData, calc->target, 0.0, 4, 6) &&
+	if (treeData.tree &&
 	    (auxMesh == NULL || bvhtree_from_mesh_looptri(&auxData, auxMesh, 0.0, 4, 6)))
 	{
-
-#ifndef __APPLE__
-#pragma omp parallel for private(i, hit) schedule(static) if (calc->numVerts > BKE_MESH_OMP_LIMIT)
-#endif
-		for (i = 0; i < calc->numVerts; ++i) {
-			float *co = calc->vertexCos[i];
-			float tmp_co[3], tmp_no[3];
-			const float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
-
-			if (weight == 0.0f) {
-				continue;
-			}
-
-			if (calc->vert) {
-				/* calc->vert contains verts from derivedMesh  */
-				/* this coordinated are deformed by vertexCos only for normal projection (to get correct normals) */
-				/* for other cases calc->varts contains undeformed coordinates and vertexCos should be used */
-				if (calc->smd->projAxis == MOD_SHRINKWRAP_PROJECT_OVER_NORMAL) {
-					copy_v3_v3(tmp_co, calc->vert[i].co);
-					normal_short_to_float_v3(tmp_no, calc->vert[i].no);
-				}
-				else {
-					copy_v3_v3(tmp_co, co);
-					copy_v3_v3(tmp_no, proj_axis);
-				}
-			}
-			else {
-				copy_v3_v3(tmp_co, co);
-				copy_v3_v3(tmp_no, proj_axis);
-			}
-
-
-			hit.index = -1;
-			hit.dist = 10000.0f; /* TODO: we should use FLT_MAX here, but sweepsphere code isn't prepared for that */
-
-			/* Project over positive direction of axis */
-			if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_PROJECT_ALLOW_POS_DIR) {
-
-				if (auxData.tree) {
-					BKE_shrinkwrap_project_normal(0, tmp_co, tmp_no,
-					                              &local2aux, auxData.tree, &hit,
-					                              auxData.raycast_callback, &auxData);
-				}
-
-				BKE_shrinkwrap_project_normal(calc->smd->shrinkOpts, tmp_co, tmp_no,
-				                              &calc->local2target, treeData.tree, &hit,
-				                              treeData.raycast_callback, &treeData);
-			}
-
-			/* Project over negative direction of axis */
-			if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_PROJECT_ALLOW_NEG_DIR) {
-				float inv_no[3];
-				negate_v3_v3(inv_no, tmp_no);
-
-				if (auxData.tree) {
-					BKE_shrinkwrap_project_normal(0, tmp_co, inv_no,
-					                              &local2aux, auxData.tree, &hit,
-					                              auxData.raycast_callback, &auxData);
-				}
-
-				BKE_shrinkwrap_project_normal(calc->smd->shrinkOpts, tmp_co, inv_no,
-				                              &calc->local2target, treeData.tree, &hit,
-				                              treeData.raycast_callback, &treeData);
-			}
-
-			/* don't set the initial dist (which is more efficient),
-			 * because its calculated in the targets space, we want the dist in our own space */
-			if (proj_limit_squared != 0.0f) {
-				if (len_squared_v3v3(hit.co, co) > proj_limit_squared) {
-					hit.index = -1;
-				}
-			}
-
-			if (hit.index != -1) {
-				madd_v3_v3v3fl(hit.co, hit.co, tmp_no, calc->keepDist);
-				interp_v3_v3v3(co, co, hit.co, weight);
-			}
-		}
+		data.calc = calc;
+		data.treeData = &treeData;
+		data.auxData = &auxData;
+		data.local2aux = &local2aux;
+		data.proj_axis = proj_axis;
+		data.proj_limit_squared = calc->smd->projLimit * calc->smd->projLimit;
+
+		BLI_task_parallel_range_ex(0, calc->numVerts, &data, NULL, 0,
+		                           shrinkwrap_calc_normal_projection_cb, calc->numVerts > BKE_MESH_OMP_LIMIT, false);
 	}
 
 	/* free data structures */
@@ -384,15 +571,76 @@ static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc, bool for
  * it builds a BVHTree from the target mesh and then performs a
  * NN matches for each vertex
  */
-static void shrinkwrap_calc_nearest_surface_point(ShrinkwrapCalcData *calc)
+static void shrinkwrap_calc_nearest_surface_point_cb(void *userdata, void *userdata_chunk, int iter)
 {
-	int i;
+	ShrinkwrapCalcCBData *data = userdata;
+	ShrinkwrapCalcData *calc = data->calc;
+	BVHTreeFromMesh *treeData = data->treeData;
+	BVHTreeNearest *nearest = userdata_chunk;
+
+	const int i = shrinkwrap_vert_index(calc, iter);
+	float *co = calc->vertexCos[i];
+	float tmp_co[3];
+	float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
+
+	if (weight == 0.0f) {
+		return;
+	}
+
+	/* Convert the vertex to tree coordinates */
+	if (calc->vert) {
+		copy_v3_v3(tmp_co, calc->vert[i].co);
+	}
+	else {
+		copy_v3_v3(tmp_co, co);
+	}
+	BLI_space_transform_apply(&calc->local2target, tmp_co);
+
+	/* Use local proximity heuristics (to reduce the nearest search)
+	 *
+	 * If we already had an hit before.. we assume this vertex is going to have a close hit to that other vertex
+	 * so we can initiate the "nearest.dist" with the expected value to that last hit.
+	 * This will lead in pruning of the search tree. */
+	if (nearest->index != -1)
+		nearest->dist_sq = len_squared_v3v3(tmp_co, nearest->co);
+	else
+		nearest->dist_sq = FLT_MAX;
+
+	BLI_bvhtree_find_nearest(treeData->tree, tmp_co, nearest, treeData->nearest_callback, treeData);
+
+	/* Found the nearest vertex */
+	if (nearest->index != -1) {
+		if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_KEEP_ABOVE_SURFACE) {
+			/* Make the vertex stay on the front side of the face */
+			madd_v3_v3v3fl(tmp_co, nearest->co, nearest->no, calc->keepDist);
+		}
+		else {
+			/* Adjusting the vertex weight,
+			 * so that after interpolating it keeps a certain distance from the nearest position */
+			const float dist = sasqrt(nearest->dist_sq);
+			if (dist > FLT_EPSILON) {
+				/* linear interpolation */
+				interp_v3_v3v3(tmp_co, tmp_co, nearest->co, (dist - calc->keepDist) / dist);
+			}
+			else {
+				copy_v3_v3(tmp_co, nearest->co);
+			}
+		}
 
+		/* Convert the coordinates back to mesh coordinates */
+		BLI_space_transform_invert(&calc->local2target, tmp_co);
+		interp_v3_v3v3(co, co, tmp_co, weight);  /* linear interpolation */
+	}
+}
+
+static void shrinkwrap_calc_nearest_surface_point(ShrinkwrapCalcData *calc, bool for_render)
+{
 	BVHTreeFromMesh treeData = NULL_BVHTreeFromMesh;
 	BVHTreeNearest nearest  = NULL_BVHTreeNearest;
+	ShrinkwrapCalcCBData data = {NULL};
 
 	/* Create a bvh-tree of the given target */
-	bvhtree_from_mesh_looptri(&treeData, calc->target, 0.0, 2, 6);
+	shrinkwrap_target_looptri_tree(calc, &treeData, 2, for_render);
 	if (treeData.tree == NULL) {
 		OUT_OF_MEMORY();
 		return;
@@ -402,62 +650,12 @@ static void shrinkwrap_calc_nearest_surface_point(ShrinkwrapCalcData *calc)
 	nearest.index = -1;
 	nearest.dist_sq = FLT_MAX;
 
+	data.calc = calc;
+	data.treeData = &treeData;
 
 	/* Find the nearest vertex */
-#ifndef __APPLE__
-#pragma omp parallel for default(none) private(i) firstprivate(nearest) shared(calc, treeData) schedule(static) if (calc->numVerts > BKE_MESH_OMP_LIMIT)
-#endif
-	for (i = 0; i < calc->numVerts; ++i) {
-		float *co = calc->vertexCos[i];
-		float tmp_co[3];
-		float weight = defvert_array_find_weight_safe(calc->dvert, i, calc->vgroup);
-		if (weight == 0.0f) continue;
-
-		/* Convert the vertex to tree coordinates */
-		if (calc->vert) {
-			copy_v3_v3(tmp_co, calc->vert[i].co);
-		}
-		else {
-			copy_v3_v3(tmp_co, co);
-		}
-		BLI_space_transform_apply(&calc->local2target, tmp_co);
-
-		/* Use local proximity heuristics (to reduce the nearest search)
-		 *
-		 * If we already had an hit before.. we assume this vertex is going to have a close hit to that other vertex
-		 * so we can initiate the "nearest.dist" with the expected value to that last hit.
-		 * This will lead in pruning of the search tree. */
-		if (nearest.index != -1)
-			nearest.dist_sq = len_squared_v3v3(tmp_co, nearest.co);
-		else
-			nearest.dist_sq = FLT_MAX;
-
-		BLI_bvhtree_find_nearest(treeData.tree, tmp_co, &nearest, treeData.nearest_callback, &treeData);
-
-		/* Found the nearest vertex */
-		if (nearest.index != -1) {
-			if (calc->smd->shrinkOpts & MOD_SHRINKWRAP_KEEP_ABOVE_SURFACE) {
-				/* Make the vertex stay on the front side of the face */
-				madd_v3_v3v3fl(tmp_co, nearest.co, nearest.no, calc->keepDist);
-			}
-			else {
-				/* Adjusting the vertex weight,
-				 * so that after interpolating it keeps a certain distance from the nearest position */
-				const float dist = sasqrt(nearest.dist_sq);
-				if (dist > FLT_EPSILON) {
-					/* linear interpolation */
-					interp_v3_v3v3(tmp_co, tmp_co, nearest.co, (dist - calc->keepDist) / dist);
-				}
-				else {
-					copy_v3_v3(tmp_co, nearest.co);
-				}
-			}
-
-			/* Convert the coordinates back to mesh coordinates */
-			BLI_space_transform_invert(&calc->local2target, tmp_co);
-			interp_v3_v3v3(co, co, tmp_co, weight);  /* linear interpolation */
-		}
-	}
+	BLI_task_parallel_range_ex(0, calc->numVerts, &data, &nearest, sizeof(nearest),
+	                           shrinkwrap_calc_nearest_surface_point_cb, calc->numVerts > BKE_MESH_OMP_LIMIT, false);
 
 	free_bvhtree_from_mesh(&treeData);
 }
@@ -537,22 +735,29 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd, Object *ob, DerivedM
 
 	/* Projecting target defined - lets work! */
 	if (calc.target) {
+		/* only worth it when the queries are spread over threads */
+		if (numVerts > BKE_MESH_OMP_LIMIT) {
+			calc.order = shrinkwrap_calc_query_order(&calc);
+		}
+
 		switch (smd->shrinkType) {
 			case MOD_SHRINKWRAP_NEAREST_SURFACE:
-				TIMEIT_BENCH(shrinkwrap_calc_nearest_surface_point(&calc), deform_surface);
+				shrinkwrap_calc_nearest_surface_point(&calc, for_render);
 				break;
 
 			case MOD_SHRINKWRAP_PROJECT:
-				TIMEIT_BENCH(shrinkwrap_calc_normal_projection(&calc, for_render), deform_project);
+				shrinkwrap_calc_normal_projection(&calc, for_render);
 				break;
 
 			case MOD_SHRINKWRAP_NEAREST_VERTEX:
-				TIMEIT_BENCH(shrinkwrap_calc_nearest_vertex(&calc), deform_vertex);
+				shrinkwrap_calc_nearest_vertex(&calc);
 				break;
 		}
 	}
 
 	/* free memory */
+	if (calc.order)
+		MEM_freeN(calc.order);
 	if (ss_mesh)
 		ss_mesh->release(ss_mesh);
 }
@@ -5003,13 +5003,23 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 		}
 
 		if (useIncremental && (flags & SUBSURF_IS_FINAL_CALC)) {
-			smd->mCache = ss = _getSubSurf(smd->mCache, levels, 3, useSimple | useAging | CCG_CALC_NORMALS);
+			CCGFlags ccg_flags = useSimple | useAging | CCG_CALC_NORMALS;
+
+			if (flags & SUBSURF_ALLOC_PAINT_MASK)
+				ccg_flags |= CCG_ALLOC_MASK;
+
+			smd->mCache = ss = _getSubSurf(smd->mCache, levels, 3, ccg_flags);
+			/* a reused subsurf may have the paint mask layer enabled, only sync coordinates */
+			ccgSubSurf_setNumLayers(ss, 3);
 
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple);
 
 			result = getCCGDerivedMesh(smd->mCache,
 			                           drawInteriorEdges,
 			                           useSubsurfUv, dm, false);
+
+			if (flags & SUBSURF_ALLOC_PAINT_MASK)
+				ccgSubSurf_setNumLayers(ss, 4);
 		}
 		else {
 			CCGFlags ccg_flags = useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS;
@@ -645,6 +645,7 @@ static void parallel_range_func(
  * \param func Callback function.
  * \param use_threading If \a true, actually split-execute loop in threads, else just do a sequential forloop
  *                      (allows caller to use any kind of test to switch on parallelization or not).
+ *                      The loop is sequential as well when the number of threads is set to one.
  * \param use_dynamic_scheduling If \a true, the whole range is divided in a lot of small chunks (of size 32 currently),
  *                               otherwise whole range is split in a few big chunks (num_threads * 2 chunks currently).
  */
@@ -668,10 +669,10 @@ void BLI_task_parallel_range_ex(
 
 	BLI_assert(start <= stop);
 
-	/* If it's not enough data to be crunched, don't bother with tasks at all,
-	 * do everything from the main thread.
+	/* If it's not enough data to be crunched, or there is a single thread to crunch it,
+	 * don't bother with tasks at all, do everything from the main thread.
 	 */
-	if (!use_threading) {
+	if (!use_threading || BLI_system_thread_count() == 1) {
 		const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
 		void *userdata_chunk_local = NULL;
 
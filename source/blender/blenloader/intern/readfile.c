@@ -4946,6 +4946,11 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 			
 			smd->emCache = smd->mCache = NULL;
 		}
+		else if (md->type == eModifierType_Multires) {
+			MultiresModifierData *mmd = (MultiresModifierData *)md;
+
+			mmd->subdiv_cache = NULL;
+		}
 		else if (md->type == eModifierType_Armature) {
 			ArmatureModifierData *amd = (ArmatureModifierData *)md;
 			
@@ -5111,6 +5116,16 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 			collmd->tri = NULL;
 			
 		}
+		else if (md->type == eModifierType_Lattice) {
+			LatticeModifierData *lmd = (LatticeModifierData *)md;
+
+			lmd->bind = NULL;
+		}
+		else if (md->type == eModifierType_Shrinkwrap) {
+			ShrinkwrapModifierData *smd = (ShrinkwrapModifierData *)md;
+
+			smd->cache = NULL;
+		}
 		else if (md->type == eModifierType_Surface) {
 			SurfaceModifierData *surmd = (SurfaceModifierData *)md;
 			
@@ -5444,6 +5459,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 
 	/* Runtime curve data  */
 	ob->curve_cache = NULL;
+	ob->modifier_cache = NULL;
 
 	/* in case this value changes in future, clamp else we get undefined behavior */
 	CLAMP(ob->rotmode, ROT_MODE_MIN, ROT_MODE_MAX);
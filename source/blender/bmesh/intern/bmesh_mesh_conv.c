@@ -86,6 +86,8 @@
 #include "BLI_listbase.h"
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_mesh.h"
 #include "BKE_customdata.h"
@@ -217,6 +219,123 @@ static BMFace *bm_face_create_from_mpoly(
 }
 
 
+/** \name Mesh -> BMesh bulk conversion
+ *
+ * Elements are created serially (mempools and disk/radial cycles aren't thread-safe),
+ * their custom-data blocks are allocated in the same pass,
+ * then a second, threaded pass fills in custom-data, normals and other per-element data.
+ * \{ */
+
+/**
+ * Allocate a custom-data block for an element created with #BM_CREATE_SKIP_CD,
+ * without initializing it, for conversions that fill in all layers afterwards.
+ */
+void BM_mesh_cd_block_alloc(CustomData *data, void **block)
+{
+	*block = data->totsize ? BLI_mempool_alloc(data->pool) : NULL;
+}
+
+typedef struct BMFromMeshData {
+	BMesh *bm;
+	Mesh *me;
+
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+	int cd_shape_keyindex_offset;
+
+	bool calc_face_normal;
+} BMFromMeshData;
+
+static void bm_from_me_vert_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMFromMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MVert *mvert = &me->mvert[i];
+	BMVert *v = data->vtable[i];
+
+	normal_short_to_float_v3(v->no, mvert->no);
+
+	/* Copy Custom Data (block is already allocated) */
+	CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(v, data->cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+	}
+
+	/* set shapekey data */
+	if (me->key) {
+		KeyBlock *block;
+		int j;
+
+		/* set shape key original index */
+		if (data->cd_shape_keyindex_offset != -1) {
+			BM_ELEM_CD_SET_INT(v, data->cd_shape_keyindex_offset, i);
+		}
+
+		for (block = me->key->block.first, j = 0; block; block = block->next, j++) {
+			float *co = CustomData_bmesh_get_n(&bm->vdata, v->head.data, CD_SHAPEKEY, j);
+
+			if (co) {
+				copy_v3_v3(co, ((float *)block->data) + 3 * i);
+			}
+		}
+	}
+}
+
+static void bm_from_me_edge_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMFromMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MEdge *medge = &me->medge[i];
+	BMEdge *e = data->etable[i];
+
+	/* Copy Custom Data (block is already allocated) */
+	CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
+
+	if (data->cd_edge_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+	}
+	if (data->cd_edge_crease_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset, (float)medge->crease / 255.0f);
+	}
+}
+
+static void bm_from_me_face_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMFromMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	BMFace *f = data->ftable[i];
+	BMLoop *l_iter, *l_first;
+	int j;
+
+	/* skipped (invalid) face */
+	if (f == NULL) {
+		return;
+	}
+
+	j = me->mpoly[i].loopstart;
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
+
+	if (data->calc_face_normal) {
+		BM_face_normal_update(f);
+	}
+}
+
+/** \} */
+
 /**
  * \brief Mesh -> BMesh
  *
@@ -233,8 +352,9 @@ void BM_mesh_bm_from_me(
 	KeyBlock *actkey, *block;
 	BMVert *v, **vtable = NULL;
 	BMEdge *e, **etable = NULL;
-	BMFace *f;
+	BMFace *f, **ftable = NULL;
 	float (*keyco)[3] = NULL;
+	BMFromMeshData data;
 	int totuv, totloops, i, j;
 
 	int cd_vert_bweight_offset;
@@ -329,6 +449,17 @@ void BM_mesh_bm_from_me(
 	cd_edge_crease_offset  = CustomData_get_offset(&bm->edata, CD_CREASE);
 	cd_shape_keyindex_offset = me->key ? CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX) : -1;
 
+	data.bm = bm;
+	data.me = me;
+	data.vtable = vtable;
+	data.etable = NULL;
+	data.ftable = NULL;
+	data.cd_vert_bweight_offset = cd_vert_bweight_offset;
+	data.cd_edge_bweight_offset = cd_edge_bweight_offset;
+	data.cd_edge_crease_offset = cd_edge_crease_offset;
+	data.cd_shape_keyindex_offset = cd_shape_keyindex_offset;
+	data.calc_face_normal = calc_face_normal;
+
 	for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
 		v = vtable[i] = BM_vert_create(bm, keyco && set_key ? keyco[i] : mvert->co, NULL, BM_CREATE_SKIP_CD);
 		BM_elem_index_set(v, i); /* set_ok */
@@ -341,28 +472,13 @@ void BM_mesh_bm_from_me(
 			BM_vert_select_set(bm, v, true);
 		}
 
-		normal_short_to_float_v3(v->no, mvert->no);
-
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
-
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
-
-		/* set shapekey data */
-		if (me->key) {
-			/* set shape key original index */
-			if (cd_shape_keyindex_offset != -1) BM_ELEM_CD_SET_INT(v, cd_shape_keyindex_offset, i);
-
-			for (block = me->key->block.first, j = 0; block; block = block->next, j++) {
-				float *co = CustomData_bmesh_get_n(&bm->vdata, v->head.data, CD_SHAPEKEY, j);
-
-				if (co) {
-					copy_v3_v3(co, ((float *)block->data) + 3 * i);
-				}
-			}
-		}
+		BM_mesh_cd_block_alloc(&bm->vdata, &v->head.data);
 	}
 
+	BLI_task_parallel_range_ex(
+	        0, me->totvert, &data, NULL, 0, bm_from_me_vert_cb,
+	        me->totvert >= BM_OMP_LIMIT, false);
+
 	bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
 
 	if (!me->totedge) {
@@ -372,6 +488,8 @@ void BM_mesh_bm_from_me(
 
 	etable = MEM_mallocN(sizeof(void **) * me->totedge, "mesh to bmesh etable");
 
+	data.etable = etable;
+
 	medge = me->medge;
 	for (i = 0; i < me->totedge; i++, medge++) {
 		e = etable[i] = BM_edge_create(bm, vtable[medge->v1], vtable[medge->v2], NULL, BM_CREATE_SKIP_CD);
@@ -385,24 +503,29 @@ void BM_mesh_bm_from_me(
 			BM_edge_select_set(bm, e, true);
 		}
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
-
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
-
+		BM_mesh_cd_block_alloc(&bm->edata, &e->head.data);
 	}
 
+	BLI_task_parallel_range_ex(
+	        0, me->totedge, &data, NULL, 0, bm_from_me_edge_cb,
+	        me->totedge >= BM_OMP_LIMIT, false);
+
 	bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
 
+	if (me->totpoly) {
+		ftable = MEM_mallocN(sizeof(void **) * me->totpoly, "mesh to bmesh ftable");
+	}
+	data.ftable = ftable;
+
 	mloop = me->mloop;
 	mp = me->mpoly;
 	for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
 		BMLoop *l_iter;
 		BMLoop *l_first;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
+		f = ftable[i] = bm_face_create_from_mpoly(
+		        mp, mloop + mp->loopstart,
+		        bm, vtable, etable);
 
 		if (UNLIKELY(f == NULL)) {
 			printf("%s: Warning! Bad face in mesh"
@@ -425,24 +548,22 @@ void BM_mesh_bm_from_me(
 		f->mat_nr = mp->mat_nr;
 		if (i == me->act_face) bm->act_face = f;
 
-		j = mp->loopstart;
 		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
 		do {
-			/* don't use 'j' since we may have skipped some faces, hence some loops. */
+			/* don't use 'mp->loopstart' since we may have skipped some faces, hence some loops. */
 			BM_elem_index_set(l_iter, totloops++); /* set_ok */
 
-			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+			BM_mesh_cd_block_alloc(&bm->ldata, &l_iter->head.data);
 		} while ((l_iter = l_iter->next) != l_first);
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
-
-		if (calc_face_normal) {
-			BM_face_normal_update(f);
-		}
+		BM_mesh_cd_block_alloc(&bm->pdata, &f->head.data);
 	}
 
+	/* loop & face custom-data, face normals */
+	BLI_task_parallel_range_ex(
+	        0, me->totpoly, &data, NULL, 0, bm_from_me_face_cb,
+	        me->totpoly >= BM_OMP_LIMIT, false);
+
 	bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
 
 	if (me->mselect && me->totselect != 0) {
@@ -490,6 +611,9 @@ void BM_mesh_bm_from_me(
 
 	MEM_freeN(vtable);
 	MEM_freeN(etable);
+	if (ftable) {
+		MEM_freeN(ftable);
+	}
 }
 
 
@@ -568,16 +692,115 @@ BLI_INLINE void bmesh_quick_edgedraw_flag(MEdge *med, BMEdge *e)
 	}
 }
 
+/** \name BMesh -> Mesh bulk conversion
+ *
+ * Indices and poly loop offsets are calculated up front,
+ * so each element can be written to its final location in parallel.
+ * \{ */
+
+typedef struct BMToMeshData {
+	BMesh *bm;
+	Mesh *me;
+
+	MVert *mvert;
+	MEdge *medge;
+	MPoly *mpoly;
+	MLoop *mloop;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+} BMToMeshData;
+
+static void bm_to_me_vert_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMToMeshData *data = userdata;
+	BMVert *v = data->bm->vtable[i];
+	MVert *mvert = &data->mvert[i];
+
+	copy_v3_v3(mvert->co, v->co);
+	normal_float_to_short_v3(mvert->no, v->no);
+
+	mvert->flag = BM_vert_flag_to_mflag(v);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->vdata, &data->me->vdata, v->head.data, i);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, data->cd_vert_bweight_offset);
+	}
+
+	BM_CHECK_ELEMENT(v);
+}
+
+static void bm_to_me_edge_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMToMeshData *data = userdata;
+	BMEdge *e = data->bm->etable[i];
+	MEdge *med = &data->medge[i];
+
+	med->v1 = BM_elem_index_get(e->v1);
+	med->v2 = BM_elem_index_get(e->v2);
+
+	med->flag = BM_edge_flag_to_mflag(e);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->edata, &data->me->edata, e->head.data, i);
+
+	bmesh_quick_edgedraw_flag(med, e);
+
+	if (data->cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_crease_offset);
+	if (data->cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_bweight_offset);
+
+	BM_CHECK_ELEMENT(e);
+}
+
+/* expects 'mpoly->loopstart' to be set */
+static void bm_to_me_face_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	BMToMeshData *data = userdata;
+	BMFace *f = data->bm->ftable[i];
+	MPoly *mpoly = &data->mpoly[i];
+	BMLoop *l_iter, *l_first;
+	int j = mpoly->loopstart;
+
+	mpoly->totloop = f->len;
+	mpoly->mat_nr = f->mat_nr;
+	mpoly->flag = BM_face_flag_to_mflag(f);
+
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		MLoop *mloop = &data->mloop[j];
+
+		mloop->e = BM_elem_index_get(l_iter->e);
+		mloop->v = BM_elem_index_get(l_iter->v);
+
+		/* copy over customdata */
+		CustomData_from_bmesh_block(&data->bm->ldata, &data->me->ldata, l_iter->head.data, j);
+
+		j++;
+		BM_CHECK_ELEMENT(l_iter);
+		BM_CHECK_ELEMENT(l_iter->e);
+		BM_CHECK_ELEMENT(l_iter->v);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->pdata, &data->me->pdata, f->head.data, i);
+
+	BM_CHECK_ELEMENT(f);
+}
+
+/** \} */
+
 void BM_mesh_bm_to_me(BMesh *bm, Mesh *me, bool do_tessface)
 {
 	MLoop *mloop;
 	MPoly *mpoly;
 	MVert *mvert, *oldverts;
-	MEdge *med, *medge;
-	BMVert *v, *eve;
-	BMEdge *e;
-	BMFace *f;
+	MEdge *medge;
+	BMVert *eve;
 	BMIter iter;
+	BMToMeshData data;
 	int i, j, ototvert;
 
 	const int cd_vert_bweight_offset = CustomData_get_offset(&bm->vdata, CD_BWEIGHT);
@@ -644,83 +867,41 @@ void BM_mesh_bm_to_me(BMesh *bm, Mesh *me, bool do_tessface)
 	/* this is called again, 'dotess' arg is used there */
 	BKE_mesh_update_customdata_pointers(me, 0);
 
-	i = 0;
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-		copy_v3_v3(mvert->co, v->co);
-		normal_float_to_short_v3(mvert->no, v->no);
-
-		mvert->flag = BM_vert_flag_to_mflag(v);
-
-		BM_elem_index_set(v, i); /* set_inline */
-
-		/* copy over customdat */
-		CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
-
-		if (cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, cd_vert_bweight_offset);
-
-		i++;
-		mvert++;
-
-		BM_CHECK_ELEMENT(v);
-	}
-	bm->elem_index_dirty &= ~BM_VERT;
-
-	med = medge;
-	i = 0;
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		med->v1 = BM_elem_index_get(e->v1);
-		med->v2 = BM_elem_index_get(e->v2);
-
-		med->flag = BM_edge_flag_to_mflag(e);
-
-		BM_elem_index_set(e, i); /* set_inline */
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
-
-		bmesh_quick_edgedraw_flag(med, e);
-
-		if (cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_crease_offset);
-		if (cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_bweight_offset);
-
-		i++;
-		med++;
-		BM_CHECK_ELEMENT(e);
+	/* indices are used for edge & loop vertex references, tables for threaded access */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+
+	data.bm = bm;
+	data.me = me;
+	data.mvert = mvert;
+	data.medge = medge;
+	data.mpoly = mpoly;
+	data.mloop = mloop;
+	data.cd_vert_bweight_offset = cd_vert_bweight_offset;
+	data.cd_edge_bweight_offset = cd_edge_bweight_offset;
+	data.cd_edge_crease_offset = cd_edge_crease_offset;
+
+	BLI_task_parallel_range_ex(
+	        0, bm->totvert, &data, NULL, 0, bm_to_me_vert_cb,
+	        bm->totvert >= BM_OMP_LIMIT, false);
+
+	BLI_task_parallel_range_ex(
+	        0, bm->totedge, &data, NULL, 0, bm_to_me_edge_cb,
+	        bm->totedge >= BM_OMP_LIMIT, false);
+
+	/* loop offsets, so faces can be written independently */
+	for (i = 0, j = 0; i < bm->totface; i++) {
+		mpoly[i].loopstart = j;
+		j += bm->ftable[i]->len;
 	}
-	bm->elem_index_dirty &= ~BM_EDGE;
+	BLI_assert(j == bm->totloop);
 
-	i = 0;
-	j = 0;
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_iter, *l_first;
-		mpoly->loopstart = j;
-		mpoly->totloop = f->len;
-		mpoly->mat_nr = f->mat_nr;
-		mpoly->flag = BM_face_flag_to_mflag(f);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			mloop->e = BM_elem_index_get(l_iter->e);
-			mloop->v = BM_elem_index_get(l_iter->v);
-
-			/* copy over customdata */
-			CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
-
-			j++;
-			mloop++;
-			BM_CHECK_ELEMENT(l_iter);
-			BM_CHECK_ELEMENT(l_iter->e);
-			BM_CHECK_ELEMENT(l_iter->v);
-		} while ((l_iter = l_iter->next) != l_first);
-
-		if (f == bm->act_face) me->act_face = i;
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
+	BLI_task_parallel_range_ex(
+	        0, bm->totface, &data, NULL, 0, bm_to_me_face_cb,
+	        bm->totface >= BM_OMP_LIMIT, false);
 
-		i++;
-		mpoly++;
-		BM_CHECK_ELEMENT(f);
+	if (bm->act_face) {
+		me->act_face = BM_elem_index_get(bm->act_face);
 	}
 
 	/* patch hook indices and vertex parents */
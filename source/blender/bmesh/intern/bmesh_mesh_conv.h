@@ -32,12 +32,14 @@
  *  \ingroup bmesh
  */
 
+struct CustomData;
 struct Mesh;
 
 void BM_mesh_cd_validate(BMesh *bm);
 void BM_mesh_cd_flag_ensure(BMesh *bm, struct Mesh *mesh, const char cd_flag);
 void BM_mesh_cd_flag_apply(BMesh *bm, const char cd_flag);
 char BM_mesh_cd_flag_from_bmesh(BMesh *bm);
+void BM_mesh_cd_block_alloc(struct CustomData *data, void **block);
 
 void BM_mesh_bm_from_me(
         BMesh *bm, struct Mesh *me,
@@ -39,6 +39,7 @@
 #include "BLI_polyfill2d.h"
 #include "BLI_polyfill2d_beautify.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "bmesh_tools.h"
@@ -1266,6 +1267,105 @@ void BM_face_as_array_loop_quad(BMFace *f, BMLoop *r_loops[4])
 }
 
 
+typedef struct TessellationData {
+	BMLoop *(*looptris)[3];
+	BMFace **ftable;
+	const int *looptris_offset;
+} TessellationData;
+
+static void bm_bmesh_calc_tessellation_cb(void *userdata, void *UNUSED(userdata_chunk), int index)
+{
+	TessellationData *data = userdata;
+	BMFace *efa = data->ftable[index];
+	BMLoop *(*looptris)[3] = &data->looptris[data->looptris_offset[index]];
+
+	/* don't consider two-edged faces */
+	if (UNLIKELY(efa->len < 3)) {
+		/* do nothing */
+	}
+	else if (efa->len == 3) {
+		BMLoop *l;
+		BMLoop **l_ptr = looptris[0];
+		l_ptr[0] = l = BM_FACE_FIRST_LOOP(efa);
+		l_ptr[1] = l = l->next;
+		l_ptr[2] = l->next;
+	}
+	else if (efa->len == 4) {
+		BMLoop *l;
+		BMLoop **l_ptr_a = looptris[0];
+		BMLoop **l_ptr_b = looptris[1];
+		(l_ptr_a[0] = l_ptr_b[0] = l = BM_FACE_FIRST_LOOP(efa));
+		(l_ptr_a[1]              = l = l->next);
+		(l_ptr_a[2] = l_ptr_b[1] = l = l->next);
+		(             l_ptr_b[2] = l->next);
+	}
+	else {
+		/* same as the single threaded version, using the stack instead of an arena */
+		const int totfilltri = efa->len - 2;
+		BMLoop **l_arr = BLI_array_alloca(l_arr, efa->len);
+		float (*projverts)[2] = BLI_array_alloca(projverts, efa->len);
+		unsigned int (*tris)[3] = BLI_array_alloca(tris, totfilltri);
+		float axis_mat[3][3];
+		BMLoop *l_iter;
+		BMLoop *l_first;
+		int j;
+
+		axis_dominant_v3_to_m3_negate(axis_mat, efa->no);
+
+		j = 0;
+		l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
+		do {
+			l_arr[j] = l_iter;
+			mul_v2_m3v3(projverts[j], axis_mat, l_iter->v->co);
+			j++;
+		} while ((l_iter = l_iter->next) != l_first);
+
+		BLI_polyfill_calc((const float (*)[2])projverts, efa->len, 1, tris);
+
+		for (j = 0; j < totfilltri; j++) {
+			BMLoop **l_ptr = looptris[j];
+			unsigned int *tri = tris[j];
+
+			l_ptr[0] = l_arr[tri[0]];
+			l_ptr[1] = l_arr[tri[1]];
+			l_ptr[2] = l_arr[tri[2]];
+		}
+	}
+}
+
+/**
+ * Threaded version of #BM_bmesh_calc_tessellation,
+ * the offset of each faces triangles is known up-front, so faces can be filled in any order.
+ */
+static void bm_bmesh_calc_tessellation_threaded(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptris_tot)
+{
+	TessellationData data;
+	int *looptris_offset = MEM_mallocN(sizeof(*looptris_offset) * (size_t)bm->totface, __func__);
+	int i, looptris_tot = 0;
+
+	BM_mesh_elem_table_ensure(bm, BM_FACE);
+
+	for (i = 0; i < bm->totface; i++) {
+		const int len = bm->ftable[i]->len;
+		looptris_offset[i] = looptris_tot;
+		if (len >= 3) {
+			looptris_tot += len - 2;
+		}
+	}
+
+	data.looptris = looptris;
+	data.ftable = bm->ftable;
+	data.looptris_offset = looptris_offset;
+
+	BLI_task_parallel_range_ex(
+	        0, bm->totface, &data, NULL, 0, bm_bmesh_calc_tessellation_cb,
+	        true, false);
+
+	MEM_freeN(looptris_offset);
+
+	*r_looptris_tot = looptris_tot;
+}
+
 /**
  * \brief BM_bmesh_calc_tessellation get the looptris and its number from a certain bmesh
  * \param looptris
@@ -1290,6 +1390,12 @@ void BM_bmesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptr
 
 	MemArena *arena = NULL;
 
+	if (bm->totface >= BM_OMP_LIMIT) {
+		bm_bmesh_calc_tessellation_threaded(bm, looptris, r_looptris_tot);
+		BLI_assert(*r_looptris_tot <= looptris_tot);
+		return;
+	}
+
 	BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
 		/* don't consider two-edged faces */
 		if (UNLIKELY(efa->len < 3)) {
@@ -34,6 +34,8 @@
 #include "BLI_math.h"
 #include "BLI_quadric.h"
 #include "BLI_heap.h"
+#include "BLI_buffer.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 
@@ -228,20 +230,22 @@ static float bm_decim_build_edge_cost_single__topology(BMEdge *e)
 
 #endif  /* USE_TOPOLOGY_FALLBACK */
 
-static void bm_decim_build_edge_cost_single(
+/**
+ * Calculate the collapse cost of an edge, without changing the heap,
+ * so edges can be calculated in parallel.
+ *
+ * \return false when the edge can't be collapsed (and shouldn't be in the heap).
+ */
+static bool bm_decim_calc_edge_cost_single(
         BMEdge *e,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
-        Heap *eheap, HeapNode **eheap_table)
+        float *r_cost)
 {
 	const Quadric *q1, *q2;
 	float optimize_co[3];
 	float cost;
 
-	if (eheap_table[BM_elem_index_get(e)]) {
-		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
-	}
-
 	if (UNLIKELY(vweights &&
 	             ((vweights[BM_elem_index_get(e->v1)] == 0.0f) ||
 	              (vweights[BM_elem_index_get(e->v2)] == 0.0f))))
@@ -321,11 +325,31 @@ static void bm_decim_build_edge_cost_single(
 		}
 	}
 
-	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
-	return;
+	*r_cost = cost;
+	return true;
 
 clear:
-	eheap_table[BM_elem_index_get(e)] = NULL;
+	return false;
+}
+
+static void bm_decim_build_edge_cost_single(
+        BMEdge *e,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table)
+{
+	float cost;
+
+	if (eheap_table[BM_elem_index_get(e)]) {
+		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+	}
+
+	if (bm_decim_calc_edge_cost_single(e, vquadrics, vweights, vweight_factor, &cost)) {
+		eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
+	}
+	else {
+		eheap_table[BM_elem_index_get(e)] = NULL;
+	}
 }
 
 
@@ -339,20 +363,79 @@ static void bm_decim_invalid_edge_cost_single(
 	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, COST_INVALID, e);
 }
 
+typedef struct DecimEdgeCostThreadedData {
+	BMEdge **etable;
+	const Quadric *vquadrics;
+	const float *vweights;
+	float vweight_factor;
+
+	/* etable aligned */
+	float *ecosts;
+	bool *ecosts_valid;
+} DecimEdgeCostThreadedData;
+
+static void bm_decim_calc_edge_cost_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	DecimEdgeCostThreadedData *data = userdata;
+
+	data->ecosts_valid[i] = bm_decim_calc_edge_cost_single(
+	        data->etable[i], data->vquadrics, data->vweights, data->vweight_factor, &data->ecosts[i]);
+}
+
+/**
+ * Calculate the costs of an array of edges in parallel (only reading the mesh and quadrics),
+ * the caller adds them to the heap in order, so the result doesn't depend on threading.
+ */
+static void bm_decim_calc_edge_cost_array(
+        BMEdge **etable, const int etable_len,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        float *r_ecosts, bool *r_ecosts_valid,
+        const bool use_threading)
+{
+	DecimEdgeCostThreadedData data;
+
+	data.etable = etable;
+	data.vquadrics = vquadrics;
+	data.vweights = vweights;
+	data.vweight_factor = vweight_factor;
+	data.ecosts = r_ecosts;
+	data.ecosts_valid = r_ecosts_valid;
+
+	BLI_task_parallel_range_ex(
+	        0, etable_len, &data, NULL, 0, bm_decim_calc_edge_cost_cb,
+	        use_threading, false);
+}
+
 static void bm_decim_build_edge_cost(
         BMesh *bm,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
         Heap *eheap, HeapNode **eheap_table)
 {
-	BMIter iter;
-	BMEdge *e;
-	unsigned int i;
+	float *ecosts;
+	bool *ecosts_valid;
+	int i;
 
-	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
-		eheap_table[i] = NULL;  /* keep sanity check happy */
-		bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+	BM_mesh_elem_index_ensure(bm, BM_EDGE);
+	BM_mesh_elem_table_ensure(bm, BM_EDGE);
+
+	ecosts = MEM_mallocN(sizeof(*ecosts) * bm->totedge, __func__);
+	ecosts_valid = MEM_mallocN(sizeof(*ecosts_valid) * bm->totedge, __func__);
+
+	bm_decim_calc_edge_cost_array(
+	        bm->etable, bm->totedge, vquadrics, vweights, vweight_factor,
+	        ecosts, ecosts_valid, bm->totedge >= BM_OMP_LIMIT);
+
+	for (i = 0; i < bm->totedge; i++) {
+		BMEdge *e = bm->etable[i];
+
+		BLI_assert(BM_elem_index_get(e) == i);
+		eheap_table[i] = ecosts_valid[i] ? BLI_heap_insert(eheap, ecosts[i], e) : NULL;
 	}
+
+	MEM_freeN(ecosts);
+	MEM_freeN(ecosts_valid);
 }
 
 #ifdef USE_SYMMETRY
@@ -1047,9 +1130,53 @@ static bool bm_edge_collapse(
 }
 
 
+/**
+ * Append the edges whose collapse cost changes when \a v is moved by a collapse:
+ * the edges of \a v, and the outer edges of its face fan.
+ */
+static void bm_decim_vert_collapse_edges(BMVert *v, BLI_Buffer *r_edges)
+{
+	if (LIKELY(v->e)) {
+		BMEdge *e_iter;
+		BMEdge *e_first;
+		e_iter = e_first = v->e;
+		do {
+			BLI_assert(BM_edge_find_double(e_iter) == NULL);
+			BLI_buffer_append(r_edges, BMEdge *, e_iter);
+		} while ((e_iter = bmesh_disk_edge_next(e_iter, v)) != e_first);
+	}
+
+	/* this block used to be disabled,
+	 * but enable now since surrounding faces may have been
+	 * set to COST_INVALID because of a face overlap that no longer occurs */
+#if 1
+	/* optional, update edges around the vertex face fan */
+	{
+		BMIter liter;
+		BMLoop *l;
+		BM_ITER_ELEM (l, &liter, v, BM_LOOPS_OF_VERT) {
+			if (l->f->len == 3) {
+				BMEdge *e_outer;
+				if (BM_vert_in_edge(l->prev->e, l->v))
+					e_outer = l->next->e;
+				else
+					e_outer = l->prev->e;
+
+				BLI_assert(BM_vert_in_edge(e_outer, l->v) == false);
+
+				BLI_buffer_append(r_edges, BMEdge *, e_outer);
+			}
+		}
+	}
+	/* end optional update */
+#endif
+}
+
 /**
  * Collapse e the edge, removing e->v2
  *
+ * \param r_edges_update: When set, the edges whose cost changed are appended,
+ * for the caller to update, otherwise they're updated in the heap here.
  * \return true when the edge was collapsed.
  */
 static bool bm_decim_edge_collapse(
@@ -1061,7 +1188,8 @@ static bool bm_decim_edge_collapse(
         int *edge_symmetry_map,
 #endif
         const CD_UseFlag customdata_flag,
-        float optimize_co[3], bool optimize_co_calc
+        float optimize_co[3], bool optimize_co_calc,
+        BLI_Buffer *r_edges_update
         )
 {
 	int e_clear_other[2];
@@ -1152,41 +1280,22 @@ static bool bm_decim_edge_collapse(
 
 
 		/* update error costs and the eheap */
-		if (LIKELY(v_other->e)) {
-			BMEdge *e_iter;
-			BMEdge *e_first;
-			e_iter = e_first = v_other->e;
-			do {
-				BLI_assert(BM_edge_find_double(e_iter) == NULL);
-				bm_decim_build_edge_cost_single(e_iter, vquadrics, vweights, vweight_factor, eheap, eheap_table);
-			} while ((e_iter = bmesh_disk_edge_next(e_iter, v_other)) != e_first);
+		if (r_edges_update) {
+			bm_decim_vert_collapse_edges(v_other, r_edges_update);
 		}
+		else {
+			BLI_buffer_declare_static(BMEdge *, edges_update, BLI_BUFFER_NOP, 32);
+			unsigned int i_update;
 
-		/* this block used to be disabled,
-		 * but enable now since surrounding faces may have been
-		 * set to COST_INVALID because of a face overlap that no longer occurs */
-#if 1
-		/* optional, update edges around the vertex face fan */
-		{
-			BMIter liter;
-			BMLoop *l;
-			BM_ITER_ELEM (l, &liter, v_other, BM_LOOPS_OF_VERT) {
-				if (l->f->len == 3) {
-					BMEdge *e_outer;
-					if (BM_vert_in_edge(l->prev->e, l->v))
-						e_outer = l->next->e;
-					else
-						e_outer = l->prev->e;
-
-					BLI_assert(BM_vert_in_edge(e_outer, l->v) == false);
-
-					bm_decim_build_edge_cost_single(e_outer, vquadrics, vweights, vweight_factor, eheap, eheap_table);
-				}
+			bm_decim_vert_collapse_edges(v_other, &edges_update);
+			for (i_update = 0; i_update < edges_update.count; i_update++) {
+				BMEdge *e_update = BLI_buffer_at(&edges_update, BMEdge *, i_update);
+				bm_decim_build_edge_cost_single(e_update, vquadrics, vweights, vweight_factor, eheap, eheap_table);
 			}
+			BLI_buffer_free(&edges_update);
 		}
-		/* end optional update */
+
 		return true;
-#endif
 	}
 	else {
 		/* add back with a high cost */
@@ -1196,6 +1305,227 @@ static bool bm_decim_edge_collapse(
 }
 
 
+/* Batched Edge Collapse
+ * ********************* */
+
+/**
+ * Collapse edges in batches of the cheapest edges with neighborhoods that don't overlap,
+ * a neighborhood being the vertices of the faces around both edge vertices.
+ *
+ * Checking a collapse and calculating its target only reads the neighborhood of the edge,
+ * the collapse only changes that neighborhood, and the edges whose cost changes only read it.
+ * So within a batch, the checks and the new costs are calculated in parallel.
+ * The collapses themselves run in order, since they free elements and merge customdata.
+ *
+ * Unlike the serial collapse, an edge made cheaper by a collapse waits for the next batch,
+ * so the result differs slightly.
+ */
+
+/* edges collapsed in one batch, at most */
+#define BATCH_SIZE_MAX 256
+/* smaller batches aren't worth the threading overhead */
+#define BATCH_OMP_LIMIT 64
+
+typedef struct DecimBatchEdge {
+	BMEdge *e;
+	float cost;
+	float optimize_co[3];
+	bool is_valid;
+} DecimBatchEdge;
+
+typedef struct DecimBatchThreadedData {
+	DecimBatchEdge *batch;
+	const Quadric *vquadrics;
+} DecimBatchThreadedData;
+
+/**
+ * Reserve the neighborhood of \a e for this batch.
+ *
+ * \return false when it overlaps the neighborhood of an edge already in the batch.
+ */
+static bool bm_decim_batch_edge_reserve(BMEdge *e, int *vbatch, const int batch_id)
+{
+	/* only reserve once all of it is free, so a skipped edge doesn't reserve anything */
+	BLI_buffer_declare_static(int, vert_indices, BLI_BUFFER_NOP, 64);
+	bool is_free = true;
+	unsigned int i;
+
+	/* edges collapse between triangles only, and the collapse checks give up on
+	 * other edges around the vertices, so the vertices of the faces are enough */
+	for (i = 0; i < 2; i++) {
+		BMVert *v = *((&e->v1) + i);
+		BMIter liter;
+		BMLoop *l;
+
+		BM_ITER_ELEM (l, &liter, v, BM_LOOPS_OF_VERT) {
+			BMLoop *l_iter = l;
+			do {
+				const int v_index = BM_elem_index_get(l_iter->v);
+				if (vbatch[v_index] == batch_id) {
+					is_free = false;
+					goto finally;
+				}
+				BLI_buffer_append(&vert_indices, int, v_index);
+			} while ((l_iter = l_iter->next) != l);
+		}
+	}
+
+	for (i = 0; i < vert_indices.count; i++) {
+		vbatch[BLI_buffer_at(&vert_indices, int, i)] = batch_id;
+	}
+
+finally:
+	BLI_buffer_free(&vert_indices);
+	return is_free;
+}
+
+static void bm_decim_batch_calc_cb(void *userdata, void *UNUSED(userdata_chunk), int i)
+{
+	DecimBatchThreadedData *data = userdata;
+	DecimBatchEdge *be = &data->batch[i];
+
+	/* disallow collapsing which results in degenerate cases,
+	 * the topology check only tags elements of this neighborhood */
+	be->is_valid = false;
+
+	if (UNLIKELY(bm_edge_collapse_is_degenerate_topology(be->e))) {
+		return;
+	}
+
+	bm_decim_calc_target_co(be->e, be->optimize_co, data->vquadrics);
+
+	/* check if this would result in an overlapping face */
+	if (UNLIKELY(bm_edge_collapse_is_degenerate_flip(be->e, be->optimize_co))) {
+		return;
+	}
+
+	be->is_valid = true;
+}
+
+static void bm_decim_collapse_batched(
+        BMesh *bm, const int face_tot_target,
+        Quadric *vquadrics,
+        float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table,
+        const CD_UseFlag customdata_flag)
+{
+	DecimBatchEdge *batch = MEM_mallocN(sizeof(*batch) * BATCH_SIZE_MAX, __func__);
+	DecimBatchEdge *skip = MEM_mallocN(sizeof(*skip) * (BATCH_SIZE_MAX + 1), __func__);
+	/* vert index aligned, the last batch that reserved the vertex */
+	int *vbatch = MEM_callocN(sizeof(*vbatch) * bm->totvert, __func__);
+	int batch_id = 0;
+
+	BLI_buffer_declare_static(BMEdge *, edges_update, BLI_BUFFER_NOP, 256);
+	float *ecosts = NULL;
+	bool *ecosts_valid = NULL;
+	unsigned int ecosts_len = 0;
+
+	while ((bm->totface > face_tot_target) &&
+	       (BLI_heap_is_empty(eheap) == false) &&
+	       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+	{
+		/* a collapse removes up to 2 faces, keep batches well below the remaining collapses,
+		 * so the last batches don't overshoot the target and follow the order of cost closely */
+		const int batch_len_max = min_ii(BATCH_SIZE_MAX, max_ii((bm->totface - face_tot_target) / 8, 1));
+		DecimBatchThreadedData data;
+		int batch_len = 0, skip_len = 0;
+		int i;
+		unsigned int i_update;
+
+		batch_id++;
+
+		/* pick the cheapest edges with neighborhoods that don't overlap,
+		 * once as many overlap as were picked, the next free edges would cost much more than the skipped ones */
+		while ((batch_len < batch_len_max) &&
+		       (skip_len <= batch_len) &&
+		       (BLI_heap_is_empty(eheap) == false) &&
+		       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+		{
+			const float cost = BLI_heap_node_value(BLI_heap_top(eheap));
+			BMEdge *e = BLI_heap_popmin(eheap);
+			DecimBatchEdge *be;
+
+			eheap_table[BM_elem_index_get(e)] = NULL;
+
+			if (bm_decim_batch_edge_reserve(e, vbatch, batch_id)) {
+				be = &batch[batch_len++];
+			}
+			else {
+				be = &skip[skip_len++];
+			}
+
+			be->e = e;
+			be->cost = cost;
+		}
+
+		/* overlapping edges go back, for a later batch */
+		for (i = 0; i < skip_len; i++) {
+			eheap_table[BM_elem_index_get(skip[i].e)] = BLI_heap_insert(eheap, skip[i].cost, skip[i].e);
+		}
+
+		/* check the collapses and calculate their targets */
+		data.batch = batch;
+		data.vquadrics = vquadrics;
+
+		BLI_task_parallel_range_ex(
+		        0, batch_len, &data, NULL, 0, bm_decim_batch_calc_cb,
+		        batch_len >= BATCH_OMP_LIMIT, false);
+
+		/* collapse, in order of cost */
+		BLI_buffer_empty(&edges_update);
+
+		for (i = 0; i < batch_len; i++) {
+			DecimBatchEdge *be = &batch[i];
+
+			if (be->is_valid) {
+				bm_decim_edge_collapse(
+				        bm, be->e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+#ifdef USE_SYMMETRY
+				        NULL,
+#endif
+				        customdata_flag,
+				        be->optimize_co, false,
+				        &edges_update);
+			}
+			else {
+				bm_decim_invalid_edge_cost_single(be->e, eheap, eheap_table);  /* add back with a high cost */
+			}
+		}
+
+		/* update the costs of the edges changed by the collapses,
+		 * these don't overlap between collapses either */
+		if (ecosts_len < edges_update.count) {
+			ecosts_len = edges_update.count;
+			MEM_SAFE_FREE(ecosts);
+			MEM_SAFE_FREE(ecosts_valid);
+			ecosts = MEM_mallocN(sizeof(*ecosts) * ecosts_len, __func__);
+			ecosts_valid = MEM_mallocN(sizeof(*ecosts_valid) * ecosts_len, __func__);
+		}
+
+		bm_decim_calc_edge_cost_array(
+		        BLI_buffer_array(&edges_update, BMEdge *), (int)edges_update.count,
+		        vquadrics, vweights, vweight_factor,
+		        ecosts, ecosts_valid, edges_update.count >= BATCH_OMP_LIMIT);
+
+		for (i_update = 0; i_update < edges_update.count; i_update++) {
+			BMEdge *e = BLI_buffer_at(&edges_update, BMEdge *, i_update);
+			const int e_index = BM_elem_index_get(e);
+
+			if (eheap_table[e_index]) {
+				BLI_heap_remove(eheap, eheap_table[e_index]);
+			}
+			eheap_table[e_index] = ecosts_valid[i_update] ? BLI_heap_insert(eheap, ecosts[i_update], e) : NULL;
+		}
+	}
+
+	BLI_buffer_free(&edges_update);
+	MEM_SAFE_FREE(ecosts);
+	MEM_SAFE_FREE(ecosts_valid);
+	MEM_freeN(batch);
+	MEM_freeN(skip);
+	MEM_freeN(vbatch);
+}
+
 /* Main Decimate Function
  * ********************** */
 
@@ -1206,13 +1536,16 @@ static bool bm_decim_edge_collapse(
  * \param vweights Optional array of vertex  aligned weights [0 - 1],
  *        a vertex group is the usual source for this.
  * \param axis: Axis of symmetry, -1 to disable mirror decimate.
+ * \param use_parallel: Collapse batches of independent edges using threads,
+ *        faster on dense meshes, but the result differs slightly (ignored with symmetry).
  */
 void BM_mesh_decimate_collapse(
         BMesh *bm,
         const float factor,
         float *vweights, float vweight_factor,
         const bool do_triangulate,
-        const int symmetry_axis, const float symmetry_eps)
+        const int symmetry_axis, const float symmetry_eps,
+        const bool use_parallel)
 {
 	Heap *eheap;             /* edge heap */
 	HeapNode **eheap_table;  /* edge index aligned table pointing to the eheap */
@@ -1268,28 +1601,35 @@ void BM_mesh_decimate_collapse(
 	if (use_symmetry == false)
 #endif
 	{
-		/* simple non-mirror case */
-		while ((bm->totface > face_tot_target) &&
-		       (BLI_heap_is_empty(eheap) == false) &&
-		       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
-		{
-			// const float value = BLI_heap_node_value(BLI_heap_top(eheap));
-			BMEdge *e = BLI_heap_popmin(eheap);
-			float optimize_co[3];
-			BLI_assert(BM_elem_index_get(e) < tot_edge_orig);  /* handy to detect corruptions elsewhere */
+		if (use_parallel) {
+			bm_decim_collapse_batched(
+			        bm, face_tot_target, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+			        customdata_flag);
+		}
+		else {
+			/* simple non-mirror case */
+			while ((bm->totface > face_tot_target) &&
+			       (BLI_heap_is_empty(eheap) == false) &&
+			       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+			{
+				// const float value = BLI_heap_node_value(BLI_heap_top(eheap));
+				BMEdge *e = BLI_heap_popmin(eheap);
+				float optimize_co[3];
+				BLI_assert(BM_elem_index_get(e) < tot_edge_orig);  /* handy to detect corruptions elsewhere */
 
-			/* under normal conditions wont be accessed again,
-			 * but NULL just incase so we don't use freed node */
-			eheap_table[BM_elem_index_get(e)] = NULL;
+				/* under normal conditions wont be accessed again,
+				 * but NULL just incase so we don't use freed node */
+				eheap_table[BM_elem_index_get(e)] = NULL;
 
-			bm_decim_edge_collapse(
-			        bm, e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+				bm_decim_edge_collapse(
+				        bm, e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 #ifdef USE_SYMMETRY
-			        edge_symmetry_map,
+				        edge_symmetry_map,
 #endif
-			        customdata_flag,
-			        optimize_co, true
-			        );
+				        customdata_flag,
+				        optimize_co, true, NULL
+				        );
+			}
 		}
 	}
 #ifdef USE_SYMMETRY
@@ -1369,7 +1709,7 @@ void BM_mesh_decimate_collapse(
 			        bm, e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 			        edge_symmetry_map,
 			        customdata_flag,
-			        optimize_co, false))
+			        optimize_co, false, NULL))
 			{
 				if (e_mirr && (eheap_table[e_index_mirr])) {
 					BLI_assert(e_index_mirr != e_index);
@@ -1380,7 +1720,7 @@ void BM_mesh_decimate_collapse(
 					        bm, e_mirr, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 					        edge_symmetry_map,
 					        customdata_flag,
-					        optimize_co, false);
+					        optimize_co, false, NULL);
 				}
 			}
 			else {
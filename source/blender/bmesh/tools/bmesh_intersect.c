@@ -832,6 +832,98 @@ static void bm_isect_tri_tri(
 
 #ifdef USE_BVH
 
+/* -------------------------------------------------------------------- */
+/* Overlap Filter
+ *
+ * The BVH overlap gives many pairs which only touch in bounds,
+ * reject these from the (threaded) overlap callback so #bm_isect_tri_tri,
+ * which edits the mesh and has to run serially, only sees pairs which may intersect.
+ *
+ * Rejection is only done when the result is certain,
+ * coplanar & near-touching pairs are always passed on to the exact checks.
+ */
+
+struct OverlapFilterData {
+	BMLoop *(*looptris)[3];
+	const struct ISectEpsilon *epsilon;
+};
+
+/**
+ * Return true when  t_b is entirely on one side of the plane of  t_a,
+ * further than any of the tests in #bm_isect_tri_tri can reach.
+ */
+static bool isect_tri_tri_plane_separated(
+        const float *t_a[3], const float *t_b[3],
+        const struct ISectEpsilon *e)
+{
+	double a0[3], e1[3], e2[3], no[3];
+	double d_min = DBL_MAX, d_max = -DBL_MAX;
+	double len, tol;
+	float co_max = 0.0f;
+	unsigned int i;
+
+	copy_v3db_v3fl(a0, t_a[0]);
+	for (i = 0; i < 3; i++) {
+		e1[i] = (double)t_a[1][i] - a0[i];
+		e2[i] = (double)t_a[2][i] - a0[i];
+	}
+	no[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	no[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	no[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	len = sqrt(no[0] * no[0] + no[1] * no[1] + no[2] * no[2]);
+
+	/* degenerate, leave it to the exact checks */
+	if (len == 0.0) {
+		return false;
+	}
+
+	for (i = 0; i < 3; i++) {
+		const double d = (((double)t_b[i][0] - a0[0]) * no[0] +
+		                  ((double)t_b[i][1] - a0[1]) * no[1] +
+		                  ((double)t_b[i][2] - a0[2]) * no[2]) / len;
+		if (d < d_min) d_min = d;
+		if (d > d_max) d_max = d;
+
+		co_max = max_ff(co_max, max_fff(fabsf(t_a[i][0]), fabsf(t_a[i][1]), fabsf(t_a[i][2])));
+		co_max = max_ff(co_max, max_fff(fabsf(t_b[i][0]), fabsf(t_b[i][1]), fabsf(t_b[i][2])));
+	}
+
+	/* - 'eps_margin' is the largest distance any of the tests accepts.
+	 * - edge factors are accepted up to 'eps' outside the edge,
+	 *   extrapolating towards the plane by at most 'eps' of the edge's range.
+	 * - the tests themselves are single precision. */
+	tol = (double)e->eps_margin +
+	      (double)e->eps * (d_max - d_min) +
+	      (double)co_max * (double)FLT_EPSILON * 8.0;
+
+	return (d_min > tol) || (d_max < -tol);
+}
+
+static bool bm_isect_overlap_filter_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	struct OverlapFilterData *data = userdata;
+	BMLoop **a = data->looptris[index_a];
+	BMLoop **b = data->looptris[index_b];
+	BMVert *fv_a[3] = {UNPACK3_EX(, a, ->v)};
+	BMVert *fv_b[3] = {UNPACK3_EX(, b, ->v)};
+	const float *f_a_cos[3] = {UNPACK3_EX(, fv_a, ->co)};
+	const float *f_b_cos[3] = {UNPACK3_EX(, fv_b, ->co)};
+
+	/* same as the early exit in 'bm_isect_tri_tri' */
+	if (UNLIKELY(ELEM(fv_a[0], UNPACK3(fv_b)) ||
+	             ELEM(fv_a[1], UNPACK3(fv_b)) ||
+	             ELEM(fv_a[2], UNPACK3(fv_b))))
+	{
+		return false;
+	}
+
+	return !(isect_tri_tri_plane_separated(f_a_cos, f_b_cos, data->epsilon) ||
+	         isect_tri_tri_plane_separated(f_b_cos, f_a_cos, data->epsilon));
+}
+
+/* -------------------------------------------------------------------- */
+/* Raycast */
+
 struct RaycastData {
 	const float **looptris;
 	BLI_Buffer *z_buffer;
@@ -1088,7 +1180,10 @@ bool BM_mesh_intersect(
 		tree_b = tree_a;
 	}
 
-	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	{
+		struct OverlapFilterData data = {looptris, &s.epsilon};
+		overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, bm_isect_overlap_filter_cb, &data);
+	}
 
 	if (overlap) {
 		unsigned int i;
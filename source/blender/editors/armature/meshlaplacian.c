@@ -36,6 +36,8 @@
 #include "BLI_memarena.h"
 #include "BLI_string.h"
 #include "BLI_alloca.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -837,6 +839,7 @@ typedef struct MeshDeformBind {
 
 	/* grids */
 	MemArena *memarena;
+	ThreadMutex memarena_lock;  /* intersections are allocated from threads */
 	MDefBoundIsect *(*boundisect)[6];
 	int *semibound;
 	int *tag;
@@ -984,34 +987,42 @@ static void harmonic_ray_callback(void *userdata, int index, const BVHTreeRay *r
 	}
 }
 
-static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb, const float co1[3], const float co2[3])
+/* thread-safe, only reads from the cage and its BVH tree */
+static bool meshdeform_ray_tree_cast(
+        MeshDeformBind *mdb, const float co1[3], const float co2[3],
+        MeshDeformIsect *r_isect_mdef, BVHTreeRayHit *r_hit)
 {
-	BVHTreeRayHit hit;
-	MeshDeformIsect isect_mdef;
 	struct MeshRayCallbackData data = {
 		mdb,
-		&isect_mdef,
+		r_isect_mdef,
 	};
 	float end[3], vec_normal[3];
 
 	/* happens binding when a cage has no faces */
 	if (UNLIKELY(mdb->bvhtree == NULL))
-		return NULL;
+		return false;
 
 	/* setup isec */
-	memset(&isect_mdef, 0, sizeof(isect_mdef));
-	isect_mdef.lambda = 1e10f;
+	memset(r_isect_mdef, 0, sizeof(*r_isect_mdef));
+	r_isect_mdef->lambda = 1e10f;
 
-	copy_v3_v3(isect_mdef.start, co1);
+	copy_v3_v3(r_isect_mdef->start, co1);
 	copy_v3_v3(end, co2);
-	sub_v3_v3v3(isect_mdef.vec, end, isect_mdef.start);
-	isect_mdef.vec_length = normalize_v3_v3(vec_normal, isect_mdef.vec);
+	sub_v3_v3v3(r_isect_mdef->vec, end, r_isect_mdef->start);
+	r_isect_mdef->vec_length = normalize_v3_v3(vec_normal, r_isect_mdef->vec);
 
-	hit.index = -1;
-	hit.dist = FLT_MAX;
-	if (BLI_bvhtree_ray_cast(mdb->bvhtree, isect_mdef.start, vec_normal,
-	                         0.0, &hit, harmonic_ray_callback, &data) != -1)
-	{
+	r_hit->index = -1;
+	r_hit->dist = FLT_MAX;
+	return (BLI_bvhtree_ray_cast(mdb->bvhtree, r_isect_mdef->start, vec_normal,
+	                             0.0, r_hit, harmonic_ray_callback, &data) != -1);
+}
+
+static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb, const float co1[3], const float co2[3])
+{
+	BVHTreeRayHit hit;
+	MeshDeformIsect isect_mdef;
+
+	if (meshdeform_ray_tree_cast(mdb, co1, co2, &isect_mdef, &hit)) {
 		const MLoop *mloop = mdb->cagedm_cache.mloop;
 		const MLoopTri *lt = &mdb->cagedm_cache.looptri[hit.index];
 		const MPoly *mp = &mdb->cagedm_cache.mpoly[lt->poly];
@@ -1023,7 +1034,9 @@ static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb, const
 		int i;
 
 		/* create MDefBoundIsect, and extra for 'poly_weights[]' */
+		BLI_mutex_lock(&mdb->memarena_lock);
 		isect = BLI_memarena_alloc(mdb->memarena, sizeof(*isect) + (sizeof(float) * mp->totloop));
+		BLI_mutex_unlock(&mdb->memarena_lock);
 
 		/* compute intersection coordinate */
 		madd_v3_v3v3fl(isect->co, co1, isect_mdef.vec, len);
@@ -1047,10 +1060,11 @@ static MDefBoundIsect *meshdeform_ray_tree_intersect(MeshDeformBind *mdb, const
 	return NULL;
 }
 
-static int meshdeform_inside_cage(MeshDeformBind *mdb, float *co)
+static int meshdeform_inside_cage(MeshDeformBind *mdb, const float co[3])
 {
-	MDefBoundIsect *isect;
-	float outside[3], start[3], dir[3];
+	BVHTreeRayHit hit;
+	MeshDeformIsect isect_mdef;
+	float outside[3];
 	int i;
 
 	for (i = 1; i <= 6; i++) {
@@ -1058,18 +1072,21 @@ static int meshdeform_inside_cage(MeshDeformBind *mdb, float *co)
 		outside[1] = co[1] + (mdb->max[1] - mdb->min[1] + 1.0f) * MESHDEFORM_OFFSET[i][1];
 		outside[2] = co[2] + (mdb->max[2] - mdb->min[2] + 1.0f) * MESHDEFORM_OFFSET[i][2];
 
-		copy_v3_v3(start, co);
-		sub_v3_v3v3(dir, outside, start);
-		normalize_v3(dir);
-		
-		isect = meshdeform_ray_tree_intersect(mdb, start, outside);
-		if (isect && !isect->facing)
+		/* only the facing of the hit is needed, no need to store the intersection */
+		if (meshdeform_ray_tree_cast(mdb, co, outside, &isect_mdef, &hit) && !isect_mdef.isect)
 			return 1;
 	}
 
 	return 0;
 }
 
+static void meshdeform_inside_cage_task(void *userdata, void *UNUSED(userdata_chunk), int a)
+{
+	MeshDeformBind *mdb = userdata;
+
+	mdb->inside[a] = meshdeform_inside_cage(mdb, mdb->vertexcos[a]);
+}
+
 /* solving */
 
 BLI_INLINE int meshdeform_index(MeshDeformBind *mdb, int x, int y, int z, int n)
@@ -1125,6 +1142,17 @@ static void meshdeform_add_intersections(MeshDeformBind *mdb, int x, int y, int
 	}
 }
 
+/* each z slice only writes to its own cells */
+static void meshdeform_add_intersections_task(void *userdata, void *UNUSED(userdata_chunk), int z)
+{
+	MeshDeformBind *mdb = userdata;
+	int x, y;
+
+	for (y = 0; y < mdb->size; y++)
+		for (x = 0; x < mdb->size; x++)
+			meshdeform_add_intersections(mdb, x, y, z);
+}
+
 static void meshdeform_bind_floodfill(MeshDeformBind *mdb)
 {
 	int *stack, *tag = mdb->tag;
@@ -1377,10 +1405,30 @@ static void meshdeform_matrix_add_exterior_phi(MeshDeformBind *mdb, int x, int y
 		mdb->phi[acenter] = phi / totweight;
 }
 
+typedef struct MeshDeformWeightsData {
+	MeshDeformBind *mdb;
+	int cagevert;
+} MeshDeformWeightsData;
+
+static void meshdeform_matrix_weights_task(void *userdata, void *UNUSED(userdata_chunk), int b)
+{
+	MeshDeformWeightsData *data = userdata;
+	MeshDeformBind *mdb = data->mdb;
+	float vec[3], gridvec[3];
+
+	if (mdb->inside[b]) {
+		copy_v3_v3(vec, mdb->vertexcos[b]);
+		gridvec[0] = (vec[0] - mdb->min[0] - mdb->halfwidth[0]) / mdb->width[0];
+		gridvec[1] = (vec[1] - mdb->min[1] - mdb->halfwidth[1]) / mdb->width[1];
+		gridvec[2] = (vec[2] - mdb->min[2] - mdb->halfwidth[2]) / mdb->width[2];
+
+		mdb->weights[b * mdb->totcagevert + data->cagevert] = meshdeform_interp_w(mdb, gridvec, vec, data->cagevert);
+	}
+}
+
 static void meshdeform_matrix_solve(MeshDeformModifierData *mmd, MeshDeformBind *mdb)
 {
 	LinearSolver *context;
-	float vec[3], gridvec[3];
 	int a, b, x, y, z, totvar;
 	char message[256];
 
@@ -1432,16 +1480,10 @@ static void meshdeform_matrix_solve(MeshDeformModifierData *mmd, MeshDeformBind
 
 			if (mdb->weights) {
 				/* static bind : compute weights for each vertex */
-				for (b = 0; b < mdb->totvert; b++) {
-					if (mdb->inside[b]) {
-						copy_v3_v3(vec, mdb->vertexcos[b]);
-						gridvec[0] = (vec[0] - mdb->min[0] - mdb->halfwidth[0]) / mdb->width[0];
-						gridvec[1] = (vec[1] - mdb->min[1] - mdb->halfwidth[1]) / mdb->width[1];
-						gridvec[2] = (vec[2] - mdb->min[2] - mdb->halfwidth[2]) / mdb->width[2];
-
-						mdb->weights[b * mdb->totcagevert + a] = meshdeform_interp_w(mdb, gridvec, vec, a);
-					}
-				}
+				MeshDeformWeightsData data = {mdb, a};
+
+				BLI_task_parallel_range_ex(0, mdb->totvert, &data, NULL, 0, meshdeform_matrix_weights_task,
+				                           mdb->totvert > 1000, false);
 			}
 			else {
 				MDefBindInfluence *inf;
@@ -1488,8 +1530,8 @@ static void harmonic_coordinates_bind(Scene *UNUSED(scene), MeshDeformModifierDa
 	MDefBindInfluence *inf;
 	MDefInfluence *mdinf;
 	MDefCell *cell;
-	float center[3], vec[3], maxwidth, totweight;
-	int a, b, x, y, z, totinside, offset;
+	float center[3], maxwidth, totweight;
+	int a, b, x, y, z, offset;
 
 	/* compute bounding box of the cage mesh */
 	INIT_MINMAX(mdb->min, mdb->max);
@@ -1515,6 +1557,7 @@ static void harmonic_coordinates_bind(Scene *UNUSED(scene), MeshDeformModifierDa
 
 	mdb->memarena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, "harmonic coords arena");
 	BLI_memarena_use_calloc(mdb->memarena);
+	BLI_mutex_init(&mdb->memarena_lock);
 
 	/* initialize data from 'cagedm' for reuse */
 	{
@@ -1547,27 +1590,16 @@ static void harmonic_coordinates_bind(Scene *UNUSED(scene), MeshDeformModifierDa
 
 	progress_bar(0, "Setting up mesh deform system");
 
-	totinside = 0;
-	for (a = 0; a < mdb->totvert; a++) {
-		copy_v3_v3(vec, mdb->vertexcos[a]);
-		mdb->inside[a] = meshdeform_inside_cage(mdb, vec);
-		if (mdb->inside[a])
-			totinside++;
-	}
-
-	/* free temporary MDefBoundIsects */
-	BLI_memarena_free(mdb->memarena);
-	mdb->memarena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, "harmonic coords arena");
+	BLI_task_parallel_range_ex(0, mdb->totvert, mdb, NULL, 0, meshdeform_inside_cage_task,
+	                           mdb->totvert > 1000, false);
 
 	/* start with all cells untyped */
 	for (a = 0; a < mdb->size3; a++)
 		mdb->tag[a] = MESHDEFORM_TAG_UNTYPED;
 	
 	/* detect intersections and tag boundary cells */
-	for (z = 0; z < mdb->size; z++)
-		for (y = 0; y < mdb->size; y++)
-			for (x = 0; x < mdb->size; x++)
-				meshdeform_add_intersections(mdb, x, y, z);
+	BLI_task_parallel_range_ex(0, mdb->size, mdb, NULL, 0, meshdeform_add_intersections_task,
+	                           true, true);
 
 	/* compute exterior and interior tags */
 	meshdeform_bind_floodfill(mdb);
@@ -1630,6 +1662,7 @@ static void harmonic_coordinates_bind(Scene *UNUSED(scene), MeshDeformModifierDa
 	MEM_freeN(mdb->boundisect);
 	MEM_freeN(mdb->semibound);
 	BLI_memarena_free(mdb->memarena);
+	BLI_mutex_end(&mdb->memarena_lock);
 	free_bvhtree_from_mesh(&mdb->bvhdata);
 }
 
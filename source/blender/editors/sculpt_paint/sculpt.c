@@ -252,6 +252,7 @@ typedef struct StrokeCache {
 	float anchored_location[3];
 
 	float vertex_rotation; /* amount to rotate the vertices when using rotate brush */
+	float curve_table[BRUSH_CURVE_TABLE_SIZE + 1]; /* brush falloff curve, sampled at stroke start */
 	Dial *dial;
 	
 	char saved_active_brush_name[MAX_ID_NAME];
@@ -1234,7 +1235,7 @@ static float tex_strength(SculptSession *ss, Brush *br,
 	}
 
 	/* Falloff curve */
-	avg *= BKE_brush_curve_strength(br, len, cache->radius);
+	avg *= BKE_brush_curve_strength_table_lookup(cache->curve_table, len, cache->radius);
 
 	avg *= frontface(br, cache->view_normal, vno, fno);
 
@@ -3914,6 +3915,9 @@ static void sculpt_update_cache_invariants(bContext *C, Sculpt *sd, SculptSessio
 
 	cache->brush = brush;
 
+	/* the falloff curve doesn't change during the stroke, avoids evaluating the curve mapping per vertex */
+	BKE_brush_curve_strength_table(brush, cache->curve_table);
+
 	/* cache projection matrix */
 	ED_view3d_ob_project_mat_get(cache->vc->rv3d, ob, cache->projection_mat);
 
@@ -145,9 +145,17 @@ typedef struct LatticeModifierData {
 	struct Object *object;
 	char name[64];          /* optional vertexgroup name, MAX_VGROUP_NAME */
 	float strength;
-	char pad[4];
+	short flag;
+	char pad[2];
+
+	struct LatticeDeformBind *bind;  /* runtime only, cached lattice cell weights */
 } LatticeModifierData;
 
+/* Lattice modifier flags */
+enum {
+	MOD_LATTICE_BIND_CACHE = (1 << 0),
+};
+
 typedef struct CurveModifierData {
 	ModifierData modifier;
 
@@ -446,6 +454,7 @@ enum {
 	MOD_DECIM_FLAG_TRIANGULATE         = (1 << 1),  /* for collapse only. dont convert tri pairs back to quads */
 	MOD_DECIM_FLAG_ALL_BOUNDARY_VERTS  = (1 << 2),  /* for dissolve only. collapse all verts between 2 faces */
 	MOD_DECIM_FLAG_SYMMETRY            = (1 << 3),
+	MOD_DECIM_FLAG_PARALLEL            = (1 << 4),  /* for collapse only. collapse independent edges in batches */
 };
 
 enum {
@@ -770,6 +779,8 @@ typedef struct MultiresModifierData {
 
 	char lvl, sculptlvl, renderlvl, totlvl;
 	char simple, flags, pad[2];
+
+	void *subdiv_cache;  /* runtime only, subdivided base mesh kept between evaluations */
 } MultiresModifierData;
 
 typedef enum {
@@ -803,6 +814,8 @@ typedef struct ShrinkwrapModifierData {
 	char subsurfLevels;
 
 	char pad[2];
+
+	struct ShrinkwrapTreeCache *cache;  /* runtime only, target tree refitted between evaluations */
 } ShrinkwrapModifierData;
 
 /* Shrinkwrap->shrinkType */
@@ -279,6 +279,9 @@ typedef struct Object {
 	/* Runtime valuated curve-specific data, not stored in the file */
 	struct CurveCache *curve_cache;
 
+	/* Runtime cache of intermediate modifier stack results, not stored in the file */
+	struct ModifierStackCache *modifier_cache;
+
 	struct DerivedMesh *derivedDeform, *derivedFinal;
 	uint64_t lastDataMask;   /* the custom data layer mask that was last used to calculate derivedDeform and derivedFinal */
 	uint64_t customdata_mask; /* (extra) custom data layer mask to use for creating derivedmesh, set by depsgraph */
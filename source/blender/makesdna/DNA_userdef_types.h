@@ -566,7 +566,8 @@ typedef struct UserDef {
 	struct WalkNavigation walk_navigation;
 
 	short opensubdiv_compute_type;
-	char pad5[6];
+	short pad5;
+	int modifier_cache_limit;	/* memory limit of intermediate modifier results in megabytes, 0 disables */
 } UserDef;
 
 extern UserDef U; /* from blenkernel blender.c */
@@ -266,6 +266,7 @@ EnumPropertyItem rna_enum_dt_layers_select_dst_items[] = {
 #include "BKE_depsgraph.h"
 #include "BKE_library.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_object.h"
 #include "BKE_particle.h"
 
@@ -422,6 +423,7 @@ static char *rna_Modifier_path(PointerRNA *ptr)
 
 static void rna_Modifier_update(Main *UNUSED(bmain), Scene *UNUSED(scene), PointerRNA *ptr)
 {
+	BKE_modifier_cache_tag_modifier(ptr->id.data, ptr->data);
 	DAG_id_tag_update(ptr->id.data, OB_RECALC_DATA);
 	WM_main_add_notifier(NC_OBJECT | ND_MODIFIER, ptr->id.data);
 }
@@ -1342,6 +1344,13 @@ static void rna_def_modifier_lattice(BlenderRNA *brna)
 	RNA_def_property_ui_range(prop, 0, 1, 10, 2);
 	RNA_def_property_ui_text(prop, "Strength", "Strength of modifier effect");
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+	prop = RNA_def_property(srna, "use_bind_cache", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_LATTICE_BIND_CACHE);
+	RNA_def_property_ui_text(prop, "Cache Binding",
+	                         "Keep the lattice cell weights of every vertex until the lattice resolution or "
+	                         "the input coordinates change, faster for animated lattices at the cost of memory");
+	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 }
 
 static void rna_def_modifier_curve(BlenderRNA *brna)
@@ -1550,6 +1559,13 @@ static void rna_def_modifier_decimate(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Triangulate", "Keep triangulated faces resulting from decimation (collapse only)");
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+	prop = RNA_def_property(srna, "use_collapse_parallel", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_PARALLEL);
+	RNA_def_property_ui_text(prop, "Parallel",
+	                         "Collapse batches of independent edges using multiple threads, faster on dense meshes "
+	                         "but the result differs slightly (collapse only, not used with symmetry)");
+	RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
 	prop = RNA_def_property(srna, "use_symmetry", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_SYMMETRY);
 	RNA_def_property_ui_text(prop, "Symmetry", "Maintain symmetry on an axis");
@@ -81,6 +81,7 @@ EnumPropertyItem rna_enum_render_pass_debug_type_items[] = {
 	{RENDER_PASS_DEBUG_BVH_TRAVERSAL_STEPS, "BVH_TRAVERSAL_STEPS", 0, "BVH Traversal Steps", ""},
 	{RENDER_PASS_DEBUG_BVH_TRAVERSED_INSTANCES, "BVH_TRAVERSED_INSTANCES", 0, "BVH Traversed Instances", ""},
 	{RENDER_PASS_DEBUG_RAY_BOUNCES, "RAY_BOUNCES", 0, "Ray Steps", ""},
+	{RENDER_PASS_DEBUG_SAMPLE_COUNT, "SAMPLE_COUNT", 0, "Sample Count", ""},
 	{0, NULL, 0, NULL, NULL}
 };
 
@@ -499,6 +500,16 @@ static void rna_def_render_engine(BlenderRNA *brna)
 	RNA_def_boolean(func, "cancel", 0, "Cancel", "Don't mark tile as done, don't merge results unless forced");
 	RNA_def_boolean(func, "do_merge_results", 0, "Merge Results", "Merge results even if cancel=true");
 
+	func = RNA_def_function(srna, "add_pass", "RE_engine_add_pass");
+	RNA_def_function_ui_description(func, "Add a named pass to the render layers, before beginning results to write it");
+	prop = RNA_def_string(func, "name", NULL, 0, "Name", "Name of the pass");
+	RNA_def_property_flag(prop, PROP_REQUIRED);
+	prop = RNA_def_int(func, "channels", 0, 1, 7, "Channels", "Number of channels", 1, 7);
+	RNA_def_property_flag(prop, PROP_REQUIRED);
+	prop = RNA_def_string(func, "chan_id", NULL, 0, "Channel IDs", "Name of every channel, one character each");
+	RNA_def_property_flag(prop, PROP_REQUIRED);
+	RNA_def_string(func, "layer", NULL, 0, "Layer", "Single layer to add the pass to");  /* NULL ok here */
+
 	func = RNA_def_function(srna, "test_break", "RE_engine_test_break");
 	RNA_def_function_ui_description(func, "Test if the render operation should been canceled, this is a fast call that should be used regularly for responsiveness");
 	prop = RNA_def_boolean(func, "do_break", 0, "Break", "");
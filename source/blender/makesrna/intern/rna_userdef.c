@@ -103,6 +103,7 @@ EnumPropertyItem rna_enum_navigation_mode_items[] = {
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
 #include "BKE_main.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_idprop.h"
 #include "BKE_pbvh.h"
 #include "BKE_paint.h"
@@ -353,6 +354,12 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain), Scene *UNUSED(scene
 	MEM_CacheLimiter_set_maximum(((size_t) U.memcachelimit) * 1024 * 1024);
 }
 
+static void rna_Userdef_modifier_cache_update(Main *bmain, Scene *UNUSED(scene), PointerRNA *UNUSED(ptr))
+{
+	BKE_modifier_cache_free_all(bmain);
+	BKE_modifier_cache_set_limit(((size_t) U.modifier_cache_limit) * 1024 * 1024);
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	Object *ob;
@@ -4107,6 +4114,14 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "modifier_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "modifier_cache_limit");
+	RNA_def_property_range(prop, 0, (sizeof(void *) == 8) ? 1024 * 32 : 1024); /* 32 bit 2 GB, 64 bit 32 GB */
+	RNA_def_property_ui_text(prop, "Modifier Cache Limit",
+	                         "Memory limit for intermediate modifier stack results, reused when only later "
+	                         "modifiers change (in megabytes, 0 to disable)");
+	RNA_def_property_update(prop, 0, "rna_Userdef_modifier_cache_update");
+
 	prop = RNA_def_property(srna, "frame_server_port", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "frameserverport");
 	RNA_def_property_range(prop, 0, 32727);
@@ -56,12 +56,21 @@ static void initData(ModifierData *md)
 
 static void copyData(ModifierData *md, ModifierData *target)
 {
-#if 0
-	LatticeModifierData *lmd = (LatticeModifierData *) md;
 	LatticeModifierData *tlmd = (LatticeModifierData *) target;
-#endif
 
 	modifier_copyData_generic(md, target);
+
+	tlmd->bind = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	LatticeModifierData *lmd = (LatticeModifierData *) md;
+
+	if (lmd->bind) {
+		BKE_lattice_deform_bind_free(lmd->bind);
+		lmd->bind = NULL;
+	}
 }
 
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
@@ -125,15 +134,26 @@ static void deformVerts(ModifierData *md, Object *ob,
                         DerivedMesh *derivedData,
                         float (*vertexCos)[3],
                         int numVerts,
-                        ModifierApplyFlag UNUSED(flag))
+                        ModifierApplyFlag flag)
 {
 	LatticeModifierData *lmd = (LatticeModifierData *) md;
-
+	struct LatticeDeformBind *bind = NULL;
 
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
-	
-	lattice_deform_verts(lmd->object, ob, derivedData,
-	                     vertexCos, numVerts, lmd->name, lmd->strength);
+
+	/* render evaluation may run alongside the viewport, leave the binding to the latter */
+	if ((lmd->flag & MOD_LATTICE_BIND_CACHE) && !(flag & MOD_APPLY_RENDER)) {
+		if (lmd->bind == NULL) {
+			lmd->bind = BKE_lattice_deform_bind_new();
+		}
+		bind = lmd->bind;
+	}
+	else if (lmd->bind && !(flag & MOD_APPLY_RENDER)) {
+		freeData(md);
+	}
+
+	lattice_deform_verts_ex(lmd->object, ob, derivedData,
+	                        vertexCos, numVerts, lmd->name, lmd->strength, bind);
 }
 
 static void deformVertsEM(
@@ -166,7 +186,7 @@ ModifierTypeInfo modifierType_Lattice = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  requiredDataMask,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        isDisabled,
 	/* updateDepgraph */    updateDepgraph,
 	/* updateDepsgraph */   updateDepsgraph,
@@ -270,14 +270,26 @@ static void meshdeform_vert_task(void *userdata, void *UNUSED(userdata_chunck),
 	}
 	else {
 		int a;
+#ifdef __SSE2__
+		__m128 co_r = _mm_setzero_ps();
+#endif
 		totweight = 0.0f;
 		zero_v3(co);
 
 		for (a = offsets[iter]; a < offsets[iter + 1]; a++) {
 			weight = influences[a].weight;
+#ifdef __SSE2__
+			/* same as the dynamic bind, 'dco' has one extra element to load float4 from */
+			co_r = _mm_add_ps(co_r, _mm_mul_ps(_mm_loadu_ps(dco[influences[a].vertex]), _mm_set1_ps(weight)));
+#else
 			madd_v3_v3fl(co, dco[influences[a].vertex], weight);
+#endif
 			totweight += weight;
 		}
+
+#ifdef __SSE2__
+		copy_v3_v3(co, (float *)&co_r);
+#endif
 	}
 
 	if (totweight > 0.0f) {
@@ -413,7 +425,8 @@ static void meshdeformModifier_do(
 	data.icagemat = icagemat;
 
 	/* Do deformation. */
-	BLI_task_parallel_range(0, totvert, &data, meshdeform_vert_task);
+	BLI_task_parallel_range_ex(0, totvert, &data, NULL, 0, meshdeform_vert_task,
+	                           totvert > 1000, false);
 
 	/* release cage derivedmesh */
 	MEM_freeN(dco);
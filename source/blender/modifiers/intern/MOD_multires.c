@@ -58,11 +58,18 @@ static void initData(ModifierData *md)
 
 static void copyData(ModifierData *md, ModifierData *target)
 {
-#if 0
-	MultiresModifierData *mmd = (MultiresModifierData *) md;
 	MultiresModifierData *tmmd = (MultiresModifierData *) target;
-#endif
+
 	modifier_copyData_generic(md, target);
+
+	tmmd->subdiv_cache = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	MultiresModifierData *mmd = (MultiresModifierData *) md;
+
+	multires_subdiv_cache_free(mmd);
 }
 
 static DerivedMesh *applyModifier(ModifierData *md, Object *ob, DerivedMesh *dm,
@@ -92,6 +99,9 @@ static DerivedMesh *applyModifier(ModifierData *md, Object *ob, DerivedMesh *dm,
 	if (ignore_simplify)
 		flags |= MULTIRES_IGNORE_SIMPLIFY;
 
+	if (flag & MOD_APPLY_USECACHE)
+		flags |= MULTIRES_IS_FINAL_CALC;
+
 	result = multires_make_derived_from_derived(dm, mmd, ob, flags);
 
 	if (result == dm)
@@ -159,7 +169,7 @@ ModifierTypeInfo modifierType_Multires = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  NULL,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        NULL,
 	/* updateDepgraph */    NULL,
 	/* updateDepsgraph */   NULL,
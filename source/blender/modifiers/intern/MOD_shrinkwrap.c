@@ -65,11 +65,21 @@ static void initData(ModifierData *md)
 
 static void copyData(ModifierData *md, ModifierData *target)
 {
-#if 0
-	ShrinkwrapModifierData *smd  = (ShrinkwrapModifierData *)md;
 	ShrinkwrapModifierData *tsmd = (ShrinkwrapModifierData *)target;
-#endif
+
 	modifier_copyData_generic(md, target);
+
+	tsmd->cache = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	ShrinkwrapModifierData *smd = (ShrinkwrapModifierData *)md;
+
+	if (smd->cache) {
+		BKE_shrinkwrap_tree_cache_free(smd->cache);
+		smd->cache = NULL;
+	}
 }
 
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
@@ -206,7 +216,7 @@ ModifierTypeInfo modifierType_Shrinkwrap = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  requiredDataMask,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        isDisabled,
 	/* updateDepgraph */    updateDepgraph,
 	/* updateDepsgraph */   updateDepsgraph,
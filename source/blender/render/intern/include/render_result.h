@@ -63,6 +63,11 @@ struct RenderResult *render_result_new_from_exr(void *exrhandle, const char *col
 void render_result_view_new(struct RenderResult *rr, const char *viewname);
 void render_result_views_new(struct RenderResult *rr, struct RenderData *rd);
 
+void render_result_add_pass(
+        struct RenderResult *rr, const char *name, int channels, const char *chan_id,
+        const char *layername, const char *viewname);
+void render_result_clone_passes(struct Render *re, struct RenderResult *rr, const char *viewname);
+
 /* Merge */
 
 void render_result_merge(struct RenderResult *rr, struct RenderResult *rrpart);
@@ -214,6 +214,9 @@ RenderResult *RE_engine_begin_result(RenderEngine *engine, int x, int y, int w,
 	if (result) {
 		RenderPart *pa;
 
+		/* passes added by the engine, render_result_new() only adds the ones from the layer settings */
+		render_result_clone_passes(re, result, viewname);
+
 		/* Copy EXR tile settings, so pipeline knows whether this is a result
 		 * for Save Buffers enabled rendering.
 		 */
@@ -289,6 +292,27 @@ void RE_engine_end_result(RenderEngine *engine, RenderResult *result, int cancel
 	render_result_free(result);
 }
 
+/**
+ * Add a pass without a pass type to \a layername, or to all layers when NULL,
+ * written to by the engine like other passes of the render results it begins after this.
+ */
+void RE_engine_add_pass(RenderEngine *engine, const char *name, int channels, const char *chan_id, const char *layername)
+{
+	Render *re = engine->re;
+
+	if (!re || !re->result || name[0] == '\0') {
+		return;
+	}
+
+	if (channels < 1 || channels > (int)strlen(chan_id)) {
+		return;
+	}
+
+	BLI_rw_mutex_lock(&re->resultmutex, THREAD_LOCK_WRITE);
+	render_result_add_pass(re->result, name, channels, chan_id, layername, NULL);
+	BLI_rw_mutex_unlock(&re->resultmutex);
+}
+
 /* Cancel */
 
 int RE_engine_test_break(RenderEngine *engine)
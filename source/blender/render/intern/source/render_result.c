@@ -457,15 +457,13 @@ static int passtype_from_name(const char *str)
 }
 
 
-static void set_pass_name(char *passname, int passtype, int channel, const char *view)
+static void set_pass_name_ex(char *passname, const char *passtype_name, const char *view)
 {
 	const char delims[] = {'.', '\0'};
 	const char *sep;
 	const char *token;
 	size_t len;
 
-	const char *passtype_name = name_from_passtype(passtype, channel);
-
 	if (view == NULL || view[0] == '\0') {
 		BLI_strncpy(passname, passtype_name, EXR_PASS_MAXNAME);
 		return;
@@ -481,6 +479,31 @@ static void set_pass_name(char *passname, int passtype, int channel, const char
 	}
 }
 
+static void set_pass_name(char *passname, int passtype, int channel, const char *view)
+{
+	set_pass_name_ex(passname, name_from_passtype(passtype, channel), view);
+}
+
+/* Name of a channel of \a rpass, or of the pass itself for channel -1,
+ * also for named passes which have no pass type. */
+static void set_render_pass_name(char *passname, const RenderPass *rpass, int channel)
+{
+	if (rpass->passtype == 0 && rpass->internal_name[0]) {
+		char name[EXR_PASS_MAXNAME];
+
+		if (channel == -1) {
+			BLI_strncpy(name, rpass->internal_name, sizeof(name));
+		}
+		else {
+			BLI_snprintf(name, sizeof(name), "%s.%c", rpass->internal_name, rpass->chan_id[channel]);
+		}
+		set_pass_name_ex(passname, name, rpass->view);
+	}
+	else {
+		set_pass_name(passname, rpass->passtype, channel, rpass->view);
+	}
+}
+
 /********************************** New **************************************/
 
 static RenderPass *render_layer_add_pass(RenderResult *rr, RenderLayer *rl, int channels, int passtype, const char *viewname)
@@ -527,6 +550,118 @@ static RenderPass *render_layer_add_pass(RenderResult *rr, RenderLayer *rl, int
 	return rpass;
 }
 
+/* Pass without a pass type, identified by its name. */
+static RenderPass *render_layer_add_named_pass(
+        RenderResult *rr, RenderLayer *rl, int channels,
+        const char *name, const char *chan_id, const char *viewname)
+{
+	const int view_id = BLI_findstringindex(&rr->views, viewname, offsetof(RenderView, name));
+	RenderPass *rpass = MEM_callocN(sizeof(RenderPass), "RenderPass named");
+	size_t rectsize = ((size_t)rr->rectx) * rr->recty * channels;
+
+	BLI_addtail(&rl->passes, rpass);
+	rpass->passtype = 0;
+	rpass->channels = channels;
+	rpass->rectx = rl->rectx;
+	rpass->recty = rl->recty;
+	rpass->view_id = view_id;
+
+	BLI_strncpy(rpass->internal_name, name, sizeof(rpass->internal_name));
+	BLI_strncpy(rpass->chan_id, chan_id, sizeof(rpass->chan_id));
+	BLI_strncpy(rpass->view, viewname, sizeof(rpass->view));
+	set_render_pass_name(rpass->name, rpass, -1);
+
+	if (rl->exrhandle) {
+		int a;
+		for (a = 0; a < channels; a++) {
+			char passname[EXR_PASS_MAXNAME];
+			BLI_snprintf(passname, sizeof(passname), "%s.%c", name, chan_id[a]);
+			IMB_exr_add_channel(rl->exrhandle, rl->name, passname, viewname, 0, 0, NULL, false);
+		}
+	}
+	else {
+		rpass->rect = MEM_mapallocN(sizeof(float) * rectsize, "RenderPass named rect");
+	}
+
+	return rpass;
+}
+
+static RenderPass *render_layer_find_named_pass(RenderLayer *rl, const char *name, const char *viewname)
+{
+	RenderPass *rpass;
+
+	for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
+		if (rpass->passtype == 0 && STREQ(rpass->internal_name, name) && STREQ(rpass->view, viewname)) {
+			return rpass;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a named pass to the layers of \a rr, for data render engines write that has no pass type.
+ *
+ * \param chan_id: Name of every channel, one character each.
+ * \param layername: Layer to add the pass to, all layers when NULL or empty.
+ * \param viewname: View to add the pass for, all views when NULL or empty.
+ */
+void render_result_add_pass(
+        RenderResult *rr, const char *name, int channels, const char *chan_id,
+        const char *layername, const char *viewname)
+{
+	RenderLayer *rl;
+	RenderView *rv;
+
+	for (rl = rr->layers.first; rl; rl = rl->next) {
+		if (layername && layername[0] && !STREQ(rl->name, layername)) {
+			continue;
+		}
+
+		for (rv = rr->views.first; rv; rv = rv->next) {
+			const char *view = rv->name;
+
+			if (viewname && viewname[0] && !STREQ(view, viewname)) {
+				continue;
+			}
+
+			if (render_layer_find_named_pass(rl, name, view) == NULL) {
+				render_layer_add_named_pass(rr, rl, channels, name, chan_id, view);
+			}
+		}
+	}
+}
+
+/**
+ * Add the named passes of the render result of \a re to the tile result \a rr,
+ * which only gets the passes enabled in the layer settings on creation.
+ */
+void render_result_clone_passes(Render *re, RenderResult *rr, const char *viewname)
+{
+	RenderLayer *rl, *rl_tile;
+	RenderPass *rpass;
+
+	for (rl = re->result->layers.first; rl; rl = rl->next) {
+		rl_tile = RE_GetRenderLayer(rr, rl->name);
+		if (rl_tile == NULL) {
+			continue;
+		}
+
+		for (rpass = rl->passes.first; rpass; rpass = rpass->next) {
+			if (rpass->passtype != 0 || rpass->internal_name[0] == '\0') {
+				continue;
+			}
+			if (viewname && viewname[0] && !STREQ(rpass->view, viewname)) {
+				continue;
+			}
+			if (render_layer_find_named_pass(rl_tile, rpass->internal_name, rpass->view) == NULL) {
+				render_layer_add_named_pass(rr, rl_tile, rpass->channels, rpass->internal_name,
+				                            rpass->chan_id, rpass->view);
+			}
+		}
+	}
+}
+
 #ifdef WITH_CYCLES_DEBUG
 const char *RE_debug_pass_name_get(int debug_type)
 {
@@ -537,6 +672,8 @@ const char *RE_debug_pass_name_get(int debug_type)
 			return "BVH Traversed Instances";
 		case RENDER_PASS_DEBUG_RAY_BOUNCES:
 			return "Ray Bounces";
+		case RENDER_PASS_DEBUG_SAMPLE_COUNT:
+			return "Sample Count";
 	}
 	return "Unknown";
 }
@@ -1238,7 +1375,7 @@ static void save_render_result_tile(RenderResult *rr, RenderResult *rrpart, cons
 			char passname[EXR_PASS_MAXNAME];
 
 			for (a = 0; a < xstride; a++) {
-				set_pass_name(passname, rpassp->passtype, a, rpassp->view);
+				set_render_pass_name(passname, rpassp, a);
 
 				IMB_exr_set_channel(rl->exrhandle, rlp->name, passname,
 				                    xstride, xstride * rrpart->rectx, rpassp->rect + a + xstride * offs);
@@ -1406,12 +1543,12 @@ int render_result_exr_file_read_path(RenderResult *rr, RenderLayer *rl_single, c
 			char passname[EXR_PASS_MAXNAME];
 
 			for (a = 0; a < xstride; a++) {
-				set_pass_name(passname, rpass->passtype, a, rpass->view);
+				set_render_pass_name(passname, rpass, a);
 				IMB_exr_set_channel(exrhandle, rl->name, passname,
 				                    xstride, xstride * rectx, rpass->rect + a);
 			}
 
-			set_pass_name(rpass->name, rpass->passtype, -1, rpass->view);
+			set_render_pass_name(rpass->name, rpass, -1);
 		}
 	}
 
@@ -62,6 +62,7 @@
 #include "BKE_library.h"
 #include "BKE_main.h"
 #include "BKE_mball_tessellate.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_node.h"
 #include "BKE_report.h"
 
@@ -490,6 +491,10 @@ void WM_exit_ext(bContext *C, const bool do_python)
 	free_openrecent();
 	
 	BKE_mball_cubeTable_free();
+
+	if ((G.debug & G_DEBUG) && BKE_modifier_cache_get_limit() != 0) {
+		BKE_modifier_cache_stats_print();
+	}
 	
 	/* render code might still access databases */
 	RE_FreeAllRender();
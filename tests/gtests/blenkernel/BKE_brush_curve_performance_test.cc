@@ -0,0 +1,132 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "DNA_brush_types.h"
+#include "DNA_color_types.h"
+#include "DNA_scene_types.h"
+#include "BKE_brush.h"
+#include "BKE_colortools.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Timing of the brush falloff evaluation, replaying a scripted stroke of "draw" dabs over a grid
+ * of about 10M vertices: evaluating the brush curve mapping per vertex (#BKE_brush_curve_strength)
+ * against the table sculpt mode samples at stroke start (#BKE_brush_curve_strength_table_lookup). */
+
+#define GRID_RES 3163  /* GRID_RES * GRID_RES ~= 10M vertices */
+#define DAB_TOT 200
+#define DAB_RADIUS 0.05f
+#define DAB_STRENGTH 0.01f
+
+typedef float (*FalloffFn)(Brush *br, const float *table, const float dist, const float radius);
+
+static float falloff_curve(Brush *br, const float *UNUSED(table), const float dist, const float radius)
+{
+	return BKE_brush_curve_strength(br, dist, radius);
+}
+
+static float falloff_table(Brush *UNUSED(br), const float *table, const float dist, const float radius)
+{
+	return BKE_brush_curve_strength_table_lookup(table, dist, radius);
+}
+
+static float (*grid_new(void))[3]
+{
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * GRID_RES * GRID_RES, __func__);
+
+	for (int y = 0; y < GRID_RES; y++) {
+		for (int x = 0; x < GRID_RES; x++) {
+			float *v = co[y * GRID_RES + x];
+			v[0] = (float)x / (float)(GRID_RES - 1);
+			v[1] = (float)y / (float)(GRID_RES - 1);
+			v[2] = 0.0f;
+		}
+	}
+
+	return co;
+}
+
+/* Displaces the vertices in each dab by the brush falloff, only visiting the vertices
+ * in the dab bounds (as the PBVH node search does for sculpt). */
+static void stroke_replay(
+        Brush *br, const float *table, FalloffFn falloff,
+        const float (*co)[3], float *r_disp)
+{
+	for (int dab = 0; dab < DAB_TOT; dab++) {
+		/* a wavy stroke across the grid */
+		const float t = (float)dab / (float)DAB_TOT;
+		const float center[3] = {0.1f + 0.8f * t, 0.5f + 0.3f * sinf(t * (float)M_PI * 4.0f), 0.0f};
+		const int x_min = max_ii(0, (int)((center[0] - DAB_RADIUS) * (GRID_RES - 1)));
+		const int x_max = min_ii(GRID_RES - 1, (int)((center[0] + DAB_RADIUS) * (GRID_RES - 1)) + 1);
+		const int y_min = max_ii(0, (int)((center[1] - DAB_RADIUS) * (GRID_RES - 1)));
+		const int y_max = min_ii(GRID_RES - 1, (int)((center[1] + DAB_RADIUS) * (GRID_RES - 1)) + 1);
+
+		for (int y = y_min; y <= y_max; y++) {
+			for (int x = x_min; x <= x_max; x++) {
+				const int i = y * GRID_RES + x;
+				const float dist_sq = len_squared_v3v3(co[i], center);
+
+				if (dist_sq < DAB_RADIUS * DAB_RADIUS) {
+					r_disp[i] += DAB_STRENGTH * falloff(br, table, sqrtf(dist_sq), DAB_RADIUS);
+				}
+			}
+		}
+	}
+}
+
+static void brush_curve_test(const int preset)
+{
+	Brush brush;
+	float table[BRUSH_CURVE_TABLE_SIZE + 1];
+	float (*co)[3];
+	float *disp_curve, *disp_table;
+	float max_error = 0.0f;
+
+	memset(&brush, 0, sizeof(brush));
+	BKE_brush_curve_preset(&brush, preset);
+	curvemapping_initialize(brush.curve);
+
+	co = grid_new();
+	disp_curve = (float *)MEM_callocN(sizeof(float) * GRID_RES * GRID_RES, __func__);
+	disp_table = (float *)MEM_callocN(sizeof(float) * GRID_RES * GRID_RES, __func__);
+
+	{
+		TIMEIT_START(stroke_curve);
+		stroke_replay(&brush, NULL, falloff_curve, co, disp_curve);
+		TIMEIT_END(stroke_curve);
+	}
+
+	{
+		TIMEIT_START(stroke_table);
+		BKE_brush_curve_strength_table(&brush, table);
+		stroke_replay(&brush, table, falloff_table, co, disp_table);
+		TIMEIT_END(stroke_table);
+	}
+
+	/* the table only differs from the curve mapping by interpolation error */
+	for (int i = 0; i < GRID_RES * GRID_RES; i++) {
+		max_error = max_ff(max_error, fabsf(disp_curve[i] - disp_table[i]));
+	}
+	printf("Max displacement error: %g\n", max_error);
+	EXPECT_LT(max_error, DAB_STRENGTH * DAB_TOT * 1e-4f);
+
+	MEM_freeN(disp_table);
+	MEM_freeN(disp_curve);
+	MEM_freeN(co);
+	curvemapping_free(brush.curve);
+}
+
+TEST(brush_curve, StrokeSmooth)
+{
+	brush_curve_test(CURVE_PRESET_SMOOTH);
+}
+
+TEST(brush_curve, StrokeSharp)
+{
+	brush_curve_test(CURVE_PRESET_SHARP);
+}
@@ -0,0 +1,132 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_object_types.h"
+#include "DNA_meta_types.h"
+#include "DNA_scene_types.h"
+#include "BKE_depsgraph.h"
+#include "BKE_displist.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mball.h"
+#include "BKE_mball_tessellate.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+#include "PIL_time.h"
+}
+
+/* Time and memory of the polygonization of a block of overlapping balls,
+ * at the resolutions of the viewport and of a final render. The vertices
+ * evaluated in threads must be the same as the serially evaluated ones. */
+
+#define BALLS_RES 6
+
+static void mball_tessellate_run(
+        Scene *scene, Object *ob, const bool serial, ListBase *r_dispbase)
+{
+	EvaluationContext eval_ctx = {DAG_EVAL_RENDER};
+	size_t mem_start;
+	double time_start, time_polygonize;
+	int totvert = 0, totface = 0;
+
+	testing_threads_serial_set(serial);
+
+	mem_start = MEM_get_memory_in_use();
+	MEM_reset_peak_memory();
+	time_start = PIL_check_seconds_timer();
+
+	BKE_mball_polygonize(&eval_ctx, scene, ob, r_dispbase);
+
+	time_polygonize = PIL_check_seconds_timer() - time_start;
+
+	for (DispList *dl = (DispList *)r_dispbase->first; dl; dl = dl->next) {
+		totvert += dl->nr;
+		totface += dl->parts;
+	}
+
+	printf("%s: vertices: %d, faces: %d, time: %.6f, memory: %.2f MB (peak %.2f MB)\n",
+	       serial ? "Serial" : "Threaded", totvert, totface,
+	       time_polygonize,
+	       (double)(MEM_get_memory_in_use() - mem_start) / (1024.0 * 1024.0),
+	       (double)(MEM_get_peak_memory() - mem_start) / (1024.0 * 1024.0));
+
+	EXPECT_GT(totface, 0);
+}
+
+static void mball_tessellate_test(const float resolution)
+{
+	ListBase dispbase_serial = {NULL, NULL};
+	ListBase dispbase = {NULL, NULL};
+	Main *bmain;
+	Scene *scene;
+	MetaBall *mb;
+	Object *ob;
+
+	BLI_threadapi_init();
+
+	bmain = BKE_main_new();
+
+	mb = BKE_mball_add(bmain, "Meta");
+	mb->rendersize = resolution;
+	for (int x = 0; x < BALLS_RES; x++) {
+		for (int y = 0; y < BALLS_RES; y++) {
+			for (int z = 0; z < BALLS_RES; z++) {
+				MetaElem *ml = BKE_mball_element_add(mb, MB_BALL);
+				ml->x = (float)x * 1.5f;
+				ml->y = (float)y * 1.5f;
+				ml->z = (float)z * 1.5f + 0.25f * sinf((float)(x + y));
+			}
+		}
+	}
+
+	ob = BKE_object_add_only_object(bmain, OB_MBALL, "Meta");
+	ob->data = mb;
+
+	/* only the bases are read, so no need for a fully initialized scene */
+	scene = (Scene *)MEM_callocN(sizeof(Scene), __func__);
+	BKE_scene_base_add(scene, ob);
+
+	printf("Balls: %d, resolution: %.3f\n", BLI_listbase_count(&mb->elems), resolution);
+
+	mball_tessellate_run(scene, ob, true, &dispbase_serial);
+	mball_tessellate_run(scene, ob, false, &dispbase);
+
+	EXPECT_EQ(BLI_listbase_count(&dispbase_serial), BLI_listbase_count(&dispbase));
+	for (DispList *dl_serial = (DispList *)dispbase_serial.first, *dl = (DispList *)dispbase.first;
+	     dl_serial && dl;
+	     dl_serial = dl_serial->next, dl = dl->next)
+	{
+		EXPECT_EQ(dl_serial->nr, dl->nr);
+		EXPECT_EQ(dl_serial->parts, dl->parts);
+		if (dl_serial->nr == dl->nr && dl_serial->parts == dl->parts) {
+			EXPECT_EQ(0, memcmp(dl_serial->verts, dl->verts, sizeof(float[3]) * dl->nr));
+			EXPECT_EQ(0, memcmp(dl_serial->nors, dl->nors, sizeof(float[3]) * dl->nr));
+			EXPECT_EQ(0, memcmp(dl_serial->index, dl->index, sizeof(int[4]) * dl->parts));
+		}
+	}
+
+	BKE_displist_free(&dispbase_serial);
+	BKE_displist_free(&dispbase);
+	BLI_freelistN(&scene->base);
+	MEM_freeN(scene);
+	BKE_main_free(bmain);
+	BKE_mball_cubeTable_free();
+}
+
+TEST(mball_tessellate, Viewport)
+{
+	mball_tessellate_test(0.1f);
+}
+
+TEST(mball_tessellate, Render)
+{
+	mball_tessellate_test(0.025f);
+}
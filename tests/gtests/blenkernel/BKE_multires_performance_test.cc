@@ -0,0 +1,181 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "BKE_ccg.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "BKE_subsurf.h"
+/* after BKE_subsurf.h, which defines MultiresModifiedFlags */
+#include "BKE_multires.h"
+#include "PIL_time.h"
+}
+
+/* Timing of the multires modifier evaluation over an animation playback, where each frame deforms
+ * part of the base mesh: evaluating the final derived mesh (which keeps the subdivided base mesh
+ * between frames) against subdividing from scratch each frame. Both must give the same grids,
+ * subdividing from scratch is done serially. */
+
+#define SPHERE_RES 48
+#define MULTIRES_LEVEL 4
+#define TOTFRAME 20
+
+typedef struct MultiresObject {
+	Main *bmain;
+	Object *ob;
+	Mesh *me;
+	MultiresModifierData *mmd;
+} MultiresObject;
+
+static void multires_object_init(MultiresObject *mob)
+{
+	const int side = (1 << (MULTIRES_LEVEL - 1)) + 1;
+	RNG *rng = BLI_rng_new(0);
+	MDisps *mdisps;
+
+	mob->bmain = BKE_main_new();
+	mob->me = testing_mesh_uvsphere_new(mob->bmain, SPHERE_RES, 1.0f);
+
+	mob->ob = BKE_object_add_only_object(mob->bmain, OB_MESH, "Multires");
+	mob->ob->data = mob->me;
+
+	mob->mmd = (MultiresModifierData *)modifier_new(eModifierType_Multires);
+	mob->mmd->lvl = mob->mmd->sculptlvl = mob->mmd->renderlvl = mob->mmd->totlvl = MULTIRES_LEVEL;
+	BLI_addtail(&mob->ob->modifiers, mob->mmd);
+
+	/* random displacements, in tangent space */
+	mdisps = (MDisps *)CustomData_add_layer(&mob->me->ldata, CD_MDISPS, CD_CALLOC, NULL, mob->me->totloop);
+	for (int i = 0; i < mob->me->totloop; i++) {
+		mdisps[i].totdisp = side * side;
+		mdisps[i].level = MULTIRES_LEVEL;
+		mdisps[i].disps = (float (*)[3])MEM_mallocN(sizeof(float[3]) * side * side, __func__);
+		for (int j = 0; j < side * side; j++) {
+			for (int k = 0; k < 3; k++) {
+				mdisps[i].disps[j][k] = (BLI_rng_get_float(rng) - 0.5f) * 0.02f;
+			}
+		}
+	}
+
+	BLI_rng_free(rng);
+}
+
+static void multires_object_free(MultiresObject *mob)
+{
+	/* frees the object modifiers and the mesh */
+	BKE_main_free(mob->bmain);
+}
+
+/* Playback deformation: bends the upper part of the sphere a little further each frame. */
+static void multires_object_deform(MultiresObject *mob, const int frame)
+{
+	const float angle = 0.01f * (float)frame;
+	MVert *mv = mob->me->mvert;
+
+	for (int i = 0; i < mob->me->totvert; i++, mv++) {
+		if (mv->co[2] > 0.25f) {
+			float rot[3][3];
+
+			axis_angle_to_mat3_single(rot, 'X', angle * (mv->co[2] - 0.25f));
+			mul_m3_v3(rot, mv->co);
+		}
+	}
+}
+
+static DerivedMesh *multires_object_eval(MultiresObject *mob, MultiresFlags flags, double *r_time)
+{
+	const double time_start = PIL_check_seconds_timer();
+	DerivedMesh *dm = CDDM_from_mesh(mob->me);
+	DerivedMesh *result = multires_make_derived_from_derived(dm, mob->mmd, mob->ob, flags);
+
+	dm->release(dm);
+	*r_time += PIL_check_seconds_timer() - time_start;
+
+	return result;
+}
+
+static float multires_grids_max_diff(DerivedMesh *dm_a, DerivedMesh *dm_b)
+{
+	CCGElem **grids_a = dm_a->getGridData(dm_a), **grids_b = dm_b->getGridData(dm_b);
+	const int totgrid = dm_a->getNumGrids(dm_a);
+	float max_diff = 0.0f;
+	CCGKey key;
+
+	dm_a->getGridKey(dm_a, &key);
+	EXPECT_EQ(totgrid, dm_b->getNumGrids(dm_b));
+
+	for (int i = 0; i < totgrid; i++) {
+		for (int j = 0; j < key.grid_area; j++) {
+			const float *co_a = CCG_elem_offset_co(&key, grids_a[i], j);
+			const float *co_b = CCG_elem_offset_co(&key, grids_b[i], j);
+
+			for (int k = 0; k < 3; k++) {
+				max_diff = max_ff(max_diff, fabsf(co_a[k] - co_b[k]));
+			}
+		}
+	}
+
+	return max_diff;
+}
+
+TEST(multires, Playback)
+{
+	MultiresObject mob;
+	DerivedMesh *dm_final = NULL;
+	double time_cached = 0.0, time_uncached = 0.0;
+	float max_diff = 0.0f;
+
+	BLI_threadapi_init();
+	BKE_modifier_init();
+
+	multires_object_init(&mob);
+	printf("Faces: %d, level: %d\n", mob.me->totpoly, MULTIRES_LEVEL);
+
+	for (int frame = 0; frame < TOTFRAME; frame++) {
+		DerivedMesh *dm_uncached;
+
+		/* first frames don't deform, as when playing back a still pose */
+		if (frame >= TOTFRAME / 2) {
+			multires_object_deform(&mob, frame);
+		}
+
+		/* the previous final derived mesh is freed before evaluating the new one */
+		if (dm_final) {
+			dm_final->release(dm_final);
+		}
+		testing_threads_serial_set(false);
+		dm_final = multires_object_eval(&mob, MULTIRES_IS_FINAL_CALC, &time_cached);
+		testing_threads_serial_set(true);
+		dm_uncached = multires_object_eval(&mob, (MultiresFlags)0, &time_uncached);
+
+		max_diff = max_ff(max_diff, multires_grids_max_diff(dm_final, dm_uncached));
+
+		dm_uncached->release(dm_uncached);
+	}
+
+	dm_final->release(dm_final);
+
+	printf("Cached: %.6f, uncached serial: %.6f\n", time_cached, time_uncached);
+	printf("Max grid difference: %g\n", max_diff);
+	EXPECT_LT(max_diff, 1e-5f);
+
+	multires_object_free(&mob);
+}
@@ -0,0 +1,236 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_ghash.h"
+#include "BLI_threads.h"
+#include "DNA_customdata_types.h"
+#include "BKE_customdata.h"
+#include "BKE_pbvh.h"
+#include "PIL_time.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "bmesh.h"
+
+extern "C" {
+#include "intern/bmesh_log.h"
+}
+
+/* Timing of dynamic topology sculpting, replaying a scripted stroke of "draw" dabs over an icosphere:
+ * each dab displaces the vertices in the brush, then subdivides/collapses edges and updates normals,
+ * the same steps sculpt mode does per dab. The stroke replayed with threads must give the same surface
+ * as replayed serially: edges of equal length are split in the order of the node's face sets
+ * (hashed by pointer), so even two serial strokes don't give identical meshes, only similar ones. */
+
+#define ICO_SUBDIV 5
+#define DAB_RADIUS 0.15f
+#define DAB_STRENGTH 0.02f
+#define DETAIL_SIZE_SMALL 0.04f
+#define DETAIL_SIZE_LARGE 0.01f
+
+typedef struct DyntopoStroke {
+	BMesh *bm;
+	BMLog *bm_log;
+	PBVH *pbvh;
+	int cd_vert_mask_offset;
+} DyntopoStroke;
+
+typedef struct DabSearchData {
+	const float *center;
+	float radius_squared;
+} DabSearchData;
+
+static bool dab_search_sphere_cb(PBVHNode *node, void *data_v)
+{
+	const DabSearchData *data = (const DabSearchData *)data_v;
+	float bb_min[3], bb_max[3], nearest[3];
+
+	BKE_pbvh_node_get_BB(node, bb_min, bb_max);
+	for (int i = 0; i < 3; i++) {
+		nearest[i] = max_ff(bb_min[i], min_ff(data->center[i], bb_max[i]));
+	}
+
+	return len_squared_v3v3(data->center, nearest) < data->radius_squared;
+}
+
+static void stroke_init(DyntopoStroke *stroke, const float detail_size)
+{
+	float mat[4][4];
+
+	unit_m4(mat);
+
+	stroke->bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	BMO_op_callf(stroke->bm, BMO_FLAG_DEFAULTS,
+	             "create_icosphere subdivisions=%i diameter=%f matrix=%m4 calc_uvs=%b",
+	             ICO_SUBDIV, 1.0f, mat, false);
+	BM_mesh_normals_update(stroke->bm);
+
+	/* same layers sculpt mode adds when enabling dynamic topology */
+	BM_data_layer_add(stroke->bm, &stroke->bm->vdata, CD_PAINT_MASK);
+	BM_data_layer_add(stroke->bm, &stroke->bm->vdata, CD_PROP_INT);
+	BM_data_layer_add(stroke->bm, &stroke->bm->pdata, CD_PROP_INT);
+	stroke->cd_vert_mask_offset = CustomData_get_offset(&stroke->bm->vdata, CD_PAINT_MASK);
+
+	stroke->bm_log = BM_log_create(stroke->bm);
+	BM_log_entry_add(stroke->bm_log);
+
+	stroke->pbvh = BKE_pbvh_new();
+	BKE_pbvh_build_bmesh(
+	        stroke->pbvh, stroke->bm, true, stroke->bm_log,
+	        CustomData_get_offset(&stroke->bm->vdata, CD_PROP_INT),
+	        CustomData_get_offset(&stroke->bm->pdata, CD_PROP_INT));
+	BKE_pbvh_bmesh_detail_size_set(stroke->pbvh, detail_size);
+}
+
+static void stroke_free(DyntopoStroke *stroke)
+{
+	BKE_pbvh_free(stroke->pbvh);
+	BM_log_free(stroke->bm_log);
+	BM_mesh_free(stroke->bm);
+}
+
+/* Draw brush: displace vertices along their normal, with a smooth falloff. */
+static void dab_displace(DyntopoStroke *stroke, PBVHNode **nodes, int totnode, const float center[3])
+{
+	for (int n = 0; n < totnode; n++) {
+		GSetIterator gs_iter;
+
+		GSET_ITER (gs_iter, BKE_pbvh_bmesh_node_unique_verts(nodes[n])) {
+			BMVert *v = (BMVert *)BLI_gsetIterator_getKey(&gs_iter);
+			const float dist = len_v3v3(v->co, center);
+
+			if (dist < DAB_RADIUS) {
+				const float fac = 1.0f - (dist / DAB_RADIUS);
+				BM_log_vert_before_modified(stroke->bm_log, v, stroke->cd_vert_mask_offset);
+				madd_v3_v3fl(v->co, v->no, DAB_STRENGTH * fac * fac);
+			}
+		}
+		BKE_pbvh_node_mark_update(nodes[n]);
+	}
+}
+
+static void stroke_replay(DyntopoStroke *stroke, const int totdab, double *r_time_topology, double *r_time_update)
+{
+	*r_time_topology = 0.0;
+	*r_time_update = 0.0;
+
+	for (int dab = 0; dab < totdab; dab++) {
+		/* a wavy stroke around the sphere */
+		const float t = ((float)dab / (float)totdab) * (float)M_PI * 2.0f;
+		float center[3] = {cosf(t), sinf(t), 0.3f * sinf(t * 5.0f)};
+		DabSearchData data;
+		PBVHNode **nodes = NULL;
+		int totnode;
+		double time_start;
+
+		normalize_v3(center);
+
+		data.center = center;
+		data.radius_squared = SQUARE(DAB_RADIUS * 1.25f);
+		BKE_pbvh_search_gather(stroke->pbvh, dab_search_sphere_cb, &data, &nodes, &totnode);
+		if (totnode == 0) {
+			continue;
+		}
+
+		dab_displace(stroke, nodes, totnode, center);
+		for (int n = 0; n < totnode; n++) {
+			BKE_pbvh_node_mark_topology_update(nodes[n]);
+			BKE_pbvh_bmesh_node_save_orig(nodes[n]);
+		}
+		MEM_freeN(nodes);
+
+		time_start = PIL_check_seconds_timer();
+		BKE_pbvh_bmesh_update_topology(
+		        stroke->pbvh, (PBVHTopologyUpdateMode)(PBVH_Subdivide | PBVH_Collapse),
+		        center, NULL, DAB_RADIUS);
+		*r_time_topology += PIL_check_seconds_timer() - time_start;
+
+		time_start = PIL_check_seconds_timer();
+		BKE_pbvh_update(stroke->pbvh, PBVH_UpdateBB | PBVH_UpdateOriginalBB | PBVH_UpdateNormals, NULL);
+		*r_time_update += PIL_check_seconds_timer() - time_start;
+	}
+
+	BKE_pbvh_bmesh_after_stroke(stroke->pbvh);
+}
+
+static void stroke_run(DyntopoStroke *stroke, const float detail_size, const int totdab, const bool serial)
+{
+	double time_topology, time_update;
+	int totface_init;
+
+	testing_threads_serial_set(serial);
+
+	stroke_init(stroke, detail_size);
+	totface_init = stroke->bm->totface;
+
+	{
+		TIMEIT_START(stroke_replay);
+		stroke_replay(stroke, totdab, &time_topology, &time_update);
+		TIMEIT_END(stroke_replay);
+	}
+
+	printf("%s: faces: %d -> %d, topology update: %.6f, PBVH update: %.6f\n",
+	       serial ? "Serial" : "Threaded", totface_init, stroke->bm->totface, time_topology, time_update);
+
+	/* the stroke refines the mesh, which stays a triangle mesh with valid normals
+	 * (not checking for manifold edges, collapsing may leave those) */
+	EXPECT_GT(stroke->bm->totface, totface_init);
+	{
+		BMIter iter;
+		BMFace *f;
+		BMVert *v;
+
+		BM_ITER_MESH (f, &iter, stroke->bm, BM_FACES_OF_MESH) {
+			EXPECT_EQ(3, f->len);
+		}
+		BM_ITER_MESH (v, &iter, stroke->bm, BM_VERTS_OF_MESH) {
+			if (v->e) {
+				EXPECT_NEAR(1.0f, len_v3(v->no), 1e-4f);
+			}
+		}
+	}
+}
+
+static float bm_area_calc(BMesh *bm)
+{
+	BMIter iter;
+	BMFace *f;
+	float area = 0.0f;
+
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		area += BM_face_calc_area(f);
+	}
+	return area;
+}
+
+static void dyntopo_stroke_test(const float detail_size, const int totdab)
+{
+	DyntopoStroke stroke_serial, stroke;
+
+	BLI_threadapi_init();
+
+	stroke_run(&stroke_serial, detail_size, totdab, true);
+	stroke_run(&stroke, detail_size, totdab, false);
+
+	EXPECT_NEAR(stroke_serial.bm->totface, stroke.bm->totface, stroke_serial.bm->totface / 1000);
+	EXPECT_NEAR(1.0f, bm_area_calc(stroke.bm) / bm_area_calc(stroke_serial.bm), 1e-3f);
+
+	stroke_free(&stroke_serial);
+	stroke_free(&stroke);
+}
+
+TEST(pbvh_dyntopo, StrokeSmall)
+{
+	dyntopo_stroke_test(DETAIL_SIZE_SMALL, 100);
+}
+
+TEST(pbvh_dyntopo, StrokeLarge)
+{
+	dyntopo_stroke_test(DETAIL_SIZE_LARGE, 400);
+}
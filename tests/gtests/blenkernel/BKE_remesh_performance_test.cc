@@ -0,0 +1,149 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "PIL_time.h"
+}
+
+#include "bmesh.h"
+
+/* Timing of the remesh modifier (dual contouring, see intern/dualcon) on a UV-sphere with noise
+ * (similar to a scan), at the octree depths used for cleaning up scanned assets.
+ * Quality is measured as the distance of the remeshed vertices from the unit sphere,
+ * and the threaded remesh must give the same mesh as the serial one. */
+
+#define SPHERE_RES 256
+#define NOISE 0.001f
+
+static Mesh *noisy_sphere_mesh_new(Main *bmain)
+{
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	Mesh *me = BKE_mesh_add(bmain, "Remesh");
+	RNG *rng = BLI_rng_new(0);
+	BMIter iter;
+	BMVert *v;
+
+	testing_bm_uvsphere_add(bm, SPHERE_RES, 1.0f, NULL, false);
+
+	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+		mul_v3_fl(v->co, 1.0f + (BLI_rng_get_float(rng) - 0.5f) * NOISE);
+	}
+
+	BM_mesh_bm_to_me(bm, me, false);
+	BM_mesh_free(bm);
+	BLI_rng_free(rng);
+
+	return me;
+}
+
+static DerivedMesh *remesh_run(ModifierData *md, DerivedMesh *dm, const bool serial)
+{
+	DerivedMesh *result;
+	MVert *mvert;
+	double time_start, time_remesh;
+	float dev_max = 0.0f;
+	int totvert;
+
+	testing_threads_serial_set(serial);
+
+	time_start = PIL_check_seconds_timer();
+	result = modifierType_getInfo(eModifierType_Remesh)->applyModifier(md, NULL, dm, (ModifierApplyFlag)0);
+	time_remesh = PIL_check_seconds_timer() - time_start;
+
+	totvert = result->getNumVerts(result);
+	mvert = result->getVertArray(result);
+	for (int i = 0; i < totvert; i++) {
+		dev_max = max_ff(dev_max, fabsf(len_v3(mvert[i].co) - 1.0f));
+	}
+
+	printf("%s: faces: %d -> %d, time: %.6f, deviation: max %g\n",
+	       serial ? "Serial" : "Threaded", dm->getNumPolys(dm), result->getNumPolys(result), time_remesh, dev_max);
+
+	EXPECT_GT(result->getNumPolys(result), 0);
+	/* the vertices are placed in cells of the octree, some cells away from the surface at most */
+	EXPECT_LT(dev_max, 8.0f / (1 << ((RemeshModifierData *)md)->depth));
+
+	return result;
+}
+
+static void remesh_test(const int depth)
+{
+	Main *bmain;
+	Mesh *me;
+	ModifierData *md;
+	RemeshModifierData *rmd;
+	DerivedMesh *dm, *result_serial, *result;
+
+	BLI_threadapi_init();
+	BKE_modifier_init();
+
+	bmain = BKE_main_new();
+	me = noisy_sphere_mesh_new(bmain);
+	dm = CDDM_from_mesh(me);
+
+	md = modifier_new(eModifierType_Remesh);
+	rmd = (RemeshModifierData *)md;
+	rmd->mode = MOD_REMESH_SHARP_FEATURES;
+	rmd->depth = depth;
+
+	printf("Depth: %d\n", depth);
+
+	result_serial = remesh_run(md, dm, true);
+	result = remesh_run(md, dm, false);
+
+	EXPECT_EQ(result_serial->getNumVerts(result_serial), result->getNumVerts(result));
+	EXPECT_EQ(result_serial->getNumLoops(result_serial), result->getNumLoops(result));
+	EXPECT_EQ(result_serial->getNumPolys(result_serial), result->getNumPolys(result));
+	if (result_serial->getNumVerts(result_serial) == result->getNumVerts(result) &&
+	    result_serial->getNumLoops(result_serial) == result->getNumLoops(result) &&
+	    result_serial->getNumPolys(result_serial) == result->getNumPolys(result))
+	{
+		const MVert *mvert_serial = result_serial->getVertArray(result_serial);
+		const MVert *mvert = result->getVertArray(result);
+		int totvert_differ = 0;
+
+		for (int i = 0; i < result->getNumVerts(result); i++) {
+			if (!equals_v3v3(mvert_serial[i].co, mvert[i].co)) {
+				totvert_differ++;
+			}
+		}
+		EXPECT_EQ(0, totvert_differ);
+		EXPECT_EQ(0, memcmp(result_serial->getLoopArray(result_serial), result->getLoopArray(result),
+		                    sizeof(MLoop) * result->getNumLoops(result)));
+		EXPECT_EQ(0, memcmp(result_serial->getPolyArray(result_serial), result->getPolyArray(result),
+		                    sizeof(MPoly) * result->getNumPolys(result)));
+	}
+
+	result_serial->release(result_serial);
+	result->release(result);
+	dm->release(dm);
+	modifier_free(md);
+	BKE_main_free(bmain);
+}
+
+TEST(remesh, Depth8)
+{
+	remesh_test(8);
+}
+
+TEST(remesh, Depth9)
+{
+	remesh_test(9);
+}
@@ -0,0 +1,153 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+#include "BKE_shrinkwrap.h"
+#include "PIL_time.h"
+}
+
+/* Time of shrinkwrapping a dense sphere onto an animated target sphere. The first evaluation builds
+ * the target tree, the following ones deform the target and refit the tree kept by the modifier.
+ * Each frame is shrinkwrapped with a newly built tree as well, which must find
+ * the target at the same distance. */
+
+#define SOURCE_RES 256
+#define TARGET_RES 128
+#define FRAMES 10
+
+/* wobble the target, keeping its topology */
+static void target_deform(DerivedMesh *dm, const float (*orco)[3], const int frame)
+{
+	MVert *mvert = dm->getVertArray(dm);
+	const int totvert = dm->getNumVerts(dm);
+
+	for (int i = 0; i < totvert; i++) {
+		const float fac = 1.0f + 0.1f * sinf(orco[i][2] * 8.0f + (float)frame * 0.5f);
+		mul_v3_v3fl(mvert[i].co, orco[i], fac);
+	}
+}
+
+static double shrinkwrap_frame(
+        ShrinkwrapModifierData *smd, Object *source_ob, DerivedMesh *source_dm, const Mesh *source_me,
+        float (*vertexCos)[3])
+{
+	double time_start;
+
+	for (int i = 0; i < source_me->totvert; i++) {
+		copy_v3_v3(vertexCos[i], source_me->mvert[i].co);
+	}
+
+	time_start = PIL_check_seconds_timer();
+	shrinkwrapModifier_deform(smd, source_ob, source_dm, vertexCos, source_me->totvert, false);
+
+	return PIL_check_seconds_timer() - time_start;
+}
+
+static void shrinkwrap_test(const short shrink_type)
+{
+	ShrinkwrapModifierData smd = {{NULL}};
+	ShrinkwrapModifierData smd_build;
+	Main *bmain;
+	Mesh *source_me, *target_me;
+	Object *source_ob, *target_ob;
+	DerivedMesh *source_dm, *target_dm;
+	float (*orco)[3], (*vertexCos)[3], (*vertexCos_build)[3];
+	double time_first = 0.0, time_refit = 0.0, time_build = 0.0;
+	float diff_max = 0.0f;
+
+	BLI_threadapi_init();
+
+	bmain = BKE_main_new();
+	source_me = testing_mesh_uvsphere_new(bmain, SOURCE_RES, 2.0f);
+	target_me = testing_mesh_uvsphere_new(bmain, TARGET_RES, 1.0f);
+
+	source_ob = BKE_object_add_only_object(bmain, OB_MESH, "Source");
+	source_ob->data = source_me;
+	target_ob = BKE_object_add_only_object(bmain, OB_MESH, "Target");
+	target_ob->data = target_me;
+
+	source_dm = CDDM_from_mesh(source_me);
+	target_dm = CDDM_from_mesh(target_me);
+	target_ob->derivedFinal = target_dm;
+
+	orco = BKE_mesh_vertexCos_get(target_me, NULL);
+	vertexCos = BKE_mesh_vertexCos_get(source_me, NULL);
+	vertexCos_build = BKE_mesh_vertexCos_get(source_me, NULL);
+
+	smd.target = target_ob;
+	smd.shrinkType = shrink_type;
+	smd.shrinkOpts = MOD_SHRINKWRAP_PROJECT_ALLOW_NEG_DIR;
+	smd.projAxis = MOD_SHRINKWRAP_PROJECT_OVER_NORMAL;
+	smd_build = smd;
+
+	for (int frame = 0; frame < FRAMES; frame++) {
+		target_deform(target_dm, orco, frame);
+
+		if (frame == 0) {
+			time_first = shrinkwrap_frame(&smd, source_ob, source_dm, source_me, vertexCos);
+		}
+		else {
+			time_refit += shrinkwrap_frame(&smd, source_ob, source_dm, source_me, vertexCos);
+		}
+
+		time_build += shrinkwrap_frame(&smd_build, source_ob, source_dm, source_me, vertexCos_build);
+		BKE_shrinkwrap_tree_cache_free(smd_build.cache);
+		smd_build.cache = NULL;
+
+		/* compare distances, where the target is concave another point at the same distance may be found */
+		for (int i = 0; i < source_me->totvert; i++) {
+			const float *co = source_me->mvert[i].co;
+			diff_max = max_ff(diff_max, fabsf(len_v3v3(co, vertexCos[i]) - len_v3v3(co, vertexCos_build[i])));
+		}
+	}
+
+	printf("Vertices: %d, target triangles: %d\n", source_me->totvert, target_dm->getNumLoopTri(target_dm));
+	printf("Time first frame: %.6f, following frames: %.6f (average), with a new tree: %.6f (average)\n",
+	       time_first, time_refit / (FRAMES - 1), time_build / FRAMES);
+	printf("Distance difference with a new tree: max %g\n", diff_max);
+
+	/* the tree is refitted from the first frame on */
+	EXPECT_TRUE(smd.cache != NULL);
+
+	/* every vertex ends up on the target, which is no further than 1.1 from the center */
+	for (int i = 0; i < source_me->totvert; i++) {
+		EXPECT_LE(len_v3(vertexCos[i]), 1.1f + 1e-4f);
+	}
+
+	EXPECT_LT(diff_max, 1e-6f);
+
+	BKE_shrinkwrap_tree_cache_free(smd.cache);
+	MEM_freeN(vertexCos);
+	MEM_freeN(vertexCos_build);
+	MEM_freeN(orco);
+	target_ob->derivedFinal = NULL;
+	target_dm->release(target_dm);
+	source_dm->release(source_dm);
+	BKE_main_free(bmain);
+}
+
+TEST(shrinkwrap, NearestSurface)
+{
+	shrinkwrap_test(MOD_SHRINKWRAP_NEAREST_SURFACE);
+}
+
+TEST(shrinkwrap, Project)
+{
+	shrinkwrap_test(MOD_SHRINKWRAP_PROJECT);
+}
@@ -0,0 +1,151 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "CCGSubSurf.h"
+#include "PIL_time.h"
+}
+
+#include "bmesh.h"
+
+/* Timing of the OpenSubdiv synchronization of an animated mesh, where each frame deforms the base
+ * mesh without changing its topology: syncing the subsurf kept between frames (which keeps the
+ * topology refiner, only checking the topology hash) against syncing a new subsurf each frame
+ * (which creates the refiner again, as a topology change does). Both must give the same refiner
+ * and coarse coordinates.
+ *
+ * Creating the GL mesh and its stencil tables needs a GL context, so isn't part of the timing. */
+
+#define GRID_RES 256
+#define SUBDIV_LEVEL 2
+#define TOTFRAME 50
+
+static Mesh *grid_mesh_new(Main *bmain)
+{
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	Mesh *me = BKE_mesh_add(bmain, "Subsurf");
+	float mat[4][4];
+
+	unit_m4(mat);
+	BMO_op_callf(bm, BMO_FLAG_DEFAULTS,
+	             "create_grid x_segments=%i y_segments=%i size=%f matrix=%m4 calc_uvs=%b",
+	             GRID_RES, GRID_RES, 1.0f, mat, false);
+	BM_mesh_bm_to_me(bm, me, false);
+	BM_mesh_free(bm);
+
+	return me;
+}
+
+/* Playback deformation: a wave running over the grid. */
+static void grid_mesh_deform(Mesh *me, const int frame)
+{
+	MVert *mv = me->mvert;
+
+	for (int i = 0; i < me->totvert; i++, mv++) {
+		mv->co[2] = 0.1f * sinf(mv->co[0] * 8.0f + (float)frame * 0.2f);
+	}
+}
+
+/* Same layout as the subsurf modifier uses, see #_getSubSurf. */
+static CCGSubSurf *subsurf_new(void)
+{
+	CCGMeshIFC ifc;
+	CCGSubSurf *ss;
+
+	ifc.vertUserSize = ifc.edgeUserSize = ifc.faceUserSize = 8;
+	ifc.numLayers = 3;
+	ifc.vertDataSize = sizeof(float) * 3 * 2;
+	ifc.simpleSubdiv = 0;
+
+	ss = ccgSubSurf_new(&ifc, SUBDIV_LEVEL, NULL, NULL);
+	ccgSubSurf_setCalcVertexNormals(ss, 1, sizeof(float) * 3);
+	ccgSubSurf_setSkipGrids(ss, true);
+
+	return ss;
+}
+
+/* Same as #ss_sync_from_derivedmesh does for the OpenSubdiv backend. */
+static void subsurf_sync(CCGSubSurf *ss, DerivedMesh *dm, double *r_time)
+{
+	const double time_start = PIL_check_seconds_timer();
+
+	ccgSubSurf_checkTopologyChanged(ss, dm);
+	ccgSubSurf_initFullSync(ss);
+	ccgSubSurf_prepareTopologyRefiner(ss, dm);
+	ccgSubSurf_processSync(ss);
+
+	*r_time += PIL_check_seconds_timer() - time_start;
+}
+
+TEST(subsurf_osd, Playback)
+{
+	Main *bmain;
+	Mesh *me;
+	CCGSubSurf *ss_cached;
+	double time_cached = 0.0, time_uncached = 0.0;
+
+	bmain = BKE_main_new();
+	me = grid_mesh_new(bmain);
+	ss_cached = subsurf_new();
+
+	printf("Faces: %d, level: %d\n", me->totpoly, SUBDIV_LEVEL);
+
+	for (int frame = 0; frame < TOTFRAME; frame++) {
+		CCGSubSurf *ss_uncached = subsurf_new();
+		DerivedMesh *dm;
+
+		grid_mesh_deform(me, frame);
+		dm = CDDM_from_mesh(me);
+
+		subsurf_sync(ss_cached, dm, &time_cached);
+		subsurf_sync(ss_uncached, dm, &time_uncached);
+
+		/* both have a refiner for the same topology */
+		EXPECT_EQ(me->totpoly, ccgSubSurf_getNumGLMeshBaseFaces(ss_cached));
+		EXPECT_EQ(me->totpoly, ccgSubSurf_getNumGLMeshBaseFaces(ss_uncached));
+		{
+			int totface_differ = 0;
+
+			for (int i = 0; i < me->totpoly; i++) {
+				if (ccgSubSurf_getNumGLMeshBaseFaceVerts(ss_cached, i) !=
+				    ccgSubSurf_getNumGLMeshBaseFaceVerts(ss_uncached, i))
+				{
+					totface_differ++;
+				}
+			}
+			EXPECT_EQ(0, totface_differ);
+		}
+
+		/* and the coarse coordinates of this frame */
+		{
+			float min_cached[3], max_cached[3], min_uncached[3], max_uncached[3];
+
+			INIT_MINMAX(min_cached, max_cached);
+			INIT_MINMAX(min_uncached, max_uncached);
+			ccgSubSurf_getMinMax(ss_cached, min_cached, max_cached);
+			ccgSubSurf_getMinMax(ss_uncached, min_uncached, max_uncached);
+			EXPECT_TRUE(equals_v3v3(min_cached, min_uncached));
+			EXPECT_TRUE(equals_v3v3(max_cached, max_uncached));
+		}
+
+		ccgSubSurf_free(ss_uncached);
+		dm->release(dm);
+	}
+
+	printf("Cached: %.6f, uncached: %.6f (per frame: %.6f, %.6f)\n",
+	       time_cached, time_uncached, time_cached / TOTFRAME, time_uncached / TOTFRAME);
+
+	ccgSubSurf_free(ss_cached);
+	BKE_main_free(bmain);
+}
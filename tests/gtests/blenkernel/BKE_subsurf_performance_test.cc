@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_subsurf.h"
+#include "PIL_time.h"
+}
+
+/* Time and memory of the Catmull-Clark subdivision of a sphere with some creased edges,
+ * at the levels sculpt and render usually use. The threaded subdivision must give the same
+ * vertices as the serial one. */
+
+#define SPHERE_RES 48
+
+static Mesh *creased_sphere_mesh_new(Main *bmain)
+{
+	Mesh *me = testing_mesh_uvsphere_new(bmain, SPHERE_RES, 1.0f);
+
+	/* crease the edges around the equator, for the sharp edge rules */
+	for (int i = 0; i < me->totedge; i++) {
+		MEdge *med = &me->medge[i];
+
+		if (fabsf(me->mvert[med->v1].co[2]) < 1e-4f && fabsf(me->mvert[med->v2].co[2]) < 1e-4f) {
+			med->crease = 255;
+		}
+	}
+
+	return me;
+}
+
+static DerivedMesh *subsurf_run(DerivedMesh *dm, const int level, const bool serial)
+{
+	SubsurfModifierData smd = {{NULL}};
+	DerivedMesh *result;
+	size_t mem_start;
+	double time_start, time_subdiv;
+
+	testing_threads_serial_set(serial);
+
+	smd.levels = smd.renderLevels = level;
+
+	mem_start = MEM_get_memory_in_use();
+	MEM_reset_peak_memory();
+	time_start = PIL_check_seconds_timer();
+
+	result = subsurf_make_derived_from_derived(dm, &smd, NULL, (SubsurfFlags)0);
+
+	time_subdiv = PIL_check_seconds_timer() - time_start;
+
+	printf("%s: subdivided vertices: %d, time: %.6f, memory: %.2f MB (peak %.2f MB)\n",
+	       serial ? "Serial" : "Threaded", result->getNumVerts(result),
+	       time_subdiv,
+	       (double)(MEM_get_memory_in_use() - mem_start) / (1024.0 * 1024.0),
+	       (double)(MEM_get_peak_memory() - mem_start) / (1024.0 * 1024.0));
+
+	EXPECT_EQ(dm->getNumLoops(dm) << (2 * (level - 1)), result->getNumPolys(result));
+
+	return result;
+}
+
+static void subsurf_test(const int level)
+{
+	Main *bmain;
+	Mesh *me;
+	DerivedMesh *dm, *result_serial, *result;
+
+	BLI_threadapi_init();
+
+	bmain = BKE_main_new();
+	me = creased_sphere_mesh_new(bmain);
+	dm = CDDM_from_mesh(me);
+
+	printf("Faces: %d, level: %d\n", me->totpoly, level);
+
+	result_serial = subsurf_run(dm, level, true);
+	result = subsurf_run(dm, level, false);
+
+	EXPECT_EQ(result_serial->getNumVerts(result_serial), result->getNumVerts(result));
+	if (result_serial->getNumVerts(result_serial) == result->getNumVerts(result)) {
+		const int totvert = result->getNumVerts(result);
+		float (*cos_serial)[3] = (float (*)[3])MEM_mallocN(sizeof(*cos_serial) * totvert, __func__);
+		float (*cos)[3] = (float (*)[3])MEM_mallocN(sizeof(*cos) * totvert, __func__);
+
+		result_serial->getVertCos(result_serial, cos_serial);
+		result->getVertCos(result, cos);
+		EXPECT_EQ(0, memcmp(cos_serial, cos, sizeof(*cos) * totvert));
+
+		MEM_freeN(cos_serial);
+		MEM_freeN(cos);
+	}
+
+	result_serial->release(result_serial);
+	result->release(result);
+	dm->release(dm);
+	BKE_main_free(bmain);
+}
+
+TEST(subsurf, Level3)
+{
+	subsurf_test(3);
+}
+
+TEST(subsurf, Level4)
+{
+	subsurf_test(4);
+}
+
+TEST(subsurf, Level5)
+{
+	subsurf_test(5);
+}
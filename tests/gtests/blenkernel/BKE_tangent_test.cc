@@ -0,0 +1,105 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+}
+
+#include "bmesh.h"
+
+/* Tangents computed per island in parallel must match a single mikktspace pass over the whole mesh. */
+
+#define SPHERE_RES 64
+
+/**
+ * A smooth UV sphere, large enough to be computed in batches, with one meridian ripped.
+ * The ripped vertices have the same position, normal and UV on both sides,
+ * so mikktspace welds them even though their indices differ.
+ */
+static Mesh *ripped_sphere_mesh_new(Main *bmain)
+{
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	Mesh *me = BKE_mesh_add(bmain, "Tangent");
+	BMIter iter;
+	BMEdge *e;
+
+	/* calc_uvs writes into an existing layer */
+	BM_data_layer_add(bm, &bm->ldata, CD_MLOOPUV);
+	testing_bm_uvsphere_add(bm, SPHERE_RES, 1.0f, NULL, true);
+
+	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+		const bool on_meridian = fabsf(e->v1->co[0]) < 1e-4f && fabsf(e->v2->co[0]) < 1e-4f &&
+		                         e->v1->co[1] > 1e-4f && e->v2->co[1] > 1e-4f;
+		BM_elem_flag_set(e, BM_ELEM_TAG, on_meridian);
+	}
+	BMO_op_callf(bm, BMO_FLAG_DEFAULTS, "split_edges edges=%he", BM_ELEM_TAG);
+
+	BM_mesh_bm_to_me(bm, me, false);
+	BM_mesh_free(bm);
+
+	/* normals of a sphere, equal for the ripped vertices */
+	for (int i = 0; i < me->totvert; i++) {
+		float no[3];
+		normalize_v3_v3(no, me->mvert[i].co);
+		normal_float_to_short_v3(me->mvert[i].no, no);
+	}
+	for (int i = 0; i < me->totpoly; i++) {
+		me->mpoly[i].flag |= ME_SMOOTH;
+	}
+
+	return me;
+}
+
+static float (*tangents_calc(Mesh *me, const bool use_threading))[4]
+{
+	DerivedMesh *dm = CDDM_from_mesh(me);
+	float (*tangent)[4];
+	float (*result)[4];
+	const int totloop = dm->getNumLoops(dm);
+
+	DM_calc_loop_tangents_ex(dm, use_threading, false);
+
+	tangent = (float (*)[4])CustomData_get_layer(&dm->loopData, CD_TANGENT);
+	result = (float (*)[4])MEM_mallocN(sizeof(*result) * (size_t)totloop, __func__);
+	memcpy(result, tangent, sizeof(*result) * (size_t)totloop);
+
+	dm->release(dm);
+
+	return result;
+}
+
+TEST(tangent, BatchedMatchesSerial)
+{
+	BLI_threadapi_init();
+
+	Main *bmain = BKE_main_new();
+	Mesh *me = ripped_sphere_mesh_new(bmain);
+
+	/* otherwise tangents are computed in a single pass */
+	EXPECT_GT(poly_to_tri_count(me->totpoly, me->totloop), BKE_MESH_OMP_LIMIT);
+
+	float (*tangent_serial)[4] = tangents_calc(me, false);
+	float (*tangent_batched)[4] = tangents_calc(me, true);
+
+	for (int i = 0; i < me->totloop; i++) {
+		EXPECT_V3_NEAR(tangent_serial[i], tangent_batched[i], 1e-5f);
+		EXPECT_EQ(tangent_serial[i][3], tangent_batched[i][3]);
+	}
+
+	MEM_freeN(tangent_serial);
+	MEM_freeN(tangent_batched);
+	BKE_main_free(bmain);
+}
@@ -0,0 +1,164 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "bmesh.h"
+
+extern "C" {
+#include "tools/bmesh_intersect.h"
+}
+
+/* Timing of the BMesh boolean (#BM_mesh_intersect) on two overlapping UV-spheres,
+ * the same setup the boolean modifier uses (tag faces of one operand, tessellate, intersect).
+ * The threaded tessellation and overlap test must give the same result as the serial ones
+ * (up to the intersection epsilon). */
+
+#define SPHERE_RES_SMALL 32
+#define SPHERE_RES_LARGE 192
+#define ISECT_EPS 0.000001f
+
+/* has no meaning for faces, same as the modifier */
+#define BM_FACE_TAG BM_ELEM_DRAW
+
+static int bm_face_isect_pair(BMFace *f, void *UNUSED(user_data))
+{
+	return BM_elem_flag_test(f, BM_FACE_TAG) ? 1 : 0;
+}
+
+static BMesh *bm_boolean_operands_new(const int res)
+{
+	const float loc_a[3] = {0.0f, 0.0f, 0.0f};
+	/* offset on all axes, so the spheres don't share any symmetry */
+	const float loc_b[3] = {0.61f, 0.37f, 0.23f};
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	BMIter iter;
+	BMFace *f;
+
+	testing_bm_uvsphere_add(bm, res, 1.0f, loc_a, false);
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		BM_elem_flag_enable(f, BM_FACE_TAG);
+	}
+	testing_bm_uvsphere_add(bm, res, 1.0f, loc_b, false);
+
+	BM_mesh_normals_update(bm);
+
+	return bm;
+}
+
+static bool bm_is_manifold(BMesh *bm)
+{
+	BMIter iter;
+	BMEdge *e;
+
+	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+		if (!BM_edge_is_manifold(e)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static BMesh *boolean_run(const int res, const int boolean_mode, const bool serial)
+{
+	BMesh *bm;
+	BMLoop *(*looptris)[3];
+	int looptris_tot, tottri;
+	bool has_isect;
+
+	testing_threads_serial_set(serial);
+
+	bm = bm_boolean_operands_new(res);
+	printf("%s: faces: %d\n", serial ? "Serial" : "Threaded", bm->totface);
+
+	looptris_tot = poly_to_tri_count(bm->totface, bm->totloop);
+	looptris = (BMLoop *(*)[3])MEM_mallocN(sizeof(*looptris) * (size_t)looptris_tot, __func__);
+
+	{
+		TIMEIT_START(tessellate);
+		BM_bmesh_calc_tessellation(bm, looptris, &tottri);
+		TIMEIT_END(tessellate);
+	}
+
+	EXPECT_EQ(looptris_tot, tottri);
+
+	{
+		TIMEIT_START(intersect);
+		has_isect = BM_mesh_intersect(
+		        bm,
+		        looptris, tottri,
+		        bm_face_isect_pair, NULL,
+		        false, false, true, true,
+		        boolean_mode,
+		        ISECT_EPS);
+		TIMEIT_END(intersect);
+	}
+
+	MEM_freeN(looptris);
+
+	EXPECT_TRUE(has_isect);
+	EXPECT_NE(0, bm->totface);
+	/* two closed spheres give a closed result */
+	EXPECT_TRUE(bm_is_manifold(bm));
+
+	return bm;
+}
+
+static void boolean_test(const int res, const int boolean_mode)
+{
+	BMesh *bm_serial, *bm;
+
+	BLI_threadapi_init();
+
+	bm_serial = boolean_run(res, boolean_mode, true);
+	bm = boolean_run(res, boolean_mode, false);
+
+	EXPECT_EQ(bm_serial->totvert, bm->totvert);
+	EXPECT_EQ(bm_serial->totedge, bm->totedge);
+	EXPECT_EQ(bm_serial->totface, bm->totface);
+	/* an intersection may be found from another pair of faces (which are ordered by pointer hashes),
+	 * rounding its position differently */
+	EXPECT_EQ(0, testing_bm_verts_differ_count(bm_serial, bm, ISECT_EPS));
+
+	BM_mesh_free(bm_serial);
+	BM_mesh_free(bm);
+}
+
+TEST(bmesh_boolean, UnionSmall)
+{
+	boolean_test(SPHERE_RES_SMALL, BMESH_ISECT_BOOLEAN_UNION);
+}
+
+TEST(bmesh_boolean, DifferenceSmall)
+{
+	boolean_test(SPHERE_RES_SMALL, BMESH_ISECT_BOOLEAN_DIFFERENCE);
+}
+
+TEST(bmesh_boolean, IntersectSmall)
+{
+	boolean_test(SPHERE_RES_SMALL, BMESH_ISECT_BOOLEAN_ISECT);
+}
+
+TEST(bmesh_boolean, UnionLarge)
+{
+	boolean_test(SPHERE_RES_LARGE, BMESH_ISECT_BOOLEAN_UNION);
+}
+
+TEST(bmesh_boolean, DifferenceLarge)
+{
+	boolean_test(SPHERE_RES_LARGE, BMESH_ISECT_BOOLEAN_DIFFERENCE);
+}
+
+TEST(bmesh_boolean, IntersectLarge)
+{
+	boolean_test(SPHERE_RES_LARGE, BMESH_ISECT_BOOLEAN_ISECT);
+}
@@ -0,0 +1,125 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "bmesh.h"
+
+extern "C" {
+#include "tools/bmesh_decimate.h"
+}
+
+/* Timing and quality of the collapse decimator (#BM_mesh_decimate_collapse), as used by the
+ * decimate modifier, on a UV-sphere with noise (similar to a scan) reduced to a fraction of its
+ * faces, serially and in parallel batches. Quality is measured as the distance of the remaining
+ * vertices from the unit sphere. */
+
+#define SPHERE_RES_SMALL 64
+#define SPHERE_RES_LARGE 256
+#define NOISE 0.001f
+
+static BMesh *bm_noisy_sphere_new(const int res)
+{
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	RNG *rng = BLI_rng_new(0);
+	BMIter iter;
+	BMVert *v;
+
+	testing_bm_uvsphere_add(bm, res, 1.0f, NULL, false);
+
+	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+		mul_v3_fl(v->co, 1.0f + (BLI_rng_get_float(rng) - 0.5f) * NOISE);
+	}
+
+	BM_mesh_normals_update(bm);
+	BLI_rng_free(rng);
+
+	return bm;
+}
+
+static void bm_sphere_deviation(BMesh *bm, float *r_dev_max, float *r_dev_avg)
+{
+	BMIter iter;
+	BMVert *v;
+	double dev_sum = 0.0;
+
+	*r_dev_max = 0.0f;
+
+	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+		const float dev = fabsf(len_v3(v->co) - 1.0f);
+
+		*r_dev_max = max_ff(*r_dev_max, dev);
+		dev_sum += dev;
+	}
+
+	*r_dev_avg = (float)(dev_sum / bm->totvert);
+}
+
+static void decimate(BMesh *bm_orig, const float factor, const bool use_parallel,
+                     int *r_totface, float *r_dev_max, float *r_dev_avg)
+{
+	BMesh *bm = BM_mesh_copy(bm_orig);
+
+	{
+		TIMEIT_START(decimate);
+		BM_mesh_decimate_collapse(bm, factor, NULL, 1.0f, true, -1, 0.0f, use_parallel);
+		TIMEIT_END(decimate);
+	}
+
+	*r_totface = bm->totface;
+	bm_sphere_deviation(bm, r_dev_max, r_dev_avg);
+
+	BM_mesh_free(bm);
+}
+
+static void decimate_test(const int res, const float factor)
+{
+	BMesh *bm;
+	int totface_orig;
+	int totface_serial, totface_parallel;
+	float dev_max_serial, dev_avg_serial;
+	float dev_max_parallel, dev_avg_parallel;
+
+	BLI_threadapi_init();
+
+	bm = bm_noisy_sphere_new(res);
+	totface_orig = bm->totface;
+
+	decimate(bm, factor, false, &totface_serial, &dev_max_serial, &dev_avg_serial);
+	decimate(bm, factor, true, &totface_parallel, &dev_max_parallel, &dev_avg_parallel);
+
+	BM_mesh_free(bm);
+
+	printf("Faces: %d -> %d (serial), %d (parallel)\n", totface_orig, totface_serial, totface_parallel);
+	printf("Deviation: max %g, average %g (serial), max %g, average %g (parallel)\n",
+	       dev_max_serial, dev_avg_serial, dev_max_parallel, dev_avg_parallel);
+
+	/* the faces were triangulated, so they can be twice as many as asked for */
+	EXPECT_LE(totface_serial, (int)(totface_orig * factor) * 2);
+	EXPECT_LT(dev_max_serial, 0.1f);
+
+	/* batches collapse edges in a different order, the quality should stay close to the serial result */
+	EXPECT_LE(totface_parallel, (int)(totface_orig * factor) * 2);
+	EXPECT_NEAR(totface_parallel, totface_serial, totface_serial / 20 + 2);
+	EXPECT_LT(dev_max_parallel, max_ff(dev_max_serial * 1.5f, 0.01f));
+	EXPECT_LT(dev_avg_parallel, max_ff(dev_avg_serial * 1.5f, 0.001f));
+}
+
+TEST(bmesh_decimate, CollapseSmall)
+{
+	decimate_test(SPHERE_RES_SMALL, 0.1f);
+}
+
+TEST(bmesh_decimate, CollapseLarge)
+{
+	decimate_test(SPHERE_RES_LARGE, 0.01f);
+}
@@ -0,0 +1,214 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "bmesh.h"
+
+/* Timing of Mesh <-> BMesh conversion (entering & leaving edit-mode),
+ * on a quad grid with a few custom-data layers, so the per-element copy isn't trivial.
+ * The round-trip is lossless, threaded and serially. */
+
+#define GRID_RES_SMALL 100
+#define GRID_RES_LARGE 1500
+
+static Mesh *mesh_grid_new(const int res)
+{
+	Mesh *me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+	MVert *mvert;
+	MEdge *medge;
+	MPoly *mpoly;
+	MLoop *mloop;
+	MLoopUV *mloopuv;
+	float *vfloat;
+	const int edges_x = (res - 1) * res;  /* edges along X, followed by edges along Y */
+	int x, y, i;
+
+	BKE_mesh_init(me);
+
+	me->totvert = res * res;
+	me->totedge = edges_x * 2;
+	me->totpoly = (res - 1) * (res - 1);
+	me->totloop = me->totpoly * 4;
+
+	mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+	medge = (MEdge *)CustomData_add_layer(&me->edata, CD_MEDGE, CD_CALLOC, NULL, me->totedge);
+	mpoly = (MPoly *)CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, NULL, me->totpoly);
+	mloop = (MLoop *)CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, NULL, me->totloop);
+	CustomData_add_layer(&me->pdata, CD_MTEXPOLY, CD_CALLOC, NULL, me->totpoly);
+	mloopuv = (MLoopUV *)CustomData_add_layer(&me->ldata, CD_MLOOPUV, CD_CALLOC, NULL, me->totloop);
+	vfloat = (float *)CustomData_add_layer(&me->vdata, CD_PROP_FLT, CD_CALLOC, NULL, me->totvert);
+
+	for (y = 0, i = 0; y < res; y++) {
+		for (x = 0; x < res; x++, i++) {
+			mvert[i].co[0] = (float)x;
+			mvert[i].co[1] = (float)y;
+			mvert[i].no[2] = 32767;
+			vfloat[i] = (float)i;
+		}
+	}
+
+	for (y = 0, i = 0; y < res; y++) {
+		for (x = 0; x < res - 1; x++, i++) {
+			medge[i].v1 = (unsigned int)(y * res + x);
+			medge[i].v2 = (unsigned int)(y * res + x + 1);
+			medge[i].flag = ME_EDGEDRAW | ME_EDGERENDER;
+		}
+	}
+	for (x = 0; x < res; x++) {
+		for (y = 0; y < res - 1; y++, i++) {
+			medge[i].v1 = (unsigned int)(y * res + x);
+			medge[i].v2 = (unsigned int)((y + 1) * res + x);
+			medge[i].flag = ME_EDGEDRAW | ME_EDGERENDER;
+		}
+	}
+
+	for (y = 0, i = 0; y < res - 1; y++) {
+		for (x = 0; x < res - 1; x++, i++) {
+			const int l = i * 4;
+			const int v = y * res + x;
+
+			mpoly[i].loopstart = l;
+			mpoly[i].totloop = 4;
+
+			mloop[l + 0].v = (unsigned int)v;
+			mloop[l + 0].e = (unsigned int)(y * (res - 1) + x);
+			mloop[l + 1].v = (unsigned int)(v + 1);
+			mloop[l + 1].e = (unsigned int)(edges_x + (x + 1) * (res - 1) + y);
+			mloop[l + 2].v = (unsigned int)(v + res + 1);
+			mloop[l + 2].e = (unsigned int)((y + 1) * (res - 1) + x);
+			mloop[l + 3].v = (unsigned int)(v + res);
+			mloop[l + 3].e = (unsigned int)(edges_x + x * (res - 1) + y);
+
+			copy_v2_fl2(mloopuv[l + 0].uv, (float)x, (float)y);
+			copy_v2_fl2(mloopuv[l + 1].uv, (float)(x + 1), (float)y);
+			copy_v2_fl2(mloopuv[l + 2].uv, (float)(x + 1), (float)(y + 1));
+			copy_v2_fl2(mloopuv[l + 3].uv, (float)x, (float)(y + 1));
+		}
+	}
+
+	BKE_mesh_update_customdata_pointers(me, false);
+
+	return me;
+}
+
+static Mesh *mesh_empty_new(void)
+{
+	Mesh *me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+	BKE_mesh_init(me);
+	return me;
+}
+
+static void mesh_free(Mesh *me)
+{
+	BKE_mesh_free(me, false);
+	MEM_freeN(me);
+}
+
+static void mesh_conv_run(const Mesh *me_src, Mesh *me_dst, const bool serial)
+{
+	BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(me_src);
+	BMesh *bm;
+
+	testing_threads_serial_set(serial);
+	printf("%s:\n", serial ? "Serial" : "Threaded");
+
+	bm = BM_mesh_create(&allocsize);
+
+	{
+		TIMEIT_START(mesh_to_bmesh);
+		BM_mesh_bm_from_me(bm, (Mesh *)me_src, true, false, 0);
+		TIMEIT_END(mesh_to_bmesh);
+	}
+
+	EXPECT_EQ(me_src->totvert, bm->totvert);
+	EXPECT_EQ(me_src->totedge, bm->totedge);
+	EXPECT_EQ(me_src->totpoly, bm->totface);
+	EXPECT_EQ(me_src->totloop, bm->totloop);
+
+	{
+		TIMEIT_START(bmesh_to_mesh);
+		BM_mesh_bm_to_me(bm, me_dst, false);
+		TIMEIT_END(bmesh_to_mesh);
+	}
+
+	BM_mesh_free(bm);
+
+	/* round-trip must be lossless */
+	ASSERT_EQ(me_src->totvert, me_dst->totvert);
+	ASSERT_EQ(me_src->totedge, me_dst->totedge);
+	ASSERT_EQ(me_src->totpoly, me_dst->totpoly);
+	ASSERT_EQ(me_src->totloop, me_dst->totloop);
+	{
+		const float *vfloat_src = (const float *)CustomData_get_layer(&me_src->vdata, CD_PROP_FLT);
+		const float *vfloat_dst = (const float *)CustomData_get_layer(&me_dst->vdata, CD_PROP_FLT);
+		int i;
+
+		ASSERT_TRUE(vfloat_dst != NULL);
+		for (i = 0; i < me_src->totvert; i++) {
+			EXPECT_EQ(0, memcmp(me_src->mvert[i].co, me_dst->mvert[i].co, sizeof(float[3])));
+			EXPECT_EQ(vfloat_src[i], vfloat_dst[i]);
+		}
+		for (i = 0; i < me_src->totedge; i++) {
+			EXPECT_EQ(me_src->medge[i].v1, me_dst->medge[i].v1);
+			EXPECT_EQ(me_src->medge[i].v2, me_dst->medge[i].v2);
+		}
+		for (i = 0; i < me_src->totloop; i++) {
+			EXPECT_EQ(me_src->mloop[i].v, me_dst->mloop[i].v);
+			EXPECT_EQ(me_src->mloop[i].e, me_dst->mloop[i].e);
+			EXPECT_EQ(0, memcmp(me_src->mloopuv[i].uv, me_dst->mloopuv[i].uv, sizeof(float[2])));
+		}
+		for (i = 0; i < me_src->totpoly; i++) {
+			EXPECT_EQ(me_src->mpoly[i].loopstart, me_dst->mpoly[i].loopstart);
+			EXPECT_EQ(me_src->mpoly[i].totloop, me_dst->mpoly[i].totloop);
+		}
+	}
+}
+
+static void mesh_conv_test(const int res)
+{
+	Mesh *me_src = mesh_grid_new(res);
+	Mesh *me_dst_serial = mesh_empty_new();
+	Mesh *me_dst = mesh_empty_new();
+
+	BLI_threadapi_init();
+
+	mesh_conv_run(me_src, me_dst_serial, true);
+	mesh_conv_run(me_src, me_dst, false);
+
+	ASSERT_EQ(me_dst_serial->totvert, me_dst->totvert);
+	ASSERT_EQ(me_dst_serial->totedge, me_dst->totedge);
+	ASSERT_EQ(me_dst_serial->totpoly, me_dst->totpoly);
+	ASSERT_EQ(me_dst_serial->totloop, me_dst->totloop);
+	EXPECT_EQ(0, memcmp(me_dst_serial->mvert, me_dst->mvert, sizeof(MVert) * me_dst->totvert));
+	EXPECT_EQ(0, memcmp(me_dst_serial->medge, me_dst->medge, sizeof(MEdge) * me_dst->totedge));
+	EXPECT_EQ(0, memcmp(me_dst_serial->mpoly, me_dst->mpoly, sizeof(MPoly) * me_dst->totpoly));
+	EXPECT_EQ(0, memcmp(me_dst_serial->mloop, me_dst->mloop, sizeof(MLoop) * me_dst->totloop));
+	EXPECT_EQ(0, memcmp(me_dst_serial->mloopuv, me_dst->mloopuv, sizeof(MLoopUV) * me_dst->totloop));
+
+	mesh_free(me_src);
+	mesh_free(me_dst_serial);
+	mesh_free(me_dst);
+}
+
+TEST(bmesh_mesh_conv, GridSmall)
+{
+	mesh_conv_test(GRID_RES_SMALL);
+}
+
+TEST(bmesh_mesh_conv, GridLarge)
+{
+	mesh_conv_test(GRID_RES_LARGE);
+}
@@ -0,0 +1,139 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include "testing/testing_mesh.h"
+#include "testing/testing_threads.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "ED_armature.h"
+#include "PIL_time.h"
+}
+
+/* Time and memory of binding a sphere to a low resolution cage around it,
+ * with the static and dynamic bind at the default and a finer grid size.
+ * The threaded bind must give the same influences as the serial one. */
+
+#define MESH_RES 64
+#define CAGE_RES 8
+
+static MeshDeformModifierData *mesh_deform_bind_run(
+        Mesh *me, Object *cage_ob, DerivedMesh *cage_dm, const int gridsize, const bool dynamic, const bool serial)
+{
+	MeshDeformModifierData *mmd;
+	float (*vertexcos)[3];
+	float cagemat[4][4];
+	size_t mem_start;
+	double time_start, time_bind;
+
+	testing_threads_serial_set(serial);
+
+	vertexcos = BKE_mesh_vertexCos_get(me, NULL);
+	unit_m4(cagemat);
+
+	mmd = (MeshDeformModifierData *)modifier_new(eModifierType_MeshDeform);
+	mmd->object = cage_ob;
+	mmd->gridsize = gridsize;
+	if (dynamic) {
+		mmd->flag |= MOD_MDEF_DYNAMIC_BIND;
+	}
+
+	mem_start = MEM_get_memory_in_use();
+	MEM_reset_peak_memory();
+	time_start = PIL_check_seconds_timer();
+
+	mesh_deform_bind(NULL, mmd, cage_dm, (float *)vertexcos, me->totvert, cagemat);
+
+	time_bind = PIL_check_seconds_timer() - time_start;
+
+	printf("%s: vertices: %d, grid size: %d, influences: %d, time: %.6f, memory: %.2f MB (peak %.2f MB)\n",
+	       serial ? "Serial" : "Threaded", me->totvert, gridsize, mmd->totinfluence,
+	       time_bind,
+	       (double)(MEM_get_memory_in_use() - mem_start) / (1024.0 * 1024.0),
+	       (double)(MEM_get_peak_memory() - mem_start) / (1024.0 * 1024.0));
+
+	MEM_freeN(vertexcos);
+
+	return mmd;
+}
+
+static void mesh_deform_bind_test(const int gridsize, const bool dynamic)
+{
+	MeshDeformModifierData *mmd_serial, *mmd;
+	Main *bmain;
+	Mesh *me, *cage_me;
+	Object *cage_ob;
+	DerivedMesh *cage_dm;
+
+	BLI_threadapi_init();
+	BKE_modifier_init();
+
+	bmain = BKE_main_new();
+	me = testing_mesh_uvsphere_new(bmain, MESH_RES, 1.0f);
+	cage_me = testing_mesh_uvsphere_new(bmain, CAGE_RES, 1.5f);
+
+	cage_ob = BKE_object_add_only_object(bmain, OB_MESH, "Cage");
+	cage_ob->data = cage_me;
+	cage_dm = CDDM_from_mesh(cage_me);
+
+	mmd_serial = mesh_deform_bind_run(me, cage_ob, cage_dm, gridsize, dynamic, true);
+	mmd = mesh_deform_bind_run(me, cage_ob, cage_dm, gridsize, dynamic, false);
+
+	/* every vertex is inside the cage, so it gets influences */
+	EXPECT_EQ(me->totvert, mmd->totvert);
+	EXPECT_GT(mmd->totinfluence, 0);
+	EXPECT_STREQ("", mmd->modifier.error ? mmd->modifier.error : "");
+
+	EXPECT_EQ(mmd_serial->totinfluence, mmd->totinfluence);
+	if (mmd_serial->totinfluence == mmd->totinfluence) {
+		if (dynamic) {
+			const int totcell = mmd->dyngridsize * mmd->dyngridsize * mmd->dyngridsize;
+
+			EXPECT_EQ(mmd_serial->dyngridsize, mmd->dyngridsize);
+			EXPECT_EQ(0, memcmp(mmd_serial->dyngrid, mmd->dyngrid, sizeof(*mmd->dyngrid) * totcell));
+			EXPECT_EQ(0, memcmp(mmd_serial->dyninfluences, mmd->dyninfluences,
+			                    sizeof(*mmd->dyninfluences) * mmd->totinfluence));
+			EXPECT_EQ(0, memcmp(mmd_serial->dynverts, mmd->dynverts, sizeof(*mmd->dynverts) * mmd->totvert));
+		}
+		else {
+			EXPECT_EQ(0, memcmp(mmd_serial->bindoffsets, mmd->bindoffsets,
+			                    sizeof(*mmd->bindoffsets) * (mmd->totvert + 1)));
+			EXPECT_EQ(0, memcmp(mmd_serial->bindinfluences, mmd->bindinfluences,
+			                    sizeof(*mmd->bindinfluences) * mmd->totinfluence));
+		}
+	}
+
+	modifier_free((ModifierData *)mmd_serial);
+	modifier_free((ModifierData *)mmd);
+	cage_dm->release(cage_dm);
+	BKE_main_free(bmain);
+}
+
+TEST(mesh_deform_bind, Static)
+{
+	mesh_deform_bind_test(5, false);
+}
+
+TEST(mesh_deform_bind, StaticPrecision6)
+{
+	mesh_deform_bind_test(6, false);
+}
+
+TEST(mesh_deform_bind, Dynamic)
+{
+	mesh_deform_bind_test(5, true);
+}
@@ -0,0 +1,98 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BLENDER_TESTING_MESH_H__
+#define __BLENDER_TESTING_MESH_H__
+
+/* UV spheres to test mesh code with, res is the number of rings,
+ * with twice as many segments, and comparison of the resulting meshes. */
+
+#include <stdlib.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "DNA_mesh_types.h"
+#include "BKE_mesh.h"
+}
+
+#include "bmesh.h"
+
+inline void testing_bm_uvsphere_add(
+        BMesh *bm, const int res, const float radius, const float loc[3], const bool calc_uvs)
+{
+	float mat[4][4];
+
+	unit_m4(mat);
+	if (loc) {
+		copy_v3_v3(mat[3], loc);
+	}
+
+	BMO_op_callf(bm, BMO_FLAG_DEFAULTS,
+	             "create_uvsphere u_segments=%i v_segments=%i diameter=%f matrix=%m4 calc_uvs=%b",
+	             res * 2, res, radius, mat, calc_uvs);
+}
+
+inline Mesh *testing_mesh_uvsphere_new(Main *bmain, const int res, const float radius)
+{
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default);
+	Mesh *me = BKE_mesh_add(bmain, "Sphere");
+
+	testing_bm_uvsphere_add(bm, res, radius, NULL, false);
+	BM_mesh_bm_to_me(bm, me, false);
+	BM_mesh_free(bm);
+
+	return me;
+}
+
+inline int testing_co_cmp(const void *co_a_v, const void *co_b_v)
+{
+	const float *co_a = (const float *)co_a_v;
+	const float *co_b = (const float *)co_b_v;
+
+	for (int i = 0; i < 3; i++) {
+		if (co_a[i] != co_b[i]) {
+			return (co_a[i] < co_b[i]) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+inline float (*testing_bm_vert_cos_sorted(BMesh *bm))[3]
+{
+	float (*cos)[3] = (float (*)[3])MEM_mallocN(sizeof(*cos) * (size_t)max_ii(bm->totvert, 1), __func__);
+	BMIter iter;
+	BMVert *v;
+	int i;
+
+	BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+		copy_v3_v3(cos[i], v->co);
+	}
+	qsort(cos, (size_t)bm->totvert, sizeof(*cos), testing_co_cmp);
+
+	return cos;
+}
+
+/* Number of vertices further than limit from their position in bm_a in bm_b, to compare the results
+ * of the same operation done in different ways. Positions are compared sorted, since
+ * the order of the vertices may follow pointer hashes (which differ between runs). */
+inline int testing_bm_verts_differ_count(BMesh *bm_a, BMesh *bm_b, const float limit)
+{
+	float (*cos_a)[3] = testing_bm_vert_cos_sorted(bm_a);
+	float (*cos_b)[3] = testing_bm_vert_cos_sorted(bm_b);
+	const int totvert = min_ii(bm_a->totvert, bm_b->totvert);
+	int totvert_differ = ABS(bm_a->totvert - bm_b->totvert);
+
+	for (int i = 0; i < totvert; i++) {
+		if (len_v3v3(cos_a[i], cos_b[i]) > limit) {
+			totvert_differ++;
+		}
+	}
+
+	MEM_freeN(cos_a);
+	MEM_freeN(cos_b);
+
+	return totvert_differ;
+}
+
+#endif  /* __BLENDER_TESTING_MESH_H__ */
@@ -0,0 +1,33 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BLENDER_TESTING_THREADS_H__
+#define __BLENDER_TESTING_THREADS_H__
+
+/* Run the parallel loops of BLI_task and OpenMP serially in the calling thread,
+ * or threaded, to check threaded results against serial ones. BLI_task uses two
+ * threads at least, so its threaded code is tested on a single core as well,
+ * OpenMP uses the system threads since its threads spin when waiting. */
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+}
+
+inline void testing_threads_serial_set(const bool serial)
+{
+	int num_threads;
+
+	BLI_system_num_threads_override_set(0);
+	num_threads = serial ? 1 : BLI_system_thread_count();
+	BLI_system_num_threads_override_set(serial ? 1 : max_ii(num_threads, 2));
+
+#ifdef _OPENMP
+	omp_set_num_threads(num_threads);
+#endif
+}
+
+#endif  /* __BLENDER_TESTING_THREADS_H__ */
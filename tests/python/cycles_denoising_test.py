@@ -0,0 +1,148 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/cycles_denoising_test.py -- --verbose
+import os
+import struct
+import tempfile
+import unittest
+
+import bpy
+
+
+def exr_read_channels(filepath):
+    """
+    Channels of an uncompressed, single part, scan line OpenEXR file with float pixels,
+    as a dict of channel name to a flat list of values.
+    """
+    with open(filepath, "rb") as f:
+        data = f.read()
+
+    magic, version = struct.unpack_from("<ii", data, 0)
+    assert magic == 20000630, "not an OpenEXR file"
+    assert (version & 0xffffff00) == 0, "only single part scan line files are supported"
+    offset = 8
+
+    def read_string(offset):
+        end = data.index(b"\0", offset)
+        return data[offset:end].decode("utf-8"), end + 1
+
+    channels = []
+    compression = None
+    data_window = None
+
+    while True:
+        name, offset = read_string(offset)
+        if not name:
+            break
+        attr_type, offset = read_string(offset)
+        size, = struct.unpack_from("<i", data, offset)
+        offset += 4
+        value = data[offset:offset + size]
+        offset += size
+
+        if name == "channels":
+            i = 0
+            while value[i] != 0:
+                end = value.index(b"\0", i)
+                pixel_type, = struct.unpack_from("<i", value, end + 1)
+                assert pixel_type == 2, "only float channels are supported"
+                channels.append(value[i:end].decode("utf-8"))
+                i = end + 1 + 16
+        elif name == "compression":
+            compression = value[0]
+        elif name == "dataWindow":
+            data_window = struct.unpack("<iiii", value)
+
+    assert compression == 0, "only uncompressed files are supported"
+
+    xmin, ymin, xmax, ymax = data_window
+    width = xmax - xmin + 1
+    height = ymax - ymin + 1
+
+    offsets = struct.unpack_from("<%dQ" % height, data, offset)
+    pixels = {name: [] for name in channels}
+
+    for line_offset in offsets:
+        # line number and size, followed by all pixels of every channel
+        offset = line_offset + 8
+        for name in channels:
+            pixels[name].extend(struct.unpack_from("<%df" % width, data, offset))
+            offset += 4 * width
+
+    return pixels
+
+
+def mean_squared_error(a, b):
+    return sum((x - y) * (x - y) for x, y in zip(a, b)) / len(a)
+
+
+class CyclesDenoisingTest(unittest.TestCase):
+    LAYER = "RenderLayer"
+
+    def setUp(self):
+        scene = bpy.context.scene
+        scene.render.engine = 'CYCLES'
+        scene.render.resolution_x = 48
+        scene.render.resolution_y = 48
+        scene.render.resolution_percentage = 100
+        scene.render.tile_x = 16
+        scene.render.tile_y = 16
+        scene.render.image_settings.file_format = 'OPEN_EXR_MULTILAYER'
+        scene.render.image_settings.color_depth = '32'
+        scene.render.image_settings.exr_codec = 'NONE'
+
+        cscene = scene.cycles
+        cscene.device = 'CPU'
+        cscene.progressive = 'PATH'
+        cscene.seed = 0
+        cscene.use_progressive_refine = False
+
+        # a ground plane, so there is indirect light and an edge to keep
+        bpy.ops.mesh.primitive_plane_add(radius=10.0, location=(0.0, 0.0, -1.0))
+
+        self.tempdir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        for filename in os.listdir(self.tempdir):
+            os.remove(os.path.join(self.tempdir, filename))
+        os.rmdir(self.tempdir)
+
+    def render(self, name, samples, use_denoising):
+        scene = bpy.context.scene
+        scene.cycles.samples = samples
+        scene.cycles.use_denoising = use_denoising
+        scene.render.filepath = os.path.join(self.tempdir, name)
+
+        bpy.ops.render.render(write_still=True)
+
+        return exr_read_channels(scene.render.filepath + ".exr")
+
+    def pass_rgb(self, channels, pass_name):
+        prefix = self.LAYER + "." + pass_name + "."
+        r, g, b = (channels[prefix + c] for c in "RGB")
+        return [v for rgb in zip(r, g, b) for v in rgb]
+
+    def test_denoised_pass(self):
+        reference = self.pass_rgb(self.render("reference", 1024, False), "Combined")
+        noisy = self.render("noisy", 16, False)
+        denoised = self.render("denoised", 16, True)
+
+        noisy_combined = self.pass_rgb(noisy, "Combined")
+        denoised_combined = self.pass_rgb(denoised, "Combined")
+
+        # the denoised result is a pass of its own, combined is left as it is
+        self.assertNotIn(self.LAYER + ".Denoised.R", noisy)
+        self.assertIn(self.LAYER + ".Denoised.R", denoised)
+        self.assertLess(mean_squared_error(noisy_combined, denoised_combined), 1e-10)
+
+        error_noisy = mean_squared_error(noisy_combined, reference)
+        error_denoised = mean_squared_error(self.pass_rgb(denoised, "Denoised"), reference)
+
+        self.assertLess(error_denoised, error_noisy * 0.75,
+                        msg="denoising error %g, noisy error %g" % (error_denoised, error_noisy))
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()